@@ -0,0 +1,69 @@
+# Copyright 2023 The Khronos Group Inc.
+# SPDX-License-Identifier: Apache-2.0
+
+# Generate the lookup tables that basisu_transcoder_init() computes at run
+# time and compile them into ktx_read instead. This removes most of the cost
+# of the first transcode.
+#
+# The generated file holds the raw bytes of the tables so it must be made by
+# a program built for the target. When cross-compiling the tables are left
+# to be computed at run time.
+
+if(CMAKE_CROSSCOMPILING)
+    message(STATUS "Cross-compiling. Basis Universal transcoder tables will be computed at run time.")
+    return()
+endif()
+
+add_executable(mktranscodertables
+    lib/mktranscodertables.cpp
+)
+
+set_target_properties(mktranscodertables PROPERTIES
+    CXX_STANDARD 11
+    CXX_STANDARD_REQUIRED YES
+)
+
+target_include_directories(mktranscodertables
+PRIVATE
+    ${CMAKE_CURRENT_SOURCE_DIR}/lib/basisu/transcoder
+)
+
+# The tables depend on which formats are supported so build the generator
+# with the same BASISD_* settings as the library. mktranscodertables.cpp
+# overrides BASISD_USE_BAKED_INIT_TABLES.
+target_compile_definitions(mktranscodertables
+PRIVATE
+    $<TARGET_PROPERTY:ktx_read,COMPILE_DEFINITIONS>
+)
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    # Warnings in basisu_transcoder.cpp are dealt with where ktx_read
+    # builds it.
+    target_compile_options(mktranscodertables PRIVATE -w)
+endif()
+
+set(transcoder_tables_inc
+    ${CMAKE_CURRENT_BINARY_DIR}/basisu_transcoder_tables_init.inc
+)
+
+add_custom_command(OUTPUT ${transcoder_tables_inc}
+    COMMAND mktranscodertables ${transcoder_tables_inc}
+    DEPENDS mktranscodertables
+    COMMENT "Generating Basis Universal transcoder tables"
+    VERBATIM
+)
+
+target_sources(ktx_read
+PRIVATE
+    ${transcoder_tables_inc}
+)
+
+target_include_directories(ktx_read
+PRIVATE
+    $<BUILD_INTERFACE:${CMAKE_CURRENT_BINARY_DIR}>
+)
+
+target_compile_definitions(ktx_read
+PRIVATE
+    BASISD_USE_BAKED_INIT_TABLES=1
+)
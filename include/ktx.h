@@ -137,6 +137,15 @@ extern "C" {
  * @brief Key string for standard writer supercompression parameter metadata.
  */
 #define KTX_WRITER_SCPARAMS_KEY "KTXwriterScParams"
+/**
+ * @~English
+ * @brief Key string for the identity of the shared ETC1S codebooks a
+ *        BasisLZ texture was encoded against.
+ *
+ * The value is a NUL terminated string of 16 hex digits. This is not a
+ * standard key so it is outside the reserved @c KTX prefix.
+ */
+#define KTX_ETC1S_CODEBOOK_KEY "LIBKTXetc1sCodebook"
 /**
  * @~English
  * @brief Standard KTX 1 format for 1D orientation value.
@@ -780,9 +789,25 @@ enum ktxTextureCreateFlagBits {
     KTX_TEXTURE_CREATE_SKIP_KVDATA_BIT = 0x04,
                                    /*!< Skip any key-value data. This overrides
                                         the RAW_KVDATA_BIT. */
-    KTX_TEXTURE_CREATE_CHECK_GLTF_BASISU_BIT = 0x08
+    KTX_TEXTURE_CREATE_CHECK_GLTF_BASISU_BIT = 0x08,
                                    /*!< Load texture compatible with the rules
                                         of KHR_texture_basisu glTF extension */
+    KTX_TEXTURE_CREATE_PARALLEL_INFLATE_BIT = 0x10,
+                                   /*!< When loading images that are
+                                        supercompressed with Zstd or ZLIB,
+                                        inflate the mip levels in parallel
+                                        using all available hardware threads.
+                                        Ignored for KTX v1 textures. */
+    KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT = 0x20
+                                   /*!< Memory-map the file when creating from
+                                        a named file. For textures with
+                                        supercompressionScheme
+                                        @c KTX_SS_NONE, pData then points
+                                        into the mapping instead of holding a
+                                        copy of the images. The mapping is
+                                        private copy-on-write so writes to
+                                        pData do not reach the file. Other
+                                        sources are read as usual. */
 };
 /**
  * @memberof ktxTexture
@@ -819,7 +844,8 @@ typedef ktx_uint32_t ktxTextureCreateFlags;
 typedef struct ktxMem ktxMem;
 typedef struct ktxStream ktxStream;
 
-enum streamType { eStreamTypeFile = 1, eStreamTypeMemory = 2, eStreamTypeCustom = 3 };
+enum streamType { eStreamTypeFile = 1, eStreamTypeMemory = 2, eStreamTypeCustom = 3,
+                  eStreamTypeMmap = 4 };
 
 /**
  * @~English
@@ -895,6 +921,12 @@ struct ktxStream
             void* allocatorAddress;  /**< pointer to a memory allocator. */
             ktx_size_t size;         /**< size of the data. */
         } custom_ptr;      /**< pointer to a struct for custom streams. */
+        struct
+        {
+            ktx_uint8_t* address;    /**< start of the mapping. */
+            ktx_size_t size;         /**< size of the mapping. */
+            ktx_size_t pos;          /**< read position. */
+        } mapped;          /**< a mapped file for a ktxMmapStream. */
     } data;                /**< pointer to the stream data. */
     ktx_off_t readpos;     /**< used by FileStream for stdin. */
     ktx_bool_t closeOnDestruct; /**< Close FILE* or dispose of memory on destruct. */
@@ -1070,6 +1102,9 @@ ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t level);
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t level);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetSerializedSize(ktxTexture2* This, ktx_size_t* pSize);
+
 KTX_API void KTX_APIENTRY
 ktxTexture2_GetComponentInfo(ktxTexture2* This, ktx_uint32_t* numComponents,
                              ktx_uint32_t* componentByteLength);
@@ -1093,6 +1128,127 @@ ktxTexture2_GetPremultipliedAlpha(ktxTexture2* This);
 KTX_API ktx_bool_t KTX_APIENTRY
 ktxTexture2_NeedsTranscoding(ktxTexture2* This);
 
+/*
+ * As ktxTexture_LoadImageData but inflates supercompressed mip levels
+ * on up to threadCount threads. 0 means the number of hardware threads.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_LoadImageDataEx(ktxTexture2* This,
+                            ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                            ktx_uint32_t threadCount);
+
+/*
+ * Load a range of mip levels into caller memory, synchronously or on a
+ * background I/O thread.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetLevelsDataSize(ktxTexture2* This, ktx_uint32_t firstLevel,
+                              ktx_uint32_t levelCount, ktx_size_t* pSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_LoadLevels(ktxTexture2* This, ktx_uint32_t firstLevel,
+                       ktx_uint32_t levelCount,
+                       ktx_uint8_t* pBuffer, ktx_size_t bufSize);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Handle of a load started with ktxTexture2_LoadLevelsAsync().
+ */
+typedef struct ktxLevelLoad ktxLevelLoad;
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Signature of function called when an asynchronous level load
+ *        completes.
+ *
+ * Called on the background I/O thread.
+ *
+ * @param[in] texture    the texture the levels were loaded from.
+ * @param[in] firstLevel first level of the load.
+ * @param[in] levelCount number of levels in the load.
+ * @param[in] result     KTX_SUCCESS or the error that ended the load.
+ * @param[in] userdata   the pointer given to ktxTexture2_LoadLevelsAsync().
+ */
+typedef void (KTX_APIENTRY* PFNKTXLEVELLOADCB)(ktxTexture2* texture,
+                                               ktx_uint32_t firstLevel,
+                                               ktx_uint32_t levelCount,
+                                               KTX_error_code result,
+                                               void* userdata);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_LoadLevelsAsync(ktxTexture2* This, ktx_uint32_t firstLevel,
+                            ktx_uint32_t levelCount,
+                            ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                            PFNKTXLEVELLOADCB pfnComplete, void* userdata,
+                            ktxLevelLoad** ppLoad);
+
+KTX_API ktx_bool_t KTX_APIENTRY
+ktxLevelLoad_IsComplete(ktxLevelLoad* load);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxLevelLoad_Wait(ktxLevelLoad* load);
+
+KTX_API void KTX_APIENTRY
+ktxLevelLoad_Destroy(ktxLevelLoad* load);
+
+/**
+ * @class ktxContext
+ * @~English
+ * @brief Opaque handle to reusable decompression and compression state.
+ */
+typedef struct ktxContext ktxContext;
+
+/*
+ * Reuse Zstd contexts, miniz state and scratch buffers across the loads,
+ * inflates and deflates of any number of textures.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxContext_Create(ktxContext** ppContext);
+
+KTX_API void KTX_APIENTRY
+ktxContext_Destroy(ktxContext* context);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_SetContext(ktxTexture2* This, ktxContext* context);
+
+/**
+ * @class ktxEtc1sCodebook
+ * @~English
+ * @brief Opaque handle to ETC1S endpoint and selector codebooks shared by
+ *        a set of textures.
+ */
+typedef struct ktxEtc1sCodebook ktxEtc1sCodebook;
+
+/*
+ * Load and save codebooks trained with ktxEtc1sCodebook_Create() and set
+ * them on textures encoded against them so they can be transcoded. A
+ * texture only points at the codebooks set on it so they must not be
+ * destroyed while set on any texture.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEtc1sCodebook_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
+                                  ktxEtc1sCodebook** ppCodebook);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEtc1sCodebook_CreateFromNamedFile(const char* const filename,
+                                     ktxEtc1sCodebook** ppCodebook);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEtc1sCodebook_WriteToMemory(ktxEtc1sCodebook* codebook,
+                               ktx_uint8_t** ppDstBytes, ktx_size_t* pSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEtc1sCodebook_WriteToNamedFile(ktxEtc1sCodebook* codebook,
+                                  const char* const dstname);
+
+KTX_API void KTX_APIENTRY
+ktxEtc1sCodebook_Destroy(ktxEtc1sCodebook* codebook);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_SetEtc1sCodebook(ktxTexture2* This, ktxEtc1sCodebook* codebook);
+
 /**
  * @~English
  * @brief Flags specifiying UASTC encoding options.
@@ -1193,6 +1349,50 @@ typedef enum ktx_pack_astc_encoder_mode_e {
 
 extern KTX_API const ktx_uint32_t KTX_ETC1S_DEFAULT_COMPRESSION_LEVEL;
 
+/**
+ * @class ktxEncoderPool
+ * @~English
+ * @brief Opaque handle to a set of encoder threads shared by compressions.
+ *
+ * Create once with ktxEncoderPool_Create() and pass to
+ * ktxTexture2_CompressBasisBatch() or ktxTexture2_CompressAstcBatch() so
+ * that successive batches, or batches compressed concurrently by
+ * application threads, run their textures on one set of threads instead
+ * of each starting its own. The pool runs whole textures. Each texture's
+ * encoder still starts its own threads.
+ */
+typedef struct ktxEncoderPool ktxEncoderPool;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEncoderPool_Create(ktx_uint32_t threadCount, ktxEncoderPool** ppPool);
+
+KTX_API void KTX_APIENTRY
+ktxEncoderPool_Destroy(ktxEncoderPool* pool);
+
+/**
+ * @class ktxEncodeCache
+ * @~English
+ * @brief Opaque handle to an on-disk cache of compression results.
+ *
+ * Create with ktxEncodeCache_Create() and pass in the ktxAstcParams or
+ * ktxBasisParams given to ktxTexture2_CompressAstcBatch() or
+ * ktxTexture2_CompressBasisBatch(). Compressing a texture whose header,
+ * DFD, metadata and image data, together with the parameters that affect
+ * the output and the library version, match an earlier compression then
+ * restores that result, the DFD, supercompression global data and levels,
+ * instead of encoding again. The least recently used entries are evicted
+ * to keep the cache within its limits. ktxTexture2_CompressAstcEx() and
+ * ktxTexture2_CompressBasisEx() do not use the cache.
+ */
+typedef struct ktxEncodeCache ktxEncodeCache;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEncodeCache_Create(const char* directory, ktx_uint64_t maxSize,
+                      ktx_uint32_t maxEntries, ktxEncodeCache** ppCache);
+
+KTX_API void KTX_APIENTRY
+ktxEncodeCache_Destroy(ktxEncodeCache* cache);
+
 /**
  * @memberof ktxTexture
  * @~English
@@ -1250,6 +1450,12 @@ typedef struct ktxAstcParams {
          /*!< A swizzle to provide as input to astcenc. It must match the regular
              expression /^[rgba01]{4}$/.
           */
+
+    ktxEncodeCache* cache;
+        /*!< Optional cache in which ktxTexture2_CompressAstcBatch() looks
+             up each result before compressing and to which it adds it
+             afterwards. Ignored by ktxTexture2_CompressAstcEx().
+         */
 } ktxAstcParams;
 
 KTX_API KTX_error_code KTX_APIENTRY
@@ -1416,11 +1622,154 @@ typedef struct ktxBasisParams {
              deterministic).
          */
 
+    ktxEncodeCache* cache;
+        /*!< Optional cache in which ktxTexture2_CompressBasisBatch() looks
+             up each result before compressing and to which it adds it
+             afterwards. Ignored by ktxTexture2_CompressBasisEx(). Results
+             of multithreaded UASTC RDO, which may differ from run to run,
+             are cached like any other.
+         */
 } ktxBasisParams;
 
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params);
 
+/*
+ * Train ETC1S codebooks on a sample of related textures once, to be shared
+ * by many of them.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxEtc1sCodebook_Create(ktxTexture2** samples, ktx_uint32_t sampleCount,
+                        ktxBasisParams* params,
+                        ktxEtc1sCodebook** ppCodebook);
+
+/*
+ * Compress a list of textures with the same parameters, running them
+ * concurrently on a ktxEncoderPool.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CompressBasisBatch(ktxTexture2** textures, ktx_uint32_t textureCount,
+                               ktxEncoderPool* pool, ktxBasisParams* params,
+                               KTX_error_code* pResults);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CompressAstcBatch(ktxTexture2** textures, ktx_uint32_t textureCount,
+                              ktxEncoderPool* pool, ktxAstcParams* params,
+                              KTX_error_code* pResults);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing extended parameters to
+ *        ktxTexture2_DeflateZstdEx.
+ *
+ * Passing a struct initialized to 0 (e.g. " = {0};") will use Zstd's default
+ * compression level and a single thread, i.e. the same result as
+ * ktxTexture2_DeflateZstd().
+ */
+typedef struct ktxZstdParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+
+    ktx_uint32_t compressionLevel;
+        /*!< Speed vs compression ratio trade-off, 1 to 22. 0 selects
+             Zstd's default level.
+         */
+
+    ktx_uint32_t threadCount;
+        /*!< Number of threads used for compression. Default is 1. Large
+             levels are split into jobs compressed by Zstd's worker threads;
+             small levels are compressed concurrently with each other.
+             Output with threadCount > 1 is identical whatever its value
+             but can differ slightly from that of a single thread.
+         */
+
+    ktx_bool_t enableLongDistanceMatching;
+        /*!< Enable Zstd's long distance matching. Improves ratio for large
+             levels with repetitive content at the cost of memory.
+         */
+
+    ktx_uint32_t windowLog;
+        /*!< Log2 of the maximum back-reference distance. 0 lets Zstd
+             choose based on compressionLevel. Values above 27 require
+             decoders to raise their window limit and so are rejected.
+         */
+} ktxZstdParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateZstdEx(ktxTexture2* This, ktxZstdParams* params);
+
+/**
+ * @class ktxStreamWriter
+ * @~English
+ * @brief Opaque handle to a writer that writes a KTX2 file one level at a
+ *        time.
+ *
+ * Create with one of the ktxStreamWriter_Create functions from a
+ * ktxTexture2 that need not have its images in memory, give it each level
+ * with ktxStreamWriter_WriteLevel(), then call ktxStreamWriter_Finish().
+ * Levels are supercompressed as they are given so memory use is bounded by
+ * about one level.
+ */
+typedef struct ktxStreamWriter ktxStreamWriter;
+
+/**
+ * @memberof ktxStreamWriter
+ * @~English
+ * @brief Structure for passing parameters to the ktxStreamWriter_Create
+ *        functions.
+ *
+ * Passing a struct initialized to 0 (e.g. " = {0};") apart from structSize
+ * writes the levels without supercompression.
+ */
+typedef struct ktxStreamWriterParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+
+    ktxSupercmpScheme supercompressionScheme;
+        /*!< @c KTX_SS_NONE, @c KTX_SS_ZSTD or @c KTX_SS_ZLIB. */
+
+    ktx_uint32_t compressionLevel;
+        /*!< Level passed to the supercompressor. See
+             ktxTexture2_DeflateZstd() and ktxTexture2_DeflateZLIB().
+         */
+
+    ktx_uint32_t threadCount;
+        /*!< Number of Zstd worker threads compressing each level. 0 or 1
+             compresses on the calling thread.
+         */
+} ktxStreamWriterParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxStreamWriter_Create(ktxTexture2* texture, ktxStream* dststr,
+                       ktxStreamWriterParams* params,
+                       ktxStreamWriter** ppWriter);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxStreamWriter_CreateForStdioStream(ktxTexture2* texture, FILE* dstsstr,
+                                     ktxStreamWriterParams* params,
+                                     ktxStreamWriter** ppWriter);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxStreamWriter_CreateForNamedFile(ktxTexture2* texture,
+                                   const char* const dstname,
+                                   ktxStreamWriterParams* params,
+                                   ktxStreamWriter** ppWriter);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxStreamWriter_WriteLevel(ktxStreamWriter* writer, ktx_uint32_t level,
+                           const ktx_uint8_t* pData, ktx_size_t dataSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxStreamWriter_Finish(ktxStreamWriter* writer);
+
+KTX_API void KTX_APIENTRY
+ktxStreamWriter_Destroy(ktxStreamWriter* writer);
+
 /**
  * @~English
  * @brief Enumerators for specifying the transcode target format.
@@ -1590,6 +1939,98 @@ KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_TranscodeBasis(ktxTexture2* This, ktx_transcode_fmt_e fmt,
                            ktx_transcode_flags transcodeFlags);
 
+/**
+ * @~English
+ * @brief Signature of a unit of work handed to a PFNKTXSCHEDULER.
+ */
+typedef void (KTX_APIENTRY* PFNKTXTASK)(void* taskData,
+                                        ktx_uint32_t taskIndex);
+
+/**
+ * @~English
+ * @brief Signature of an application supplied task scheduler.
+ *
+ * The scheduler must call @p pfnTask(@p taskData, i) exactly once for each
+ * i in [0, @p taskCount). The calls may be made concurrently from any
+ * threads. The scheduler must not return until all calls have returned.
+ * @p userdata is the value given in ktxTranscodeParams.
+ */
+typedef void (KTX_APIENTRY* PFNKTXSCHEDULER)(ktx_uint32_t taskCount,
+                                             PFNKTXTASK pfnTask,
+                                             void* taskData,
+                                             void* userdata);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing extended parameters to
+ *        ktxTexture2_TranscodeBasisEx.
+ *
+ * Passing a struct initialized to 0 (e.g. " = {0};") transcodes on the
+ * calling thread, i.e. behaves as ktxTexture2_TranscodeBasis().
+ */
+typedef struct ktxTranscodeParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+
+    ktx_uint32_t threadCount;
+        /*!< Number of threads, including the calling thread, used for
+             transcoding when @c pfnScheduler is NULL. Default is 1.
+         */
+
+    PFNKTXSCHEDULER pfnScheduler;
+        /*!< Optional scheduler used to run the transcode tasks, e.g. on
+             an application's job system. When set, @c threadCount is
+             ignored.
+         */
+
+    void* schedulerUserdata;
+        /*!< Passed to @c pfnScheduler.
+         */
+} ktxTranscodeParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_TranscodeBasisEx(ktxTexture2* This, ktx_transcode_fmt_e fmt,
+                             ktx_transcode_flags transcodeFlags,
+                             ktxTranscodeParams* params);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetTranscodedSize(ktxTexture2* This, ktx_transcode_fmt_e fmt,
+                              ktx_size_t* pDataSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetTranscodedLevelSize(ktxTexture2* This, ktx_uint32_t level,
+                                   ktx_transcode_fmt_e fmt,
+                                   ktx_size_t* pLevelSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_TranscodeLevel(ktxTexture2* This, ktx_uint32_t level,
+                           ktx_transcode_fmt_e fmt,
+                           ktx_transcode_flags transcodeFlags,
+                           ktx_uint8_t* pBuffer, ktx_size_t bufSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetTranscodedImageLayout(ktxTexture2* This, ktx_uint32_t level,
+                                     ktx_transcode_fmt_e fmt,
+                                     ktx_uint32_t rowAlignment,
+                                     ktx_uint32_t* pRowPitch,
+                                     ktx_size_t* pImageSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_TranscodeImage(ktxTexture2* This, ktx_uint32_t level,
+                           ktx_uint32_t layer, ktx_uint32_t faceSlice,
+                           ktx_transcode_fmt_e fmt,
+                           ktx_transcode_flags transcodeFlags,
+                           ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                           ktx_uint32_t rowPitch);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_IterateTranscodeLevels(ktxTexture2* This, ktx_transcode_fmt_e fmt,
+                                   ktx_transcode_flags transcodeFlags,
+                                   PFNKTXITERCB iterCb, void* userdata);
+
 /*
  * Returns a string corresponding to a KTX error code.
  */
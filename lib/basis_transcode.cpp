@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <vector>
 #include <KHR/khr_df.h>
 
 #include "dfdutils/dfd.h"
@@ -29,6 +30,7 @@
 #include "vkformat_enum.h"
 #include "vk_format.h"
 #include "basis_sgd.h"
+#include "etc1s_codebook.h"
 #include "basisu/transcoder/basisu_file_headers.h"
 #include "basisu/transcoder/basisu_transcoder.h"
 #include "basisu/transcoder/basisu_transcoder_internal.h"
@@ -45,95 +47,273 @@ inline bool isPow2(uint32_t x) { return x && ((x & (x - 1U)) == 0U); }
 
 inline bool isPow2(uint64_t x) { return x && ((x & (x - 1U)) == 0U); }
 
-KTX_error_code
-ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
-                           alpha_content_e alphaContent,
-                           ktxTexture2* prototype,
-                           ktx_transcode_fmt_e outputFormat,
-                           ktx_transcode_flags transcodeFlags);
-KTX_error_code
-ktxTexture2_transcodeUastc(ktxTexture2* This,
-                           alpha_content_e alphaContent,
-                           ktxTexture2* prototype,
-                           ktx_transcode_fmt_e outputFormat,
-                           ktx_transcode_flags transcodeFlags);
+/**
+ * @internal
+ * @~English
+ * @brief Where a level's images are read from and written to when
+ *        transcoding.
+ */
+struct ktxTranscodeLevel {
+    uint64_t inputOffset;             /*!< Offset of the level in the
+                                           source data. */
+    ktx_size_t inputImageByteLength;  /*!< Size of a source image. UASTC
+                                           only. */
+    uint64_t outputOffset;            /*!< Offset of the level in the
+                                           transcoded data. */
+    ktx_size_t outputImageByteLength; /*!< Size of a transcoded image. */
+    ktx_size_t outputByteLength;      /*!< Size of the transcoded level. */
+    uint32_t width, height;
+    uint32_t blocksX, blocksY;
+};
 
 /**
- * @memberof ktxTexture2
- * @ingroup reader
+ * @internal
  * @~English
- * @brief Transcode a KTX2 texture with BasisLZ/ETC1S or UASTC images.
- *
- * If the texture contains BasisLZ supercompressed images, Inflates them from
- * back to ETC1S then transcodes them to the specified block-compressed
- * format. If the texture contains UASTC images, inflates them, if they have been
- * supercompressed with zstd, then transcodes then to the specified format, The
- * transcoded images replace the original images and the texture's fields including
- * the DFD are modified to reflect the new format.
- *
- * These types of textures must be transcoded to a desired target
- * block-compressed format before they can be uploaded to a GPU via a
- * graphics API.
- *
- * The following block compressed transcode targets are available: @c KTX_TTF_ETC1_RGB,
- * @c KTX_TTF_ETC2_RGBA, @c KTX_TTF_BC1_RGB, @c KTX_TTF_BC3_RGBA,
- * @c KTX_TTF_BC4_R, @c KTX_TTF_BC5_RG, @c KTX_TTF_BC7_RGBA,
- * @c @c KTX_TTF_PVRTC1_4_RGB, @c KTX_TTF_PVRTC1_4_RGBA,
- * @c KTX_TTF_PVRTC2_4_RGB, @c KTX_TTF_PVRTC2_4_RGBA, @c KTX_TTF_ASTC_4x4_RGBA,
- * @c KTX_TTF_ETC2_EAC_R11, @c KTX_TTF_ETC2_EAC_RG11, @c KTX_TTF_ETC and
- * @c KTX_TTF_BC1_OR_3.
+ * @brief A run of images in one level that are transcoded, in order, by a
+ *        single task.
  *
- * @c KTX_TTF_ETC automatically selects between @c KTX_TTF_ETC1_RGB and
- * @c KTX_TTF_ETC2_RGBA according to whether an alpha channel is available. @c KTX_TTF_BC1_OR_3
- * does likewise between @c KTX_TTF_BC1_RGB and @c KTX_TTF_BC3_RGBA. Note that if
- * @c KTX_TTF_PVRTC1_4_RGBA or @c KTX_TTF_PVRTC2_4_RGBA is specified and there is no alpha
- * channel @c KTX_TTF_PVRTC1_4_RGB or @c KTX_TTF_PVRTC2_4_RGB respectively will be selected.
+ * Tasks are independent of each other so they can be run concurrently.
+ */
+struct ktxTranscodeTask {
+    uint32_t level;
+    uint32_t firstImage;  /*!< Index of first image within the level. */
+    uint32_t imageStride;
+    uint32_t imageCount;
+};
+
+/**
+ * @internal
+ * @~English
+ * @brief Get the shape of a @p width x @p height image in a format.
  *
- * Transcoding to ATC & FXT1 formats is not supported by libktx as there
- * are no equivalent Vulkan formats.
+ * @param[in]   formatSize   size information of the format.
+ * @param[in]   width        width of the image in pixels.
+ * @param[in]   height       height of the image in pixels.
+ * @param[out]  pElementSize pointer to a location in which to store the size
+ *                           in bytes of a block, or a pixel for uncompressed
+ *                           formats.
+ * @param[out]  pRowElements pointer to a location in which to store the
+ *                           number of blocks or pixels in a row.
+ * @param[out]  pRows        pointer to a location in which to store the
+ *                           number of rows of blocks or pixels.
+ */
+static void
+ktxTranscodedImageShape(const ktxFormatSize& formatSize,
+                        ktx_uint32_t width, ktx_uint32_t height,
+                        ktx_uint32_t* pElementSize,
+                        ktx_uint32_t* pRowElements,
+                        ktx_uint32_t* pRows)
+{
+    *pElementSize = formatSize.blockSizeInBits / 8;
+    *pRowElements = MAX(formatSize.minBlocksX,
+                        (width + formatSize.blockWidth - 1)
+                        / formatSize.blockWidth);
+    *pRows = MAX(formatSize.minBlocksY,
+                 (height + formatSize.blockHeight - 1)
+                 / formatSize.blockHeight);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Calculate the input and output locations of each level.
  *
- * The following uncompressed transcode targets are also available: @c KTX_TTF_RGBA32,
- * @c KTX_TTF_RGB565, KTX_TTF_BGR565 and KTX_TTF_RGBA4444.
+ * Levels are written smallest first, as in the source, and padded to
+ * @p levelAlignment in case of transcoding to uncompressed. The layout is
+ * that of a ktxTexture2 created in the target format.
+ */
+static void
+ktxTexture2_calcTranscodeLevels(ktxTexture2* This,
+                                const ktxFormatSize& formatSize,
+                                ktx_uint32_t levelAlignment,
+                                std::vector<ktxTranscodeLevel>& levels)
+{
+    uint64_t levelOffsetWrite = 0;
+
+    levels.resize(This->numLevels);
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        ktxTranscodeLevel& lvl = levels[level];
+        uint32_t depth = MAX(1, This->baseDepth >> level);
+        uint32_t numImages = This->numLayers * This->numFaces * depth;
+        uint32_t elementSize, rowElements, rows;
+        // ETC1S & UASTC texel block dimensions
+        const uint32_t bw = 4, bh = 4;
+
+        lvl.width = MAX(1, This->baseWidth >> level);
+        lvl.height = MAX(1, This->baseHeight >> level);
+        lvl.blocksX = (lvl.width + (bw - 1)) / bw;
+        lvl.blocksY = (lvl.height + (bh - 1)) / bh;
+        lvl.inputOffset = ktxTexture2_levelDataOffset(This, level);
+        lvl.inputImageByteLength =
+                        ktxTexture_calcImageSize(ktxTexture(This), level,
+                                                 KTX_FORMAT_VERSION_TWO);
+        ktxTranscodedImageShape(formatSize, lvl.width, lvl.height,
+                                &elementSize, &rowElements, &rows);
+        lvl.outputImageByteLength = (ktx_size_t)elementSize * rowElements * rows;
+        lvl.outputByteLength = numImages * lvl.outputImageByteLength;
+        lvl.outputOffset = levelOffsetWrite;
+        levelOffsetWrite += lvl.outputByteLength;
+        // In case of transcoding to uncompressed.
+        levelOffsetWrite = _KTX_PADN(levelAlignment, levelOffsetWrite);
+    }
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Split the transcoding of levels @p firstLevel to
+ *        @p firstLevel + @p numLevels - 1 into independent tasks.
  *
- * The following @p transcodeFlags are available.
+ * Each image is a task of its own except in video, where a P-frame needs the
+ * previous frame of the same face and level. There all the frames of one face
+ * of a level form a single task. Images are ordered face0 [face1 ...] within
+ * each layer so a face's frames are @c numFaces apart. Tasks for the largest
+ * levels come first so they are not left until last.
+ */
+static void
+ktxTexture2_calcTranscodeTasks(ktxTexture2* This,
+                               uint32_t firstLevel, uint32_t numLevels,
+                               std::vector<ktxTranscodeTask>& tasks)
+{
+    for (uint32_t level = firstLevel; level < firstLevel + numLevels; level++) {
+        uint32_t depth = MAX(1, This->baseDepth >> level);
+        uint32_t numImages = This->numLayers * This->numFaces * depth;
+
+        if (This->isVideo) {
+            for (uint32_t face = 0; face < This->numFaces; face++)
+                tasks.push_back({level, face, This->numFaces,
+                                 numImages / This->numFaces});
+        } else {
+            for (uint32_t image = 0; image < numImages; image++)
+                tasks.push_back({level, image, 1, 1});
+        }
+    }
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Set the prototype's level index to describe the transcoded levels.
+ */
+static void
+ktxTexture2_setTranscodedLevelIndex(ktxTexture2* This,
+                                    const std::vector<ktxTranscodeLevel>& levels,
+                                    ktxLevelIndexEntry* protoLevelIndex)
+{
+    for (uint32_t level = 0; level < This->numLevels; level++) {
+        protoLevelIndex[level].byteOffset = levels[level].outputOffset;
+        protoLevelIndex[level].byteLength = levels[level].outputByteLength;
+        protoLevelIndex[level].uncompressedByteLength =
+                                                levels[level].outputByteLength;
+    }
+}
+
+template<class F>
+struct ktxScheduledTranscode {
+    F* transcode;
+    std::vector<KTX_error_code> results;
+};
+
+template<class F>
+static void KTX_APIENTRY
+ktxRunScheduledTranscodeTask(void* taskData, ktx_uint32_t taskIndex)
+{
+    ktxScheduledTranscode<F>& tasks =
+                            *static_cast<ktxScheduledTranscode<F>*>(taskData);
+    tasks.results[taskIndex] = (*tasks.transcode)(taskIndex);
+}
+
+template<class F>
+static KTX_error_code
+ktxRunTranscodeTask(ktx_uint32_t taskIndex, ktx_uint32_t, void* userdata)
+{
+    return (*static_cast<F*>(userdata))(taskIndex);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Run transcode tasks on the application's scheduler or our threads.
  *
- * @sa ktxtexture2_CompressBasis().
+ * @return KTX_SUCCESS or the error from the lowest numbered failing task.
+ */
+template<class F>
+static KTX_error_code
+ktxRunTranscodeTasks(const ktxTranscodeParams& params, uint32_t taskCount,
+                     F& transcode)
+{
+    if (params.pfnScheduler) {
+        ktxScheduledTranscode<F> tasks;
+        tasks.transcode = &transcode;
+        tasks.results.resize(taskCount, KTX_SUCCESS);
+        params.pfnScheduler(taskCount, ktxRunScheduledTranscodeTask<F>,
+                            &tasks, params.schedulerUserdata);
+        for (KTX_error_code result : tasks.results) {
+            if (result != KTX_SUCCESS)
+                return result;
+        }
+        return KTX_SUCCESS;
+    }
+    ktx_uint32_t threadCount =
+        ktxParallel_threadCount(params.threadCount ? params.threadCount : 1,
+                                taskCount);
+    return ktxParallel_for(taskCount, threadCount, ktxRunTranscodeTask<F>,
+                           &transcode);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief What is needed to transcode any of a texture's levels to one format.
+ */
+struct ktxTranscodeState {
+    ktx_transcode_fmt_e outputFormat; /*!< Target after resolving, e.g.,
+                                           KTX_TTF_ETC. */
+    ktx_transcode_flags transcodeFlags;
+    VkFormat vkFormat;
+    alpha_content_e alphaContent;
+    basis_tex_format textureFormat;
+    ktxFormatSize formatSize;         /*!< Size information of vkFormat. */
+    ktx_uint32_t levelAlignment;      /*!< Required alignment of levels in
+                                           vkFormat. */
+    ktxTexture2* prototype;           /*!< Texture in the target format whose
+                                           DFD and data replace the texture's.
+                                           Only created by
+                                           ktxTexture2_TranscodeBasisEx. */
+    std::vector<ktxTranscodeLevel> levels;
+    // ETC1S only. Set by ktxTexture2_initTranscoder. firstImages contains the
+    // indices of the first images for each level to ease finding the correct
+    // slice description. The last entry is the total number of images.
+    std::vector<uint32_t> firstImages;
+    basisu_lowlevel_etc1s_transcoder etc1s;
+
+    ktxTranscodeState() : prototype(nullptr) { }
+    ~ktxTranscodeState() {
+        if (prototype)
+            ktxTexture2_Destroy(prototype);
+    }
+};
+
+/**
+ * @internal
+ * @~English
+ * @brief Check a texture can be transcoded to @p outputFormat and work out
+ *        the size and location of each transcoded level.
  *
  * @param[in]   This         pointer to the ktxTexture2 object of interest.
- * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
- *                                             specifying the target format.
+ * @param[in]   outputFormat the target format.
  * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
- *                                                operation. @sa ktx_texture_decode_flags_e.
+ *                           operation.
+ * @param[out]  state        the state to initialize.
  *
  * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
- *
- * @exception KTX_FILE_DATA_ERROR
- *                              Supercompression global data is corrupted.
- * @exception KTX_INVALID_OPERATION
- *                              The texture's format is not transcodable (not
- *                              ETC1S/BasisLZ or UASTC).
- * @exception KTX_INVALID_OPERATION
- *                              Supercompression global data is missing, i.e.,
- *                              the texture object is invalid.
- * @exception KTX_INVALID_OPERATION
- *                              Image data is missing, i.e., the texture object
- *                              is invalid.
- * @exception KTX_INVALID_OPERATION
- *                              @p outputFormat is PVRTC1 but the texture does
- *                              does not have power-of-two dimensions.
- * @exception KTX_INVALID_VALUE @p outputFormat is invalid.
- * @exception KTX_TRANSCODE_FAILED
- *                              Something went wrong during transcoding.
- * @exception KTX_UNSUPPORTED_FEATURE
- *                              KTX_TF_PVRTC_DECODE_TO_NEXT_POW2 was requested
- *                              or the specified transcode target has not been
- *                              included in the library being used.
- * @exception KTX_OUT_OF_MEMORY Not enough memory to carry out transcoding.
+ *              See ktxTexture2\_TranscodeBasis() for the errors.
  */
- KTX_error_code
- ktxTexture2_TranscodeBasis(ktxTexture2* This,
-                            ktx_transcode_fmt_e outputFormat,
-                            ktx_transcode_flags transcodeFlags)
+static KTX_error_code
+ktxTexture2_initTranscodeFormat(ktxTexture2* This,
+                                ktx_transcode_fmt_e outputFormat,
+                                ktx_transcode_flags transcodeFlags,
+                                ktxTranscodeState& state)
 {
     uint32_t* BDB = This->pDfd + 1;
     khr_df_model_e colorModel = (khr_df_model_e)KHR_DFDVAL(BDB, MODEL);
@@ -287,12 +467,50 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
     }
 
 
-    // Create a prototype texture to use for calculating sizes in the target
-    // format and, as useful side effects, provide us with a properly sized
-    // data allocation and the DFD for the target format.
+    // Get the size information of the target format the way
+    // ktxTexture2_Create does, from its DFD, so the layout matches that of a
+    // texture created in the target format without creating one.
+    uint32_t* pDfd = vk2dfd(vkFormat);
+    if (pDfd == nullptr)
+        return KTX_OUT_OF_MEMORY;
+    bool formatKnown = ktxFormatSize_initFromDfd(&state.formatSize, pDfd);
+    free(pDfd);
+    assert(formatKnown);
+    (void)formatKnown;
+
+    state.outputFormat = outputFormat;
+    state.transcodeFlags = transcodeFlags;
+    state.vkFormat = vkFormat;
+    state.alphaContent = alphaContent;
+    state.textureFormat = textureFormat;
+    state.levelAlignment = lcm4(state.formatSize.blockSizeInBits / 8);
+    ktxTexture2_calcTranscodeLevels(This, state.formatSize,
+                                    state.levelAlignment, state.levels);
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Create a texture in the transcode target format with storage for
+ *        the transcoded images.
+ *
+ * It provides the DFD for the target format and the memory into which
+ * ktxTexture2\_TranscodeBasisEx() transcodes.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   state        state prepared by ktxTexture2\_initTranscodeFormat().
+ *                           The prototype is stored in @c state.prototype.
+ *
+ * @return      KTX_SUCCESS on success, KTX_OUT_OF_MEMORY otherwise.
+ */
+static KTX_error_code
+ktxTexture2_createTranscodePrototype(ktxTexture2* This,
+                                     ktxTranscodeState& state)
+{
     ktxTextureCreateInfo createInfo;
     createInfo.glInternalformat = 0;
-    createInfo.vkFormat = vkFormat;
+    createInfo.vkFormat = state.vkFormat;
     createInfo.baseWidth = This->baseWidth;
     createInfo.baseHeight = This->baseHeight;
     createInfo.baseDepth = This->baseDepth;
@@ -314,97 +532,345 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
         return result;
     }
 
-    if (!This->pData) {
-        if (ktxTexture_isActiveStream((ktxTexture*)This)) {
-             // Load pending. Complete it.
-            result = ktxTexture2_LoadImageData(This, NULL, 0);
-            if (result != KTX_SUCCESS)
-            {
-                ktxTexture2_Destroy(prototype);
-                return result;
-            }
-        } else {
-            // No data to transcode.
-            ktxTexture2_Destroy(prototype);
+    // The levels were laid out without it.
+    assert(prototype->_private->_requiredLevelAlignment
+           == state.levelAlignment);
+    assert(prototype->dataSize
+           == state.levels[0].outputOffset + state.levels[0].outputByteLength);
+    state.prototype = prototype;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Prepare the transcoder for transcoding the texture's images.
+ *
+ * Initializes the transcoder's global tables, if not already done, and,
+ * for BasisLZ/ETC1S, decodes the codebooks and tables from the
+ * supercompression global data. These are only read afterwards so any
+ * number of levels or images can be transcoded concurrently with them.
+ *
+ * A texture encoded against shared codebooks uses those set with
+ * ktxTexture2_SetEtc1sCodebook(), which must have the id recorded in its
+ * @c KTX_ETC1S_CODEBOOK_KEY metadata.
+ *
+ * @exception KTX_FILE_DATA_ERROR
+ *                              Supercompression global data is corrupted,
+ *                              including when it has no codebooks and the
+ *                              texture does not record shared ones.
+ * @exception KTX_INVALID_OPERATION
+ *                              The texture was encoded against shared
+ *                              codebooks and matching ones are not set.
+ */
+static KTX_error_code
+ktxTexture2_initTranscoder(ktxTexture2* This, ktxTranscodeState& state)
+{
+    // Transcoder global initialization. Requires ~9 milliseconds when compiled
+    // and executed natively on a Core i7 2.2 GHz unless the tables it computes
+    // are compiled in with KTX_FEATURE_BAKED_TRANSCODER_TABLES. Several
+    // threads may transcode their first texture at the same time. C++11
+    // guarantees a local static is initialized exactly once, with the other
+    // threads waiting until it is done.
+    static const bool transcoderInitialized = (basisu_transcoder_init(), true);
+    (void)transcoderInitialized;
+
+    if (state.textureFormat != basis_tex_format::cETC1S)
+        return KTX_SUCCESS;
+
+    DECLARE_PRIVATE(priv, This);
+    assert(This->supercompressionScheme == KTX_SS_BASIS_LZ);
+
+    uint8_t* bgd = priv._supercompressionGlobalData;
+    ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
+    // A texture encoded against shared codebooks has none of its own and
+    // records which they are in its metadata. Missing codebooks without
+    // that record mean the global data is corrupt.
+    char* codebookId = NULL;
+    ktx_uint32_t codebookIdLen = 0;
+    bool sharedCodebook = !bgdh.endpointsByteLength
+                          && !bgdh.selectorsByteLength
+                          && ktxHashList_FindValue(&This->kvDataHead,
+                                                   KTX_ETC1S_CODEBOOK_KEY,
+                                                   &codebookIdLen,
+                                                   (void**)&codebookId)
+                             == KTX_SUCCESS;
+    if (!(sharedCodebook || (bgdh.endpointsByteLength
+                             && bgdh.selectorsByteLength))
+        || !bgdh.tablesByteLength) {
+        debug_printf("ktxTexture_TranscodeBasis: missing endpoints, selectors or tables");
+        return KTX_FILE_DATA_ERROR;
+    }
+    const ktxEtc1sCodebook* codebook = priv._etc1sCodebook;
+    if (sharedCodebook) {
+        if (!codebook) {
+            debug_printf("ktxTexture_TranscodeBasis: shared codebooks not set");
+            return KTX_INVALID_OPERATION;
+        }
+        if (codebookIdLen != sizeof(codebook->id)
+            || memcmp(codebookId, codebook->id, sizeof(codebook->id)) != 0
+            || (bgdh.endpointCount
+                && bgdh.endpointCount != codebook->endpointCount)
+            || (bgdh.selectorCount
+                && bgdh.selectorCount != codebook->selectorCount)) {
+            debug_printf("ktxTexture_TranscodeBasis: texture was encoded against other shared codebooks");
             return KTX_INVALID_OPERATION;
         }
     }
 
-    // Transcoder global initialization. Requires ~9 milliseconds when compiled
-    // and executed natively on a Core i7 2.2 GHz. If this is too slow, the
-    // tables it computes can easily be moved to be compiled in.
-    static bool transcoderInitialized;
-    if (!transcoderInitialized) {
-        basisu_transcoder_init();
-        transcoderInitialized = true;
+    std::vector<uint32_t>& firstImages = state.firstImages;
+    firstImages.resize(This->numLevels + 1);
+
+    // Temporary invariant value
+    uint32_t layersFaces = This->numLayers * This->numFaces;
+    firstImages[0] = 0;
+    for (uint32_t level = 1; level <= This->numLevels; level++) {
+        // NOTA BENE: numFaces * depth is only reasonable because they can't
+        // both be > 1. I.e there are no 3d cubemaps.
+        firstImages[level] = firstImages[level - 1]
+                           + layersFaces * MAX(This->baseDepth >> (level - 1), 1);
     }
+    uint32_t& imageCount = firstImages[This->numLevels];
 
-    if (textureFormat == basis_tex_format::cETC1S) {
-        result = ktxTexture2_transcodeLzEtc1s(This, alphaContent,
-                                            prototype, outputFormat,
-                                            transcodeFlags);
-    } else {
-        result = ktxTexture2_transcodeUastc(This, alphaContent,
-                                            prototype, outputFormat,
-                                            transcodeFlags);
+    if (BGD_TABLES_ADDR(0, bgdh, imageCount) + bgdh.tablesByteLength > priv._sgdByteLength) {
+        return KTX_FILE_DATA_ERROR;
     }
+    // FIXME: Do more validation.
 
-    if (result == KTX_SUCCESS) {
-        // Fix up the current texture
-        DECLARE_PROTECTED(thisPrtctd, This);
-        DECLARE_PRIVATE(protoPriv, prototype);
-        DECLARE_PROTECTED(protoPrtctd, prototype);
-        memcpy(&thisPrtctd._formatSize, &protoPrtctd._formatSize,
-               sizeof(ktxFormatSize));
-        This->vkFormat = vkFormat;
-        This->isCompressed = prototype->isCompressed;
-        This->supercompressionScheme = KTX_SS_NONE;
-        priv._requiredLevelAlignment = protoPriv._requiredLevelAlignment;
-        // Copy the levelIndex from the prototype to This.
-        memcpy(priv._levelIndex, protoPriv._levelIndex,
-               This->numLevels * sizeof(ktxLevelIndexEntry));
-        // Move the DFD and data from the prototype to This.
-        free(This->pDfd);
-        This->pDfd = prototype->pDfd;
-        prototype->pDfd = 0;
-        free(This->pData);
-        This->pData = prototype->pData;
-        This->dataSize = prototype->dataSize;
-        prototype->pData = 0;
-        prototype->dataSize = 0;
-        // Free SGD data
-        This->_private->_sgdByteLength = 0;
-        if (This->_private->_supercompressionGlobalData) {
-            free(This->_private->_supercompressionGlobalData);
-            This->_private->_supercompressionGlobalData = NULL;
-        }
+    // Prepare low-level transcoder for transcoding slices.
+    basist::basisu_lowlevel_etc1s_transcoder& bit = state.etc1s;
+
+    if (sharedCodebook) {
+        bit.set_global_codebooks(&codebook->transcoder);
+    } else {
+        bit.decode_palettes(bgdh.endpointCount, BGD_ENDPOINTS_ADDR(bgd, imageCount),
+                            bgdh.endpointsByteLength,
+                            bgdh.selectorCount, BGD_SELECTORS_ADDR(bgd, bgdh, imageCount),
+                            bgdh.selectorsByteLength);
     }
-    ktxTexture2_Destroy(prototype);
-    return result;
- }
+
+    bit.decode_tables(BGD_TABLES_ADDR(bgd, bgdh, imageCount),
+                      bgdh.tablesByteLength);
+    return KTX_SUCCESS;
+}
 
 /**
- * @memberof ktxTexture2 @private
- * @ingroup reader
+ * @internal
  * @~English
- * @brief Transcode a KTX2 texture with BasisLZ supercompressed ETC1S images.
+ * @brief Transcode a single image.
  *
- * Inflates the images from BasisLZ supercompression back to ETC1S
- * then transcodes them to the specified block-compressed format. The
- * transcoded images replace the original images and the texture's fields
- * including the DFD are modified to reflect the new format.
+ * For BasisLZ/ETC1S the image is inflated back to ETC1S then transcoded to
+ * the target format. UASTC images must already have been inflated if they
+ * were supercompressed.
  *
- * BasisLZ supercompressed textures must be transcoded to a desired target
- * block-compressed format before they can be uploaded to a GPU via a graphics
- * API.
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   state        state prepared by ktxTexture2\_initTranscodeFormat()
+ *                           and ktxTexture2\_initTranscoder().
+ * @param[in]   lvl          location of the image's level in @p pInput.
+ * @param[in]   level        the image's level.
+ * @param[in]   image        index of the image within the level.
+ * @param[in]   pInput       pointer to the BasisLZ or UASTC data.
+ * @param[in]   inputSize    size of the data at @p pInput.
+ * @param[in]   pOutput      pointer to memory for the transcoded image.
+ * @param[in]   outputSize   size of the memory at @p pOutput.
+ * @param[in]   outputRowPitch  distance between the starts of rows in the
+ *                           output, in blocks for block-compressed formats or
+ *                           in pixels for uncompressed formats. 0 for tightly
+ *                           packed rows.
+ * @param[in,out] xcoderState state used to find the previous frame when
+ *                           decoding a video P-frame.
  *
- * The following block compressed transcode targets are available: @c KTX_TTF_ETC1_RGB,
- * @c KTX_TTF_ETC2_RGBA, @c KTX_TTF_BC1_RGB, @c KTX_TTF_BC3_RGBA,
- * @c KTX_TTF_BC4_R, @c KTX_TTF_BC5_RG, @c KTX_TTF_BC7_RGBA,
- * @c @c KTX_TTF_PVRTC1_4_RGB, @c KTX_TTF_PVRTC1_4_RGBA,
- * @c KTX_TTF_PVRTC2_4_RGB, @c KTX_TTF_PVRTC2_4_RGBA, @c KTX_TTF_ASTC_4x4_RGBA,
- * @c KTX_TTF_ETC2_EAC_R11, @c KTX_TTF_ETC2_EAC_RG11, @c KTX_TTF_ETC and
- * @c KTX_TTF_BC1_OR_3.
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_DATA_ERROR
+ *                              Alpha slice information is missing.
+ * @exception KTX_TRANSCODE_FAILED
+ *                              Something went wrong during transcoding.
+ */
+static KTX_error_code
+ktxTexture2_transcodeImage(ktxTexture2* This,
+                           ktxTranscodeState& state,
+                           const ktxTranscodeLevel& lvl,
+                           uint32_t level, uint32_t image,
+                           const ktx_uint8_t* pInput, ktx_size_t inputSize,
+                           ktx_uint8_t* pOutput, ktx_size_t outputSize,
+                           uint32_t outputRowPitch,
+                           basisu_transcoder_state& xcoderState)
+{
+    // Inconveniently, the output buffer size parameter of transcode_image
+    // has to be in pixels for uncompressed output and in blocks for
+    // compressed output. The only reason for humouring the API is so
+    // its buffer size tests provide a real check. An alternative is to
+    // always provide the size in bytes which will always pass.
+    ktx_uint32_t outputBlockByteLength = state.formatSize.blockSizeInBits / 8;
+    uint32_t xcodedDataLength = (uint32_t)(outputSize / outputBlockByteLength);
+    bool status;
+
+    if (state.textureFormat == basis_tex_format::cETC1S) {
+        DECLARE_PRIVATE(priv, This);
+        const ktxBasisLzEtc1sImageDesc& imageDesc
+            = BGD_ETC1S_IMAGE_DESCS(priv._supercompressionGlobalData)
+                                    [state.firstImages[level] + image];
+
+        if (state.alphaContent != eNone)
+        {
+            // The slice descriptions should have alpha information.
+            if (imageDesc.alphaSliceByteOffset == 0
+                || imageDesc.alphaSliceByteLength == 0)
+                return KTX_FILE_DATA_ERROR;
+        }
+
+        // FIXME: Iframe flag needs to be queryable by the application. In
+        // Basis the app can query file_info and image_info from the
+        // transcoder which returns a structure with lots of info about the
+        // image.
+        status = state.etc1s.transcode_image(
+                  (transcoder_texture_format)state.outputFormat,
+                  pOutput,
+                  xcodedDataLength,
+                  pInput,
+                  (uint32_t)inputSize,
+                  lvl.blocksX,
+                  lvl.blocksY,
+                  lvl.width,
+                  lvl.height,
+                  level,
+                  (uint32_t)(lvl.inputOffset + imageDesc.rgbSliceByteOffset),
+                  imageDesc.rgbSliceByteLength,
+                  (uint32_t)(lvl.inputOffset + imageDesc.alphaSliceByteOffset),
+                  imageDesc.alphaSliceByteLength,
+                  state.transcodeFlags,
+                  state.alphaContent != eNone,
+                  This->isVideo,
+                  // Our P-Frame flag is in the same bit as
+                  // cSliceDescFlagsFrameIsIFrame. We have to
+                  // invert it to make it an I-Frame flag.
+                  //
+                  // API currently doesn't have any way to pass
+                  // the I-Frame flag.
+                  //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
+                  outputRowPitch, // output_row_pitch_in_blocks_or_pixels
+                  &xcoderState,
+                  0  // output_rows_in_pixels
+                  );
+    } else {
+        // The transcoder has no state so there is no need to share one.
+        basisu_lowlevel_uastc_transcoder uit;
+        ktx_size_t imageOffsetIn = lvl.inputOffset
+                                 + image * lvl.inputImageByteLength;
+
+        status = uit.transcode_image(
+                      (transcoder_texture_format)state.outputFormat,
+                      pOutput,
+                      xcodedDataLength,
+                      pInput,
+                      (uint32_t)inputSize,
+                      lvl.blocksX,
+                      lvl.blocksY,
+                      lvl.width,
+                      lvl.height,
+                      level,
+                      (uint32_t)imageOffsetIn,
+                      (uint32_t)lvl.inputImageByteLength,
+                      state.transcodeFlags,
+                      state.alphaContent != eNone,
+                      This->isVideo, // is_video
+                      //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
+                      outputRowPitch, // output_row_pitch_in_blocks_or_pixels
+                      &xcoderState, // pState
+                      0, // output_rows_in_pixels,
+                      -1, // channel0
+                      -1  // channel1
+                      );
+    }
+    return status ? KTX_SUCCESS : KTX_TRANSCODE_FAILED;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Transcode the images described by @p tasks with the transcoder
+ *        for the texture's format.
+ *
+ * The source and destination of each level are given by @p levels, relative
+ * to @p pInput and @p pOutput. Images are written tightly packed.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   state        state prepared by ktxTexture2\_initTranscodeFormat()
+ *                           and ktxTexture2\_initTranscoder().
+ * @param[in]   levels       locations of the levels.
+ * @param[in]   tasks        the images to transcode.
+ * @param[in]   pInput       pointer to the BasisLZ or UASTC data.
+ * @param[in]   inputSize    size of the data at @p pInput.
+ * @param[in]   pOutput      pointer to memory for the transcoded images.
+ * @param[in]   outputSize   size of the memory at @p pOutput.
+ * @param[in]   params       how to run the transcode tasks.
+ *
+ * @return      KTX_SUCCESS or the error from ktxTexture2\_transcodeImage().
+ */
+static KTX_error_code
+ktxTexture2_transcodeImages(ktxTexture2* This,
+                            ktxTranscodeState& state,
+                            const std::vector<ktxTranscodeLevel>& levels,
+                            const std::vector<ktxTranscodeTask>& tasks,
+                            const ktx_uint8_t* pInput, ktx_size_t inputSize,
+                            ktx_uint8_t* pOutput, ktx_size_t outputSize,
+                            const ktxTranscodeParams& params)
+{
+    auto transcodeImages = [&](uint32_t taskIndex) -> KTX_error_code {
+        const ktxTranscodeTask& task = tasks[taskIndex];
+        const ktxTranscodeLevel& lvl = levels[task.level];
+        // basisu_transcoder_state is used to find the previous frame when
+        // decoding a video P-Frame. A task transcodes either a single image
+        // or, for video, all the frames of one face of a level in order so
+        // a state per task is sufficient.
+        basisu_transcoder_state xcoderState;
+
+        for (uint32_t i = 0, image = task.firstImage; i < task.imageCount;
+             i++, image += task.imageStride) {
+            uint64_t writeOffset = lvl.outputOffset
+                                 + image * lvl.outputImageByteLength;
+            KTX_error_code result;
+            result = ktxTexture2_transcodeImage(This, state, lvl,
+                                                task.level, image,
+                                                pInput, inputSize,
+                                                pOutput + writeOffset,
+                                                outputSize - writeOffset,
+                                                0, xcoderState);
+            if (result != KTX_SUCCESS)
+                return result;
+        }
+        return KTX_SUCCESS;
+    };
+
+    return ktxRunTranscodeTasks(params, (uint32_t)tasks.size(),
+                                transcodeImages);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode a KTX2 texture with BasisLZ/ETC1S or UASTC images.
+ *
+ * If the texture contains BasisLZ supercompressed images, Inflates them from
+ * back to ETC1S then transcodes them to the specified block-compressed
+ * format. If the texture contains UASTC images, inflates them, if they have been
+ * supercompressed with zstd, then transcodes then to the specified format, The
+ * transcoded images replace the original images and the texture's fields including
+ * the DFD are modified to reflect the new format.
+ *
+ * These types of textures must be transcoded to a desired target
+ * block-compressed format before they can be uploaded to a GPU via a
+ * graphics API.
+ *
+ * The following block compressed transcode targets are available: @c KTX_TTF_ETC1_RGB,
+ * @c KTX_TTF_ETC2_RGBA, @c KTX_TTF_BC1_RGB, @c KTX_TTF_BC3_RGBA,
+ * @c KTX_TTF_BC4_R, @c KTX_TTF_BC5_RG, @c KTX_TTF_BC7_RGBA,
+ * @c @c KTX_TTF_PVRTC1_4_RGB, @c KTX_TTF_PVRTC1_4_RGBA,
+ * @c KTX_TTF_PVRTC2_4_RGB, @c KTX_TTF_PVRTC2_4_RGBA, @c KTX_TTF_ASTC_4x4_RGBA,
+ * @c KTX_TTF_ETC2_EAC_R11, @c KTX_TTF_ETC2_EAC_RG11, @c KTX_TTF_ETC and
+ * @c KTX_TTF_BC1_OR_3.
  *
  * @c KTX_TTF_ETC automatically selects between @c KTX_TTF_ETC1_RGB and
  * @c KTX_TTF_ETC2_RGBA according to whether an alpha channel is available. @c KTX_TTF_BC1_OR_3
@@ -412,7 +878,8 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
  * @c KTX_TTF_PVRTC1_4_RGBA or @c KTX_TTF_PVRTC2_4_RGBA is specified and there is no alpha
  * channel @c KTX_TTF_PVRTC1_4_RGB or @c KTX_TTF_PVRTC2_4_RGB respectively will be selected.
  *
- * ATC & FXT1 formats are not supported by KTX2 & libktx as there are no equivalent Vulkan formats.
+ * Transcoding to ATC & FXT1 formats is not supported by libktx as there
+ * are no equivalent Vulkan formats.
  *
  * The following uncompressed transcode targets are also available: @c KTX_TTF_RGBA32,
  * @c KTX_TTF_RGB565, KTX_TTF_BGR565 and KTX_TTF_RGBA4444.
@@ -423,9 +890,9 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
  *
  * @param[in]   This         pointer to the ktxTexture2 object of interest.
  * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
- *                           specifying the target format.
+ *                                             specifying the target format.
  * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
- *                           operation. @sa ktx_texture_decode_flags_e.
+ *                                                operation. @sa ktx_texture_decode_flags_e.
  *
  * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
  *
@@ -443,297 +910,785 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
  * @exception KTX_INVALID_OPERATION
  *                              @p outputFormat is PVRTC1 but the texture does
  *                              does not have power-of-two dimensions.
+ * @exception KTX_INVALID_OPERATION
+ *                              The texture was encoded against shared ETC1S
+ *                              codebooks and matching ones have not been set
+ *                              with ktxTexture2_SetEtc1sCodebook().
  * @exception KTX_INVALID_VALUE @p outputFormat is invalid.
  * @exception KTX_TRANSCODE_FAILED
- *                              Something went wrong during transcoding. The
- *                              texture object will be corrupted.
+ *                              Something went wrong during transcoding.
  * @exception KTX_UNSUPPORTED_FEATURE
  *                              KTX_TF_PVRTC_DECODE_TO_NEXT_POW2 was requested
  *                              or the specified transcode target has not been
  *                              included in the library being used.
  * @exception KTX_OUT_OF_MEMORY Not enough memory to carry out transcoding.
  */
-KTX_error_code
-ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
-                             alpha_content_e alphaContent,
-                             ktxTexture2* prototype,
-                             ktx_transcode_fmt_e outputFormat,
-                             ktx_transcode_flags transcodeFlags)
+ KTX_error_code
+ ktxTexture2_TranscodeBasis(ktxTexture2* This,
+                            ktx_transcode_fmt_e outputFormat,
+                            ktx_transcode_flags transcodeFlags)
 {
-    DECLARE_PRIVATE(priv, This);
-    DECLARE_PRIVATE(protoPriv, prototype);
-    KTX_error_code result = KTX_SUCCESS;
+    ktxTranscodeParams params = {};
+    params.structSize = sizeof(params);
+    params.threadCount = 1;
+    return ktxTexture2_TranscodeBasisEx(This, outputFormat, transcodeFlags,
+                                        &params);
+}
 
-    assert(This->supercompressionScheme == KTX_SS_BASIS_LZ);
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode a KTX2 texture with BasisLZ/ETC1S or UASTC images using
+ *        multiple threads or an application supplied scheduler.
+ *
+ * Identical to ktxTexture2\_TranscodeBasis() except that the images, which
+ * are transcoded to separate locations, are split into tasks that are run
+ * concurrently, either on up to @c params->threadCount threads or by
+ * @c params->pfnScheduler. Each image is a task except for video where the
+ * frames of each face of a level are transcoded, in order, by a single task
+ * as P-frames depend on the preceding frame. If the image data has not yet
+ * been loaded it is inflated using the same number of threads.
+ *
+ * The transcoded data is the same whatever the number of threads.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
+ *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   params       pointer to a ktxTranscodeParams struct.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p params is NULL or @c params->structSize
+ *                              is not sizeof(ktxTranscodeParams).
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis().
+ */
+ KTX_error_code
+ ktxTexture2_TranscodeBasisEx(ktxTexture2* This,
+                              ktx_transcode_fmt_e outputFormat,
+                              ktx_transcode_flags transcodeFlags,
+                              ktxTranscodeParams* params)
+{
+    if (params == nullptr || params->structSize != sizeof(ktxTranscodeParams))
+        return KTX_INVALID_VALUE;
 
-    uint8_t* bgd = priv._supercompressionGlobalData;
-    ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
-    if (!(bgdh.endpointsByteLength && bgdh.selectorsByteLength && bgdh.tablesByteLength)) {
-        debug_printf("ktxTexture_TranscodeBasis: missing endpoints, selectors or tables");
-        return KTX_FILE_DATA_ERROR;
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat,
+                                             transcodeFlags, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (!This->pData) {
+        if (ktxTexture_isActiveStream((ktxTexture*)This)) {
+             // Load pending. Complete it.
+            ktx_uint32_t threadCount = 1;
+            if (!params->pfnScheduler && params->threadCount)
+                threadCount = params->threadCount;
+            result = ktxTexture2_LoadImageDataEx(This, NULL, 0, threadCount);
+            if (result != KTX_SUCCESS)
+                return result;
+        } else {
+            // No data to transcode.
+            return KTX_INVALID_OPERATION;
+        }
     }
 
-    // Compute some helpful numbers.
-    //
-    // firstImages contains the indices of the first images for each level to
-    // ease finding the correct slice description when iterating from smallest
-    // level to largest or when randomly accessing them (t.b.c). The last array
-    // entry contains the total number of images, for calculating the offsets
-    // of the endpoints, etc.
-    uint32_t* firstImages = new uint32_t[This->numLevels+1];
+    result = ktxTexture2_initTranscoder(This, state);
+    if (result != KTX_SUCCESS)
+        return result;
 
-    // Temporary invariant value
-    uint32_t layersFaces = This->numLayers * This->numFaces;
-    firstImages[0] = 0;
-    for (uint32_t level = 1; level <= This->numLevels; level++) {
-        // NOTA BENE: numFaces * depth is only reasonable because they can't
-        // both be > 1. I.e there are no 3d cubemaps.
-        firstImages[level] = firstImages[level - 1]
-                           + layersFaces * MAX(This->baseDepth >> (level - 1), 1);
+    result = ktxTexture2_createTranscodePrototype(This, state);
+    if (result != KTX_SUCCESS)
+        return result;
+    ktxTexture2* prototype = state.prototype;
+
+    std::vector<ktxTranscodeTask> tasks;
+    ktxTexture2_calcTranscodeTasks(This, 0, This->numLevels, tasks);
+    result = ktxTexture2_transcodeImages(This, state, state.levels, tasks,
+                                         This->pData, This->dataSize,
+                                         prototype->pData,
+                                         prototype->dataSize, *params);
+
+    if (result == KTX_SUCCESS) {
+        // Fix up the current texture
+        DECLARE_PRIVATE(priv, This);
+        DECLARE_PROTECTED(thisPrtctd, This);
+        DECLARE_PRIVATE(protoPriv, prototype);
+        DECLARE_PROTECTED(protoPrtctd, prototype);
+        ktxTexture2_setTranscodedLevelIndex(This, state.levels,
+                                            protoPriv._levelIndex);
+        memcpy(&thisPrtctd._formatSize, &protoPrtctd._formatSize,
+               sizeof(ktxFormatSize));
+        This->vkFormat = state.vkFormat;
+        This->isCompressed = prototype->isCompressed;
+        This->supercompressionScheme = KTX_SS_NONE;
+        priv._requiredLevelAlignment = protoPriv._requiredLevelAlignment;
+        // Copy the levelIndex from the prototype to This.
+        memcpy(priv._levelIndex, protoPriv._levelIndex,
+               This->numLevels * sizeof(ktxLevelIndexEntry));
+        // Move the DFD and data from the prototype to This.
+        free(This->pDfd);
+        This->pDfd = prototype->pDfd;
+        prototype->pDfd = 0;
+        ktxTexture2_freeImageData(This);
+        This->pData = prototype->pData;
+        This->dataSize = prototype->dataSize;
+        prototype->pData = 0;
+        prototype->dataSize = 0;
+        // Free SGD data
+        This->_private->_sgdByteLength = 0;
+        if (This->_private->_supercompressionGlobalData) {
+            free(This->_private->_supercompressionGlobalData);
+            This->_private->_supercompressionGlobalData = NULL;
+        }
     }
-    uint32_t& imageCount = firstImages[This->numLevels];
+    return result;
+ }
 
-    if (BGD_TABLES_ADDR(0, bgdh, imageCount) + bgdh.tablesByteLength > priv._sgdByteLength) {
-        return KTX_FILE_DATA_ERROR;
+/**
+ * @internal
+ * @~English
+ * @brief Size of the scratch memory needed to read @p level for transcoding.
+ *
+ * None is needed if the image data is loaded. Otherwise the level is read,
+ * inflated if necessary, into the start of the scratch memory. A Zstd or
+ * ZLIB supercompressed level is first read into the remainder.
+ */
+static ktx_size_t
+ktxTexture2_transcodeScratchSize(ktxTexture2* This, ktx_uint32_t level)
+{
+    const ktxLevelIndexEntry& entry = This->_private->_levelIndex[level];
+
+    if (This->pData)
+        return 0;
+    if (This->supercompressionScheme == KTX_SS_ZSTD
+        || This->supercompressionScheme == KTX_SS_ZLIB)
+        return entry.uncompressedByteLength + entry.byteLength;
+    return entry.byteLength;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Find the data of @p level to transcode.
+ *
+ * This is the loaded image data, if any, otherwise the level is read from the
+ * source stream into @p pScratch.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   level        the level of interest.
+ * @param[in]   pScratch     pointer to at least
+ *                           ktxTexture2\_transcodeScratchSize() bytes.
+ * @param[in]   scratchSize  size of the memory at @p pScratch.
+ * @param[out]  ppInput      pointer to a location in which to store a pointer
+ *                           to the level's data.
+ * @param[out]  pInputSize   pointer to a location in which to store the size
+ *                           of the level's data.
+ */
+static KTX_error_code
+ktxTexture2_transcodeInput(ktxTexture2* This, ktx_uint32_t level,
+                           ktx_uint8_t* pScratch, ktx_size_t scratchSize,
+                           const ktx_uint8_t** ppInput, ktx_size_t* pInputSize)
+{
+    DECLARE_PRIVATE(priv, This);
+
+    if (This->pData) {
+        ktx_uint64_t offset = ktxTexture2_levelDataOffset(This, level);
+        *pInputSize = priv._levelIndex[level].byteLength;
+        if (offset + *pInputSize > This->dataSize)
+            return KTX_FILE_DATA_ERROR;
+        *ppInput = This->pData + offset;
+    } else {
+        ktx_size_t levelCapacity = priv._levelIndex[level].byteLength;
+        if (This->supercompressionScheme == KTX_SS_ZSTD
+            || This->supercompressionScheme == KTX_SS_ZLIB)
+            levelCapacity = priv._levelIndex[level].uncompressedByteLength;
+        assert(scratchSize >= ktxTexture2_transcodeScratchSize(This, level));
+        KTX_error_code result;
+        result = ktxTexture2_readLevelInt(This, level,
+                                          pScratch, levelCapacity,
+                                          pScratch + levelCapacity,
+                                          scratchSize - levelCapacity,
+                                          pInputSize);
+        if (result != KTX_SUCCESS)
+            return result;
+        *ppInput = pScratch;
     }
-    // FIXME: Do more validation.
+    return KTX_SUCCESS;
+}
 
-    // Prepare low-level transcoder for transcoding slices.
-    basist::basisu_lowlevel_etc1s_transcoder bit;
+/**
+ * @internal
+ * @~English
+ * @brief Transcode the images of a single level into @p pBuffer.
+ *
+ * The level is transcoded from the loaded image data, if any, otherwise it
+ * is read from the source stream into @p pScratch.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   state        state prepared by ktxTexture2\_initTranscodeFormat()
+ *                           and ktxTexture2\_initTranscoder().
+ * @param[in]   level        the level to transcode.
+ * @param[in]   pScratch     pointer to at least
+ *                           ktxTexture2\_transcodeScratchSize() bytes.
+ * @param[in]   scratchSize  size of the memory at @p pScratch.
+ * @param[in]   pBuffer      pointer to memory for the transcoded level.
+ *                           Must be at least the level's transcoded size.
+ */
+static KTX_error_code
+ktxTexture2_transcodeLevelInt(ktxTexture2* This, ktxTranscodeState& state,
+                              ktx_uint32_t level,
+                              ktx_uint8_t* pScratch, ktx_size_t scratchSize,
+                              ktx_uint8_t* pBuffer)
+{
+    const ktx_uint8_t* pInput;
+    ktx_size_t inputSize;
+    KTX_error_code result;
+
+    result = ktxTexture2_transcodeInput(This, level, pScratch, scratchSize,
+                                        &pInput, &inputSize);
+    if (result != KTX_SUCCESS)
+        return result;
 
-    // basisu_transcoder_state is used to find the previous frame when
-    // decoding a video P-Frame. It tracks the previous frame for each mip
-    // level. For cube map array textures we need to find the previous frame
-    // for each face so we a state per face. Although providing this is only
-    // needed for video, it is easier to always pass our own.
-    std::vector<basisu_transcoder_state> xcoderStates;
-    xcoderStates.resize(This->isVideo ? This->numFaces : 1);
+    // Both the input and output hold only this level.
+    std::vector<ktxTranscodeLevel> levels(state.levels);
+    levels[level].inputOffset = 0;
+    levels[level].outputOffset = 0;
 
-    bit.decode_palettes(bgdh.endpointCount, BGD_ENDPOINTS_ADDR(bgd, imageCount),
-                        bgdh.endpointsByteLength,
-                        bgdh.selectorCount, BGD_SELECTORS_ADDR(bgd, bgdh, imageCount),
-                        bgdh.selectorsByteLength);
+    std::vector<ktxTranscodeTask> tasks;
+    ktxTexture2_calcTranscodeTasks(This, level, 1, tasks);
 
-    bit.decode_tables(BGD_TABLES_ADDR(bgd, bgdh, imageCount),
-                      bgdh.tablesByteLength);
+    ktxTranscodeParams params = {};
+    params.structSize = sizeof(params);
+    params.threadCount = 1;
+    return ktxTexture2_transcodeImages(This, state, levels, tasks,
+                                       pInput, inputSize,
+                                       pBuffer, levels[level].outputByteLength,
+                                       params);
+}
 
-    // Find matching VkFormat and calculate output sizes.
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Get the size of a level of a BasisLZ/ETC1S or UASTC texture after
+ *        transcoding.
+ *
+ * Use this to size the buffer given to ktxTexture2\_TranscodeLevel(). No
+ * image data is loaded or transcoded.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   level        mip level of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[out]  pLevelSize   pointer to location to store the size in bytes
+ *                           of all the images of @p level in the target
+ *                           format.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pLevelSize is NULL or @p level
+ *                              is not less than @c This->numLevels.
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis().
+ */
+KTX_error_code
+ktxTexture2_GetTranscodedLevelSize(ktxTexture2* This, ktx_uint32_t level,
+                                   ktx_transcode_fmt_e outputFormat,
+                                   ktx_size_t* pLevelSize)
+{
+    if (This == nullptr || pLevelSize == nullptr || level >= This->numLevels)
+        return KTX_INVALID_VALUE;
 
-    const bool isVideo = This->isVideo;
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat, 0, state);
+    if (result != KTX_SUCCESS)
+        return result;
 
-    ktx_uint8_t* pXcodedData = prototype->pData;
-    // Inconveniently, the output buffer size parameter of transcode_image
-    // has to be in pixels for uncompressed output and in blocks for
-    // compressed output. The only reason for humouring the API is so
-    // its buffer size tests provide a real check. An alternative is to
-    // always provide the size in bytes which will always pass.
-    ktx_uint32_t outputBlockByteLength
-                      = prototype->_protected->_formatSize.blockSizeInBits / 8;
-    ktx_size_t xcodedDataLength
-                      = prototype->dataSize / outputBlockByteLength;
-    ktxLevelIndexEntry* protoLevelIndex;
-    uint64_t levelOffsetWrite;
-    const ktxBasisLzEtc1sImageDesc* imageDescs = BGD_ETC1S_IMAGE_DESCS(bgd);
-
-    // Finally we're ready to transcode the slices.
-
-    // FIXME: Iframe flag needs to be queryable by the application. In Basis
-    // the app can query file_info and image_info from the transcoder which
-    // returns a structure with lots of info about the image.
-
-    protoLevelIndex = protoPriv._levelIndex;
-    levelOffsetWrite = 0;
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        uint64_t levelOffset = ktxTexture2_levelDataOffset(This, level);
-        uint64_t writeOffset = levelOffsetWrite;
-        uint64_t writeOffsetBlocks = levelOffsetWrite / outputBlockByteLength;
-        uint32_t levelWidth = MAX(1, This->baseWidth >> level);
-        uint32_t levelHeight = MAX(1, This->baseHeight >> level);
-        // ETC1S texel block dimensions
-        const uint32_t bw = 4, bh = 4;
-        uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
-        uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
-        uint32_t depth = MAX(1, This->baseDepth >> level);
-        //uint32_t faceSlices = This->numFaces == 1 ? depth : This->numFaces;
-        uint32_t faceSlices = This->numFaces * depth;
-        uint32_t numImages = This->numLayers * faceSlices;
-        uint32_t image = firstImages[level];
-        uint32_t endImage = image + numImages;
-        ktx_size_t levelImageSizeOut, levelSizeOut;
-        uint32_t stateIndex = 0;
-
-        levelSizeOut = 0;
-        // FIXME: Figure out a way to get the size out of the transcoder.
-        levelImageSizeOut = ktxTexture2_GetImageSize(prototype, level);
-        for (; image < endImage; image++) {
-            const ktxBasisLzEtc1sImageDesc& imageDesc = imageDescs[image];
-
-            basisu_transcoder_state& xcoderState = xcoderStates[stateIndex];
-            // We have face0 [face1 ...] within each layer. Use `stateIndex`
-            // rather than a double loop of layers and faceSlices as this
-            // works for 3d texture and non-array cube maps as well as
-            // cube map arrays without special casing.
-            if (++stateIndex == xcoderStates.size())
-                stateIndex = 0;
-
-            if (alphaContent != eNone)
-            {
-                // The slice descriptions should have alpha information.
-                if (imageDesc.alphaSliceByteOffset == 0
-                    || imageDesc.alphaSliceByteLength == 0)
-                    return KTX_FILE_DATA_ERROR;
-            }
+    *pLevelSize = state.levels[level].outputByteLength;
+    return KTX_SUCCESS;
+}
 
-            bool status;
-            status = bit.transcode_image(
-                      (transcoder_texture_format)outputFormat,
-                      pXcodedData + writeOffset,
-                      (uint32_t)(xcodedDataLength - writeOffsetBlocks),
-                      This->pData,
-                      (uint32_t)This->dataSize,
-                      levelBlocksX,
-                      levelBlocksY,
-                      levelWidth,
-                      levelHeight,
-                      level,
-                      (uint32_t)(levelOffset + imageDesc.rgbSliceByteOffset),
-                      imageDesc.rgbSliceByteLength,
-                      (uint32_t)(levelOffset + imageDesc.alphaSliceByteOffset),
-                      imageDesc.alphaSliceByteLength,
-                      transcodeFlags,
-                      alphaContent != eNone,
-                      isVideo,
-                      // Our P-Frame flag is in the same bit as
-                      // cSliceDescFlagsFrameIsIFrame. We have to
-                      // invert it to make it an I-Frame flag.
-                      //
-                      // API currently doesn't have any way to pass
-                      // the I-Frame flag.
-                      //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
-                      0, // output_row_pitch_in_blocks_or_pixels
-                      &xcoderState,
-                      0  // output_rows_in_pixels
-                      );
-            if (!status) {
-                result = KTX_TRANSCODE_FAILED;
-                goto cleanup;
-            }
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Get the size of the image data of a BasisLZ/ETC1S or UASTC texture
+ *        after transcoding.
+ *
+ * This is the @c dataSize the texture will have after
+ * ktxTexture2\_TranscodeBasis() to @p outputFormat, all the levels with
+ * any padding between them required by the target format. Use it to size
+ * memory for the transcoded data in advance. No image data is loaded or
+ * transcoded and no texture is created. The size of individual levels is
+ * given by ktxTexture2\_GetTranscodedLevelSize().
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[out]  pDataSize    pointer to location to store the size in bytes
+ *                           of all the levels in the target format.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pDataSize is NULL.
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis().
+ */
+KTX_error_code
+ktxTexture2_GetTranscodedSize(ktxTexture2* This,
+                              ktx_transcode_fmt_e outputFormat,
+                              ktx_size_t* pDataSize)
+{
+    if (This == nullptr || pDataSize == nullptr)
+        return KTX_INVALID_VALUE;
 
-            writeOffset += levelImageSizeOut;
-            levelSizeOut += levelImageSizeOut;
-        } // end images loop
-        protoLevelIndex[level].byteOffset = levelOffsetWrite;
-        protoLevelIndex[level].byteLength = levelSizeOut;
-        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
-        levelOffsetWrite += levelSizeOut;
-        assert(levelOffsetWrite == writeOffset);
-        // In case of transcoding to uncompressed.
-        levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
-                                     levelOffsetWrite);
-    } // level loop
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat, 0, state);
+    if (result != KTX_SUCCESS)
+        return result;
 
-    result = KTX_SUCCESS;
+    // Level 0 is the last level in the data.
+    *pDataSize = (ktx_size_t)(state.levels[0].outputOffset
+                              + state.levels[0].outputByteLength);
+    return KTX_SUCCESS;
+}
 
-cleanup:
-    delete[] firstImages;
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode a single level of a BasisLZ/ETC1S or UASTC texture into
+ *        application supplied memory.
+ *
+ * Transcodes all the images, i.e. every layer, face and depth slice, of
+ * @p level to @p outputFormat. They are written to @p pBuffer in the same
+ * order as in a KTX level, without padding. Unlike
+ * ktxTexture2\_TranscodeBasis() the texture is not modified so this can be
+ * called for any number of levels and formats.
+ *
+ * If the image data has not been loaded, only the data for @p level is read
+ * from the texture's source and, if it is Zstd or ZLIB supercompressed,
+ * inflated. Peak memory use is then about twice the size of the level,
+ * rather than the size of the whole texture plus the whole texture in the
+ * target format. Loading levels one at a time, smallest first, gets the
+ * first images to the GPU sooner. See also
+ * ktxTexture2\_IterateTranscodeLevels().
+ *
+ * Levels of a texture whose image data is loaded may be transcoded
+ * concurrently on different threads. Reading from the source is not thread
+ * safe.
+ *
+ * For the available @p outputFormat values and @p transcodeFlags see
+ * ktxTexture2\_TranscodeBasis(). The VkFormat of the transcoded data is the
+ * one ktxTexture2\_TranscodeBasis() would set.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   level        mip level to transcode.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
+ *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   pBuffer      pointer to memory for the transcoded images.
+ * @param[in]   bufSize      size of the memory at @p pBuffer. Must be at
+ *                           least the size given by
+ *                           ktxTexture2\_GetTranscodedLevelSize().
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pBuffer is NULL, @p level is not
+ *                              less than @c This->numLevels or @p bufSize is
+ *                              too small.
+ * @exception KTX_INVALID_OPERATION
+ *                              The image data is not loaded and the texture
+ *                              has no source from which to read it.
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis() and
+ * ktxTexture2\_LoadImageData().
+ */
+KTX_error_code
+ktxTexture2_TranscodeLevel(ktxTexture2* This, ktx_uint32_t level,
+                           ktx_transcode_fmt_e outputFormat,
+                           ktx_transcode_flags transcodeFlags,
+                           ktx_uint8_t* pBuffer, ktx_size_t bufSize)
+{
+    if (This == nullptr || pBuffer == nullptr || level >= This->numLevels)
+        return KTX_INVALID_VALUE;
+
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat,
+                                             transcodeFlags, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (bufSize < state.levels[level].outputByteLength)
+        return KTX_INVALID_VALUE;
+
+    if (!This->pData && !ktxTexture_isActiveStream((ktxTexture*)This))
+        return KTX_INVALID_OPERATION; // No data to transcode.
+
+    result = ktxTexture2_initTranscoder(This, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktx_size_t scratchSize = ktxTexture2_transcodeScratchSize(This, level);
+    ktx_uint8_t* pScratch = NULL;
+    if (scratchSize) {
+        pScratch = (ktx_uint8_t*)ktxContext_acquireBuffer(
+                                        This->_private->_context, scratchSize);
+        if (!pScratch)
+            return KTX_OUT_OF_MEMORY;
+    }
+    result = ktxTexture2_transcodeLevelInt(This, state, level,
+                                           pScratch, scratchSize, pBuffer);
+    ktxContext_releaseBuffer(This->_private->_context, pScratch);
     return result;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Get the row pitch and size of an image of a BasisLZ/ETC1S or UASTC
+ *        texture transcoded with rows aligned to @p rowAlignment.
+ *
+ * Use this to lay out, e.g., a staging buffer whose rows must be aligned
+ * for a copy to a GPU image and to size the buffer given to
+ * ktxTexture2\_TranscodeImage(). A row is a row of blocks for
+ * block-compressed formats and a row of pixels for uncompressed formats.
+ * No image data is loaded or transcoded.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   level        mip level of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   rowAlignment required alignment in bytes of the start of each
+ *                           row. Must be 0 or a power of 2. 0 or 1 give
+ *                           tightly packed rows.
+ * @param[out]  pRowPitch    pointer to a location in which to store the
+ *                           distance in bytes between the starts of rows.
+ * @param[out]  pImageSize   pointer to a location in which to store the size
+ *                           in bytes of an image laid out with
+ *                           @p *pRowPitch.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p pRowPitch or @p pImageSize is
+ *                              NULL, @p level is not less than
+ *                              @c This->numLevels or @p rowAlignment is not
+ *                              0 or a power of 2.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p outputFormat is PVRTC1, whose images can
+ *                              only be tightly packed, and @p rowAlignment
+ *                              would require padding.
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis().
+ */
+KTX_error_code
+ktxTexture2_GetTranscodedImageLayout(ktxTexture2* This, ktx_uint32_t level,
+                                     ktx_transcode_fmt_e outputFormat,
+                                     ktx_uint32_t rowAlignment,
+                                     ktx_uint32_t* pRowPitch,
+                                     ktx_size_t* pImageSize)
+{
+    if (This == nullptr || pRowPitch == nullptr || pImageSize == nullptr
+        || level >= This->numLevels
+        || (rowAlignment != 0 && !isPow2(rowAlignment)))
+        return KTX_INVALID_VALUE;
+
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat, 0, state);
+    if (result != KTX_SUCCESS)
+        return result;
 
+    ktx_uint32_t elementSize, rowElements, rows;
+    ktxTranscodedImageShape(state.formatSize, state.levels[level].width,
+                            state.levels[level].height,
+                            &elementSize, &rowElements, &rows);
+    ktx_uint32_t rowPitch = rowElements * elementSize;
+    if (rowAlignment > 1)
+        rowPitch = _KTX_PADN(rowAlignment, rowPitch);
+    if (rowPitch != rowElements * elementSize
+        && (state.outputFormat == KTX_TTF_PVRTC1_4_RGB
+            || state.outputFormat == KTX_TTF_PVRTC1_4_RGBA))
+        return KTX_INVALID_OPERATION;
+
+    *pRowPitch = rowPitch;
+    *pImageSize = (ktx_size_t)rowPitch * rows;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode a single image of a BasisLZ/ETC1S or UASTC texture into
+ *        application supplied memory with a given row pitch.
+ *
+ * Transcodes the image of @p layer and @p faceSlice of @p level to
+ * @p outputFormat, writing it directly to @p pBuffer, which can be, e.g.,
+ * persistently mapped GPU memory. No memory is allocated for the transcoded
+ * image and it is not copied. Rows, of blocks for block-compressed formats
+ * or of pixels for uncompressed formats, start @p rowPitch bytes apart.
+ * Bytes between the end of one row and the start of the next are not
+ * written. Use ktxTexture2\_GetTranscodedImageLayout() to find a pitch
+ * meeting an alignment requirement and the size of @p pBuffer it needs.
+ *
+ * The texture is not modified. If the image data has not been loaded, the
+ * data for @p level is read from the texture's source, as by
+ * ktxTexture2\_TranscodeLevel(). Images of a texture whose image data is
+ * loaded may be transcoded concurrently on different threads.
+ *
+ * A BasisLZ/ETC1S video P-frame depends on the preceding frames of the
+ * same face so, for such video, the frames of layers 0 to @p layer - 1 are
+ * transcoded into @p pBuffer in turn before the requested frame. UASTC
+ * video has no P-frames so only the requested frame is transcoded. Use
+ * ktxTexture2\_TranscodeLevel() or ktxTexture2\_IterateTranscodeLevels() to
+ * get every frame of a video efficiently.
+ *
+ * For the available @p outputFormat values and @p transcodeFlags see
+ * ktxTexture2\_TranscodeBasis(). The VkFormat of the transcoded data is the
+ * one ktxTexture2\_TranscodeBasis() would set.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   level        mip level of the image to transcode.
+ * @param[in]   layer        array layer of the image to transcode.
+ * @param[in]   faceSlice    cube map face or depth slice of the image to
+ *                           transcode.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
+ *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   pBuffer      pointer to memory for the transcoded image.
+ * @param[in]   bufSize      size of the memory at @p pBuffer. Must be at
+ *                           least @p rowPitch times the number of rows.
+ * @param[in]   rowPitch     distance in bytes between the starts of rows.
+ *                           Must be a multiple of the size of a block, or a
+ *                           pixel for uncompressed formats, and at least the
+ *                           size of a row. 0 for tightly packed rows.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pBuffer is NULL, @p level,
+ *                              @p layer or @p faceSlice is out of range,
+ *                              @p rowPitch is not valid for
+ *                              @p outputFormat or @p bufSize is too small.
+ * @exception KTX_INVALID_OPERATION
+ *                              The image data is not loaded and the texture
+ *                              has no source from which to read it.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p outputFormat is PVRTC1, whose images can
+ *                              only be tightly packed, and @p rowPitch is
+ *                              not 0 or the size of a row.
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis() and
+ * ktxTexture2\_LoadImageData().
+ */
 KTX_error_code
-ktxTexture2_transcodeUastc(ktxTexture2* This,
-                           alpha_content_e alphaContent,
-                           ktxTexture2* prototype,
+ktxTexture2_TranscodeImage(ktxTexture2* This, ktx_uint32_t level,
+                           ktx_uint32_t layer, ktx_uint32_t faceSlice,
                            ktx_transcode_fmt_e outputFormat,
-                           ktx_transcode_flags transcodeFlags)
+                           ktx_transcode_flags transcodeFlags,
+                           ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                           ktx_uint32_t rowPitch)
 {
-    assert(This->supercompressionScheme != KTX_SS_BASIS_LZ);
-
-    ktx_uint8_t* pXcodedData = prototype->pData;
-    ktx_uint32_t outputBlockByteLength
-                      = prototype->_protected->_formatSize.blockSizeInBits / 8;
-    ktx_size_t xcodedDataLength
-                      = prototype->dataSize / outputBlockByteLength;
-    DECLARE_PRIVATE(protoPriv, prototype);
-    ktxLevelIndexEntry* protoLevelIndex = protoPriv._levelIndex;
-    ktx_size_t levelOffsetWrite = 0;
-
-    basisu_lowlevel_uastc_transcoder uit;
-    // See comment on same declaration in transcodeEtc1s.
-    std::vector<basisu_transcoder_state> xcoderStates;
-    xcoderStates.resize(This->isVideo ? This->numFaces : 1);
-
-    for (ktx_int32_t level = This->numLevels - 1; level >= 0; level--)
-    {
-        ktx_uint32_t depth;
-        uint64_t writeOffset = levelOffsetWrite;
-        uint64_t writeOffsetBlocks = levelOffsetWrite / outputBlockByteLength;
-        ktx_size_t levelImageSizeIn, levelImageOffsetIn;
-        ktx_size_t levelImageSizeOut, levelSizeOut;
-        ktx_uint32_t levelImageCount;
-        uint32_t levelWidth = MAX(1, This->baseWidth >> level);
-        uint32_t levelHeight = MAX(1, This->baseHeight >> level);
-        // UASTC texel block dimensions
-        const uint32_t bw = 4, bh = 4;
-        uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
-        uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
-        uint32_t stateIndex = 0;
-
-        depth = MAX(1, This->baseDepth  >> level);
-
-        levelImageCount = This->numLayers * This->numFaces * depth;
-        levelImageSizeIn = ktxTexture_calcImageSize(ktxTexture(This), level,
-                                                    KTX_FORMAT_VERSION_TWO);
-        levelImageSizeOut = ktxTexture_calcImageSize(ktxTexture(prototype),
-                                                     level,
-                                                     KTX_FORMAT_VERSION_TWO);
-
-        levelImageOffsetIn = ktxTexture2_levelDataOffset(This, level);
-        levelSizeOut = 0;
-        bool status;
-        for (uint32_t image = 0; image < levelImageCount; image++) {
-            basisu_transcoder_state& xcoderState = xcoderStates[stateIndex];
-            // See comment before same lines in transcodeEtc1s.
-            if (++stateIndex == xcoderStates.size())
-                stateIndex = 0;
-
-            status = uit.transcode_image(
-                          (transcoder_texture_format)outputFormat,
-                          pXcodedData + writeOffset,
-                          (uint32_t)(xcodedDataLength - writeOffsetBlocks),
-                          This->pData,
-                          (uint32_t)This->dataSize,
-                          levelBlocksX,
-                          levelBlocksY,
-                          levelWidth,
-                          levelHeight,
-                          level,
-                          (uint32_t)levelImageOffsetIn,
-                          (uint32_t)levelImageSizeIn,
-                          transcodeFlags,
-                          alphaContent != eNone,
-                          This->isVideo, // is_video
-                          //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
-                          0, // output_row_pitch_in_blocks_or_pixels
-                          &xcoderState, // pState
-                          0, // output_rows_in_pixels,
-                          -1, // channel0
-                          -1  // channel1
-                          );
-            if (!status)
-                return KTX_TRANSCODE_FAILED;
-            writeOffset += levelImageSizeOut;
-            levelSizeOut += levelImageSizeOut;
-            levelImageOffsetIn += levelImageSizeIn;
+    if (This == nullptr || pBuffer == nullptr || level >= This->numLevels
+        || layer >= This->numLayers)
+        return KTX_INVALID_VALUE;
+    ktx_uint32_t depth = MAX(1, This->baseDepth >> level);
+    if (faceSlice >= This->numFaces * depth)
+        return KTX_INVALID_VALUE;
+
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat,
+                                             transcodeFlags, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktx_uint32_t elementSize, rowElements, rows;
+    ktxTranscodedImageShape(state.formatSize, state.levels[level].width,
+                            state.levels[level].height,
+                            &elementSize, &rowElements, &rows);
+    if (rowPitch == 0)
+        rowPitch = rowElements * elementSize;
+    if (rowPitch % elementSize != 0 || rowPitch < rowElements * elementSize)
+        return KTX_INVALID_VALUE;
+    if (rowPitch != rowElements * elementSize
+        && (state.outputFormat == KTX_TTF_PVRTC1_4_RGB
+            || state.outputFormat == KTX_TTF_PVRTC1_4_RGBA))
+        return KTX_INVALID_OPERATION;
+    ktx_size_t imageSize = (ktx_size_t)rowPitch * rows;
+    if (bufSize < imageSize)
+        return KTX_INVALID_VALUE;
+
+    if (!This->pData && !ktxTexture_isActiveStream((ktxTexture*)This))
+        return KTX_INVALID_OPERATION; // No data to transcode.
+
+    result = ktxTexture2_initTranscoder(This, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktx_size_t scratchSize = ktxTexture2_transcodeScratchSize(This, level);
+    ktx_uint8_t* pScratch = NULL;
+    if (scratchSize) {
+        pScratch = (ktx_uint8_t*)ktxContext_acquireBuffer(
+                                        This->_private->_context, scratchSize);
+        if (!pScratch)
+            return KTX_OUT_OF_MEMORY;
+    }
+
+    const ktx_uint8_t* pInput;
+    ktx_size_t inputSize;
+    result = ktxTexture2_transcodeInput(This, level, pScratch, scratchSize,
+                                        &pInput, &inputSize);
+    if (result == KTX_SUCCESS) {
+        // The input holds only this level.
+        ktxTranscodeLevel lvl = state.levels[level];
+        lvl.inputOffset = 0;
+
+        // Images are ordered face or depth slice within layer. For video,
+        // layers are frames and each ETC1S P-frame needs the ones before it.
+        // UASTC has no P-frames.
+        ktx_uint32_t imagesPerLayer = This->numFaces * depth;
+        ktx_uint32_t firstLayer = This->isVideo
+                                  && state.textureFormat
+                                     == basis_tex_format::cETC1S
+                                ? 0 : layer;
+        basisu_transcoder_state xcoderState;
+        for (ktx_uint32_t l = firstLayer; l <= layer; l++) {
+            result = ktxTexture2_transcodeImage(This, state, lvl, level,
+                                                l * imagesPerLayer + faceSlice,
+                                                pInput, inputSize,
+                                                pBuffer, imageSize,
+                                                rowPitch / elementSize,
+                                                xcoderState);
+            if (result != KTX_SUCCESS)
+                break;
         }
-        protoLevelIndex[level].byteOffset = levelOffsetWrite;
-        // writeOffset will be equal to total size of the images in the level.
-        protoLevelIndex[level].byteLength = levelSizeOut;
-        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
-        levelOffsetWrite += levelSizeOut;
     }
-    // In case of transcoding to uncompressed.
-    levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
-                                 levelOffsetWrite);
-    return KTX_SUCCESS;
+    ktxContext_releaseBuffer(This->_private->_context, pScratch);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode the levels of a BasisLZ/ETC1S or UASTC texture one at a
+ *        time, smallest first, passing each to a callback.
+ *
+ * Works like ktxTexture2\_IterateLoadLevelFaces() except that the images
+ * are transcoded to @p outputFormat before being passed to @p iterCb.
+ * Each level is read, inflated and transcoded only when it is reached, using
+ * memory for a single level that is reused for every level, so the first
+ * levels can be uploaded while the data of the larger ones has not yet been
+ * read. As with ktxTexture2\_IterateLoadLevelFaces(), the faces of a
+ * non-array cubemap are passed separately. Otherwise the entire level is
+ * passed at once.
+ *
+ * The texture is not modified and its source remains available so, unlike
+ * ktxTexture2\_IterateLoadLevelFaces(), this can be called again. If the
+ * image data is already loaded it is transcoded from there. The data passed
+ * to @p iterCb is only valid until the callback returns.
+ *
+ * For the available @p outputFormat values and @p transcodeFlags see
+ * ktxTexture2\_TranscodeBasis().
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
+ *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   iterCb       the address of a callback function which is
+ *                           called with the data for each level or face.
+ * @param[in,out] userdata   the address of application-specific data which
+ *                           is passed to the callback along with the image
+ *                           data.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error. The
+ *          following are returned directly by this function. @p iterCb may
+ *          return these for other causes or may return additional errors.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p iterCb is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              The image data is not loaded and the texture
+ *                              has no source from which to read it.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for a level.
+ *
+ * For other exceptions see ktxTexture2\_TranscodeBasis() and
+ * ktxTexture2\_LoadImageData().
+ */
+KTX_error_code
+ktxTexture2_IterateTranscodeLevels(ktxTexture2* This,
+                                   ktx_transcode_fmt_e outputFormat,
+                                   ktx_transcode_flags transcodeFlags,
+                                   PFNKTXITERCB iterCb, void* userdata)
+{
+    if (This == nullptr || iterCb == nullptr)
+        return KTX_INVALID_VALUE;
+
+    ktxTranscodeState state;
+    KTX_error_code result;
+    result = ktxTexture2_initTranscodeFormat(This, outputFormat,
+                                             transcodeFlags, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (!This->pData && !ktxTexture_isActiveStream((ktxTexture*)This))
+        return KTX_INVALID_OPERATION; // No data to transcode.
+
+    result = ktxTexture2_initTranscoder(This, state);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    // Allocate memory sufficient for the largest level.
+    ktx_size_t levelSize = 0, scratchSize = 0;
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+        levelSize = MAX(levelSize, state.levels[level].outputByteLength);
+        scratchSize = MAX(scratchSize,
+                          ktxTexture2_transcodeScratchSize(This, level));
+    }
+    ktx_uint8_t* pLevel = (ktx_uint8_t*)ktxContext_acquireBuffer(
+                            This->_private->_context, levelSize + scratchSize);
+    if (!pLevel)
+        return KTX_OUT_OF_MEMORY;
+    ktx_uint8_t* pScratch = pLevel + levelSize;
+
+    for (ktx_int32_t level = This->numLevels - 1; level >= 0; --level) {
+        const ktxTranscodeLevel& lvl = state.levels[level];
+        int depth = MAX(1, This->baseDepth >> level);
+
+        result = ktxTexture2_transcodeLevelInt(This, state, level,
+                                               pScratch, scratchSize, pLevel);
+        if (result != KTX_SUCCESS)
+            break;
+
+        if (This->isCubemap && !This->isArray) {
+            ktx_uint8_t* pFace = pLevel;
+            for (ktx_uint32_t face = 0; face < This->numFaces; ++face) {
+                result = iterCb(level, face, lvl.width, lvl.height, depth,
+                                lvl.outputImageByteLength, pFace, userdata);
+                if (result != KTX_SUCCESS)
+                    break;
+                pFace += lvl.outputImageByteLength;
+            }
+        } else {
+            result = iterCb(level, 0, lvl.width, lvl.height, depth,
+                            lvl.outputByteLength, pLevel, userdata);
+        }
+        if (result != KTX_SUCCESS)
+            break;
+    }
+
+    ktxContext_releaseBuffer(This->_private->_context, pLevel);
+    return result;
 }
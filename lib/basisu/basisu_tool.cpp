@@ -32,6 +32,15 @@
 #define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
 #include "encoder/basisu_miniz.h"
 
+#if BASISU_SUPPORT_SSE
+#define CPPSPMD_NAME(a) a##_sse41
+#include "encoder/basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#define CPPSPMD_NAME(a) a##_avx2
+#include "encoder/basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#endif
+
 // Set BASISU_CATCH_EXCEPTIONS if you want exceptions to crash the app, otherwise main() catches them.
 #ifndef BASISU_CATCH_EXCEPTIONS
 	#define BASISU_CATCH_EXCEPTIONS 0
@@ -55,7 +64,9 @@ enum tool_mode
 	cCompSize,
 	cTest,
 	cSplitImage,
-	cCombineImages
+	cCombineImages,
+	cJobPoolBench,
+	cKernelBench
 };
 
 static void print_usage()
@@ -105,6 +116,9 @@ static void print_usage()
 		" -framerate X: Set framerate in .basis header to X/frames sec.\n"
 		" -individual: Process input images individually and output multiple .basis/.ktx2 files (not as a texture array - this is now the default as of v1.16)\n"
 		" -tex_array: Process input images as a single texture array and write a single .basis/.ktx2 file (the former default before v1.16)\n"
+		" -target_psnr X: Search for the lowest -q (ETC1S) or highest -uastc_rdo_l (UASTC) whose output still has an RGB (RGBA for UASTC with alpha) PSNR of at least X dB in every slice.\n"
+		" -target_ssim X: Like -target_psnr, but the target is a Rec. 709 luma SSIM of X, in [0,1].\n"
+		" -target_trials X: Set the maximum number of encodes -target_psnr/-target_ssim tries. Range is [1,32], default is 8.\n"
 		" -comp_level X: Set ETC1S encoding speed vs. quality tradeoff. Range is 0-6, default is 1. Higher values=MUCH slower, but slightly higher quality. Higher levels intended for videos. Use -q first!\n"
 		" -fuzz_testing: Use with -validate: Disables CRC16 validation of file contents before transcoding\n"
 		"\nUASTC options:\n"
@@ -114,6 +128,7 @@ static void print_usage()
 		"                 compressed files, higher values=lower quality/smaller LZ compressed files. Good range to try is [.25-10].\n"
 		"                 Note: Previous versons used the -uastc_rdo_q option, which was removed because the RDO algorithm was changed.\n"
 		" -uastc_rdo_d X: Set UASTC RDO dictionary size in bytes. Default is 4096, max is 65536. Lower values=faster, but less compression.\n"
+		" -uastc_rdo_c X: Set the maximum number of distinct selector patterns UASTC RDO tries per block. Default is 0, all in the dictionary. Lower values=faster, but less compression.\n"
 		" -uastc_rdo_b X: Set UASTC RDO max smooth block error scale. Range is [1,300]. Default is 10.0, 1.0=disabled. Larger values suppress more artifacts (and allocate more bits) on smooth blocks.\n"
 		" -uastc_rdo_s X: Set UASTC RDO max smooth block standard deviation. Range is [.01,65536]. Default is 18.0. Larger values expand the range of blocks considered smooth.\n"
 		" -uastc_rdo_f: Don't favor simpler UASTC modes in RDO mode.\n"
@@ -140,9 +155,12 @@ static void print_usage()
 		" -disable_hierarchical_endpoint_codebooks: Disable hierarchical endpoint codebook usage, slower but higher quality on some compression levels\n"
 		" -compare_ssim: Compute and display SSIM of image comparison (slow)\n"
 		" -bench: UASTC benchmark mode, for development only\n"
+		" -job_pool_bench: Measure job pool scaling from 1 thread up to -max_threads (default: all hardware threads), for development only\n"
+		" -kernel_bench: Measure the throughput of the SSE 4.1 and AVX2 builds of the SIMD encoder kernels, for development only\n"
 		" -resample X Y: Resample all input textures to XxY pixels using a box filter\n"
 		" -resample_factor X: Resample all input textures by scale factor X using a box filter\n"
 		" -no_sse: Forbid all SSE instruction set usage\n"
+		" -no_avx2: Use the SSE 4.1 build of the SIMD encoder kernels even if the CPU supports AVX2\n"
 		" -validate_etc1s: Validate internal ETC1S compressor's data structures during compression (slower, intended for development).\n"
 		"\n"
 		"Mipmap generation options:\n"
@@ -359,6 +377,10 @@ public:
 				m_compare_ssim = true;
 			else if (strcasecmp(pArg, "-bench") == 0)
 				m_mode = cBench;
+			else if (strcasecmp(pArg, "-job_pool_bench") == 0)
+				m_mode = cJobPoolBench;
+			else if (strcasecmp(pArg, "-kernel_bench") == 0)
+				m_mode = cKernelBench;
 			else if (strcasecmp(pArg, "-comp_size") == 0)
 				m_mode = cCompSize;
 			else if (strcasecmp(pArg, "-test") == 0)
@@ -373,6 +395,13 @@ public:
 			{
 #if BASISU_SUPPORT_SSE
 				g_cpu_supports_sse41 = false;
+				g_cpu_supports_avx2 = false;
+#endif
+			}
+			else if (strcasecmp(pArg, "-no_avx2") == 0)
+			{
+#if BASISU_SUPPORT_SSE
+				g_cpu_supports_avx2 = false;
 #endif
 			}
 			else if (strcasecmp(pArg, "-no_status_output") == 0)
@@ -453,6 +482,12 @@ public:
 				m_comp_params.m_rdo_uastc_dict_size = atoi(arg_v[arg_index + 1]);
 				arg_count++;
 			}
+			else if (strcasecmp(pArg, "-uastc_rdo_c") == 0)
+			{
+				REMAINING_ARGS_CHECK(1);
+				m_comp_params.m_rdo_uastc_max_candidates = atoi(arg_v[arg_index + 1]);
+				arg_count++;
+			}
 			else if (strcasecmp(pArg, "-uastc_rdo_b") == 0)
 			{
 				REMAINING_ARGS_CHECK(1);
@@ -479,6 +514,26 @@ public:
 				m_comp_params.m_quality_level = clamp<int>(atoi(arg_v[arg_index + 1]), BASISU_QUALITY_MIN, BASISU_QUALITY_MAX);
 				arg_count++;
 			}
+			else if (strcasecmp(pArg, "-target_psnr") == 0)
+			{
+				REMAINING_ARGS_CHECK(1);
+				m_comp_params.m_target_metric = cTargetMetricPSNR;
+				m_comp_params.m_target_metric_value = (float)atof(arg_v[arg_index + 1]);
+				arg_count++;
+			}
+			else if (strcasecmp(pArg, "-target_ssim") == 0)
+			{
+				REMAINING_ARGS_CHECK(1);
+				m_comp_params.m_target_metric = cTargetMetricSSIM;
+				m_comp_params.m_target_metric_value = (float)atof(arg_v[arg_index + 1]);
+				arg_count++;
+			}
+			else if (strcasecmp(pArg, "-target_trials") == 0)
+			{
+				REMAINING_ARGS_CHECK(1);
+				m_comp_params.m_target_max_trials = atoi(arg_v[arg_index + 1]);
+				arg_count++;
+			}
 			else if (strcasecmp(pArg, "-output_file") == 0)
 			{
 				REMAINING_ARGS_CHECK(1);
@@ -4163,6 +4218,283 @@ static uint32_t compute_miniz_compressed_size(const char* pFilename, uint32_t &o
 	return (uint32_t)comp_size;
 }
 
+// Stand-in for the work done by an encoder job: a dependent chain of integer ops the compiler can't fold away.
+static uint32_t job_pool_bench_work(uint32_t seed, uint32_t iters)
+{
+	uint32_t x = seed | 1;
+	for (uint32_t i = 0; i < iters; i++)
+		x = x * 1664525U + 1013904223U + (x >> 13);
+	return x;
+}
+
+static bool job_pool_bench_mode(command_line_params& opts)
+{
+	uint32_t max_threads = opts.m_max_threads;
+	if (max_threads >= 1024)
+		max_threads = std::max(1U, std::thread::hardware_concurrency());
+
+	// Fine grained jobs like the frontend's and uastc_rdo's stress the scheduler, coarse ones show the best case.
+	const uint32_t TOTAL_FINE_JOBS = 100000, FINE_JOB_ITERS = 200;
+	const uint32_t TOTAL_COARSE_JOBS = 2000, COARSE_JOB_ITERS = 100000;
+	const uint32_t TOTAL_RANGE_ITEMS = 1000000, RANGE_ITEM_ITERS = 50;
+	const uint32_t TOTAL_GRAPH_LAYERS = 200, GRAPH_LAYER_WIDTH = 64, GRAPH_JOB_ITERS = 2000;
+
+	std::vector<uint32_t> thread_counts;
+	for (uint32_t t = 1; t < max_threads; t *= 2)
+		thread_counts.push_back(t);
+	thread_counts.push_back(max_threads);
+
+	printf("Hardware threads: %u\n", std::thread::hardware_concurrency());
+	printf("%8s %13s %13s %13s %13s\n", "Threads", "Fine ms", "Coarse ms", "Range ms", "Graph ms");
+
+	double base_ms[4] = { 0, 0, 0, 0 };
+	std::atomic<uint32_t> sink(0);
+
+	for (uint32_t ti = 0; ti < thread_counts.size(); ti++)
+	{
+		const uint32_t num_threads = thread_counts[ti];
+		job_pool jpool(num_threads);
+		double ms[4];
+		interval_timer tm;
+
+		tm.start();
+		for (uint32_t i = 0; i < TOTAL_FINE_JOBS; i++)
+			jpool.add_job([i, &sink] { sink += job_pool_bench_work(i, FINE_JOB_ITERS); });
+		jpool.wait_for_all();
+		ms[0] = tm.get_elapsed_ms();
+
+		tm.start();
+		for (uint32_t i = 0; i < TOTAL_COARSE_JOBS; i++)
+			jpool.add_job([i, &sink] { sink += job_pool_bench_work(i, COARSE_JOB_ITERS); });
+		jpool.wait_for_all();
+		ms[1] = tm.get_elapsed_ms();
+
+		tm.start();
+		jpool.parallel_for(0, TOTAL_RANGE_ITEMS, [&sink](uint32_t first, uint32_t last) {
+			uint32_t x = 0;
+			for (uint32_t i = first; i < last; i++)
+				x += job_pool_bench_work(i, RANGE_ITEM_ITERS);
+			sink += x;
+		});
+		ms[2] = tm.get_elapsed_ms();
+
+		// Layers of jobs each depending on two jobs of the previous layer.
+		tm.start();
+		{
+			std::vector<job_pool::job_handle> prev(GRAPH_LAYER_WIDTH), cur(GRAPH_LAYER_WIDTH);
+			for (uint32_t l = 0; l < TOTAL_GRAPH_LAYERS; l++)
+			{
+				for (uint32_t i = 0; i < GRAPH_LAYER_WIDTH; i++)
+				{
+					const job_pool::job_handle deps[2] = { prev[i], prev[(i + 1) % GRAPH_LAYER_WIDTH] };
+					cur[i] = jpool.add_job([i, &sink] { sink += job_pool_bench_work(i, GRAPH_JOB_ITERS); }, deps, 2);
+				}
+				prev.swap(cur);
+			}
+		}
+		jpool.wait_for_all();
+		ms[3] = tm.get_elapsed_ms();
+
+		if (!ti)
+			memcpy(base_ms, ms, sizeof(ms));
+
+		printf("%8u %7.1f %4.1fx %7.1f %4.1fx %7.1f %4.1fx %7.1f %4.1fx\n", num_threads,
+			ms[0], base_ms[0] / ms[0], ms[1], base_ms[1] / ms[1], ms[2], base_ms[2] / ms[2], ms[3], base_ms[3] / ms[3]);
+	}
+
+	// Keep the work from being optimized away.
+	debug_printf("%u\n", sink.load());
+
+	return true;
+}
+
+#if BASISU_SUPPORT_SSE
+// The SIMD encoder kernels built for one instruction set.
+struct kernel_bench_isa
+{
+	const char* m_pName;
+	bool m_supported;
+	decltype(&perceptual_distance_rgb_4_N_sse41) m_perceptual_distance;
+	decltype(&find_selectors_perceptual_rgb_4_N_sse41) m_find_selectors_perceptual;
+	decltype(&find_lowest_error_perceptual_rgb_4_N_sse41) m_find_lowest_error_perceptual;
+	decltype(&update_covar_matrix_16x16_sse41) m_update_covar_matrix;
+	decltype(&resample_rgba_row_x_sse41) m_resample_rgba_row_x;
+};
+
+// Calls func() iters times, returns ns per call.
+template<typename F>
+static double kernel_bench_time(F&& func, uint32_t iters)
+{
+	interval_timer tm;
+	tm.start();
+	for (uint32_t i = 0; i < iters; i++)
+		func(i);
+	return tm.get_elapsed_secs() * 1e+9 / iters;
+}
+#endif
+
+static bool kernel_bench_mode(command_line_params& opts)
+{
+	BASISU_NOTE_UNUSED(opts);
+
+#if BASISU_SUPPORT_SSE
+	if (!g_cpu_supports_sse41)
+	{
+		error_printf("The SIMD kernels need SSE 4.1, which is not supported or was disabled\n");
+		return false;
+	}
+
+	const kernel_bench_isa isas[] =
+	{
+		{ "SSE 4.1", true, perceptual_distance_rgb_4_N_sse41, find_selectors_perceptual_rgb_4_N_sse41, find_lowest_error_perceptual_rgb_4_N_sse41, update_covar_matrix_16x16_sse41, resample_rgba_row_x_sse41 },
+		{ "AVX2", g_cpu_supports_avx2, perceptual_distance_rgb_4_N_avx2, find_selectors_perceptual_rgb_4_N_avx2, find_lowest_error_perceptual_rgb_4_N_avx2, update_covar_matrix_16x16_avx2, resample_rgba_row_x_avx2 }
+	};
+	const uint32_t num_isas = sizeof(isas) / sizeof(isas[0]);
+
+	const uint32_t NUM_BLOCKS = 4096, BLOCK_ITERS = 2000000;
+	const uint32_t NUM_TRAINING_VECS = 4096, COVAR_ITERS = 200;
+	const uint32_t RESAMPLE_SRC_W = 4096, RESAMPLE_DST_W = 2048, RESAMPLE_TAPS = 12, RESAMPLE_ITERS = 2000;
+
+	basisu::rand r;
+	r.seed(1);
+
+	basisu::vector<color_rgba> pixels(NUM_BLOCKS * 16), block_colors(NUM_BLOCKS * 4);
+	for (uint32_t i = 0; i < pixels.size(); i++)
+		pixels[i].set(r.byte(), r.byte(), r.byte(), 255);
+	for (uint32_t i = 0; i < block_colors.size(); i++)
+		block_colors[i].set(r.byte(), r.byte(), r.byte(), 255);
+
+	basisu::vector<uint8_t> selectors(NUM_BLOCKS * 16);
+	for (uint32_t i = 0; i < selectors.size(); i++)
+		selectors[i] = (uint8_t)r.irand(0, 3);
+
+	basisu::vector< std::pair<vec16F, uint64_t> > training_vecs(NUM_TRAINING_VECS);
+	uint_vec training_indices(NUM_TRAINING_VECS);
+	for (uint32_t i = 0; i < NUM_TRAINING_VECS; i++)
+	{
+		for (uint32_t j = 0; j < 16; j++)
+			training_vecs[i].first[j] = r.frand(0.0f, 1.0f);
+		training_vecs[i].second = r.irand(1, 16);
+		training_indices[i] = r.irand(0, NUM_TRAINING_VECS - 1);
+	}
+	vec16F origin;
+	for (uint32_t j = 0; j < 16; j++)
+		origin[j] = .5f;
+
+	std::vector<float> src_row(RESAMPLE_SRC_W * 4), dst_row(RESAMPLE_DST_W * 4);
+	for (uint32_t i = 0; i < src_row.size(); i++)
+		src_row[i] = r.frand(0.0f, 1.0f);
+	uint_vec first(RESAMPLE_DST_W + 1), pixel_indices(RESAMPLE_DST_W * RESAMPLE_TAPS);
+	std::vector<float> weights(RESAMPLE_DST_W * RESAMPLE_TAPS);
+	for (uint32_t x = 0; x <= RESAMPLE_DST_W; x++)
+		first[x] = x * RESAMPLE_TAPS;
+	for (uint32_t i = 0; i < pixel_indices.size(); i++)
+	{
+		pixel_indices[i] = clamp<int>((int)((i / RESAMPLE_TAPS) * 2 + (i % RESAMPLE_TAPS)) - (int)RESAMPLE_TAPS / 2, 0, RESAMPLE_SRC_W - 1);
+		weights[i] = 1.0f / RESAMPLE_TAPS;
+	}
+
+	printf("%-30s", "ns per call");
+	for (uint32_t i = 0; i < num_isas; i++)
+		printf(" %14s", isas[i].m_pName);
+	printf("\n");
+
+	const char* kernel_names[] = { "perceptual_distance_rgb_4_N", "find_selectors_perceptual_rgb_4_N", "find_lowest_error_perceptual_rgb_4_N", "update_covar_matrix_16x16", "resample_rgba_row_x" };
+	const uint32_t num_kernels = sizeof(kernel_names) / sizeof(kernel_names[0]);
+
+	bool all_match = true;
+
+	for (uint32_t k = 0; k < num_kernels; k++)
+	{
+		printf("%-30s", kernel_names[k]);
+
+		double base_ns = 0.0f;
+		int64_t base_check = 0;
+
+		for (uint32_t i = 0; i < num_isas; i++)
+		{
+			const kernel_bench_isa& isa = isas[i];
+			if (!isa.m_supported)
+			{
+				printf(" %14s", "n/a");
+				continue;
+			}
+
+			// Sum of the results, to check the builds agree and to keep the calls from being optimized away.
+			int64_t check = 0;
+			double ns = 0.0f;
+
+			switch (k)
+			{
+			case 0:
+				ns = kernel_bench_time([&](uint32_t iter) {
+					const uint32_t b = iter & (NUM_BLOCKS - 1);
+					int64_t err;
+					isa.m_perceptual_distance(&err, &selectors[b * 16], &block_colors[b * 4], &pixels[b * 16], 16, INT64_MAX);
+					check += err;
+				}, BLOCK_ITERS);
+				break;
+			case 1:
+				ns = kernel_bench_time([&](uint32_t iter) {
+					const uint32_t b = iter & (NUM_BLOCKS - 1);
+					int64_t err;
+					uint8_t sels[16];
+					isa.m_find_selectors_perceptual(&err, sels, &block_colors[b * 4], &pixels[b * 16], 16, INT64_MAX);
+					check += err + sels[iter & 15];
+				}, BLOCK_ITERS);
+				break;
+			case 2:
+				ns = kernel_bench_time([&](uint32_t iter) {
+					const uint32_t b = iter & (NUM_BLOCKS - 1);
+					int64_t err;
+					isa.m_find_lowest_error_perceptual(&err, &block_colors[b * 4], &pixels[b * 16], 16, INT64_MAX);
+					check += err;
+				}, BLOCK_ITERS);
+				break;
+			case 3:
+				ns = kernel_bench_time([&](uint32_t iter) {
+					BASISU_NOTE_UNUSED(iter);
+					float matrix[16 * 16];
+					isa.m_update_covar_matrix(NUM_TRAINING_VECS, training_vecs.data(), origin.get_ptr(), training_indices.data(), matrix);
+					for (uint32_t j = 0; j < 16 * 16; j++)
+						check += (int64_t)matrix[j];
+				}, COVAR_ITERS);
+				break;
+			case 4:
+				ns = kernel_bench_time([&](uint32_t iter) {
+					BASISU_NOTE_UNUSED(iter);
+					isa.m_resample_rgba_row_x(dst_row.data(), src_row.data(), RESAMPLE_DST_W, first.data(), pixel_indices.data(), weights.data());
+					check += (int64_t)(dst_row[iter & (dst_row.size() - 1)] * 1e+6f);
+				}, RESAMPLE_ITERS);
+				break;
+			}
+
+			if (!i)
+			{
+				base_ns = ns;
+				base_check = check;
+				printf(" %14.1f", ns);
+			}
+			else
+			{
+				if (check != base_check)
+					all_match = false;
+				printf(" %8.1f %4.2fx", ns, base_ns / ns);
+			}
+		}
+
+		printf("\n");
+	}
+
+	printf("Results of all builds match: %u\n", all_match);
+
+	return all_match;
+#else
+	error_printf("The SIMD kernels are not compiled in (BASISU_SUPPORT_SSE=0)\n");
+	return false;
+#endif
+}
+
 static bool compsize_mode(command_line_params& opts)
 {
 	if (opts.m_input_filenames.size() != 1)
@@ -4395,7 +4727,7 @@ static int main_internal(int argc, const char **argv)
 	}
 
 #if BASISU_SUPPORT_SSE
-	printf("Using SSE 4.1: %u, Multithreading: %u, Zstandard support: %u, OpenCL: %u\n", g_cpu_supports_sse41, (uint32_t)opts.m_comp_params.m_multithreading, basist::basisu_transcoder_supports_ktx2_zstd(), opencl_is_available());
+	printf("Using SSE 4.1: %u, AVX2: %u, Multithreading: %u, Zstandard support: %u, OpenCL: %u\n", g_cpu_supports_sse41, g_cpu_supports_avx2, (uint32_t)opts.m_comp_params.m_multithreading, basist::basisu_transcoder_supports_ktx2_zstd(), opencl_is_available());
 #else
 	printf("Multithreading: %u, Zstandard support: %u, OpenCL: %u\n", (uint32_t)opts.m_comp_params.m_multithreading, basist::basisu_transcoder_supports_ktx2_zstd(), opencl_is_available());
 #endif
@@ -4451,6 +4783,12 @@ static int main_internal(int argc, const char **argv)
 	case cCombineImages:
 		status = combine_images_mode(opts);
 		break;
+	case cJobPoolBench:
+		status = job_pool_bench_mode(opts);
+		break;
+	case cKernelBench:
+		status = kernel_bench_mode(opts);
+		break;
 	default:
 		assert(0);
 		break;
@@ -20,6 +20,9 @@
 #if BASISU_SUPPORT_SSE
 #define CPPSPMD_NAME(a) a##_sse41
 #include "basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#define CPPSPMD_NAME(a) a##_avx2
+#include "basisu_kernels_declares.h"
 #endif
 
 #define BASISU_FASTER_SELECTOR_REORDERING 0
@@ -963,11 +966,11 @@ namespace basisu
 										int64_t trial_err;
 										if (r.get_params().m_perceptual)
 										{
-											perceptual_distance_rgb_4_N_sse41(&trial_err, block_selectors, block_colors, src_pixels.get_ptr(), 16, best_trial_err);
+											BASISU_SPMD_KERNEL(perceptual_distance_rgb_4_N)(&trial_err, block_selectors, block_colors, src_pixels.get_ptr(), 16, best_trial_err);
 										}
 										else
 										{
-											linear_distance_rgb_4_N_sse41(&trial_err, block_selectors, block_colors, src_pixels.get_ptr(), 16, best_trial_err);
+											BASISU_SPMD_KERNEL(linear_distance_rgb_4_N)(&trial_err, block_selectors, block_colors, src_pixels.get_ptr(), 16, best_trial_err);
 										}
 
 										//if (trial_err > thresh_err)
@@ -14,6 +14,7 @@
 // limitations under the License.
 #include "basisu_comp.h"
 #include "basisu_enc.h"
+#include "basisu_ssim.h"
 #include <unordered_set>
 #include <atomic>
 
@@ -52,7 +53,10 @@ namespace basisu
 		m_basis_bits_per_texel(0.0f),
 		m_total_blocks(0),
 		m_any_source_image_has_alpha(false),
-	   m_opencl_failed(false)
+	   m_opencl_failed(false),
+		m_reuse_frontend_etc1s_blocks(false),
+		m_target_metric_achieved(0.0f),
+		m_target_setting(0.0f)
 	{
 		debug_printf("basis_compressor::basis_compressor\n");
 		
@@ -85,6 +89,8 @@ namespace basisu
 		}
 				
 		m_params = params;
+
+		m_mip_resamplers.clear();
 				
 		if (m_params.m_debug)
 		{
@@ -155,6 +161,7 @@ namespace basisu
 			PRINT_BOOL_VALUE(m_rdo_uastc);
 			PRINT_FLOAT_VALUE(m_rdo_uastc_quality_scalar);
 			PRINT_INT_VALUE(m_rdo_uastc_dict_size);
+			PRINT_INT_VALUE(m_rdo_uastc_max_candidates);
 			PRINT_FLOAT_VALUE(m_rdo_uastc_max_allowed_rms_increase_ratio);
 			PRINT_FLOAT_VALUE(m_rdo_uastc_skip_block_rms_thresh);
 			PRINT_FLOAT_VALUE(m_rdo_uastc_max_smooth_block_error_scale);
@@ -162,6 +169,10 @@ namespace basisu
 			PRINT_BOOL_VALUE(m_rdo_uastc_favor_simpler_modes_in_rdo_mode)
 			PRINT_BOOL_VALUE(m_rdo_uastc_multithreading);
 
+			debug_printf("m_target_metric: %u\n", m_params.m_target_metric);
+			PRINT_FLOAT_VALUE(m_target_metric_value);
+			PRINT_INT_VALUE(m_target_max_trials);
+
 			PRINT_INT_VALUE(m_resample_width);
 			PRINT_INT_VALUE(m_resample_height);
 			PRINT_FLOAT_VALUE(m_resample_factor);
@@ -234,7 +245,16 @@ namespace basisu
 		if (!extract_source_blocks())
 			return cECFailedFrontEnd;
 
-		if (m_params.m_uastc)
+		if (m_params.m_target_metric != cTargetMetricNone)
+		{
+			error_code ec = search_target_quality();
+			if (ec != cECSuccess)
+				return ec;
+
+			if ((!m_params.m_uastc) && (!extract_frontend_texture_data()))
+				return cECFailedFontendExtract;
+		}
+		else if (m_params.m_uastc)
 		{
 			error_code ec = encode_slices_to_uastc();
 			if (ec != cECSuccess)
@@ -271,21 +291,22 @@ namespace basisu
 	{
 		debug_printf("basis_compressor::encode_slices_to_uastc\n");
 
+		encode_uastc_slice_textures();
+
+		return create_uastc_backend_output();
+	}
+
+	void basis_compressor::encode_uastc_slice_textures()
+	{
+		debug_printf("basis_compressor::encode_uastc_slice_textures\n");
+
 		m_uastc_slice_textures.resize(m_slice_descs.size());
 		for (uint32_t slice_index = 0; slice_index < m_slice_descs.size(); slice_index++)
 			m_uastc_slice_textures[slice_index].init(texture_format::cUASTC4x4, m_slice_descs[slice_index].m_orig_width, m_slice_descs[slice_index].m_orig_height);
 
-		m_uastc_backend_output.m_tex_format = basist::basis_tex_format::cUASTC4x4;
-		m_uastc_backend_output.m_etc1s = false;
-		m_uastc_backend_output.m_slice_desc = m_slice_descs;
-		m_uastc_backend_output.m_slice_image_data.resize(m_slice_descs.size());
-		m_uastc_backend_output.m_slice_image_crcs.resize(m_slice_descs.size());
-				
 		for (uint32_t slice_index = 0; slice_index < m_slice_descs.size(); slice_index++)
 		{
 			gpu_image& tex = m_uastc_slice_textures[slice_index];
-			basisu_backend_slice_desc& slice_desc = m_slice_descs[slice_index];
-			(void)slice_desc;
 
 			const uint32_t num_blocks_x = tex.get_blocks_x();
 			const uint32_t num_blocks_y = tex.get_blocks_y();
@@ -330,7 +351,7 @@ namespace basisu
 							uint32_t val = total_blocks_processed;
 							if ((val & 16383) == 16383)
 							{
-								debug_printf("basis_compressor::encode_slices_to_uastc: %3.1f%% done\n", static_cast<float>(val) * 100.0f / total_blocks);
+								debug_printf("basis_compressor::encode_uastc_slice_textures: %3.1f%% done\n", static_cast<float>(val) * 100.0f / total_blocks);
 							}
 
 						}
@@ -344,6 +365,27 @@ namespace basisu
 #ifndef __EMSCRIPTEN__
 			m_params.m_pJob_pool->wait_for_all();
 #endif
+		} // slice_index
+	}
+
+	// Creates the backend output from m_uastc_slice_textures, applying RDO with the current parameters if it's enabled.
+	// The textures themselves are left alone, so this can be called again with different RDO parameters.
+	basis_compressor::error_code basis_compressor::create_uastc_backend_output()
+	{
+		debug_printf("basis_compressor::create_uastc_backend_output\n");
+
+		m_uastc_backend_output.m_tex_format = basist::basis_tex_format::cUASTC4x4;
+		m_uastc_backend_output.m_etc1s = false;
+		m_uastc_backend_output.m_slice_desc = m_slice_descs;
+		m_uastc_backend_output.m_slice_image_data.resize(m_slice_descs.size());
+		m_uastc_backend_output.m_slice_image_crcs.resize(m_slice_descs.size());
+
+		gpu_image rdo_tex;
+
+		for (uint32_t slice_index = 0; slice_index < m_slice_descs.size(); slice_index++)
+		{
+			const gpu_image* pTex = &m_uastc_slice_textures[slice_index];
+			const basisu_backend_slice_desc& slice_desc = m_slice_descs[slice_index];
 
 			if (m_params.m_rdo_uastc)
 			{
@@ -352,10 +394,14 @@ namespace basisu
 				rdo_params.m_max_allowed_rms_increase_ratio = m_params.m_rdo_uastc_max_allowed_rms_increase_ratio;
 				rdo_params.m_skip_block_rms_thresh = m_params.m_rdo_uastc_skip_block_rms_thresh;
 				rdo_params.m_lz_dict_size = m_params.m_rdo_uastc_dict_size;
+				rdo_params.m_max_candidates = m_params.m_rdo_uastc_max_candidates;
 				rdo_params.m_smooth_block_max_error_scale = m_params.m_rdo_uastc_max_smooth_block_error_scale;
 				rdo_params.m_max_smooth_block_std_dev = m_params.m_rdo_uastc_smooth_block_max_std_dev;
 								
-				bool status = uastc_rdo(tex.get_total_blocks(), (basist::uastc_block*)tex.get_ptr(),
+				rdo_tex = *pTex;
+				pTex = &rdo_tex;
+
+				bool status = uastc_rdo(rdo_tex.get_total_blocks(), (basist::uastc_block*)rdo_tex.get_ptr(),
 					(const color_rgba *)m_source_blocks[slice_desc.m_first_block_index].m_pixels, rdo_params, m_params.m_pack_uastc_flags, m_params.m_rdo_uastc_multithreading ? m_params.m_pJob_pool : nullptr,
 					(m_params.m_rdo_uastc_multithreading && m_params.m_pJob_pool) ? basisu::minimum<uint32_t>(4, (uint32_t)m_params.m_pJob_pool->get_total_threads()) : 0);
 				if (!status)
@@ -364,16 +410,265 @@ namespace basisu
 				}
 			}
 
-			m_uastc_backend_output.m_slice_image_data[slice_index].resize(tex.get_size_in_bytes());
-			memcpy(&m_uastc_backend_output.m_slice_image_data[slice_index][0], tex.get_ptr(), tex.get_size_in_bytes());
+			m_uastc_backend_output.m_slice_image_data[slice_index].resize(pTex->get_size_in_bytes());
+			memcpy(&m_uastc_backend_output.m_slice_image_data[slice_index][0], pTex->get_ptr(), pTex->get_size_in_bytes());
 			
-			m_uastc_backend_output.m_slice_image_crcs[slice_index] = basist::crc16(tex.get_ptr(), tex.get_size_in_bytes(), 0);
-						
+			m_uastc_backend_output.m_slice_image_crcs[slice_index] = basist::crc16(pTex->get_ptr(), pTex->get_size_in_bytes(), 0);
 		} // slice_index
 				
 		return cECSuccess;
 	}
 
+	// UASTC RDO quality scalars tried by the target quality search at levels 1 and 255. Levels in between are spaced logarithmically.
+	const float TARGET_QUALITY_UASTC_MAX_LAMBDA = 10.0f;
+	const float TARGET_QUALITY_UASTC_MIN_LAMBDA = .01f;
+
+	// Searches for the lowest quality level whose output reaches m_params.m_target_metric_value, bisecting over the levels
+	// [1,255] which are ETC1S quality levels, or UASTC RDO quality scalars from TARGET_QUALITY_UASTC_MAX_LAMBDA down to
+	// TARGET_QUALITY_UASTC_MIN_LAMBDA. Every trial reuses the work that doesn't depend on the level: the UASTC blocks are
+	// only encoded once and only RDO is repeated, and the frontend keeps its initial ETC1S blocks. The smallest passing
+	// output is kept. If none pass the highest level is used.
+	basis_compressor::error_code basis_compressor::search_target_quality()
+	{
+		debug_printf("basis_compressor::search_target_quality\n");
+
+		if (m_params.m_target_metric >= cTargetMetricTotal)
+			return cECFailedValidating;
+
+		const float target = m_params.m_target_metric_value;
+		const uint32_t max_trials = m_params.m_target_max_trials;
+
+		interval_timer tm;
+		tm.start();
+
+		if (m_params.m_uastc)
+		{
+			m_params.m_rdo_uastc = true;
+			encode_uastc_slice_textures();
+		}
+
+		int lo = (int)BASISU_QUALITY_MIN, hi = (int)BASISU_QUALITY_MAX;
+		int best_level = -1, last_level = -1;
+		uint64_t best_size = UINT64_MAX;
+		float best_metric = 0.0f;
+		basisu_backend_output best_uastc_output;
+		float best_uastc_lambda = 0.0f;
+
+		for (uint32_t trial = 0; (trial < max_trials) && (lo < hi); trial++)
+		{
+			const int level = (lo + hi) / 2;
+
+			float metric = 0.0f;
+			uint64_t size = 0;
+			error_code ec = run_target_quality_trial(level, metric, size);
+			if (ec != cECSuccess)
+				return ec;
+			last_level = level;
+
+			if (m_params.m_status_output)
+				printf("Target quality trial %u: level %i, metric %3.4f, %llu bytes\n", trial, level, metric, (unsigned long long)size);
+
+			if (metric >= target)
+			{
+				hi = level;
+				if (size < best_size)
+				{
+					best_level = level;
+					best_size = size;
+					best_metric = metric;
+					if (m_params.m_uastc)
+					{
+						best_uastc_output = m_uastc_backend_output;
+						best_uastc_lambda = m_params.m_rdo_uastc_quality_scalar;
+					}
+				}
+			}
+			else
+				lo = level + 1;
+		}
+
+		if (best_level < 0)
+		{
+			// lo == hi here unless the trials ran out, and in either case every lower level failed.
+			best_level = hi;
+			if (m_params.m_status_output)
+				printf("Warning: Target quality not reached, using level %i\n", best_level);
+		}
+
+		if (best_level != last_level)
+		{
+			if ((m_params.m_uastc) && (best_uastc_output.m_slice_image_data.size()))
+			{
+				// The last trial's lambda is still set, so restore the best one with its output.
+				m_uastc_backend_output = best_uastc_output;
+				m_params.m_rdo_uastc_quality_scalar = best_uastc_lambda;
+			}
+			else
+			{
+				// The frontend and backend state are needed by the rest of process(), so redo the best trial.
+				uint64_t size = 0;
+				error_code ec = run_target_quality_trial(best_level, best_metric, size);
+				if (ec != cECSuccess)
+					return ec;
+			}
+		}
+
+		m_reuse_frontend_etc1s_blocks = false;
+		m_target_metric_achieved = best_metric;
+		m_target_setting = m_params.m_uastc ? (float)m_params.m_rdo_uastc_quality_scalar : (float)m_params.m_quality_level;
+
+		debug_printf("basis_compressor::search_target_quality: Level %i, metric %3.4f, took %3.3f secs\n", best_level, best_metric, tm.get_elapsed_secs());
+
+		return cECSuccess;
+	}
+
+	// Compresses the source blocks at one level of search_target_quality() and measures the result.
+	basis_compressor::error_code basis_compressor::run_target_quality_trial(int level, float &metric, uint64_t &size)
+	{
+		debug_printf("basis_compressor::run_target_quality_trial: level %i\n", level);
+
+		if (m_params.m_uastc)
+		{
+			const float t = (level - (int)BASISU_QUALITY_MIN) / (float)(BASISU_QUALITY_MAX - BASISU_QUALITY_MIN);
+			m_params.m_rdo_uastc_quality_scalar = TARGET_QUALITY_UASTC_MAX_LAMBDA * powf(TARGET_QUALITY_UASTC_MIN_LAMBDA / TARGET_QUALITY_UASTC_MAX_LAMBDA, t);
+			m_target_setting = m_params.m_rdo_uastc_quality_scalar;
+
+			error_code ec = create_uastc_backend_output();
+			if (ec != cECSuccess)
+				return ec;
+
+			// UASTC is always LZ compressed afterwards, so that's the size that matters.
+			size = 0;
+			for (uint32_t i = 0; i < m_uastc_backend_output.m_slice_image_data.size(); i++)
+			{
+				const uint8_vec& data = m_uastc_backend_output.m_slice_image_data[i];
+#if BASISD_SUPPORT_KTX2_ZSTD
+				uint8_vec comp_data(ZSTD_compressBound(data.size()));
+				size_t comp_size = ZSTD_compress(comp_data.data(), comp_data.size(), data.data(), data.size(), m_params.m_ktx2_zstd_supercompression_level);
+				if (ZSTD_isError(comp_size))
+					return cECFailedUASTCRDOPostProcess;
+#else
+				size_t comp_size = 0;
+				void* pComp_data = tdefl_compress_mem_to_heap(data.data(), data.size(), &comp_size, TDEFL_DEFAULT_MAX_PROBES);
+				if (!pComp_data)
+					return cECFailedUASTCRDOPostProcess;
+				mz_free(pComp_data);
+#endif
+				size += comp_size;
+			}
+		}
+		else
+		{
+			// process_frontend() scales the RDO thresholds by the quality level, so every trial starts from the originals.
+			const param<float> endpoint_rdo_thresh(m_params.m_endpoint_rdo_thresh), selector_rdo_thresh(m_params.m_selector_rdo_thresh);
+
+			m_params.m_quality_level = level;
+
+			bool status = process_frontend() && process_backend();
+
+			m_params.m_endpoint_rdo_thresh = endpoint_rdo_thresh;
+			m_params.m_selector_rdo_thresh = selector_rdo_thresh;
+
+			if (!status)
+				return cECFailedBackend;
+
+			m_reuse_frontend_etc1s_blocks = true;
+
+			if (!m_basis_file.init(m_backend.get_output(), m_params.m_tex_type, m_params.m_userdata0, m_params.m_userdata1, m_params.m_y_flip, m_params.m_us_per_frame))
+				return cECFailedCreateBasisFile;
+
+			size = m_basis_file.get_compressed_data().size();
+		}
+
+		if (!compute_target_metric(metric))
+			return cECFailedCreateBasisFile;
+
+		return cECSuccess;
+	}
+
+	// Measures the current output against the source slices with m_params.m_target_metric. The worst slice counts.
+	bool basis_compressor::compute_target_metric(float &metric)
+	{
+		basist::basisu_transcoder decoder;
+
+		if (!m_params.m_uastc)
+		{
+			basist::basisu_transcoder_init();
+
+			if (m_params.m_pGlobal_codebooks)
+				decoder.set_global_codebooks(m_params.m_pGlobal_codebooks);
+
+			const uint8_vec& comp_data = m_basis_file.get_compressed_data();
+			if (!decoder.start_transcoding(comp_data.data(), (uint32_t)comp_data.size()))
+			{
+				error_printf("basis_compressor::compute_target_metric: decoder.start_transcoding() failed!\n");
+				return false;
+			}
+		}
+
+		metric = 1e+30f;
+
+		for (uint32_t slice_index = 0; slice_index < m_slice_descs.size(); slice_index++)
+		{
+			const basisu_backend_slice_desc& slice_desc = m_slice_descs[slice_index];
+
+			gpu_image decoded_texture;
+			if (m_params.m_uastc)
+			{
+				decoded_texture.init(texture_format::cUASTC4x4, slice_desc.m_orig_width, slice_desc.m_orig_height);
+
+				const uint8_vec& data = m_uastc_backend_output.m_slice_image_data[slice_index];
+				memcpy(decoded_texture.get_ptr(), data.data(), minimum<size_t>(data.size(), decoded_texture.get_size_in_bytes()));
+			}
+			else
+			{
+				decoded_texture.init(texture_format::cETC1, slice_desc.m_orig_width, slice_desc.m_orig_height);
+
+				const uint8_vec& comp_data = m_basis_file.get_compressed_data();
+				if (!decoder.transcode_slice(comp_data.data(), (uint32_t)comp_data.size(), slice_index,
+					decoded_texture.get_ptr(), slice_desc.m_num_blocks_x * slice_desc.m_num_blocks_y, basist::block_format::cETC1, sizeof(etc_block)))
+				{
+					error_printf("basis_compressor::compute_target_metric: Transcoding failed on slice %u!\n", slice_index);
+					return false;
+				}
+			}
+
+			image decoded_image;
+			decoded_texture.unpack(decoded_image);
+
+			float slice_metric;
+			if (m_params.m_target_metric == cTargetMetricSSIM)
+				slice_metric = compute_ssim(m_slice_images[slice_index], decoded_image, true, false, m_params.m_multithreading ? m_params.m_pJob_pool : nullptr)[0];
+			else
+			{
+				image_metrics em;
+				em.calc(m_slice_images[slice_index], decoded_image, 0, ((m_params.m_uastc) && (m_any_source_image_has_alpha)) ? 4 : 3);
+				slice_metric = em.m_psnr;
+			}
+
+			metric = minimum(metric, slice_metric);
+		}
+
+		return true;
+	}
+
+	const image_resampler *basis_compressor::get_mip_resampler(uint32_t src_width, uint32_t src_height, uint32_t dst_width, uint32_t dst_height)
+	{
+		for (const auto &pResampler : m_mip_resamplers)
+		{
+			if ((pResampler->get_src_width() == src_width) && (pResampler->get_src_height() == src_height) &&
+				(pResampler->get_dst_width() == dst_width) && (pResampler->get_dst_height() == dst_height))
+				return pResampler.get();
+		}
+
+		std::unique_ptr<image_resampler> pResampler(new image_resampler);
+		if (!pResampler->init(src_width, src_height, dst_width, dst_height, m_params.m_mip_filter.c_str(), m_params.m_mip_scale, m_params.m_mip_wrapping))
+			return nullptr;
+
+		m_mip_resamplers.push_back(std::move(pResampler));
+		return m_mip_resamplers.back().get();
+	}
+
 	bool basis_compressor::generate_mipmaps(const image &img, basisu::vector<image> &mips, bool has_alpha)
 	{
 		debug_printf("basis_compressor::generate_mipmaps\n");
@@ -429,32 +724,74 @@ namespace basisu
 				level_img.renormalize_normal_map();
 		}
 #else
+		const uint32_t first_index = (uint32_t)mips.size();
+		mips.resize(first_index + total_levels - 1);
+
+		// Look up the contributor tables for every level before starting, as they are shared with
+		// other slices and the lookup isn't thread safe.
+		basisu::vector<const image_resampler *> resamplers(total_levels);
 		for (uint32_t level = 1; level < total_levels; level++)
 		{
 			const uint32_t level_width = maximum<uint32_t>(1, img.get_width() >> level);
 			const uint32_t level_height = maximum<uint32_t>(1, img.get_height() >> level);
 
-			image& level_img = *enlarge_vector(mips, 1);
-			level_img.resize(level_width, level_height);
+			mips[first_index + level - 1].resize(level_width, level_height);
+
+			uint32_t src_width = img.get_width(), src_height = img.get_height();
+			if ((m_params.m_mip_fast) && (level > 1))
+			{
+				src_width = mips[first_index + level - 2].get_width();
+				src_height = mips[first_index + level - 2].get_height();
+			}
+
+			resamplers[level] = get_mip_resampler(src_width, src_height, level_width, level_height);
+		}
+
+		std::atomic<bool> status(true);
+
+		auto generate_level = [&](uint32_t level)
+		{
+			image& level_img = mips[first_index + level - 1];
 
 			const image* pSource_image = &img;
 
 			if (m_params.m_mip_fast)
 			{
 				if (level > 1)
-					pSource_image = &mips[level - 1];
+					pSource_image = &mips[first_index + level - 2];
 			}
 
-			bool status = image_resample(*pSource_image, level_img, m_params.m_mip_srgb, m_params.m_mip_filter.c_str(), m_params.m_mip_scale, m_params.m_mip_wrapping, 0, has_alpha ? 4 : 3);
-			if (!status)
+			if ((pSource_image->get_width() == level_img.get_width()) && (pSource_image->get_height() == level_img.get_height()))
+				level_img = *pSource_image;
+			else if ((!resamplers[level]) ||
+				(!resamplers[level]->resample(*pSource_image, level_img, m_params.m_mip_srgb, 0, has_alpha ? 4 : 3, m_params.m_pJob_pool)))
 			{
 				error_printf("basis_compressor::generate_mipmaps: image_resample() failed!\n");
-				return false;
+				status = false;
+				return;
 			}
 
 			if (m_params.m_mip_renormalize)
 				level_img.renormalize_normal_map();
+		};
+
+		if (m_params.m_mip_fast)
+		{
+			// Each level is made from the previous one. Only the rows of a level are done in parallel.
+			for (uint32_t level = 1; (level < total_levels) && (status); level++)
+				generate_level(level);
+		}
+		else
+		{
+			// Each level is made from the base image so the levels are independent.
+			for (uint32_t level = 1; level < total_levels; level++)
+				m_params.m_pJob_pool->add_job([&generate_level, level] { generate_level(level); });
+
+			m_params.m_pJob_pool->wait_for_all();
 		}
+
+		if (!status)
+			return false;
 #endif
 
 		if (m_params.m_debug)
@@ -1168,6 +1505,7 @@ namespace basisu
 		p.m_validate = m_params.m_validate_etc1s;
 		p.m_pJob_pool = m_params.m_pJob_pool;
 		p.m_pGlobal_codebooks = m_params.m_pGlobal_codebooks;
+		p.m_reuse_etc1s_blocks = m_reuse_frontend_etc1s_blocks;
 		
 		// Don't keep trying to use OpenCL if it ever fails.
 		p.m_pOpenCL_context = !m_opencl_failed ? m_pOpenCL_context : nullptr;
@@ -1504,42 +1842,47 @@ namespace basisu
 
 					image_stats& s = m_stats[slice_index];
 
-					// TODO: We used to output SSIM (during heavy encoder development), but this slowed down compression too much. We'll be adding it back.
+					// Each decoded image is compared in one pass, which gives the SSIM cheaply enough to always include it.
+					job_pool *pStats_job_pool = m_params.m_multithreading ? m_params.m_pJob_pool : nullptr;
 
+					image_quality q;
 					image_metrics em;
 
 					// ---- .basis stats
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 0, 3);
+					compute_image_quality(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], true, false, q, pStats_job_pool);
+
+					q.get_metrics(em, 0, 3);
 					em.print(".basis RGB Avg:          ");
 					s.m_basis_rgb_avg_psnr = em.m_psnr;
 
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 0, 4);
+					q.get_metrics(em, 0, 4);
 					em.print(".basis RGBA Avg:         ");
 					s.m_basis_rgba_avg_psnr = em.m_psnr;
 
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 0, 1);
+					q.get_metrics(em, 0, 1);
 					em.print(".basis R   Avg:          ");
 
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 1, 1);
+					q.get_metrics(em, 1, 1);
 					em.print(".basis G   Avg:          ");
 
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 2, 1);
+					q.get_metrics(em, 2, 1);
 					em.print(".basis B   Avg:          ");
 
 					if (m_params.m_uastc)
 					{
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 3, 1);
+						q.get_metrics(em, 3, 1);
 						em.print(".basis A   Avg:          ");
 
 						s.m_basis_a_avg_psnr = em.m_psnr;
 					}
 
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 0, 0);
+					q.get_metrics(em, 0, 0);
 					em.print(".basis 709 Luma:         ");
 					s.m_basis_luma_709_psnr = static_cast<float>(em.m_psnr);
 					s.m_basis_luma_709_ssim = static_cast<float>(em.m_ssim);
+					printf(".basis 709 Luma SSIM:    %1.5f\n", s.m_basis_luma_709_ssim);
 
-					em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked[slice_index], 0, 0, true, true);
+					q.get_metrics(em, 0, 0, true);
 					em.print(".basis 601 Luma:         ");
 					s.m_basis_luma_601_psnr = static_cast<float>(em.m_psnr);
 
@@ -1553,37 +1896,40 @@ namespace basisu
 					if (m_decoded_output_textures_unpacked_bc7[slice_index].get_width())
 					{
 						// ---- BC7 stats
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 0, 3);
+						compute_image_quality(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], true, false, q, pStats_job_pool);
+
+						q.get_metrics(em, 0, 3);
 						em.print("BC7 RGB Avg:             ");
 						s.m_bc7_rgb_avg_psnr = em.m_psnr;
 
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 0, 4);
+						q.get_metrics(em, 0, 4);
 						em.print("BC7 RGBA Avg:            ");
 						s.m_bc7_rgba_avg_psnr = em.m_psnr;
 
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 0, 1);
+						q.get_metrics(em, 0, 1);
 						em.print("BC7 R   Avg:             ");
 
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 1, 1);
+						q.get_metrics(em, 1, 1);
 						em.print("BC7 G   Avg:             ");
 
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 2, 1);
+						q.get_metrics(em, 2, 1);
 						em.print("BC7 B   Avg:             ");
 
 						if (m_params.m_uastc)
 						{
-							em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 3, 1);
+							q.get_metrics(em, 3, 1);
 							em.print("BC7 A   Avg:             ");
 
 							s.m_bc7_a_avg_psnr = em.m_psnr;
 						}
 
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 0, 0);
+						q.get_metrics(em, 0, 0);
 						em.print("BC7 709 Luma:            ");
 						s.m_bc7_luma_709_psnr = static_cast<float>(em.m_psnr);
 						s.m_bc7_luma_709_ssim = static_cast<float>(em.m_ssim);
+						printf("BC7 709 Luma SSIM:       %1.5f\n", s.m_bc7_luma_709_ssim);
 
-						em.calc(m_slice_images[slice_index], m_decoded_output_textures_unpacked_bc7[slice_index], 0, 0, true, true);
+						q.get_metrics(em, 0, 0, true);
 						em.print("BC7 601 Luma:            ");
 						s.m_bc7_luma_601_psnr = static_cast<float>(em.m_psnr);
 					}
@@ -1591,16 +1937,19 @@ namespace basisu
 					if (!m_params.m_uastc)
 					{
 						// ---- Nearly best possible ETC1S stats
-						em.calc(m_slice_images[slice_index], m_best_etc1s_images_unpacked[slice_index], 0, 3);
+						compute_image_quality(m_slice_images[slice_index], m_best_etc1s_images_unpacked[slice_index], true, false, q, pStats_job_pool);
+
+						q.get_metrics(em, 0, 3);
 						em.print("Unquantized ETC1S RGB Avg:     ");
 						s.m_best_etc1s_rgb_avg_psnr = static_cast<float>(em.m_psnr);
 
-						em.calc(m_slice_images[slice_index], m_best_etc1s_images_unpacked[slice_index], 0, 0);
+						q.get_metrics(em, 0, 0);
 						em.print("Unquantized ETC1S 709 Luma:    ");
 						s.m_best_etc1s_luma_709_psnr = static_cast<float>(em.m_psnr);
 						s.m_best_etc1s_luma_709_ssim = static_cast<float>(em.m_ssim);
+						printf("Unquantized ETC1S 709 Luma SSIM: %1.5f\n", s.m_best_etc1s_luma_709_ssim);
 
-						em.calc(m_slice_images[slice_index], m_best_etc1s_images_unpacked[slice_index], 0, 0, true, true);
+						q.get_metrics(em, 0, 0, true);
 						em.print("Unquantized ETC1S 601 Luma:    ");
 						s.m_best_etc1s_luma_601_psnr = static_cast<float>(em.m_psnr);
 					}
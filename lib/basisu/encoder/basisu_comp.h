@@ -202,6 +202,15 @@ namespace basisu
 		bool m_changed;
 	};
 
+	// Quality metrics process() can search for, see basis_compressor_params::m_target_metric.
+	enum target_metric
+	{
+		cTargetMetricNone = 0,
+		cTargetMetricPSNR,		// RGB average PSNR, or RGBA if any source image has alpha
+		cTargetMetricSSIM,		// Rec. 709 luma SSIM
+		cTargetMetricTotal
+	};
+
 	struct basis_compressor_params
 	{
 		basis_compressor_params() :
@@ -216,10 +225,14 @@ namespace basisu
 			m_pack_uastc_flags(cPackUASTCLevelDefault),
 			m_rdo_uastc_quality_scalar(1.0f, 0.001f, 50.0f),
 			m_rdo_uastc_dict_size(BASISU_RDO_UASTC_DICT_SIZE_DEFAULT, BASISU_RDO_UASTC_DICT_SIZE_MIN, BASISU_RDO_UASTC_DICT_SIZE_MAX),
+			m_rdo_uastc_max_candidates(0, 0, BASISU_RDO_UASTC_DICT_SIZE_MAX / 16),
 			m_rdo_uastc_max_smooth_block_error_scale(UASTC_RDO_DEFAULT_SMOOTH_BLOCK_MAX_ERROR_SCALE, 1.0f, 300.0f),
 			m_rdo_uastc_smooth_block_max_std_dev(UASTC_RDO_DEFAULT_MAX_SMOOTH_BLOCK_STD_DEV, .01f, 65536.0f),
 			m_rdo_uastc_max_allowed_rms_increase_ratio(UASTC_RDO_DEFAULT_MAX_ALLOWED_RMS_INCREASE_RATIO, .01f, 100.0f),
 			m_rdo_uastc_skip_block_rms_thresh(UASTC_RDO_DEFAULT_SKIP_BLOCK_RMS_THRESH, .01f, 100.0f),
+			m_target_metric(cTargetMetricNone),
+			m_target_metric_value(0.0f, 0.0f, 100.0f),
+			m_target_max_trials(8, 1, 32),
 			m_resample_width(0, 1, 16384),
 			m_resample_height(0, 1, 16384),
 			m_resample_factor(0.0f, .00125f, 100.0f),
@@ -291,6 +304,7 @@ namespace basisu
 			m_pack_uastc_flags = cPackUASTCLevelDefault;
 			m_rdo_uastc.clear();
 			m_rdo_uastc_quality_scalar.clear();
+			m_rdo_uastc_max_candidates.clear();
 			m_rdo_uastc_max_smooth_block_error_scale.clear();
 			m_rdo_uastc_smooth_block_max_std_dev.clear();
 			m_rdo_uastc_max_allowed_rms_increase_ratio.clear();
@@ -298,6 +312,10 @@ namespace basisu
 			m_rdo_uastc_favor_simpler_modes_in_rdo_mode.clear();
 			m_rdo_uastc_multithreading.clear();
 
+			m_target_metric = cTargetMetricNone;
+			m_target_metric_value.clear();
+			m_target_max_trials.clear();
+
 			m_resample_width.clear();
 			m_resample_height.clear();
 			m_resample_factor.clear();
@@ -419,6 +437,7 @@ namespace basisu
 		bool_param<false> m_rdo_uastc;
 		param<float> m_rdo_uastc_quality_scalar;
 		param<int> m_rdo_uastc_dict_size;
+		param<int> m_rdo_uastc_max_candidates;
 		param<float> m_rdo_uastc_max_smooth_block_error_scale;
 		param<float> m_rdo_uastc_smooth_block_max_std_dev;
 		param<float> m_rdo_uastc_max_allowed_rms_increase_ratio;
@@ -426,6 +445,13 @@ namespace basisu
 		bool_param<true> m_rdo_uastc_favor_simpler_modes_in_rdo_mode;
 		bool_param<true> m_rdo_uastc_multithreading;
 
+		// Target quality mode. Unless m_target_metric is cTargetMetricNone, process() searches m_quality_level (ETC1S) or
+		// m_rdo_uastc_quality_scalar (UASTC, which forces m_rdo_uastc on) for the smallest output whose worst slice still
+		// reaches m_target_metric_value, trying at most m_target_max_trials settings. The other parameters are left alone.
+		uint32_t m_target_metric;
+		param<float> m_target_metric_value;
+		param<int> m_target_max_trials;
+
 		param<int> m_resample_width;
 		param<int> m_resample_height;
 		param<float> m_resample_factor;
@@ -489,6 +515,10 @@ namespace basisu
 		bool get_any_source_image_has_alpha() const { return m_any_source_image_has_alpha; }
 
 		bool get_opencl_failed() const { return m_opencl_failed; }
+
+		// The metric reached and the ETC1S quality level or UASTC RDO quality scalar chosen by the target quality search.
+		float get_target_metric_achieved() const { return m_target_metric_achieved; }
+		float get_target_setting() const { return m_target_setting; }
 								
 	private:
 		basis_compressor_params m_params;
@@ -533,6 +563,14 @@ namespace basisu
 
 		bool m_opencl_failed;
 
+		// Set while the target quality search compresses the same source blocks again, so the frontend can keep its initial ETC1S blocks.
+		bool m_reuse_frontend_etc1s_blocks;
+		float m_target_metric_achieved;
+		float m_target_setting;
+
+		// Contributor tables for mipmap generation, shared by all slices with the same dimensions.
+		std::vector<std::unique_ptr<image_resampler> > m_mip_resamplers;
+
 		bool read_source_images();
 		bool extract_source_blocks();
 		bool process_frontend();
@@ -541,6 +579,12 @@ namespace basisu
 		bool create_basis_file_and_transcode();
 		bool write_output_files_and_compute_stats();
 		error_code encode_slices_to_uastc();
+		void encode_uastc_slice_textures();
+		error_code create_uastc_backend_output();
+		error_code search_target_quality();
+		error_code run_target_quality_trial(int level, float &metric, uint64_t &size);
+		bool compute_target_metric(float &metric);
+		const image_resampler *get_mip_resampler(uint32_t src_width, uint32_t src_height, uint32_t dst_width, uint32_t dst_height);
 		bool generate_mipmaps(const image &img, basisu::vector<image> &mips, bool has_alpha);
 		bool validate_texture_type_constraints();
 		bool validate_ktx2_constraints();
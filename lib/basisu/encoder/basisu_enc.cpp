@@ -25,6 +25,14 @@
 #include "basisu_opencl.h"
 #include <vector>
 
+#if BASISU_SUPPORT_SSE
+#define CPPSPMD_NAME(a) a##_sse41
+#include "basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#define CPPSPMD_NAME(a) a##_avx2
+#include "basisu_kernels_declares.h"
+#endif
+
 #define MINIZ_HEADER_FILE_ONLY
 #define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
 #include "basisu_miniz.h"
@@ -41,6 +49,7 @@ namespace basisu
 	double interval_timer::g_timer_freq;
 #if BASISU_SUPPORT_SSE
 	bool g_cpu_supports_sse41;
+	bool g_cpu_supports_avx2;
 #endif
 
 	uint8_t g_hamming_dist[256] =
@@ -610,9 +619,10 @@ namespace basisu
 	}
 
 	bool image_resample(const image &src, image &dst, bool srgb,
-		const char *pFilter, float filter_scale, 
+		const char *pFilter, float filter_scale,
 		bool wrapping,
-		uint32_t first_comp, uint32_t num_comps)
+		uint32_t first_comp, uint32_t num_comps,
+		job_pool *pJob_pool)
 	{
 		assert((first_comp + num_comps) <= 4);
 
@@ -645,115 +655,330 @@ namespace basisu
 			return true;
 		}
 
-		float srgb_to_linear_table[256];
-		if (srgb)
+		image_resampler resampler;
+		if (!resampler.init(src_w, src_h, dst_w, dst_h, pFilter, filter_scale, wrapping))
+			return false;
+
+		return resampler.resample(src, dst, srgb, first_comp, num_comps, pJob_pool);
+	}
+
+	// Number of destination rows in a band, the unit of work of image_resampler::resample().
+	const uint32_t IMAGE_RESAMPLER_BAND_ROWS = 32;
+
+	// 8-bit to float and float to 8-bit sRGB conversion tables, built on first use.
+	struct image_resampler_tables
+	{
+		enum { LINEAR_TO_SRGB_TABLE_SIZE = 8192 };
+
+		float m_linear[256];
+		float m_srgb_to_linear[256];
+		uint8_t m_linear_to_srgb[LINEAR_TO_SRGB_TABLE_SIZE];
+
+		image_resampler_tables()
 		{
 			for (int i = 0; i < 256; ++i)
-				srgb_to_linear_table[i] = srgb_to_linear((float)i * (1.0f/255.0f));
+			{
+				m_linear[i] = i * (1.0f / 255.0f);
+				m_srgb_to_linear[i] = srgb_to_linear((float)i * (1.0f / 255.0f));
+			}
+
+			for (int i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; ++i)
+				m_linear_to_srgb[i] = (uint8_t)clamp<int>((int)(255.0f * linear_to_srgb((float)i * (1.0f / (LINEAR_TO_SRGB_TABLE_SIZE - 1))) + .5f), 0, 255);
+		}
+
+		static const image_resampler_tables &get()
+		{
+			static const image_resampler_tables s_tables;
+			return s_tables;
 		}
+	};
+
+	void image_resampler::clear()
+	{
+		m_src_w = 0;
+		m_src_h = 0;
+		m_dst_w = 0;
+		m_dst_h = 0;
+		m_delay_x_resample = false;
+		m_x.clear();
+		m_y.clear();
+	}
 
-		const int LINEAR_TO_SRGB_TABLE_SIZE = 8192;
-		uint8_t linear_to_srgb_table[LINEAR_TO_SRGB_TABLE_SIZE];
+	bool image_resampler::init_contribs(contrib_table &table, uint32_t src_size, uint32_t dst_size,
+		int filter_index, float filter_scale, bool wrapping)
+	{
+		Resampler::Contrib_List *pClist = Resampler::make_clist(src_size, dst_size,
+			wrapping ? Resampler::BOUNDARY_WRAP : Resampler::BOUNDARY_CLAMP,
+			g_resample_filters[filter_index].func, g_resample_filters[filter_index].support, filter_scale, 0.0f);
+		if (!pClist)
+			return false;
+
+		uint32_t total = 0;
+		for (uint32_t i = 0; i < dst_size; i++)
+			total += pClist[i].n;
 
-		if (srgb)
+		table.m_first.resize(dst_size + 1);
+		table.m_pixels.resize(total);
+		table.m_weights.resize(total);
+
+		uint32_t k = 0;
+		for (uint32_t i = 0; i < dst_size; i++)
 		{
-			for (int i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; ++i)
-				linear_to_srgb_table[i] = (uint8_t)clamp<int>((int)(255.0f * linear_to_srgb((float)i * (1.0f / (LINEAR_TO_SRGB_TABLE_SIZE - 1))) + .5f), 0, 255);
+			table.m_first[i] = k;
+			for (uint32_t j = 0; j < pClist[i].n; j++, k++)
+			{
+				table.m_pixels[k] = pClist[i].p[j].pixel;
+				table.m_weights[k] = pClist[i].p[j].weight;
+			}
 		}
+		table.m_first[dst_size] = k;
 
-		std::vector<float> samples[cMaxComps];
-		Resampler *resamplers[cMaxComps];
-		
-		resamplers[0] = new Resampler(src_w, src_h, dst_w, dst_h,
-			wrapping ? Resampler::BOUNDARY_WRAP : Resampler::BOUNDARY_CLAMP, 0.0f, 1.0f,
-			pFilter, nullptr, nullptr, filter_scale, filter_scale, 0, 0);
-		samples[0].resize(src_w);
+		free(pClist->p);
+		free(pClist);
+
+		return true;
+	}
 
-		for (uint32_t i = 1; i < num_comps; ++i)
+	bool image_resampler::init(uint32_t src_w, uint32_t src_h, uint32_t dst_w, uint32_t dst_h,
+		const char *pFilter, float filter_scale, bool wrapping)
+	{
+		clear();
+
+		if (!src_w || !src_h || !dst_w || !dst_h)
+			return false;
+
+		if ((maximum(src_w, src_h) > BASISU_RESAMPLER_MAX_DIMENSION) || (maximum(dst_w, dst_h) > BASISU_RESAMPLER_MAX_DIMENSION))
+			return false;
+
+		const int filter_index = find_resample_filter(pFilter ? pFilter : BASISU_RESAMPLER_DEFAULT_FILTER);
+		if (filter_index < 0)
+			return false;
+
+		if ((!init_contribs(m_x, src_w, dst_w, filter_index, filter_scale, wrapping)) ||
+			(!init_contribs(m_y, src_h, dst_h, filter_index, filter_scale, wrapping)))
 		{
-			resamplers[i] = new Resampler(src_w, src_h, dst_w, dst_h,
-				wrapping ? Resampler::BOUNDARY_WRAP : Resampler::BOUNDARY_CLAMP, 0.0f, 1.0f,
-				pFilter, resamplers[0]->get_clist_x(), resamplers[0]->get_clist_y(), filter_scale, filter_scale, 0, 0);
-			samples[i].resize(src_w);
+			clear();
+			return false;
 		}
 
-		uint32_t dst_y = 0;
+		m_src_w = src_w;
+		m_src_h = src_h;
+		m_dst_w = dst_w;
+		m_dst_h = dst_h;
+
+		// Same choice of which axis to resample first as Resampler, including weighting Y axis ops a
+		// little more, so results match it.
+		const uint64_t x_ops = m_x.m_pixels.size(), y_ops = m_y.m_pixels.size();
+		const uint64_t xy_ops = x_ops * src_h + (4 * y_ops * dst_w) / 3;
+		const uint64_t yx_ops = (4 * y_ops * src_w) / 3 + x_ops * dst_h;
+		m_delay_x_resample = (xy_ops > yx_ops) || ((xy_ops == yx_ops) && (src_w < dst_w));
+
+		return true;
+	}
+
+	bool image_resampler::resample(const image &src, image &dst, bool srgb,
+		uint32_t first_comp, uint32_t num_comps, job_pool *pJob_pool) const
+	{
+		if (!is_valid())
+			return false;
+
+		if ((src.get_width() != m_src_w) || (src.get_height() != m_src_h) || (dst.get_width() != m_dst_w) || (dst.get_height() != m_dst_h))
+			return false;
+
+		if ((num_comps < 1) || ((first_comp + num_comps) > 4))
+			return false;
 
-		for (uint32_t src_y = 0; src_y < src_h; ++src_y)
+		const image_resampler_tables &tables = image_resampler_tables::get();
+		const float *pSrgb_to_linear = srgb ? tables.m_srgb_to_linear : nullptr;
+		const uint8_t *pLinear_to_srgb = srgb ? tables.m_linear_to_srgb : nullptr;
+
+		const uint32_t num_bands = (m_dst_h + IMAGE_RESAMPLER_BAND_ROWS - 1) / IMAGE_RESAMPLER_BAND_ROWS;
+
+		if ((pJob_pool) && (pJob_pool->get_total_threads() > 1) && (num_bands > 1))
 		{
-			const color_rgba *pSrc = &src(0, src_y);
+			pJob_pool->parallel_for(0, num_bands, [&](uint32_t first_band, uint32_t last_band)
+				{
+					resample_bands(src, dst, pSrgb_to_linear, pLinear_to_srgb, first_comp, num_comps, first_band, last_band);
+				});
+		}
+		else
+		{
+			resample_bands(src, dst, pSrgb_to_linear, pLinear_to_srgb, first_comp, num_comps, 0, num_bands);
+		}
+
+		return true;
+	}
+
+	void image_resampler::resample_row_x(float *pDst, const float *pSrc) const
+	{
+		const uint32_t *pFirst = m_x.m_first.data();
+		const uint32_t *pPixels = m_x.m_pixels.data();
+		const float *pWeights = m_x.m_weights.data();
 
-			// Put source lines into resampler(s)
-			for (uint32_t x = 0; x < src_w; ++x)
+#if BASISU_SUPPORT_SSE
+		if (g_cpu_supports_sse41)
+		{
+			BASISU_SPMD_KERNEL(resample_rgba_row_x)(pDst, pSrc, m_dst_w, pFirst, pPixels, pWeights);
+			return;
+		}
+#endif
+
+		for (uint32_t x = 0; x < m_dst_w; x++)
+		{
+			float total[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (uint32_t k = pFirst[x]; k < pFirst[x + 1]; k++)
 			{
-				for (uint32_t c = 0; c < num_comps; ++c)
-				{
-					const uint32_t comp_index = first_comp + c;
-					const uint32_t v = (*pSrc)[comp_index];
+				const float *pS = pSrc + pPixels[k] * 4;
+				const float w = pWeights[k];
+				for (uint32_t c = 0; c < 4; c++)
+					total[c] += pS[c] * w;
+			}
 
-					if (!srgb || (comp_index == 3))
-						samples[c][x] = v * (1.0f / 255.0f);
-					else
-						samples[c][x] = srgb_to_linear_table[v];
-				}
+			for (uint32_t c = 0; c < 4; c++)
+				pDst[x * 4 + c] = total[c];
+		}
+	}
+
+	// Resamples in the same order as Resampler and accumulates contributors in list order, so the output
+	// matches its. Each band of destination rows first prepares the source rows it needs: converted to
+	// linear, and resampled horizontally unless X is resampled last. Rows the previous band of the same
+	// call already prepared are copied from it, so only the first band of a range repeats any work.
+	void image_resampler::resample_bands(const image &src, image &dst, const float *pSrgb_to_linear, const uint8_t *pLinear_to_srgb,
+		uint32_t first_comp, uint32_t num_comps, uint32_t first_band, uint32_t last_band) const
+	{
+		const image_resampler_tables &tables = image_resampler_tables::get();
+		const uint32_t src_w = m_src_w, dst_w = m_dst_w;
+		const uint32_t row_size = (m_delay_x_resample ? src_w : dst_w) * 4;
+
+		// Alpha is always linear.
+		const float *pTo_linear[4];
+		for (uint32_t c = 0; c < 4; c++)
+			pTo_linear[c] = (pSrgb_to_linear && (c != 3)) ? pSrgb_to_linear : tables.m_linear;
+
+		std::vector<float> src_row(m_delay_x_resample ? 0 : src_w * 4);
+		std::vector<float> accum(row_size);
+		std::vector<float> dst_row(m_delay_x_resample ? dst_w * 4 : 0);
+
+		// Prepared source rows of the current and previous bands, and the slot of each source row in
+		// them, or -1.
+		std::vector<float> rows[2];
+		std::vector<int> row_slots[2];
+		uint_vec used_rows[2];
+		row_slots[0].resize(m_src_h, -1);
+		row_slots[1].resize(m_src_h, -1);
+
+		uint32_t cur = 0;
+
+		for (uint32_t band = first_band; band < last_band; band++)
+		{
+			const uint32_t prev = cur ^ 1;
+			const uint32_t first_y = band * IMAGE_RESAMPLER_BAND_ROWS;
+			const uint32_t last_y = minimum(m_dst_h, first_y + IMAGE_RESAMPLER_BAND_ROWS);
 
-				pSrc++;
+			std::vector<int> &slots = row_slots[cur];
+			uint_vec &used = used_rows[cur];
+
+			used.resize(0);
+			for (uint32_t k = m_y.m_first[first_y]; k < m_y.m_first[last_y]; k++)
+			{
+				const uint32_t src_y = m_y.m_pixels[k];
+				if (slots[src_y] < 0)
+				{
+					slots[src_y] = (int)used.size();
+					used.push_back(src_y);
+				}
 			}
 
-			for (uint32_t c = 0; c < num_comps; ++c)
+			rows[cur].resize(used.size() * row_size);
+
+			for (uint32_t i = 0; i < used.size(); i++)
 			{
-				if (!resamplers[c]->put_line(&samples[c][0]))
+				const uint32_t src_y = used[i];
+				float *pRow = &rows[cur][i * row_size];
+
+				const int prev_slot = row_slots[prev][src_y];
+				if (prev_slot >= 0)
 				{
-					for (uint32_t i = 0; i < num_comps; i++)
-						delete resamplers[i];
-					return false;
+					memcpy(pRow, &rows[prev][prev_slot * row_size], row_size * sizeof(float));
+					continue;
 				}
+
+				float *pLinear = m_delay_x_resample ? pRow : &src_row[0];
+
+				const color_rgba *pSrc = &src(0, src_y);
+				for (uint32_t x = 0; x < src_w; x++)
+				{
+					for (uint32_t c = 0; c < 4; c++)
+						pLinear[x * 4 + c] = pTo_linear[c][pSrc[x][c]];
+				}
+
+				if (!m_delay_x_resample)
+					resample_row_x(pRow, pLinear);
 			}
 
-			// Now retrieve any output lines
-			for (;;)
+			// The previous band's rows are no longer needed.
+			for (uint32_t i = 0; i < used_rows[prev].size(); i++)
+				row_slots[prev][used_rows[prev][i]] = -1;
+			used_rows[prev].resize(0);
+
+			for (uint32_t dst_y = first_y; dst_y < last_y; dst_y++)
 			{
-				uint32_t c;
-				for (c = 0; c < num_comps; ++c)
+				float *pAccum = &accum[0];
+
+				for (uint32_t k = m_y.m_first[dst_y]; k < m_y.m_first[dst_y + 1]; k++)
 				{
-					const uint32_t comp_index = first_comp + c;
+					const float *pRow = &rows[cur][slots[m_y.m_pixels[k]] * row_size];
+					const float w = m_y.m_weights[k];
 
-					const float *pOutput_samples = resamplers[c]->get_line();
-					if (!pOutput_samples)
-						break;
+					if (k == m_y.m_first[dst_y])
+					{
+						for (uint32_t i = 0; i < row_size; i++)
+							pAccum[i] = pRow[i] * w;
+					}
+					else
+					{
+						for (uint32_t i = 0; i < row_size; i++)
+							pAccum[i] += pRow[i] * w;
+					}
+				}
 
-					const bool linear_flag = !srgb || (comp_index == 3);
-					
-					color_rgba *pDst = &dst(0, dst_y);
+				const float *pSamples = pAccum;
+				if (m_delay_x_resample)
+				{
+					resample_row_x(&dst_row[0], pAccum);
+					pSamples = &dst_row[0];
+				}
 
-					for (uint32_t x = 0; x < dst_w; x++)
+				color_rgba *pDst = &dst(0, dst_y);
+
+				for (uint32_t x = 0; x < dst_w; x++)
+				{
+					for (uint32_t c = first_comp; c < first_comp + num_comps; c++)
 					{
+						float v = pSamples[x * 4 + c];
+						if (v < 0.0f)
+							v = 0.0f;
+						else if (v > 1.0f)
+							v = 1.0f;
+
 						// TODO: Add dithering
-						if (linear_flag)
+						if ((!pLinear_to_srgb) || (c == 3))
 						{
-							int j = (int)(255.0f * pOutput_samples[x] + .5f);
-							(*pDst)[comp_index] = (uint8_t)clamp<int>(j, 0, 255);
+							int j = (int)(255.0f * v + .5f);
+							pDst[x][c] = (uint8_t)clamp<int>(j, 0, 255);
 						}
 						else
 						{
-							int j = (int)((LINEAR_TO_SRGB_TABLE_SIZE - 1) * pOutput_samples[x] + .5f);
-							(*pDst)[comp_index] = linear_to_srgb_table[clamp<int>(j, 0, LINEAR_TO_SRGB_TABLE_SIZE - 1)];
+							int j = (int)((image_resampler_tables::LINEAR_TO_SRGB_TABLE_SIZE - 1) * v + .5f);
+							pDst[x][c] = pLinear_to_srgb[clamp<int>(j, 0, image_resampler_tables::LINEAR_TO_SRGB_TABLE_SIZE - 1)];
 						}
-
-						pDst++;
 					}
 				}
-				if (c < num_comps)
-					break;
-
-				++dst_y;
 			}
-		}
-
-		for (uint32_t i = 0; i < num_comps; ++i)
-			delete resamplers[i];
 
-		return true;
+			cur = prev;
+		}
 	}
 
 	void canonical_huffman_calculate_minimum_redundancy(sym_freq *A, int num_syms)
@@ -1512,14 +1737,41 @@ namespace basisu
 		return h;
 	}
 
+	struct job_pool::job_node
+	{
+		std::function<void()> m_func;
+		std::mutex m_mutex;
+		std::vector<job_handle> m_dependents;
+		std::atomic<uint32_t> m_num_pending; // Unfinished dependencies, plus one while the job is being added.
+		bool m_done;
+		std::shared_ptr<job_group> m_group;
+
+		job_node(std::function<void()>&& func) : m_func(std::move(func)), m_num_pending(1), m_done(false) { }
+	};
+
+	// The pool, if any, whose worker is running on this thread and the index of that worker's deque.
+	static thread_local const job_pool* g_pCur_job_pool;
+	static thread_local uint32_t g_cur_job_deque_index;
+
+	thread_local job_pool::running_job* job_pool::s_pRunning_job;
+
+	// Number of times an idle worker looks for work before going to sleep.
+	const uint32_t JOB_POOL_SPIN_COUNT = 64;
+
 	job_pool::job_pool(uint32_t num_threads) : 
-		m_num_active_jobs(0),
+		m_num_queued(0),
+		m_num_outstanding(0),
+		m_num_sleeping(0),
 		m_kill_flag(false)
 	{
 		assert(num_threads >= 1U);
 
 		debug_printf("job_pool::job_pool: %u total threads\n", num_threads);
 
+		m_deques.resize(num_threads);
+		for (uint32_t i = 0; i < num_threads; i++)
+			m_deques[i].reset(new job_deque);
+
 		if (num_threads > 1)
 		{
 			m_threads.resize(num_threads - 1);
@@ -1534,7 +1786,10 @@ namespace basisu
 		debug_printf("job_pool::~job_pool\n");
 		
 		// Notify all workers that they need to die right now.
-		m_kill_flag = true;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_kill_flag = true;
+		}
 		
 		m_has_work.notify_all();
 
@@ -1542,97 +1797,362 @@ namespace basisu
 		for (uint32_t i = 0; i < m_threads.size(); i++)
 			m_threads[i].join();
 	}
-				
-	void job_pool::add_job(const std::function<void()>& job)
+
+	uint32_t job_pool::get_deque_index() const
+	{
+		return (g_pCur_job_pool == this) ? g_cur_job_deque_index : 0;
+	}
+
+	// Counts a new job as outstanding in the pool and, if it is being added by a job of this pool, in that job's group.
+	std::shared_ptr<job_pool::job_group> job_pool::begin_job()
 	{
-		std::unique_lock<std::mutex> lock(m_mutex);
+		m_num_outstanding++;
 
-		m_queue.emplace_back(job);
+		if (!s_pRunning_job || (s_pRunning_job->m_pPool != this))
+			return nullptr;
 
-		const size_t queue_size = m_queue.size();
+		std::shared_ptr<job_group>& group = s_pRunning_job->m_group;
+		if (!group)
+			group = std::make_shared<job_group>();
 
-		lock.unlock();
+		group->m_num_outstanding++;
+		return group;
+	}
 
-		if (queue_size > 1)
+	void job_pool::push_job(job_entry&& job)
+	{
+		job_deque& d = *m_deques[get_deque_index()];
+		{
+			std::lock_guard<std::mutex> lock(d.m_mutex);
+			d.m_jobs.emplace_back(std::move(job));
+		}
+
+		m_num_queued++;
+
+		// Only take the pool lock when someone may be waiting. Sleepers check m_num_queued under the lock after announcing themselves, so this can't miss one.
+		if (m_num_sleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
 			m_has_work.notify_one();
+		}
 	}
 
-	void job_pool::add_job(std::function<void()>&& job)
+	bool job_pool::pop_job(uint32_t deque_index, job_entry& job)
 	{
-		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_num_queued.load(std::memory_order_relaxed) <= 0)
+			return false;
 
-		m_queue.emplace_back(std::move(job));
-						
-		const size_t queue_size = m_queue.size();
+		const uint32_t num_deques = (uint32_t)m_deques.size();
+
+		// Newest of our own jobs first, then the oldest of everyone else's.
+		for (uint32_t i = 0; i < num_deques; i++)
+		{
+			job_deque& d = *m_deques[(deque_index + i) % num_deques];
+
+			std::lock_guard<std::mutex> lock(d.m_mutex);
+			if (d.m_jobs.empty())
+				continue;
+
+			if (!i)
+			{
+				job = std::move(d.m_jobs.back());
+				d.m_jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(d.m_jobs.front());
+				d.m_jobs.pop_front();
+			}
+
+			m_num_queued--;
+			return true;
+		}
 
-		lock.unlock();
+		return false;
+	}
+
+	void job_pool::run_job(job_entry& job)
+	{
+		running_job context;
+		context.m_pPool = this;
+		context.m_pPrev = s_pRunning_job;
+		s_pRunning_job = &context;
 
-		if (queue_size > 1)
+		if (job.m_node)
 		{
-			m_has_work.notify_one();
+			job_node& node = *job.m_node;
+
+			node.m_func();
+			node.m_func = nullptr;
+
+			std::vector<job_handle> dependents;
+			{
+				std::lock_guard<std::mutex> lock(node.m_mutex);
+				node.m_done = true;
+				dependents.swap(node.m_dependents);
+			}
+
+			for (uint32_t i = 0; i < dependents.size(); i++)
+			{
+				if (--dependents[i]->m_num_pending == 0)
+				{
+					job_entry entry;
+					entry.m_group = dependents[i]->m_group;
+					entry.m_node = std::move(dependents[i]);
+					push_job(std::move(entry));
+				}
+			}
+		}
+		else
+		{
+			job.m_func();
+		}
+
+		s_pRunning_job = context.m_pPrev;
+
+		bool notify = false;
+		if (job.m_group && (--job.m_group->m_num_outstanding == 0))
+			notify = true;
+
+		job = job_entry();
+
+		if (--m_num_outstanding == 0)
+			notify = true;
+
+		// Wake anyone waiting in wait_for_all() for a count that just reached zero.
+		if (notify)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_has_work.notify_all();
 		}
 	}
 
-	void job_pool::wait_for_all()
+	bool job_pool::try_run_job(uint32_t deque_index)
 	{
-		std::unique_lock<std::mutex> lock(m_mutex);
+		job_entry job;
+		if (!pop_job(deque_index, job))
+			return false;
 
-		// Drain the job queue on the calling thread.
-		while (!m_queue.empty())
+		run_job(job);
+		return true;
+	}
+				
+	void job_pool::add_job(const std::function<void()>& job)
+	{
+		std::function<void()> f(job);
+		add_job(std::move(f));
+	}
+
+	void job_pool::add_job(std::function<void()>&& job)
+	{
+		job_entry entry;
+		entry.m_group = begin_job();
+		entry.m_func = std::move(job);
+		push_job(std::move(entry));
+	}
+
+	job_pool::job_handle job_pool::add_job(std::function<void()>&& job, const job_handle* pDeps, uint32_t num_deps)
+	{
+		job_handle node(std::make_shared<job_node>(std::move(job)));
+		node->m_group = begin_job();
+
+		for (uint32_t i = 0; i < num_deps; i++)
 		{
-			std::function<void()> job(m_queue.back());
-			m_queue.pop_back();
+			if (!pDeps[i])
+				continue;
 
-			lock.unlock();
+			job_node& dep = *pDeps[i];
 
-			job();
+			std::lock_guard<std::mutex> lock(dep.m_mutex);
+			if (!dep.m_done)
+			{
+				node->m_num_pending++;
+				dep.m_dependents.push_back(node);
+			}
+		}
 
-			lock.lock();
+		// Drop the reference held while adding. If every dependency has already completed the job can run now, otherwise the last one to complete queues it.
+		if (--node->m_num_pending == 0)
+		{
+			job_entry entry;
+			entry.m_group = node->m_group;
+			entry.m_node = node;
+			push_job(std::move(entry));
 		}
 
-		// The queue is empty, now wait for all active jobs to finish up.
-		m_no_more_jobs.wait(lock, [this]{ return !m_num_active_jobs; } );
+		return node;
 	}
 
-	void job_pool::job_thread(uint32_t index)
+	void job_pool::parallel_for(uint32_t begin, uint32_t end, const std::function<void(uint32_t first, uint32_t last)>& func, uint32_t min_chunk)
 	{
-		BASISU_NOTE_UNUSED(index);
-		//debug_printf("job_pool::job_thread: starting %u\n", index);
-		
-		while (true)
+		if (begin >= end)
+			return;
+
+		min_chunk = maximum<uint32_t>(min_chunk, 1);
+
+		const uint32_t total_threads = (uint32_t)get_total_threads();
+		const uint32_t total_chunks = (end - begin + min_chunk - 1) / min_chunk;
+
+		if ((total_threads == 1) || (total_chunks == 1))
+		{
+			func(begin, end);
+			return;
+		}
+
+		// Shared with the helper jobs, which may only get to run after this returns.
+		struct range_state
+		{
+			std::atomic<uint32_t> m_next;
+			std::atomic<uint32_t> m_remaining;
+			uint32_t m_end;
+			uint32_t m_min_chunk;
+			uint32_t m_divisor;
+			const std::function<void(uint32_t, uint32_t)>* m_pFunc;
+			std::mutex m_mutex;
+			std::condition_variable m_done;
+
+			// Guided scheduling: take a share of what's left, so early chunks are big (low overhead) and late ones small (good balance).
+			bool grab(uint32_t& first, uint32_t& last)
+			{
+				uint32_t cur = m_next.load();
+				for ( ; ; )
+				{
+					if (cur >= m_end)
+						return false;
+
+					const uint32_t size = minimum(m_end - cur, maximum(m_min_chunk, (m_end - cur) / m_divisor));
+					if (m_next.compare_exchange_weak(cur, cur + size))
+					{
+						first = cur;
+						last = cur + size;
+						return true;
+					}
+				}
+			}
+
+			void run()
+			{
+				uint32_t first, last;
+				while (grab(first, last))
+				{
+					(*m_pFunc)(first, last);
+
+					if (m_remaining.fetch_sub(last - first) == last - first)
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_done.notify_all();
+					}
+				}
+			}
+		};
+
+		std::shared_ptr<range_state> state(std::make_shared<range_state>());
+		state->m_next = begin;
+		state->m_remaining = end - begin;
+		state->m_end = end;
+		state->m_min_chunk = min_chunk;
+		state->m_divisor = total_threads * 2;
+		state->m_pFunc = &func; // Only called while a chunk is outstanding, so before this returns.
+
+		const uint32_t num_helpers = minimum(total_threads, total_chunks) - 1;
+		for (uint32_t i = 0; i < num_helpers; i++)
+			add_job([state] { state->run(); });
+
+		state->run();
+
+		// Help with other jobs until the chunks taken by other threads are done.
+		const uint32_t deque_index = get_deque_index();
+		while (state->m_remaining.load())
 		{
+			if (try_run_job(deque_index))
+				continue;
+
+			std::unique_lock<std::mutex> lock(state->m_mutex);
+			state->m_done.wait(lock, [&state] { return !state->m_remaining.load(); });
+		}
+	}
+
+	void job_pool::help_until_done(const std::atomic<int>& num_outstanding)
+	{
+		const uint32_t deque_index = get_deque_index();
+
+		while (num_outstanding.load())
+		{
+			// Run jobs on the calling thread while there are any.
+			if (try_run_job(deque_index))
+				continue;
+
+			// The rest are running elsewhere or waiting on them. Sleep until one of them queues more work or the last completes.
 			std::unique_lock<std::mutex> lock(m_mutex);
+			m_num_sleeping++;
+			m_has_work.wait(lock, [this, &num_outstanding] { return !num_outstanding.load() || (m_num_queued.load() > 0); });
+			m_num_sleeping--;
+		}
+	}
 
-			// Wait for any jobs to be issued.
-			m_has_work.wait(lock, [this] { return m_kill_flag || m_queue.size(); } );
+	void job_pool::wait_for_all()
+	{
+		if (s_pRunning_job && (s_pRunning_job->m_pPool == this))
+		{
+			// Keep the group alive even if running other jobs here replaces the context's reference.
+			std::shared_ptr<job_group> group(s_pRunning_job->m_group);
+			if (group)
+				help_until_done(group->m_num_outstanding);
+			return;
+		}
 
-			// Check to see if we're supposed to exit.
-			if (m_kill_flag)
-				break;
+		help_until_done(m_num_outstanding);
+	}
 
-			// Get the job and execute it.
-			std::function<void()> job(m_queue.back());
-			m_queue.pop_back();
+	void job_pool::wait_for(const job_handle* pJobs, uint32_t num_jobs)
+	{
+		// A job that runs once all of them have completed clears the count help_until_done() waits on.
+		std::shared_ptr<std::atomic<int> > pending(std::make_shared<std::atomic<int> >(1));
+		add_job([this, pending]
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				*pending = 0;
+				m_has_work.notify_all();
+			}, pJobs, num_jobs);
 
-			++m_num_active_jobs;
+		help_until_done(*pending);
+	}
+
+	void job_pool::job_thread(uint32_t index)
+	{
+		//debug_printf("job_pool::job_thread: starting %u\n", index);
 
-			lock.unlock();
+		g_pCur_job_pool = this;
+		g_cur_job_deque_index = index + 1;
+		
+		uint32_t idle_count = 0;
 
-			job();
+		while (!m_kill_flag)
+		{
+			if (try_run_job(index + 1))
+			{
+				idle_count = 0;
+				continue;
+			}
 
-			lock.lock();
+			if (++idle_count < JOB_POOL_SPIN_COUNT)
+			{
+				std::this_thread::yield();
+				continue;
+			}
 
-			--m_num_active_jobs;
+			idle_count = 0;
 
-			// Now check if there are no more jobs remaining. 
-			const bool all_done = m_queue.empty() && !m_num_active_jobs;
-			
-			lock.unlock();
+			std::unique_lock<std::mutex> lock(m_mutex);
 
-			if (all_done)
-				m_no_more_jobs.notify_all();
+			// Announce we're sleeping before checking for work, see push_job().
+			m_num_sleeping++;
+			m_has_work.wait(lock, [this] { return m_kill_flag || (m_num_queued.load() > 0); });
+			m_num_sleeping--;
 		}
 
+		g_pCur_job_pool = nullptr;
+
 		//debug_printf("job_pool::job_thread: exiting\n");
 	}
 #if !defined(LIBKTX)
@@ -19,7 +19,9 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <thread>
 #include <unordered_map>
 #include <ostream>
@@ -36,6 +38,7 @@
 #if BASISU_SUPPORT_SSE
 // Declared in basisu_kernels_imp.h, but we can't include that here otherwise it would lead to circular type errors.
 extern void update_covar_matrix_16x16_sse41(uint32_t num_vecs, const void* pWeighted_vecs, const void* pOrigin, const uint32_t *pVec_indices, void* pMatrix16x16);
+extern void update_covar_matrix_16x16_avx2(uint32_t num_vecs, const void* pWeighted_vecs, const void* pOrigin, const uint32_t *pVec_indices, void* pMatrix16x16);
 #endif
 
 namespace basisu
@@ -52,12 +55,19 @@ namespace basisu
 	void basisu_encoder_deinit();
 
 	// basisu_kernels_sse.cpp - will be a no-op and g_cpu_supports_sse41 will always be false unless compiled with BASISU_SUPPORT_SSE=1
+	// Also sets g_cpu_supports_avx2 if the CPU and OS support AVX2.
 	extern void detect_sse41();
 
 #if BASISU_SUPPORT_SSE
 	extern bool g_cpu_supports_sse41;
+	extern bool g_cpu_supports_avx2;
+
+	// The SPMD kernels are built for SSE 4.1 (basisu_kernels_sse.cpp) and AVX2 (basisu_kernels_avx2.cpp).
+	// This picks the widest build the CPU supports. Only use it where g_cpu_supports_sse41 is true.
+	#define BASISU_SPMD_KERNEL(name) (g_cpu_supports_avx2 ? name##_avx2 : name##_sse41)
 #else
 	const bool g_cpu_supports_sse41 = false;
+	const bool g_cpu_supports_avx2 = false;
 #endif
 
 	void error_vprintf(const char* pFmt, va_list args);
@@ -690,12 +700,20 @@ namespace basisu
 
 #undef BASISU_GET_KEY
 	
-	// Very simple job pool with no dependencies.
+	// Work-stealing job pool.
+	// Each thread owns a deque of jobs. Threads push and pop their own jobs at the back (LIFO, for locality) and idle threads steal from the front of
+	// the others' deques, so adding and taking jobs rarely contends on a single lock. Jobs may depend on earlier jobs and ranges can be split across
+	// all threads with parallel_for().
 	class job_pool
 	{
 		BASISU_NO_EQUALS_OR_COPY_CONSTRUCT(job_pool);
 
+		struct job_node;
+
 	public:
+		// Handle to a job that later jobs can depend on.
+		typedef std::shared_ptr<job_node> job_handle;
+
 		// num_threads is the TOTAL number of job pool threads, including the calling thread! So 2=1 new thread, 3=2 new threads, etc.
 		job_pool(uint32_t num_threads);
 		~job_pool();
@@ -703,22 +721,79 @@ namespace basisu
 		void add_job(const std::function<void()>& job);
 		void add_job(std::function<void()>&& job);
 
+		// Adds a job that won't start until all num_deps jobs in pDeps have completed. Null handles are ignored.
+		job_handle add_job(std::function<void()>&& job, const job_handle* pDeps, uint32_t num_deps);
+
+		// Calls func(first, last) on disjoint subranges covering [begin, end) using all threads, including the calling thread, and returns once the
+		// whole range is done. Chunks start large and shrink as the range runs out so the threads finish together. No chunk is smaller than 
+		// min_chunk, except the last. May be called from within a job.
+		void parallel_for(uint32_t begin, uint32_t end, const std::function<void(uint32_t first, uint32_t last)>& func, uint32_t min_chunk = 1);
+
+		// Runs jobs on the calling thread until all jobs added so far, and any they depend on, have completed.
+		// Called from within a job it waits only for the jobs that job has added, so a job can itself use the pool, e.g. to compress one of many
+		// textures sharing the pool.
 		void wait_for_all();
 
+		// Runs jobs on the calling thread until the num_jobs jobs in pJobs have completed. Unlike wait_for_all() it doesn't wait for jobs added by
+		// other threads, so several callers can each wait for their own jobs on a shared pool.
+		void wait_for(const job_handle* pJobs, uint32_t num_jobs);
+
 		size_t get_total_threads() const { return 1 + m_threads.size(); }
 		
 	private:
+		// Counts the outstanding jobs added by one running job.
+		struct job_group
+		{
+			std::atomic<int> m_num_outstanding;
+
+			job_group() : m_num_outstanding(0) { }
+		};
+
+		struct job_entry
+		{
+			std::function<void()> m_func;
+			job_handle m_node;
+			std::shared_ptr<job_group> m_group;
+		};
+
+		// Context of the job being run by a thread. Jobs it adds are counted in m_group, created on first use.
+		struct running_job
+		{
+			const job_pool* m_pPool;
+			std::shared_ptr<job_group> m_group;
+			running_job* m_pPrev;
+		};
+
+		static thread_local running_job* s_pRunning_job;
+
+		struct job_deque
+		{
+			std::mutex m_mutex;
+			std::deque<job_entry> m_jobs;
+			char m_pad[64]; // Keep each deque's lock on its own cache line.
+		};
+
 		std::vector<std::thread> m_threads;
-		std::vector<std::function<void()> > m_queue;
+
+		// Deque 0 is shared by all threads outside the pool. Deque i+1 belongs to worker thread i.
+		std::vector<std::unique_ptr<job_deque> > m_deques;
 		
 		std::mutex m_mutex;
 		std::condition_variable m_has_work;
-		std::condition_variable m_no_more_jobs;
 		
-		uint32_t m_num_active_jobs;
+		std::atomic<int> m_num_queued;		// Jobs in the deques.
+		std::atomic<int> m_num_outstanding;	// Jobs added but not yet completed, including those waiting on dependencies.
+		std::atomic<int> m_num_sleeping;	// Threads waiting on m_has_work.
 		
 		std::atomic<bool> m_kill_flag;
 
+		uint32_t get_deque_index() const;
+		std::shared_ptr<job_group> begin_job();
+		void help_until_done(const std::atomic<int>& num_outstanding);
+		void push_job(job_entry&& job);
+		bool pop_job(uint32_t deque_index, job_entry& job);
+		bool try_run_job(uint32_t deque_index);
+		void run_job(job_entry& job);
 		void job_thread(uint32_t index);
 	};
 
@@ -1668,7 +1743,7 @@ namespace basisu
 				// This SSE function takes pointers to void types, so do some sanity checks.
 				assert(sizeof(TrainingVectorType) == sizeof(float) * 16);
 				assert(sizeof(training_vec_with_weight) == sizeof(std::pair<vec16F, uint64_t>));
-				update_covar_matrix_16x16_sse41(node.m_training_vecs.size(), m_training_vecs.data(), &node.m_origin, node.m_training_vecs.data(), &cmatrix);
+				BASISU_SPMD_KERNEL(update_covar_matrix_16x16)(node.m_training_vecs.size(), m_training_vecs.data(), &node.m_origin, node.m_training_vecs.data(), &cmatrix);
 #endif
 			}
 
@@ -3285,9 +3360,64 @@ namespace basisu
 	float srgb_to_linear(float s);
 
 	bool image_resample(const image &src, image &dst, bool srgb = false,
-		const char *pFilter = "lanczos4", float filter_scale = 1.0f, 
+		const char *pFilter = "lanczos4", float filter_scale = 1.0f,
 		bool wrapping = false,
-		uint32_t first_comp = 0, uint32_t num_comps = 4);
+		uint32_t first_comp = 0, uint32_t num_comps = 4,
+		job_pool *pJob_pool = nullptr);
+
+	// Separable image resampler for one source and destination size. The contributor tables are computed
+	// once by init() and shared by all the components and by every image resampled with the object, so
+	// one instance can be reused for all the slices of a texture with the same dimensions.
+	// resample() filters all 4 components of a pixel together and, given a job pool, processes bands of
+	// destination rows in parallel. The result doesn't depend on the number of threads.
+	class image_resampler
+	{
+		BASISU_NO_EQUALS_OR_COPY_CONSTRUCT(image_resampler);
+
+	public:
+		image_resampler() : m_src_w(0), m_src_h(0), m_dst_w(0), m_dst_h(0), m_delay_x_resample(false) { }
+
+		bool init(uint32_t src_w, uint32_t src_h, uint32_t dst_w, uint32_t dst_h,
+			const char *pFilter = "lanczos4", float filter_scale = 1.0f, bool wrapping = false);
+
+		void clear();
+
+		bool is_valid() const { return m_dst_w != 0; }
+
+		uint32_t get_src_width() const { return m_src_w; }
+		uint32_t get_src_height() const { return m_src_h; }
+		uint32_t get_dst_width() const { return m_dst_w; }
+		uint32_t get_dst_height() const { return m_dst_h; }
+
+		// src and dst must already have the dimensions given to init(). Thread safe.
+		bool resample(const image &src, image &dst, bool srgb = false,
+			uint32_t first_comp = 0, uint32_t num_comps = 4, job_pool *pJob_pool = nullptr) const;
+
+	private:
+		// Contributors of destination sample i are m_pixels/m_weights[m_first[i], m_first[i + 1]).
+		struct contrib_table
+		{
+			uint_vec m_first;
+			uint_vec m_pixels;
+			basisu::vector<float> m_weights;
+
+			void clear() { m_first.clear(); m_pixels.clear(); m_weights.clear(); }
+		};
+
+		uint32_t m_src_w, m_src_h, m_dst_w, m_dst_h;
+		contrib_table m_x, m_y;
+
+		// Resample Y before X, chosen as Resampler does by the number of multiplies.
+		bool m_delay_x_resample;
+
+		static bool init_contribs(contrib_table &table, uint32_t src_size, uint32_t dst_size,
+			int filter_index, float filter_scale, bool wrapping);
+
+		void resample_row_x(float *pDst, const float *pSrc) const;
+
+		void resample_bands(const image &src, image &dst, const float *pSrgb_to_linear, const uint8_t *pLinear_to_srgb,
+			uint32_t first_comp, uint32_t num_comps, uint32_t first_band, uint32_t last_band) const;
+	};
 
 	// Timing
 			
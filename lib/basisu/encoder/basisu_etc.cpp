@@ -17,6 +17,9 @@
 #if BASISU_SUPPORT_SSE
 #define CPPSPMD_NAME(a) a##_sse41
 #include "basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#define CPPSPMD_NAME(a) a##_avx2
+#include "basisu_kernels_declares.h"
 #endif
 
 #define BASISU_DEBUG_ETC_ENCODER 0
@@ -1004,6 +1007,8 @@ namespace basisu
 		m_selectors.resize(n);
 		m_best_selectors.resize(n);
 		m_temp_selectors.resize(n);
+		m_inten_table_selectors.resize(g_cpu_supports_sse41 ? n * cETC1IntenModifierValues : 0);
+		m_inten_table_scratch.resize(g_cpu_supports_sse41 ? n * 2 : 0);
 		m_trial_solution.m_selectors.resize(n);
 		m_best_solution.m_selectors.resize(n);
 
@@ -1135,6 +1140,7 @@ namespace basisu
 
 		const uint8_t *pSelectors_to_use = m_pParams->m_pForce_selectors;
 
+		uint32_t inten_table_mask = 0;
 		for (uint32_t inten_table = 0; inten_table < cETC1IntenModifierValues; inten_table++)
 		{
 			if (m_pParams->m_quality <= cETCQualityMedium)
@@ -1143,6 +1149,34 @@ namespace basisu
 					continue;
 			}
 
+			inten_table_mask |= 1U << inten_table;
+		}
+
+#if BASISU_SUPPORT_SSE
+		// Evaluate all the tables with one kernel call, which shares the per-pixel work between them and stops early on a table using the same rules as the
+		// per-table kernels. The linear distance is cheap enough that for a few pixels the shared setup costs more than it saves.
+		int64_t inten_table_errors[cETC1IntenModifierValues];
+		bool evaluated_all_tables = false;
+		if (g_cpu_supports_sse41)
+		{
+			if (m_pParams->m_perceptual)
+			{
+				BASISU_SPMD_KERNEL(evaluate_inten_tables_perceptual_rgb_N)(inten_table_errors, &m_inten_table_selectors[0], pSelectors_to_use, &base_color, &g_etc1_inten_tables[0][0], inten_table_mask, m_pParams->m_pSrc_pixels, n, &m_inten_table_scratch[0]);
+				evaluated_all_tables = true;
+			}
+			else if (n >= 16)
+			{
+				BASISU_SPMD_KERNEL(evaluate_inten_tables_linear_rgb_N)(inten_table_errors, &m_inten_table_selectors[0], pSelectors_to_use, &base_color, &g_etc1_inten_tables[0][0], inten_table_mask, m_pParams->m_pSrc_pixels, n, &m_inten_table_scratch[0]);
+				evaluated_all_tables = true;
+			}
+		}
+#endif
+
+		for (uint32_t inten_table = 0; inten_table < cETC1IntenModifierValues; inten_table++)
+		{
+			if ((inten_table_mask & (1U << inten_table)) == 0)
+				continue;
+
 #if 0
 			if (m_pParams->m_quality <= cETCQualityMedium)
 			{
@@ -1228,20 +1262,17 @@ namespace basisu
 			else
 			{
 #if BASISU_SUPPORT_SSE
-				if (pSelectors_to_use)
+				if (evaluated_all_tables)
 				{
-					if (m_pParams->m_perceptual)
-						perceptual_distance_rgb_4_N_sse41((int64_t*)&total_error, pSelectors_to_use, block_colors, pSrc_pixels, n, trial_solution.m_error);
-					else
-						linear_distance_rgb_4_N_sse41((int64_t*)&total_error, pSelectors_to_use, block_colors, pSrc_pixels, n, trial_solution.m_error);
+					total_error = inten_table_errors[inten_table];
+
+					if ((!pSelectors_to_use) && (total_error < trial_solution.m_error))
+						memcpy(&m_temp_selectors[0], &m_inten_table_selectors[inten_table * n], n);
 				}
+				else if (pSelectors_to_use)
+					BASISU_SPMD_KERNEL(linear_distance_rgb_4_N)((int64_t*)&total_error, pSelectors_to_use, block_colors, pSrc_pixels, n, trial_solution.m_error);
 				else
-				{
-					if (m_pParams->m_perceptual)
-						find_selectors_perceptual_rgb_4_N_sse41((int64_t*)&total_error, &m_temp_selectors[0], block_colors, pSrc_pixels, n, trial_solution.m_error);
-					else
-						find_selectors_linear_rgb_4_N_sse41((int64_t*)&total_error, &m_temp_selectors[0], block_colors, pSrc_pixels, n, trial_solution.m_error);
-				}
+					BASISU_SPMD_KERNEL(find_selectors_linear_rgb_4_N)((int64_t*)&total_error, &m_temp_selectors[0], block_colors, pSrc_pixels, n, trial_solution.m_error);
 #endif
 			}
 
@@ -1411,7 +1442,7 @@ namespace basisu
 						}
 
 						int64_t block_error;
-						perceptual_distance_rgb_4_N_sse41(&block_error, &m_temp_selectors[0], block_colors, pSrc_pixels, n, INT64_MAX);
+						BASISU_SPMD_KERNEL(perceptual_distance_rgb_4_N)(&block_error, &m_temp_selectors[0], block_colors, pSrc_pixels, n, INT64_MAX);
 						total_error += block_error;
 #endif
 					}
@@ -1074,6 +1074,8 @@ namespace basisu
 		potential_solution m_best_solution;
 		potential_solution m_trial_solution;
 		basisu::vector<uint8_t> m_temp_selectors;
+		basisu::vector<uint8_t> m_inten_table_selectors;
+		basisu::vector<int> m_inten_table_scratch;
 
 		enum { cSolutionsTriedHashBits = 10, cTotalSolutionsTriedHashSize = 1 << cSolutionsTriedHashBits, cSolutionsTriedHashMask = cTotalSolutionsTriedHashSize - 1 };
 		uint8_t m_solutions_tried[cTotalSolutionsTriedHashSize / 8];
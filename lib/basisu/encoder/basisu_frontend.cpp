@@ -26,6 +26,9 @@
 #if BASISU_SUPPORT_SSE
 #define CPPSPMD_NAME(a) a##_sse41
 #include "basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#define CPPSPMD_NAME(a) a##_avx2
+#include "basisu_kernels_declares.h"
 #endif
 
 #define BASISU_FRONTEND_VERIFY(c) do { if (!(c)) handle_verify_failure(__LINE__); } while(0)
@@ -165,7 +168,8 @@ namespace basisu
 
 		// Encode the initial high quality ETC1S texture
 
-		init_etc1_images();
+		if ((!m_params.m_reuse_etc1s_blocks) || (m_etc1_blocks_etc1s.size() != m_total_blocks))
+			init_etc1_images();
 
 		// First quantize the ETC1S endpoints
 
@@ -1901,7 +1905,7 @@ namespace basisu
 								else
 								{
 #if BASISU_SUPPORT_SSE
-									find_lowest_error_perceptual_rgb_4_N_sse41((int64_t*)&total_err, subblock_colors, pSubblock_pixels, num_subblock_pixels, best_cluster_err);
+									BASISU_SPMD_KERNEL(find_lowest_error_perceptual_rgb_4_N)((int64_t*)&total_err, subblock_colors, pSubblock_pixels, num_subblock_pixels, best_cluster_err);
 #endif
 								}
 							}
@@ -1929,7 +1933,7 @@ namespace basisu
 								else
 								{
 #if BASISU_SUPPORT_SSE
-									find_lowest_error_linear_rgb_4_N_sse41((int64_t*)&total_err, subblock_colors, pSubblock_pixels, num_subblock_pixels, best_cluster_err);
+									BASISU_SPMD_KERNEL(find_lowest_error_linear_rgb_4_N)((int64_t*)&total_err, subblock_colors, pSubblock_pixels, num_subblock_pixels, best_cluster_err);
 #endif
 								}
 							}
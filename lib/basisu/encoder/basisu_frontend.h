@@ -80,6 +80,7 @@ namespace basisu
 				m_validate(false),
 				m_multithreaded(false),
 				m_disable_hierarchical_endpoint_codebooks(false),
+				m_reuse_etc1s_blocks(false),
 				m_tex_type(basist::cBASISTexType2D),
 				m_pOpenCL_context(nullptr),
 				m_pJob_pool(nullptr)
@@ -101,6 +102,10 @@ namespace basisu
 			bool m_validate;
 			bool m_multithreaded;
 			bool m_disable_hierarchical_endpoint_codebooks;
+
+			// Keep the initial ETC1S blocks from the previous compress(). Only valid if the source blocks, m_compression_level
+			// and m_perceptual haven't changed since.
+			bool m_reuse_etc1s_blocks;
 			
 			basist::basis_texture_type m_tex_type;
 			const basist::basisu_lowlevel_etc1s_transcoder *m_pGlobal_codebooks;
@@ -0,0 +1,47 @@
+// basisu_kernels_avx2.cpp
+// Copyright (C) 2019-2021 Binomial LLC. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// The kernels of basisu_kernels_sse.cpp built for CPUs with AVX2, which BASISU_SPMD_KERNEL() selects
+// at runtime. This file must be compiled with AVX2 enabled (-mavx2 or /arch:AVX2) and nothing else in
+// the encoder may be, as it's only called after checking the CPU. It must not enable FMA either so
+// the results match the SSE 4.1 kernels exactly.
+#include "basisu_enc.h"
+
+#if BASISU_SUPPORT_SSE
+
+#define CPPSPMD_SSE2 0
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if !defined(__AVX2__)
+	#error Please check your compiler options
+#endif
+
+#if !defined(_MSC_VER) && defined(__FMA__)
+	#error FMA must not be enabled for this file
+#endif
+
+#include "cppspmd_sse.h"
+
+#include "cppspmd_type_aliases.h"
+
+using namespace basisu;
+
+#include "basisu_kernels_declares.h"
+#include "basisu_kernels_imp.h"
+
+#endif // #if BASISU_SUPPORT_SSE
@@ -23,5 +23,13 @@ void CPPSPMD_NAME(find_selectors_linear_rgb_4_N)(int64_t* pDistance, uint8_t* pS
 void CPPSPMD_NAME(find_lowest_error_perceptual_rgb_4_N)(int64_t* pDistance, const basisu::color_rgba* pBlock_colors, const basisu::color_rgba* pSrc_pixels, uint32_t n, int64_t early_out_error);
 void CPPSPMD_NAME(find_lowest_error_linear_rgb_4_N)(int64_t* pDistance, const basisu::color_rgba* pBlock_colors, const basisu::color_rgba* pSrc_pixels, uint32_t n, int64_t early_out_error);
 
+void CPPSPMD_NAME(evaluate_inten_tables_perceptual_rgb_N)(int64_t* pDistances, uint8_t* pSelectors, const uint8_t* pForce_selectors, const basisu::color_rgba* pBase_color, const int* pInten_tables, uint32_t table_mask, const basisu::color_rgba* pSrc_pixels, uint32_t n, int* pScratch);
+void CPPSPMD_NAME(evaluate_inten_tables_linear_rgb_N)(int64_t* pDistances, uint8_t* pSelectors, const uint8_t* pForce_selectors, const basisu::color_rgba* pBase_color, const int* pInten_tables, uint32_t table_mask, const basisu::color_rgba* pSrc_pixels, uint32_t n, int* pScratch);
+
 void CPPSPMD_NAME(update_covar_matrix_16x16)(uint32_t num_vecs, const void* pWeighted_vecs, const void *pOrigin, const uint32_t* pVec_indices, void *pMatrix16x16);
+
+void CPPSPMD_NAME(resample_rgba_row_x)(float* pDst, const float* pSrc, uint32_t dst_w, const uint32_t* pFirst, const uint32_t* pPixels, const float* pWeights);
+
+void CPPSPMD_NAME(filter_rows_N)(float* pDst, const float* const* ppSrc_rows, const float* pWeights, uint32_t num_taps, uint32_t n);
+void CPPSPMD_NAME(ssim_row_N)(float* pDst, const float* pMu_a, const float* pMu_b, const float* pA_sq, const float* pB_sq, const float* pA_b, float c1, float c2, uint32_t n);
 #endif
@@ -548,6 +548,364 @@ namespace CPPSPMD_NAME(basisu_kernels_namespace)
       }
    };
 
+   // Computes the error and selectors of each ETC1 intensity table in table_mask for one base color, stopping early on a table once it
+   // can't beat the best table before it, just like calling find_selectors_perceptual_rgb_4_N() or perceptual_distance_rgb_4_N() per table.
+   // For a block color that isn't clamped the chroma part of the perceptual distance doesn't depend on the intensity delta and the luma part
+   // only shifts by 128*delta, so both are computed once per pixel into pScratch (2 ints per pixel) and shared by all the tables.
+   struct evaluate_inten_tables_perceptual_rgb_N : spmd_kernel
+   {
+      inline vint compute_dist(
+         const vint& base_r, const vint& base_g, const vint& base_b,
+         const vint& r, const vint& g, const vint& b)
+      {
+         vint dr = base_r - r;
+         vint dg = base_g - g;
+         vint db = base_b - b;
+
+         vint delta_l = dr * 27 + dg * 92 + db * 9;
+         vint delta_cr = dr * 128 - delta_l;
+         vint delta_cb = db * 128 - delta_l;
+
+         vint id = VINT_SHIFT_RIGHT(delta_l * delta_l, 7) +
+            VINT_SHIFT_RIGHT(VINT_SHIFT_RIGHT(delta_cr * delta_cr, 7) * 26, 7) +
+            VINT_SHIFT_RIGHT(VINT_SHIFT_RIGHT(delta_cb * delta_cb, 7) * 3, 7);
+
+         return id;
+      }
+
+      void _call(int64_t* pDistances,
+         uint8_t* pSelectors,
+         const uint8_t* pForce_selectors,
+         const color_rgba* pBase_color, const int* pInten_tables, uint32_t table_mask,
+         const color_rgba* pSrc_pixels, uint32_t n,
+         int* pScratch)
+      {
+         const vint base_r((int)pBase_color->r), base_g((int)pBase_color->g), base_b((int)pBase_color->b);
+
+         uint32_t i;
+
+         for (i = 0; (i + 4) <= n; i += 4)
+         {
+            __m128i c0 = load_rgba32(&pSrc_pixels[i + 0]), c1 = load_rgba32(&pSrc_pixels[i + 1]), c2 = load_rgba32(&pSrc_pixels[i + 2]), c3 = load_rgba32(&pSrc_pixels[i + 3]);
+
+            vint r, g, b, a;
+            transpose4x4(r.m_value, g.m_value, b.m_value, a.m_value, c0, c1, c2, c3);
+
+            vint dr = base_r - r;
+            vint dg = base_g - g;
+            vint db = base_b - b;
+
+            vint delta_l = dr * 27 + dg * 92 + db * 9;
+            vint delta_cr = dr * 128 - delta_l;
+            vint delta_cb = db * 128 - delta_l;
+
+            storeu_linear_all(pScratch + i * 2, delta_l);
+            storeu_linear_all(pScratch + i * 2 + 4, VINT_SHIFT_RIGHT(VINT_SHIFT_RIGHT(delta_cr * delta_cr, 7) * 26, 7) + VINT_SHIFT_RIGHT(VINT_SHIFT_RIGHT(delta_cb * delta_cb, 7) * 3, 7));
+         }
+
+         const int min_base = minimum(pBase_color->r, pBase_color->g, pBase_color->b), max_base = maximum(pBase_color->r, pBase_color->g, pBase_color->b);
+
+         const __m128i shuf = _mm_set_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 12, 8, 4, 0);
+
+         int64_t best_distance = INT64_MAX;
+
+         for (uint32_t t = 0; t < 8; t++)
+         {
+            pDistances[t] = INT64_MAX;
+            if ((table_mask & (1 << t)) == 0)
+               continue;
+
+            const int* pInten_table = pInten_tables + t * 4;
+
+            // Only the tables whose deltas push a block color out of range need the full distance calculation.
+            bool unclamped[4];
+            bool any_clamped = false;
+            vint delta_l_ofs[4];
+            for (uint32_t s = 0; s < 4; s++)
+            {
+               const int yd = pInten_table[s];
+
+               unclamped[s] = ((min_base + yd) >= 0) && ((max_base + yd) <= 255);
+               any_clamped |= !unclamped[s];
+
+               store_all(delta_l_ofs[s], yd * 128);
+            }
+
+            // Only needed for clamped tables and the last n & 3 pixels, but cheap enough to always set so no path reads them uninitialized.
+            color_rgba block_colors[4];
+            vint block_colors_r[4], block_colors_g[4], block_colors_b[4];
+            for (uint32_t s = 0; s < 4; s++)
+            {
+               block_colors[s].set(pBase_color->r + pInten_table[s], pBase_color->g + pInten_table[s], pBase_color->b + pInten_table[s], 255);
+
+               store_all(block_colors_r[s], (int)block_colors[s].r);
+               store_all(block_colors_g[s], (int)block_colors[s].g);
+               store_all(block_colors_b[s], (int)block_colors[s].b);
+            }
+
+            uint8_t* pTable_selectors = pSelectors + t * n;
+
+            int64_t distance = 0;
+
+            for (i = 0; (i + 4) <= n; i += 4)
+            {
+               vint delta_l = loadu_linear_all(pScratch + i * 2);
+               vint chroma_dist = loadu_linear_all(pScratch + i * 2 + 4);
+
+               vint r(0), g(0), b(0), a;
+               if (any_clamped)
+               {
+                  __m128i c0 = load_rgba32(&pSrc_pixels[i + 0]), c1 = load_rgba32(&pSrc_pixels[i + 1]), c2 = load_rgba32(&pSrc_pixels[i + 2]), c3 = load_rgba32(&pSrc_pixels[i + 3]);
+                  transpose4x4(r.m_value, g.m_value, b.m_value, a.m_value, c0, c1, c2, c3);
+               }
+
+               vint dist[4];
+               for (uint32_t s = 0; s < 4; s++)
+               {
+                  if (unclamped[s])
+                  {
+                     vint l = delta_l + delta_l_ofs[s];
+                     store_all(dist[s], VINT_SHIFT_RIGHT(l * l, 7) + chroma_dist);
+                  }
+                  else
+                     store_all(dist[s], compute_dist(block_colors_r[s], block_colors_g[s], block_colors_b[s], r, g, b));
+               }
+
+               vint best_dist;
+               if (pForce_selectors)
+               {
+                  vint sels(_mm_set_epi32(pForce_selectors[i + 3], pForce_selectors[i + 2], pForce_selectors[i + 1], pForce_selectors[i]));
+                  store_all(best_dist, spmd_ternaryi(sels == 0, dist[0], spmd_ternaryi(sels == 1, dist[1], spmd_ternaryi(sels == 2, dist[2], dist[3]))));
+               }
+               else
+               {
+                  store_all(best_dist, min(min(min(dist[0], dist[1]), dist[2]), dist[3]));
+
+                  vint sels = spmd_ternaryi(best_dist == dist[0], 0, spmd_ternaryi(best_dist == dist[1], 1, spmd_ternaryi(best_dist == dist[2], 2, 3)));
+
+                  __m128i vsels = shuffle_epi8(sels.m_value, shuf);
+                  storeu_si32((void *)(pTable_selectors + i), vsels);
+               }
+
+               distance += reduce_add(best_dist);
+               if (distance >= best_distance)
+                  break;
+            }
+
+            if (distance < best_distance)
+            {
+               for (; i < n; i++)
+               {
+                  int r = pSrc_pixels[i].r, g = pSrc_pixels[i].g, b = pSrc_pixels[i].b;
+
+                  int best_err = INT_MAX, best_sel = 0;
+                  for (int sel = 0; sel < 4; sel++)
+                  {
+                     if ((pForce_selectors) && (sel != pForce_selectors[i]))
+                        continue;
+
+                     int dr = block_colors[sel].r - r;
+                     int dg = block_colors[sel].g - g;
+                     int db = block_colors[sel].b - b;
+
+                     int delta_l = dr * 27 + dg * 92 + db * 9;
+                     int delta_cr = dr * 128 - delta_l;
+                     int delta_cb = db * 128 - delta_l;
+
+                     int id = ((delta_l * delta_l) >> 7) +
+                        ((((delta_cr * delta_cr) >> 7) * 26) >> 7) +
+                        ((((delta_cb * delta_cb) >> 7) * 3) >> 7);
+
+                     if (id < best_err)
+                     {
+                        best_err = id;
+                        best_sel = sel;
+                     }
+                  }
+
+                  pTable_selectors[i] = (uint8_t)best_sel;
+
+                  distance += best_err;
+                  if (distance >= best_distance)
+                     break;
+               }
+            }
+
+            pDistances[t] = distance;
+            if (distance < best_distance)
+               best_distance = distance;
+         }
+      }
+   };
+
+   // Linear RGB version of evaluate_inten_tables_perceptual_rgb_N(). For a block color that isn't clamped the squared distance is
+   // sum(d*d) + 2*yd*sum(d) + 3*yd*yd, where d is the pixel's distance to the base color, so the two sums go into pScratch.
+   struct evaluate_inten_tables_linear_rgb_N : spmd_kernel
+   {
+      inline vint compute_dist(
+         const vint& base_r, const vint& base_g, const vint& base_b,
+         const vint& r, const vint& g, const vint& b)
+      {
+         vint dr = base_r - r;
+         vint dg = base_g - g;
+         vint db = base_b - b;
+
+         vint id = dr * dr + dg * dg + db * db;
+         return id;
+      }
+
+      void _call(int64_t* pDistances,
+         uint8_t* pSelectors,
+         const uint8_t* pForce_selectors,
+         const color_rgba* pBase_color, const int* pInten_tables, uint32_t table_mask,
+         const color_rgba* pSrc_pixels, uint32_t n,
+         int* pScratch)
+      {
+         const vint base_r((int)pBase_color->r), base_g((int)pBase_color->g), base_b((int)pBase_color->b);
+
+         uint32_t i;
+
+         for (i = 0; (i + 4) <= n; i += 4)
+         {
+            __m128i c0 = load_rgba32(&pSrc_pixels[i + 0]), c1 = load_rgba32(&pSrc_pixels[i + 1]), c2 = load_rgba32(&pSrc_pixels[i + 2]), c3 = load_rgba32(&pSrc_pixels[i + 3]);
+
+            vint r, g, b, a;
+            transpose4x4(r.m_value, g.m_value, b.m_value, a.m_value, c0, c1, c2, c3);
+
+            vint dr = base_r - r;
+            vint dg = base_g - g;
+            vint db = base_b - b;
+
+            storeu_linear_all(pScratch + i * 2, dr * dr + dg * dg + db * db);
+            storeu_linear_all(pScratch + i * 2 + 4, dr + dg + db);
+         }
+
+         const int min_base = minimum(pBase_color->r, pBase_color->g, pBase_color->b), max_base = maximum(pBase_color->r, pBase_color->g, pBase_color->b);
+
+         const __m128i shuf = _mm_set_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 12, 8, 4, 0);
+
+         int64_t best_distance = INT64_MAX;
+
+         for (uint32_t t = 0; t < 8; t++)
+         {
+            pDistances[t] = INT64_MAX;
+            if ((table_mask & (1 << t)) == 0)
+               continue;
+
+            const int* pInten_table = pInten_tables + t * 4;
+
+            // Only the tables whose deltas push a block color out of range need the full distance calculation.
+            bool unclamped[4];
+            bool any_clamped = false;
+            vint delta_scale[4], delta_ofs[4];
+            for (uint32_t s = 0; s < 4; s++)
+            {
+               const int yd = pInten_table[s];
+
+               unclamped[s] = ((min_base + yd) >= 0) && ((max_base + yd) <= 255);
+               any_clamped |= !unclamped[s];
+
+               store_all(delta_scale[s], yd * 2);
+               store_all(delta_ofs[s], yd * yd * 3);
+            }
+
+            // Only needed for clamped tables and the last n & 3 pixels, but cheap enough to always set so no path reads them uninitialized.
+            color_rgba block_colors[4];
+            vint block_colors_r[4], block_colors_g[4], block_colors_b[4];
+            for (uint32_t s = 0; s < 4; s++)
+            {
+               block_colors[s].set(pBase_color->r + pInten_table[s], pBase_color->g + pInten_table[s], pBase_color->b + pInten_table[s], 255);
+
+               store_all(block_colors_r[s], (int)block_colors[s].r);
+               store_all(block_colors_g[s], (int)block_colors[s].g);
+               store_all(block_colors_b[s], (int)block_colors[s].b);
+            }
+
+            uint8_t* pTable_selectors = pSelectors + t * n;
+
+            int64_t distance = 0;
+
+            for (i = 0; (i + 4) <= n; i += 4)
+            {
+               vint base_dist = loadu_linear_all(pScratch + i * 2);
+               vint delta_sum = loadu_linear_all(pScratch + i * 2 + 4);
+
+               vint r(0), g(0), b(0), a;
+               if (any_clamped)
+               {
+                  __m128i c0 = load_rgba32(&pSrc_pixels[i + 0]), c1 = load_rgba32(&pSrc_pixels[i + 1]), c2 = load_rgba32(&pSrc_pixels[i + 2]), c3 = load_rgba32(&pSrc_pixels[i + 3]);
+                  transpose4x4(r.m_value, g.m_value, b.m_value, a.m_value, c0, c1, c2, c3);
+               }
+
+               vint dist[4];
+               for (uint32_t s = 0; s < 4; s++)
+               {
+                  if (unclamped[s])
+                     store_all(dist[s], base_dist + delta_sum * delta_scale[s] + delta_ofs[s]);
+                  else
+                     store_all(dist[s], compute_dist(block_colors_r[s], block_colors_g[s], block_colors_b[s], r, g, b));
+               }
+
+               vint best_dist;
+               if (pForce_selectors)
+               {
+                  vint sels(_mm_set_epi32(pForce_selectors[i + 3], pForce_selectors[i + 2], pForce_selectors[i + 1], pForce_selectors[i]));
+                  store_all(best_dist, spmd_ternaryi(sels == 0, dist[0], spmd_ternaryi(sels == 1, dist[1], spmd_ternaryi(sels == 2, dist[2], dist[3]))));
+               }
+               else
+               {
+                  store_all(best_dist, min(min(min(dist[0], dist[1]), dist[2]), dist[3]));
+
+                  vint sels = spmd_ternaryi(best_dist == dist[0], 0, spmd_ternaryi(best_dist == dist[1], 1, spmd_ternaryi(best_dist == dist[2], 2, 3)));
+
+                  __m128i vsels = shuffle_epi8(sels.m_value, shuf);
+                  storeu_si32((void *)(pTable_selectors + i), vsels);
+               }
+
+               distance += reduce_add(best_dist);
+               if (distance >= best_distance)
+                  break;
+            }
+
+            if (distance < best_distance)
+            {
+               for (; i < n; i++)
+               {
+                  int r = pSrc_pixels[i].r, g = pSrc_pixels[i].g, b = pSrc_pixels[i].b;
+
+                  int best_err = INT_MAX, best_sel = 0;
+                  for (int sel = 0; sel < 4; sel++)
+                  {
+                     if ((pForce_selectors) && (sel != pForce_selectors[i]))
+                        continue;
+
+                     int dr = block_colors[sel].r - r;
+                     int dg = block_colors[sel].g - g;
+                     int db = block_colors[sel].b - b;
+
+                     int id = dr * dr + dg * dg + db * db;
+                     if (id < best_err)
+                     {
+                        best_err = id;
+                        best_sel = sel;
+                     }
+                  }
+
+                  pTable_selectors[i] = (uint8_t)best_sel;
+
+                  distance += best_err;
+                  if (distance >= best_distance)
+                     break;
+               }
+            }
+
+            pDistances[t] = distance;
+            if (distance < best_distance)
+               best_distance = distance;
+         }
+      }
+   };
+
    struct update_covar_matrix_16x16 : spmd_kernel
    {
       void _call(
@@ -607,6 +965,65 @@ namespace CPPSPMD_NAME(basisu_kernels_namespace)
       }
    };
 
+   // Horizontally resamples a row of RGBA float pixels, one pixel per vector.
+   struct resample_rgba_row_x : spmd_kernel
+   {
+      void _call(float* pDst, const float* pSrc, uint32_t dst_w, const uint32_t* pFirst, const uint32_t* pPixels, const float* pWeights)
+      {
+         for (uint32_t x = 0; x < dst_w; x++)
+         {
+            vfloat total = zero_vfloat();
+
+            for (uint32_t k = pFirst[x]; k < pFirst[x + 1]; k++)
+               store_all(total, total + loadu_linear_all(pSrc + pPixels[k] * 4) * vfloat(pWeights[k]));
+
+            storeu_linear_all(pDst + x * 4, total);
+         }
+      }
+   };
+
+   // pDst[x] = sum of ppSrc_rows[i][x] * pWeights[i]. Processes whole vectors so the rows must be readable and pDst writable up to n rounded up to a multiple of 4.
+   struct filter_rows_N : spmd_kernel
+   {
+      void _call(float* pDst, const float* const* ppSrc_rows, const float* pWeights, uint32_t num_taps, uint32_t n)
+      {
+         for (uint32_t x = 0; x < n; x += PROGRAM_COUNT)
+         {
+            vfloat total = zero_vfloat();
+
+            for (uint32_t i = 0; i < num_taps; i++)
+               store_all(total, total + loadu_linear_all(ppSrc_rows[i] + x) * vfloat(pWeights[i]));
+
+            storeu_linear_all(pDst + x, total);
+         }
+      }
+   };
+
+   // SSIM of each pixel from the gaussian filtered a, b, a*a, b*b and a*b. Same padding requirement as filter_rows_N.
+   struct ssim_row_N : spmd_kernel
+   {
+      void _call(float* pDst, const float* pMu_a, const float* pMu_b, const float* pA_sq, const float* pB_sq, const float* pA_b, float c1, float c2, uint32_t n)
+      {
+         for (uint32_t x = 0; x < n; x += PROGRAM_COUNT)
+         {
+            vfloat mu_a = loadu_linear_all(pMu_a + x);
+            vfloat mu_b = loadu_linear_all(pMu_b + x);
+            vfloat mu_a_sq = mu_a * mu_a;
+            vfloat mu_b_sq = mu_b * mu_b;
+            vfloat mu_ab = mu_a * mu_b;
+
+            vfloat s_a = loadu_linear_all(pA_sq + x) - mu_a_sq;
+            vfloat s_b = loadu_linear_all(pB_sq + x) - mu_b_sq;
+            vfloat s_ab = loadu_linear_all(pA_b + x) - mu_ab;
+
+            vfloat num = (mu_ab * 2.0f + c1) * (s_ab * 2.0f + c2);
+            vfloat den = (mu_a_sq + mu_b_sq + c1) * (s_a + s_b + c2);
+
+            storeu_linear_all(pDst + x, num / den);
+         }
+      }
+   };
+
 } // namespace
 
 using namespace CPPSPMD_NAME(basisu_kernels_namespace);
@@ -641,7 +1058,32 @@ void CPPSPMD_NAME(find_lowest_error_linear_rgb_4_N)(int64_t* pDistance, const co
    spmd_call< find_lowest_error_linear_rgb_4_N >(pDistance, pBlock_colors, pSrc_pixels, n, early_out_error);
 }
 
+void CPPSPMD_NAME(evaluate_inten_tables_perceptual_rgb_N)(int64_t* pDistances, uint8_t* pSelectors, const uint8_t* pForce_selectors, const color_rgba* pBase_color, const int* pInten_tables, uint32_t table_mask, const color_rgba* pSrc_pixels, uint32_t n, int* pScratch)
+{
+   spmd_call< evaluate_inten_tables_perceptual_rgb_N >(pDistances, pSelectors, pForce_selectors, pBase_color, pInten_tables, table_mask, pSrc_pixels, n, pScratch);
+}
+
+void CPPSPMD_NAME(evaluate_inten_tables_linear_rgb_N)(int64_t* pDistances, uint8_t* pSelectors, const uint8_t* pForce_selectors, const color_rgba* pBase_color, const int* pInten_tables, uint32_t table_mask, const color_rgba* pSrc_pixels, uint32_t n, int* pScratch)
+{
+   spmd_call< evaluate_inten_tables_linear_rgb_N >(pDistances, pSelectors, pForce_selectors, pBase_color, pInten_tables, table_mask, pSrc_pixels, n, pScratch);
+}
+
 void CPPSPMD_NAME(update_covar_matrix_16x16)(uint32_t num_vecs, const void* pWeighted_vecs, const void* pOrigin, const uint32_t *pVec_indices, void* pMatrix16x16)
 {
    spmd_call < update_covar_matrix_16x16 >(num_vecs, pWeighted_vecs, pOrigin, pVec_indices, pMatrix16x16);
 }
+
+void CPPSPMD_NAME(resample_rgba_row_x)(float* pDst, const float* pSrc, uint32_t dst_w, const uint32_t* pFirst, const uint32_t* pPixels, const float* pWeights)
+{
+   spmd_call < resample_rgba_row_x >(pDst, pSrc, dst_w, pFirst, pPixels, pWeights);
+}
+
+void CPPSPMD_NAME(filter_rows_N)(float* pDst, const float* const* ppSrc_rows, const float* pWeights, uint32_t num_taps, uint32_t n)
+{
+   spmd_call < filter_rows_N >(pDst, ppSrc_rows, pWeights, num_taps, n);
+}
+
+void CPPSPMD_NAME(ssim_row_N)(float* pDst, const float* pMu_a, const float* pMu_b, const float* pA_sq, const float* pB_sq, const float* pA_b, float c1, float c2, uint32_t n)
+{
+   spmd_call < ssim_row_N >(pDst, pMu_a, pMu_b, pA_sq, pB_sq, pA_b, c1, c2, n);
+}
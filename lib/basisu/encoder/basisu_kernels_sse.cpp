@@ -64,6 +64,7 @@ struct cpu_info
 	bool m_has_sse42;
 	bool m_has_avx;
 	bool m_has_avx2;
+	bool m_has_osxsave;
 	bool m_has_pclmulqdq;
 };
 
@@ -79,6 +80,7 @@ static void extract_x86_flags(cpu_info &info, uint32_t ecx, uint32_t edx)
 	info.m_has_sse42 = (ecx & (1 << 20)) != 0;
 	info.m_has_pclmulqdq = (ecx & (1 << 1)) != 0;
 	info.m_has_avx = (ecx & (1 << 28)) != 0;
+	info.m_has_osxsave = (ecx & (1 << 27)) != 0;
 }
 
 static void extract_x86_extended_flags(cpu_info &info, uint32_t ebx)
@@ -138,6 +140,24 @@ static void get_cpuinfo(cpu_info &info)
 	}
 }
 
+// Returns true if the OS saves the YMM registers on context switches.
+static bool os_supports_avx(const cpu_info &info)
+{
+	if (!info.m_has_osxsave)
+		return false;
+
+#ifdef _MSC_VER
+	const uint64_t xcr0 = _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__("xgetbv;" : "=a"(eax), "=d"(edx) : "c"(0));
+	const uint64_t xcr0 = ((uint64_t)edx << 32) | eax;
+#endif
+
+	// XMM and YMM state
+	return (xcr0 & 6) == 6;
+}
+
 void detect_sse41()
 {
 	cpu_info info;
@@ -145,6 +165,8 @@ void detect_sse41()
 
 	// Check for everything from SSE to SSE 4.1
 	g_cpu_supports_sse41 = info.m_has_sse && info.m_has_sse2 && info.m_has_sse3 && info.m_has_ssse3 && info.m_has_sse41;
+
+	g_cpu_supports_avx2 = g_cpu_supports_sse41 && info.m_has_avx && info.m_has_avx2 && os_supports_avx(info);
 }
 
 } // namespace basisu
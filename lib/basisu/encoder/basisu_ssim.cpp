@@ -14,6 +14,14 @@
 // limitations under the License.
 #include "basisu_ssim.h"
 
+#if BASISU_SUPPORT_SSE
+#define CPPSPMD_NAME(a) a##_sse41
+#include "basisu_kernels_declares.h"
+#undef CPPSPMD_NAME
+#define CPPSPMD_NAME(a) a##_avx2
+#include "basisu_kernels_declares.h"
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -365,44 +373,305 @@ namespace basisu
 		return avg_image(smap);
 	}
 
-	vec4F compute_ssim(const image &a, const image &b, bool luma, bool luma_601)
+	vec4F compute_ssim(const image &a, const image &b, bool luma, bool luma_601, job_pool *pJob_pool)
 	{
-		image ta(a), tb(b);
-
-		if ((ta.get_width() != tb.get_width()) || (ta.get_height() != tb.get_height()))
-		{
+		if ((a.get_width() != b.get_width()) || (a.get_height() != b.get_height()))
 			debug_printf("compute_ssim: Cropping input images to equal dimensions\n");
 
-			const uint32_t w = minimum(a.get_width(), b.get_width());
-			const uint32_t h = minimum(a.get_height(), b.get_height());
-			ta.crop(w, h);
-			tb.crop(w, h);
-		}
+		image_quality q;
+		compute_image_quality(a, b, luma, luma_601, q, pJob_pool);
 
-		if (!ta.get_width() || !ta.get_height())
+		if (!q.m_width || !q.m_height)
 		{
 			assert(0);
 			return vec4F(0);
 		}
 
-		if (luma)
+		return q.m_ssim;
+	}
+
+	void image_quality::clear()
+	{
+		m_width = 0;
+		m_height = 0;
+		clear_obj(m_max_error);
+		clear_obj(m_total_error);
+		clear_obj(m_total_sq_error);
+		m_ssim.set(0.0f);
+		m_luma_ssim = false;
+		m_luma_601 = false;
+	}
+
+	void image_quality::get_metrics(image_metrics &em, uint32_t first_chan, uint32_t total_chans, bool use_601_luma) const
+	{
+		assert((first_chan < 4U) && (first_chan + total_chans <= 4U));
+
+		const uint32_t first = total_chans ? first_chan : (use_601_luma ? (uint32_t)cChanLuma601 : (uint32_t)cChanLuma709);
+		const uint32_t num_chans = maximum<uint32_t>(total_chans, 1);
+
+		uint32_t max_error = 0;
+		double sum = 0.0f, sum2 = 0.0f;
+		for (uint32_t c = first; c < first + num_chans; c++)
+		{
+			max_error = maximum(max_error, m_max_error[c]);
+			sum += (double)m_total_error[c];
+			sum2 += (double)m_total_sq_error[c];
+		}
+
+		const double total_values = (double)m_width * (double)m_height * (double)num_chans;
+
+		em.m_max = (float)max_error;
+		em.m_mean = (float)clamp<double>(sum / total_values, 0.0f, 255.0);
+		em.m_mean_squared = (float)clamp<double>(sum2 / total_values, 0.0f, 255.0f * 255.0f);
+		em.m_rms = (float)sqrt(em.m_mean_squared);
+		em.m_psnr = em.m_rms ? (float)clamp<double>(log10(255.0 / em.m_rms) * 20.0f, 0.0f, 100.0f) : 100.0f;
+
+		em.m_ssim = 0.0f;
+		if (!total_chans)
+		{
+			if ((m_luma_ssim) && (m_luma_601 == use_601_luma))
+				em.m_ssim = m_ssim[0];
+		}
+		else if (!m_luma_ssim)
+		{
+			for (uint32_t c = first_chan; c < first_chan + total_chans; c++)
+				em.m_ssim += m_ssim[c] / total_chans;
+		}
+	}
+
+	// The same 11x11 gaussian, sigma 1.5, as compute_ssim(const imagef &, const imagef &), applied as two 1D passes.
+	const int cQualityFilterRadius = 5;
+	const int cQualityFilterTaps = cQualityFilterRadius * 2 + 1;
+
+	// Rows per unit of work. The totals are kept per band and summed in order so the results don't depend on how the bands are split.
+	const uint32_t cQualityBandHeight = 32;
+
+	struct quality_band_totals
+	{
+		double m_ssim[4];
+		uint32_t m_max_error[image_quality::cTotalChans];
+		uint64_t m_total_error[image_quality::cTotalChans];
+		uint64_t m_total_sq_error[image_quality::cTotalChans];
+	};
+
+	static void filter_rows(float *pDst, const float *const *ppSrc_rows, const float *pWeights, uint32_t num_taps, uint32_t n)
+	{
+#if BASISU_SUPPORT_SSE
+		if (g_cpu_supports_sse41)
+		{
+			BASISU_SPMD_KERNEL(filter_rows_N)(pDst, ppSrc_rows, pWeights, num_taps, n);
+			return;
+		}
+#endif
+
+		for (uint32_t x = 0; x < n; x++)
+		{
+			float total = 0.0f;
+			for (uint32_t i = 0; i < num_taps; i++)
+				total += ppSrc_rows[i][x] * pWeights[i];
+			pDst[x] = total;
+		}
+	}
+
+	static void ssim_row(float *pDst, const float *pMu_a, const float *pMu_b, const float *pA_sq, const float *pB_sq, const float *pA_b, float c1, float c2, uint32_t n)
+	{
+#if BASISU_SUPPORT_SSE
+		if (g_cpu_supports_sse41)
+		{
+			BASISU_SPMD_KERNEL(ssim_row_N)(pDst, pMu_a, pMu_b, pA_sq, pB_sq, pA_b, c1, c2, n);
+			return;
+		}
+#endif
+
+		for (uint32_t x = 0; x < n; x++)
+		{
+			const float mu_a_sq = pMu_a[x] * pMu_a[x];
+			const float mu_b_sq = pMu_b[x] * pMu_b[x];
+			const float mu_ab = pMu_a[x] * pMu_b[x];
+
+			const float s_a = pA_sq[x] - mu_a_sq;
+			const float s_b = pB_sq[x] - mu_b_sq;
+			const float s_ab = pA_b[x] - mu_ab;
+
+			pDst[x] = ((mu_ab * 2.0f + c1) * (s_ab * 2.0f + c2)) / ((mu_a_sq + mu_b_sq + c1) * (s_a + s_b + c2));
+		}
+	}
+
+	// Accumulates rows [y_begin, y_end) of the image quality into pBands, starting with the band containing y_begin, which must be the first
+	// row of a band. Keeps the horizontally filtered values of the last cQualityFilterTaps rows in a ring, so each row is filtered once.
+	static void compute_image_quality_rows(const image &a, const image &b, uint32_t width, uint32_t height, bool luma_ssim, bool luma_601,
+		const float *pKernel, uint32_t y_begin, uint32_t y_end, quality_band_totals *pBands)
+	{
+		const float C1 = 6.50250f, C2 = 58.52250f;
+		const int R = cQualityFilterRadius, T = cQualityFilterTaps;
+		const uint32_t num_chans = luma_ssim ? 2 : 4;
+
+		// The kernels process whole vectors of 4 so round up the rows they read or write.
+		const uint32_t row_len = (width + 3) & ~3U;
+		const uint32_t padded_len = row_len + R * 2;
+
+		// a, b, a*a, b*b and a*b of a source row per channel, with the edge pixels repeated R times on each side.
+		basisu::vector<float> src(num_chans * 5 * padded_len);
+		// The same filtered horizontally, for the last T rows.
+		basisu::vector<float> ring(T * num_chans * 5 * row_len);
+		// The same filtered vertically for the current row, and the SSIM of each pixel.
+		basisu::vector<float> filtered(5 * row_len), ssim(row_len);
+
+		const float *rows[cQualityFilterTaps];
+		const int first_row = (int)y_begin - R;
+
+		auto filter_src_row = [&](int y)
+		{
+			const uint32_t sy = clamp<int>(y, 0, height - 1);
+
+			for (uint32_t x = 0; x < width + R * 2; x++)
+			{
+				const uint32_t sx = clamp<int>((int)x - R, 0, width - 1);
+				const color_rgba &ca = a(sx, sy), &cb = b(sx, sy);
+
+				for (uint32_t c = 0; c < num_chans; c++)
+				{
+					float va, vb;
+					if (luma_ssim)
+					{
+						va = c ? ca.a : (float)ca.get_luma(luma_601);
+						vb = c ? cb.a : (float)cb.get_luma(luma_601);
+					}
+					else
+					{
+						va = ca[c];
+						vb = cb[c];
+					}
+
+					float *pSrc = &src[c * 5 * padded_len];
+					pSrc[x] = va;
+					pSrc[padded_len + x] = vb;
+					pSrc[padded_len * 2 + x] = va * va;
+					pSrc[padded_len * 3 + x] = vb * vb;
+					pSrc[padded_len * 4 + x] = va * vb;
+				}
+			}
+
+			const uint32_t slot = (y - first_row) % T;
+			for (uint32_t i = 0; i < num_chans * 5; i++)
+			{
+				for (int t = 0; t < T; t++)
+					rows[t] = &src[i * padded_len + t];
+
+				filter_rows(&ring[(slot * num_chans * 5 + i) * row_len], rows, pKernel, T, width);
+			}
+		};
+
+		for (int y = first_row; y < (int)y_begin + R; y++)
+			filter_src_row(y);
+
+		for (uint32_t y = y_begin; y < y_end; y++)
 		{
-			for (uint32_t y = 0; y < ta.get_height(); y++)
+			filter_src_row(y + R);
+
+			quality_band_totals &band = pBands[(y - y_begin) / cQualityBandHeight];
+
+			for (uint32_t c = 0; c < num_chans; c++)
 			{
-				for (uint32_t x = 0; x < ta.get_width(); x++)
+				for (uint32_t q = 0; q < 5; q++)
 				{
-					ta(x, y).set(ta(x, y).get_luma(luma_601), ta(x, y).a);
-					tb(x, y).set(tb(x, y).get_luma(luma_601), tb(x, y).a);
+					for (int t = 0; t < T; t++)
+					{
+						const uint32_t slot = ((int)y - R + t - first_row) % T;
+						rows[t] = &ring[((slot * num_chans + c) * 5 + q) * row_len];
+					}
+
+					filter_rows(&filtered[q * row_len], rows, pKernel, T, width);
+				}
+
+				ssim_row(ssim.data(), &filtered[0], &filtered[row_len], &filtered[row_len * 2], &filtered[row_len * 3], &filtered[row_len * 4], C1, C2, width);
+
+				double total = 0.0f;
+				for (uint32_t x = 0; x < width; x++)
+					total += ssim[x];
+				band.m_ssim[c] += total;
+			}
+
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const color_rgba &ca = a(x, y), &cb = b(x, y);
+
+				uint32_t errors[image_quality::cTotalChans];
+				for (uint32_t c = 0; c < 4; c++)
+					errors[c] = iabs(ca[c] - cb[c]);
+				errors[image_quality::cChanLuma709] = iabs(ca.get_709_luma() - cb.get_709_luma());
+				errors[image_quality::cChanLuma601] = iabs(ca.get_601_luma() - cb.get_601_luma());
+
+				for (uint32_t c = 0; c < image_quality::cTotalChans; c++)
+				{
+					band.m_max_error[c] = maximum(band.m_max_error[c], errors[c]);
+					band.m_total_error[c] += errors[c];
+					band.m_total_sq_error[c] += errors[c] * errors[c];
 				}
 			}
 		}
+	}
+
+	void compute_image_quality(const image &a, const image &b, bool luma_ssim, bool luma_601, image_quality &q, job_pool *pJob_pool)
+	{
+		q.clear();
+		q.m_luma_ssim = luma_ssim;
+		q.m_luma_601 = luma_601;
 
-		imagef fta, ftb;
+		const uint32_t width = minimum(a.get_width(), b.get_width());
+		const uint32_t height = minimum(a.get_height(), b.get_height());
+		if (!width || !height)
+			return;
 
-		fta.set(ta);
-		ftb.set(tb);
+		q.m_width = width;
+		q.m_height = height;
 
-		return compute_ssim(fta, ftb);
+		float kernel[cQualityFilterTaps];
+		compute_gaussian_kernel(kernel, cQualityFilterTaps, 1, 1.5f * 1.5f, cComputeGaussianFlagNormalize);
+
+		const uint32_t num_bands = (height + cQualityBandHeight - 1) / cQualityBandHeight;
+		basisu::vector<quality_band_totals> bands(num_bands);
+		for (uint32_t i = 0; i < num_bands; i++)
+			clear_obj(bands[i]);
+
+		auto compute_bands = [&](uint32_t first_band, uint32_t last_band)
+		{
+			compute_image_quality_rows(a, b, width, height, luma_ssim, luma_601, kernel,
+				first_band * cQualityBandHeight, minimum(last_band * cQualityBandHeight, height), &bands[first_band]);
+		};
+
+		if ((pJob_pool) && (pJob_pool->get_total_threads() > 1) && (num_bands > 1))
+			pJob_pool->parallel_for(0, num_bands, compute_bands);
+		else
+			compute_bands(0, num_bands);
+
+		double ssim[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < num_bands; i++)
+		{
+			const quality_band_totals &band = bands[i];
+
+			for (uint32_t c = 0; c < 4; c++)
+				ssim[c] += band.m_ssim[c];
+
+			for (uint32_t c = 0; c < image_quality::cTotalChans; c++)
+			{
+				q.m_max_error[c] = maximum(q.m_max_error[c], band.m_max_error[c]);
+				q.m_total_error[c] += band.m_total_error[c];
+				q.m_total_sq_error[c] += band.m_total_sq_error[c];
+			}
+		}
+
+		const double total_pixels = (double)width * (double)height;
+		if (luma_ssim)
+		{
+			const float l = (float)(ssim[0] / total_pixels);
+			q.m_ssim.set(l, l, l, (float)(ssim[1] / total_pixels));
+		}
+		else
+		{
+			for (uint32_t c = 0; c < 4; c++)
+				q.m_ssim[c] = (float)(ssim[c] / total_pixels);
+		}
 	}
 
 } // namespace basisu
@@ -39,6 +39,37 @@ namespace basisu
 	void gaussian_filter(imagef &dst, const imagef &orig_img, uint32_t odd_filter_width, float sigma_sqr, bool wrapping = false, uint32_t width_divisor = 1, uint32_t height_divisor = 1);
 
 	vec4F compute_ssim(const imagef &a, const imagef &b);
-	vec4F compute_ssim(const image &a, const image &b, bool luma, bool luma_601);
+	vec4F compute_ssim(const image &a, const image &b, bool luma, bool luma_601, job_pool *pJob_pool = nullptr);
+
+	// Error totals and SSIM of an image against a reference, from one pass of compute_image_quality().
+	class image_quality
+	{
+	public:
+		enum { cChanLuma709 = 4, cChanLuma601 = 5, cTotalChans = 6 };
+
+		image_quality() { clear(); }
+
+		void clear();
+
+		// Sets em to the result of image_metrics::calc(a, b, first_chan, total_chans, true, use_601_luma). em.m_ssim is set from m_ssim if it
+		// was computed for the same channels, otherwise it's 0.
+		void get_metrics(image_metrics &em, uint32_t first_chan, uint32_t total_chans, bool use_601_luma = false) const;
+
+		uint32_t m_width, m_height;
+
+		// Indexed by channel: R, G, B, A, 709 luma and 601 luma.
+		uint32_t m_max_error[cTotalChans];
+		uint64_t m_total_error[cTotalChans];
+		uint64_t m_total_sq_error[cTotalChans];
+
+		// Mean SSIM, the same as compute_ssim(a, b, m_luma_ssim, m_luma_601).
+		vec4F m_ssim;
+		bool m_luma_ssim, m_luma_601;
+	};
+
+	// Computes the error totals and SSIM together in a single pass over bands of rows, without any full size temporary images, using the SIMD
+	// kernels if the CPU supports them. The bands are spread across pJob_pool's threads if it isn't null. The results don't depend on the
+	// number of threads.
+	void compute_image_quality(const image &a, const image &b, bool luma_ssim, bool luma_601, image_quality &q, job_pool *pJob_pool = nullptr);
 
 } // namespace basisu
@@ -3793,34 +3793,119 @@ namespace basisu
 		return len_cost + dist_cost;
 	}
 
-	struct selector_bitsequence
+	// Maps a selector bit sequence at a bit offset to the index of the last block that used it. Open addressing with linear
+	// probing in one allocation, sized up front for every block of a job so it never rehashes.
+	class selector_history_table
 	{
-		uint64_t m_sel;
-		uint32_t m_ofs;
-		selector_bitsequence() { }
-		selector_bitsequence(uint32_t bit_ofs, uint64_t sel) : m_sel(sel), m_ofs(bit_ofs) { }
-		bool operator== (const selector_bitsequence& other) const
+	public:
+		selector_history_table(uint32_t max_entries)
 		{
-			return (m_ofs == other.m_ofs) && (m_sel == other.m_sel);
+			uint32_t size = 16;
+			while (size < max_entries * 2)
+				size <<= 1;
+			m_entries.resize(size);
+			m_mask = size - 1;
 		}
 
-		bool operator< (const selector_bitsequence& other) const
+		// Returns the index of the last block with these selectors, or -1.
+		int find(uint32_t ofs, uint64_t sel) const
 		{
-			if (m_ofs < other.m_ofs)
-				return true;
-			else if (m_ofs == other.m_ofs)
-				return m_sel < other.m_sel;
+			for (uint32_t i = hash(ofs, sel); ; i = (i + 1) & m_mask)
+			{
+				const entry& e = m_entries[i];
+				if (e.m_block_index < 0)
+					return -1;
+				if ((e.m_sel == sel) && (e.m_ofs == ofs))
+					return e.m_block_index;
+			}
+		}
 
-			return false;
+		void set(uint32_t ofs, uint64_t sel, int block_index)
+		{
+			for (uint32_t i = hash(ofs, sel); ; i = (i + 1) & m_mask)
+			{
+				entry& e = m_entries[i];
+				if ((e.m_block_index < 0) || ((e.m_sel == sel) && (e.m_ofs == ofs)))
+				{
+					e.m_sel = sel;
+					e.m_ofs = ofs;
+					e.m_block_index = block_index;
+					return;
+				}
+			}
+		}
+
+	private:
+		struct entry
+		{
+			uint64_t m_sel = 0;
+			uint32_t m_ofs = 0;
+			int m_block_index = -1;
+		};
+
+		basisu::vector<entry> m_entries;
+		uint32_t m_mask;
+
+		uint32_t hash(uint32_t ofs, uint64_t sel) const
+		{
+			uint64_t h = (sel ^ (ofs * 0x9E3779B97F4A7C15ULL)) * 0xFF51AFD7ED558CCDULL;
+			return (uint32_t)(h >> 32) & m_mask;
 		}
 	};
 
-	struct selector_bitsequence_hash
+	// Set of the selector bit sequences already tried for the current block. Entries are tagged with a generation so
+	// moving on to the next block doesn't need to clear the table.
+	class selector_candidate_set
 	{
-		std::size_t operator()(selector_bitsequence const& s) const noexcept
+	public:
+		selector_candidate_set(uint32_t max_entries) : m_generation(0)
+		{
+			uint32_t size = 16;
+			while (size < max_entries * 2)
+				size <<= 1;
+			m_entries.resize(size);
+			m_mask = size - 1;
+		}
+
+		void next_block()
 		{
-			return static_cast<std::size_t>(hash_hsieh((uint8_t *)&s, sizeof(s)) ^ s.m_sel);
+			if (++m_generation == 0)
+			{
+				for (uint32_t i = 0; i <= m_mask; i++)
+					m_entries[i].m_generation = 0;
+				m_generation = 1;
+			}
+		}
+
+		// Returns false if the selectors sel (low 64 bits) and sel_high were already inserted for the current block.
+		bool insert(uint64_t sel, uint64_t sel_high)
+		{
+			for (uint32_t i = (uint32_t)(((sel ^ sel_high) * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask; ; i = (i + 1) & m_mask)
+			{
+				entry& e = m_entries[i];
+				if (e.m_generation != m_generation)
+				{
+					e.m_sel = sel;
+					e.m_sel_high = sel_high;
+					e.m_generation = m_generation;
+					return true;
+				}
+				if ((e.m_sel == sel) && (e.m_sel_high == sel_high))
+					return false;
+			}
 		}
+
+	private:
+		struct entry
+		{
+			uint64_t m_sel = 0;
+			uint64_t m_sel_high = 0;
+			uint32_t m_generation = 0;
+		};
+
+		basisu::vector<entry> m_entries;
+		uint32_t m_mask;
+		uint32_t m_generation;
 	};
 
 	class tracked_stat
@@ -3856,7 +3941,8 @@ namespace basisu
 		const int total_blocks_to_check = basisu::maximum<uint32_t>(1U, params.m_lz_dict_size / sizeof(basist::uastc_block));
 		const bool perceptual = false;
 
-		std::unordered_map<selector_bitsequence, uint32_t, selector_bitsequence_hash> selector_history;
+		selector_history_table selector_history(last_index - first_index);
+		selector_candidate_set tried_selectors(basisu::minimum<uint32_t>(total_blocks_to_check, last_index - first_index));
 						
 		for (uint32_t block_index = first_index; block_index < last_index; block_index++)
 		{
@@ -3928,19 +4014,16 @@ namespace basisu
 
 			if (cur_rms_err >= params.m_skip_block_rms_thresh)
 			{
-				auto cur_search_res = selector_history.insert(std::make_pair(selector_bitsequence(first_sel_bit, cur_sel_bits), block_index));
-
 				// Block already has too much error, so don't mess with it.
-				if (!cur_search_res.second)
-					(*cur_search_res.first).second = block_index;
+				selector_history.set(first_sel_bit, cur_sel_bits, block_index);
 
 				total_skipped++;
 				continue;
 			}
 
 			int cur_bits;
-			auto cur_find_res = selector_history.find(selector_bitsequence(first_sel_bit, cur_sel_bits));
-			if (cur_find_res == selector_history.end())
+			const int cur_match_block_index = selector_history.find(first_sel_bit, cur_sel_bits);
+			if (cur_match_block_index < 0)
 			{
 				// Wasn't found - wildly estimate literal cost
 				//cur_bits = (total_sel_bits * 5) / 4;
@@ -3949,8 +4032,7 @@ namespace basisu
 			else
 			{
 				// Was found - wildly estimate match cost
-				uint32_t match_block_index = cur_find_res->second;
-				const int block_dist_in_bytes = (block_index - match_block_index) * 16;
+				const int block_dist_in_bytes = (block_index - cur_match_block_index) * 16;
 				cur_bits = compute_match_cost_estimate(block_dist_in_bytes);
 			}
 
@@ -3961,6 +4043,10 @@ namespace basisu
 			uint32_t best_block_index = block_index;
 
 			float best_t = cur_ms_err * smooth_block_error_scale + cur_bits * params.m_lambda;
+			const float max_trial_rms_err = cur_rms_err * params.m_max_allowed_rms_increase_ratio;
+
+			tried_selectors.next_block();
+			uint32_t total_candidates = 0;
 
 			// Now scan through previous blocks, insert their selector bit patterns into the current block, and find 
 			// selector bit patterns which don't increase the overall block error too much.
@@ -3971,14 +4057,34 @@ namespace basisu
 				uint32_t bit_offset = first_sel_bit;
 				uint64_t sel_bits = read_bits((const uint8_t*)&prev_blk, bit_offset, basisu::minimum(64U, total_sel_bits));
 
-				int match_block_index = prev_block_index;
-				auto res = selector_history.find(selector_bitsequence(first_sel_bit, sel_bits));
-				if (res != selector_history.end())
-					match_block_index = res->second;
 				// Have we already checked this bit pattern? If so then skip this block.
+				int match_block_index = selector_history.find(first_sel_bit, sel_bits);
+				if (match_block_index < 0)
+					match_block_index = prev_block_index;
 				if (match_block_index > prev_block_index)
 					continue;
 
+				// Blocks using other modes aren't in the history under this offset, so also skip selectors already
+				// tried from a nearer block. They give the same error for a match that costs no more.
+				uint64_t sel_bits_high = 0;
+				if (total_sel_bits > 64)
+				{
+					uint32_t high_bit_offset = bit_offset;
+					sel_bits_high = read_bits((const uint8_t*)&prev_blk, high_bit_offset, total_sel_bits - 64U);
+				}
+				if (!tried_selectors.insert(sel_bits, sel_bits_high))
+					continue;
+
+				if ((params.m_max_candidates) && (total_candidates++ == params.m_max_candidates))
+					break;
+
+				// Error can only add to the rate, so skip matches costing more than the best trial so far.
+				const int block_dist_in_bytes = (block_index - match_block_index) * 16;
+				const int match_bits = compute_match_cost_estimate(block_dist_in_bytes);
+				const float match_t = match_bits * params.m_lambda;
+				if (match_t >= best_t)
+					continue;
+
 				unpacked_uastc_block unpacked_prev_blk;
 				if (!unpack_uastc(prev_blk, unpacked_prev_blk, false, true))
 					return false;
@@ -3988,11 +4094,7 @@ namespace basisu
 				set_block_bits((uint8_t*)&trial_blk, sel_bits, basisu::minimum(64U, total_sel_bits), first_sel_bit);
 
 				if (total_sel_bits > 64)
-				{
-					sel_bits = read_bits((const uint8_t*)&prev_blk, bit_offset, total_sel_bits - 64U);
-
-					set_block_bits((uint8_t*)&trial_blk, sel_bits, total_sel_bits - 64U, first_sel_bit + basisu::minimum(64U, total_sel_bits));
-				}
+					set_block_bits((uint8_t*)&trial_blk, sel_bits_high, total_sel_bits - 64U, first_sel_bit + basisu::minimum(64U, total_sel_bits));
 
 				unpacked_uastc_block unpacked_trial_blk;
 				if (!unpack_uastc(trial_blk, unpacked_trial_blk, false, true))
@@ -4006,6 +4108,12 @@ namespace basisu
 				for (uint32_t i = 0; i < 16; i++)
 					trial_uastc_err += color_distance(perceptual, pPixels[i], ((color_rgba*)decoded_trial_uastc_block)[i], true);
 
+				// The trial's error is at least half its UASTC error, so reject it before transcoding to BC7 if that
+				// alone is too much.
+				const float min_trial_ms_err = (float)(trial_uastc_err / 2) * (1.0f / 64.0f);
+				if ((sqrtf(min_trial_ms_err) > max_trial_rms_err) || (min_trial_ms_err * smooth_block_error_scale + match_t >= best_t))
+					continue;
+
 				// Transcode trial to BC7, compute error
 				bc7_optimization_results trial_b7_results;
 				if (!transcode_uastc_to_bc7(unpacked_trial_blk, trial_b7_results))
@@ -4026,13 +4134,10 @@ namespace basisu
 				const float trial_ms_err = (float)trial_err * (1.0f / 64.0f);
 				const float trial_rms_err = sqrtf(trial_ms_err);
 
-				if (trial_rms_err > cur_rms_err * params.m_max_allowed_rms_increase_ratio)
+				if (trial_rms_err > max_trial_rms_err)
 					continue;
 
-				const int block_dist_in_bytes = (block_index - match_block_index) * 16;
-				const int match_bits = compute_match_cost_estimate(block_dist_in_bytes);
-
-				float t = trial_ms_err * smooth_block_error_scale + match_bits * params.m_lambda;
+				float t = trial_ms_err * smooth_block_error_scale + match_t;
 				if (t < best_t)
 				{
 					best_t = t;
@@ -4118,9 +4223,7 @@ namespace basisu
 				uint32_t bit_offset = first_sel_bit;
 				uint64_t sel_bits = read_bits((const uint8_t*)&best_block, bit_offset, basisu::minimum(64U, total_sel_bits));
 
-				auto res = selector_history.insert(std::make_pair(selector_bitsequence(first_sel_bit, sel_bits), block_index));
-				if (!res.second)
-					(*res.first).second = block_index;
+				selector_history.set(first_sel_bit, sel_bits, block_index);
 			}
 
 		} // block_index
@@ -106,6 +106,7 @@ namespace basisu
 			m_skip_block_rms_thresh = UASTC_RDO_DEFAULT_SKIP_BLOCK_RMS_THRESH;
 			m_endpoint_refinement = true;
 			m_lz_literal_cost = 100;
+			m_max_candidates = 0;
 						
 			m_max_smooth_block_std_dev = UASTC_RDO_DEFAULT_MAX_SMOOTH_BLOCK_STD_DEV;
 			m_smooth_block_max_error_scale = UASTC_RDO_DEFAULT_SMOOTH_BLOCK_MAX_ERROR_SCALE;
@@ -131,6 +132,10 @@ namespace basisu
 		float m_smooth_block_max_error_scale;
 		
 		uint32_t m_lz_literal_cost;
+
+		// m_max_candidates: Maximum number of distinct selector patterns from the dictionary to try on each block, nearest first. 0=all of them.
+		// Lower values are faster, especially with large dictionaries, but find fewer matches.
+		uint32_t m_max_candidates;
 	};
 
 	// num_blocks, pBlocks: Number of blocks and pointer to UASTC blocks to process.
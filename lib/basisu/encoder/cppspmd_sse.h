@@ -91,6 +91,12 @@
 	#define CPPSPMD_SSE41 0
 	#define CPPSPMD cppspmd_sse2
 	#define CPPSPMD_ARCH _sse2
+#elif defined(__AVX2__)
+	// The same 4 wide code compiled with VEX encoding (basisu_kernels_avx2.cpp). It gets its own
+	// namespace so out of line copies of its inline functions can't replace the SSE 4.1 build's.
+	#define CPPSPMD_SSE41 1
+	#define CPPSPMD cppspmd_avx2
+	#define CPPSPMD_ARCH _avx2
 #else
 	#define CPPSPMD_SSE41 1
 	#define CPPSPMD cppspmd_sse41
@@ -442,6 +448,9 @@ struct spmd_kernel
 
 		vbool() = default;
 
+		// Declared so the private assignment operator doesn't make the implicit copy constructor deprecated.
+		vbool(const vbool&) = default;
+
 		CPPSPMD_FORCE_INLINE vbool(bool value) : m_value(_mm_set1_epi32(value ? UINT32_MAX : 0)) { }
 
 		CPPSPMD_FORCE_INLINE explicit vbool(const __m128i& value) : m_value(value) { }
@@ -474,6 +483,8 @@ struct spmd_kernel
 
 		vfloat() = default;
 
+		vfloat(const vfloat&) = default;
+
 		CPPSPMD_FORCE_INLINE explicit vfloat(const __m128& v) : m_value(v) { }
 
 		CPPSPMD_FORCE_INLINE vfloat(float value) : m_value(_mm_set1_ps(value)) { }
@@ -762,6 +773,8 @@ struct spmd_kernel
 
 		vint() = default;
 
+		vint(const vint&) = default;
+
 		CPPSPMD_FORCE_INLINE explicit vint(const __m128i& value) : m_value(value)	{ }
 
 		CPPSPMD_FORCE_INLINE explicit vint(const lint &other) : m_value(other.m_value) { }
@@ -139,6 +139,24 @@
 	#endif
 #endif
 
+// If BASISD_SUPPORT_X86_SIMD is 1, the ETC1S->BC1, BC7 and ASTC transcoders use SSE 4.1 or AVX2 kernels, picked at runtime by
+// basisu_transcoder_init() from what the CPU supports, to find the best selector mapping for batches of blocks.
+// The output is bit-identical to the scalar code. No compiler options are needed; the kernels are compiled with function target attributes.
+#ifndef BASISD_SUPPORT_X86_SIMD
+	#if (defined(_M_AMD64) || defined(_M_IX86) || defined(__i386__) || defined(__x86_64__)) && !defined(__EMSCRIPTEN__) && (defined(_MSC_VER) || defined(__GNUC__))
+		#define BASISD_SUPPORT_X86_SIMD 1
+	#else
+		#define BASISD_SUPPORT_X86_SIMD 0
+	#endif
+#endif
+
+#if BASISD_SUPPORT_X86_SIMD
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
 #define BASISD_WRITE_NEW_BC7_MODE5_TABLES			0
 #define BASISD_WRITE_NEW_DXT1_TABLES				0
 #define BASISD_WRITE_NEW_ETC2_EAC_A8_TABLES		0
@@ -146,6 +164,19 @@
 #define BASISD_WRITE_NEW_ATC_TABLES					0
 #define BASISD_WRITE_NEW_ETC2_EAC_R11_TABLES		0
 
+// Set BASISD_WRITE_NEW_INIT_TABLES to 1 to build basisu_transcoder_write_init_tables(), which dumps the tables computed by
+// basisu_transcoder_init() to an .inc file. Build with BASISD_USE_BAKED_INIT_TABLES set to 1 to compile that file back in
+// (it's found as "basisu_transcoder_tables_init.inc" on the include path) so basisu_transcoder_init() only copies them.
+// The file holds the raw bytes of the tables so it must be generated by a build of this file for the same target using the
+// same BASISD_SUPPORT_* settings.
+#ifndef BASISD_WRITE_NEW_INIT_TABLES
+	#define BASISD_WRITE_NEW_INIT_TABLES			0
+#endif
+
+#ifndef BASISD_USE_BAKED_INIT_TABLES
+	#define BASISD_USE_BAKED_INIT_TABLES			0
+#endif
+
 #ifndef BASISD_ENABLE_DEBUG_FLAGS
 	#define BASISD_ENABLE_DEBUG_FLAGS	0
 #endif
@@ -1901,6 +1932,12 @@ namespace basist
 	void uastc_init();
 #endif
 
+#if BASISD_USE_BAKED_INIT_TABLES
+	static void transcoder_init_baked_tables();
+#endif
+
+	static void transcoder_init_etc1s_mapping_kernels();
+
 	static bool g_transcoder_initialized;
 		
 	// Library global initialization. Requires ~9 milliseconds when compiled and executed natively on a Core i7 2.2 GHz.
@@ -1915,6 +1952,9 @@ namespace basist
          
      BASISU_DEVEL_ERROR("basisu_transcoder::basisu_transcoder_init: Initializing (this is not an error)\n");      
 
+#if BASISD_USE_BAKED_INIT_TABLES
+		transcoder_init_baked_tables();
+#else
 #if BASISD_SUPPORT_UASTC
 		uastc_init();
 #endif
@@ -2026,11 +2066,306 @@ namespace basist
 #if BASISD_SUPPORT_PVRTC2
 		transcoder_init_pvrtc2();
 #endif
+#endif // #if BASISD_USE_BAKED_INIT_TABLES
+
+		transcoder_init_etc1s_mapping_kernels();
 
 		g_transcoder_initialized = true;
 	}
 
+	// The ETC1S->BC1, BC7 and ASTC conversion tables are laid out [32][8][RANGES][MAPPING]. For each block the converters sum the
+	// errors of the R, G and B rows of 10 mappings and pick the first mapping with the lowest total. This is the hottest part
+	// of those transcoders so it's done for a batch of blocks at a time, with SIMD where the CPU has it.
+	const uint32_t NUM_ETC1S_SELECTOR_MAPPINGS = 10;
+
+	// All the conversion table solution structs have this layout.
+	struct etc1s_to_x_solution
+	{
+		uint8_t m_lo;
+		uint8_t m_hi;
+		uint16_t m_err;
+	};
+
+	struct etc1s_mapping_rows
+	{
+		const void* m_pR;
+		const void* m_pG;
+		const void* m_pB;
+	};
+
+	// Maximum number of blocks the batched converters gather before converting them.
+	const uint32_t ETC1S_BLOCK_BATCH_SIZE = 32;
+
+	typedef void (*find_best_etc1s_mappings_func)(const etc1s_mapping_rows* pRows, uint32_t num_blocks, uint8_t* pBest_mappings);
+
+	static inline uint32_t get_etc1s_solution_err(const void* pRow, uint32_t mapping)
+	{
+		return static_cast<const etc1s_to_x_solution*>(pRow)[mapping].m_err;
+	}
+
+	static void find_best_etc1s_mappings_scalar(const etc1s_mapping_rows* pRows, uint32_t num_blocks, uint8_t* pBest_mappings)
+	{
+		for (uint32_t i = 0; i < num_blocks; i++)
+		{
+			const etc1s_mapping_rows& rows = pRows[i];
+
+			uint32_t best_err = UINT_MAX;
+			uint32_t best_mapping = 0;
+
+#define DO_ITER(m) { uint32_t total_err = get_etc1s_solution_err(rows.m_pR, m) + get_etc1s_solution_err(rows.m_pG, m) + get_etc1s_solution_err(rows.m_pB, m); if (total_err < best_err) { best_err = total_err; best_mapping = m; } }
+			DO_ITER(0); DO_ITER(1); DO_ITER(2); DO_ITER(3); DO_ITER(4);
+			DO_ITER(5); DO_ITER(6); DO_ITER(7); DO_ITER(8); DO_ITER(9);
+#undef DO_ITER
+
+			pBest_mappings[i] = static_cast<uint8_t>(best_mapping);
+		}
+	}
+
+#if BASISD_SUPPORT_X86_SIMD
+#if defined(__GNUC__) || defined(__clang__)
+	#define BASISD_TARGET_SSE41 __attribute__((target("sse4.1")))
+	#define BASISD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define BASISD_TARGET_SSE41
+	#define BASISD_TARGET_AVX2
+#endif
+
+	static inline uint32_t bit_scan_forward(uint32_t v)
+	{
+		assert(v);
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, v);
+		return index;
+#else
+		return __builtin_ctz(v);
+#endif
+	}
+
+	// Loads the errors of mappings [ofs, ofs+4) of a row into 32-bit lanes.
+	BASISD_TARGET_SSE41 static inline __m128i load_etc1s_errs_sse41(const void* pRow, uint32_t ofs)
+	{
+		return _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const etc1s_to_x_solution*>(pRow) + ofs)), 16);
+	}
+
+	// Loads the errors of the last 2 mappings of a row into the low 2 lanes.
+	BASISD_TARGET_SSE41 static inline __m128i load_etc1s_errs_tail_sse41(const void* pRow)
+	{
+		return _mm_srli_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(static_cast<const etc1s_to_x_solution*>(pRow) + 8)), 16);
+	}
+
+	// Horizontal unsigned minimum, broadcast to all lanes.
+	BASISD_TARGET_SSE41 static inline __m128i hmin_epu32_sse41(__m128i v)
+	{
+		v = _mm_min_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_min_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	}
+
+	// The totals are at most 3*65535 so they can't overflow 32-bit lanes. Taking the lowest set bit of the "equals minimum" mask
+	// selects the first mapping with the lowest error, exactly like the scalar loop's strict less-than.
+	BASISD_TARGET_SSE41 static void find_best_etc1s_mappings_sse41(const etc1s_mapping_rows* pRows, uint32_t num_blocks, uint8_t* pBest_mappings)
+	{
+		const __m128i tail_pad = _mm_set_epi32(-1, -1, 0, 0);
+
+		for (uint32_t i = 0; i < num_blocks; i++)
+		{
+			const etc1s_mapping_rows& rows = pRows[i];
+
+			const __m128i e0 = _mm_add_epi32(_mm_add_epi32(load_etc1s_errs_sse41(rows.m_pR, 0), load_etc1s_errs_sse41(rows.m_pG, 0)), load_etc1s_errs_sse41(rows.m_pB, 0));
+			const __m128i e1 = _mm_add_epi32(_mm_add_epi32(load_etc1s_errs_sse41(rows.m_pR, 4), load_etc1s_errs_sse41(rows.m_pG, 4)), load_etc1s_errs_sse41(rows.m_pB, 4));
+			__m128i e2 = _mm_add_epi32(_mm_add_epi32(load_etc1s_errs_tail_sse41(rows.m_pR), load_etc1s_errs_tail_sse41(rows.m_pG)), load_etc1s_errs_tail_sse41(rows.m_pB));
+			e2 = _mm_or_si128(e2, tail_pad);
+
+			const __m128i m = hmin_epu32_sse41(_mm_min_epu32(_mm_min_epu32(e0, e1), e2));
+
+			const uint32_t mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(e0, m))) |
+				(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(e1, m))) << 4) |
+				(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(e2, m))) << 8);
+
+			pBest_mappings[i] = static_cast<uint8_t>(bit_scan_forward(mask));
+		}
+	}
+
+	BASISD_TARGET_AVX2 static inline __m256i load_etc1s_errs_avx2(const void* pRow)
+	{
+		return _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow)), 16);
+	}
+
+	BASISD_TARGET_AVX2 static inline __m128i load_etc1s_errs_tail_avx2(const void* pRow)
+	{
+		return _mm_srli_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(static_cast<const etc1s_to_x_solution*>(pRow) + 8)), 16);
+	}
+
+	// Same as the SSE 4.1 version but the first 8 mappings are handled in one 256-bit register.
+	BASISD_TARGET_AVX2 static void find_best_etc1s_mappings_avx2(const etc1s_mapping_rows* pRows, uint32_t num_blocks, uint8_t* pBest_mappings)
+	{
+		const __m128i tail_pad = _mm_set_epi32(-1, -1, 0, 0);
+
+		for (uint32_t i = 0; i < num_blocks; i++)
+		{
+			const etc1s_mapping_rows& rows = pRows[i];
+
+			const __m256i e0 = _mm256_add_epi32(_mm256_add_epi32(load_etc1s_errs_avx2(rows.m_pR), load_etc1s_errs_avx2(rows.m_pG)), load_etc1s_errs_avx2(rows.m_pB));
+			__m128i e1 = _mm_add_epi32(_mm_add_epi32(load_etc1s_errs_tail_avx2(rows.m_pR), load_etc1s_errs_tail_avx2(rows.m_pG)), load_etc1s_errs_tail_avx2(rows.m_pB));
+			e1 = _mm_or_si128(e1, tail_pad);
+
+			__m128i m = _mm_min_epu32(_mm_min_epu32(_mm256_castsi256_si128(e0), _mm256_extracti128_si256(e0, 1)), e1);
+			m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+			m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			const uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(e0, _mm256_broadcastd_epi32(m)))) |
+				(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(e1, m))) << 8);
+
+			pBest_mappings[i] = static_cast<uint8_t>(bit_scan_forward(mask));
+		}
+	}
+
+	static void get_x86_simd_support(bool& has_sse41, bool& has_avx2)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int regs[4];
+		__cpuid(regs, 0);
+		const int max_leaf = regs[0];
+
+		__cpuid(regs, 1);
+		has_sse41 = (regs[2] & (1 << 19)) != 0;
+
+		// AVX2 also needs the OS to save the YMM registers.
+		const bool os_saves_ymm = ((regs[2] & (1 << 27)) != 0) && ((regs[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 6) == 6);
+
+		has_avx2 = false;
+		if ((max_leaf >= 7) && os_saves_ymm)
+		{
+			__cpuidex(regs, 7, 0);
+			has_avx2 = (regs[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		has_sse41 = __builtin_cpu_supports("sse4.1") != 0;
+		has_avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+#endif // BASISD_SUPPORT_X86_SIMD
+
+	static find_best_etc1s_mappings_func g_pFind_best_etc1s_mappings = find_best_etc1s_mappings_scalar;
+
+	static void transcoder_init_etc1s_mapping_kernels()
+	{
+#if BASISD_SUPPORT_X86_SIMD
+		bool has_sse41, has_avx2;
+		get_x86_simd_support(has_sse41, has_avx2);
+
+		if (has_avx2)
+			g_pFind_best_etc1s_mappings = find_best_etc1s_mappings_avx2;
+		else if (has_sse41)
+			g_pFind_best_etc1s_mappings = find_best_etc1s_mappings_sse41;
+#endif
+	}
+
+	// Blocks queued by transcode_slice() for one of the batched converters.
+	struct etc1s_block_batch
+	{
+		void* m_pDst_blocks[ETC1S_BLOCK_BATCH_SIZE];
+		const endpoint* m_pEndpoints[ETC1S_BLOCK_BATCH_SIZE];
+		const selector* m_pSelectors[ETC1S_BLOCK_BATCH_SIZE];
+		uint32_t m_num_blocks;
+
+		etc1s_block_batch() : m_num_blocks(0) { }
+
+		// Returns true when the batch is full and must be converted.
+		bool add(void* pDst_block, const endpoint* pEndpoints, const selector* pSelector)
+		{
+			assert(m_num_blocks < ETC1S_BLOCK_BATCH_SIZE);
+			m_pDst_blocks[m_num_blocks] = pDst_block;
+			m_pEndpoints[m_num_blocks] = pEndpoints;
+			m_pSelectors[m_num_blocks] = pSelector;
+			return ++m_num_blocks == ETC1S_BLOCK_BATCH_SIZE;
+		}
+	};
+
 #if BASISD_SUPPORT_DXT1
+	static inline bool is_etc1s_to_dxt1_special_block(const endpoint* pEndpoints, const selector* pSelector)
+	{
+		return (pSelector->m_lo_selector == pSelector->m_hi_selector) ||
+			((pEndpoints->m_inten5 >= 7) && (pSelector->m_num_unique_selectors == 2) && (pSelector->m_lo_selector == 0) && (pSelector->m_hi_selector == 3));
+	}
+
+	static inline etc1s_mapping_rows get_etc1s_to_dxt1_mapping_rows(const endpoint* pEndpoints, const selector* pSelector)
+	{
+		static_assert((NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS == NUM_ETC1S_SELECTOR_MAPPINGS) && (sizeof(etc1_to_dxt1_56_solution) == sizeof(etc1s_to_x_solution)), "The mapping kernels can't read this table");
+
+		const color32& base_color = pEndpoints->m_color5;
+		const uint32_t inten_table = pEndpoints->m_inten5;
+
+		const uint32_t selector_range_table = g_etc1_to_dxt1_selector_range_index[pSelector->m_lo_selector][pSelector->m_hi_selector];
+
+		//[32][8][RANGES][MAPPING]
+		etc1s_mapping_rows rows;
+		rows.m_pR = &g_etc1_to_dxt_5[(inten_table * 32 + base_color.r) * (NUM_ETC1_TO_DXT1_SELECTOR_RANGES * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS];
+		rows.m_pG = &g_etc1_to_dxt_6[(inten_table * 32 + base_color.g) * (NUM_ETC1_TO_DXT1_SELECTOR_RANGES * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS];
+		rows.m_pB = &g_etc1_to_dxt_5[(inten_table * 32 + base_color.b) * (NUM_ETC1_TO_DXT1_SELECTOR_RANGES * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS];
+		return rows;
+	}
+
+	// Converts a block that isn't one of the special cases handled by convert_etc1s_to_dxt1() using the given selector mapping.
+	static void convert_etc1s_to_dxt1_mapped(dxt1_block* pDst_block, const selector* pSelector,
+		const etc1_to_dxt1_56_solution* pTable_r, const etc1_to_dxt1_56_solution* pTable_g, const etc1_to_dxt1_56_solution* pTable_b,
+		uint32_t best_mapping, bool use_threecolor_blocks)
+	{
+		uint32_t l = dxt1_block::pack_unscaled_color(pTable_r[best_mapping].m_lo, pTable_g[best_mapping].m_lo, pTable_b[best_mapping].m_lo);
+		uint32_t h = dxt1_block::pack_unscaled_color(pTable_r[best_mapping].m_hi, pTable_g[best_mapping].m_hi, pTable_b[best_mapping].m_hi);
+
+		const uint8_t* pSelectors_xlat_256 = &g_etc1_to_dxt1_selector_mappings_raw_dxt1_256[best_mapping][0];
+
+		if (l < h)
+		{
+			std::swap(l, h);
+			pSelectors_xlat_256 = &g_etc1_to_dxt1_selector_mappings_raw_dxt1_inv_256[best_mapping][0];
+		}
+
+		pDst_block->set_low_color(static_cast<uint16_t>(l));
+		pDst_block->set_high_color(static_cast<uint16_t>(h));
+
+		if (l == h)
+		{
+			uint8_t mask = 0;
+
+			if (!use_threecolor_blocks)
+			{
+				// This is an annoying edge case that impacts BC3.
+
+				// Make l > h
+				if (h > 0)
+					h--;
+				else
+				{
+					// l = h = 0
+					assert(l == h && h == 0);
+
+					h = 0;
+					l = 1;
+					mask = 0x55;
+				}
+
+				assert(l > h);
+				pDst_block->set_low_color(static_cast<uint16_t>(l));
+				pDst_block->set_high_color(static_cast<uint16_t>(h));
+			}
+
+			pDst_block->m_selectors[0] = mask;
+			pDst_block->m_selectors[1] = mask;
+			pDst_block->m_selectors[2] = mask;
+			pDst_block->m_selectors[3] = mask;
+
+			return;
+		}
+
+		pDst_block->m_selectors[0] = pSelectors_xlat_256[pSelector->m_selectors[0]];
+		pDst_block->m_selectors[1] = pSelectors_xlat_256[pSelector->m_selectors[1]];
+		pDst_block->m_selectors[2] = pSelectors_xlat_256[pSelector->m_selectors[2]];
+		pDst_block->m_selectors[3] = pSelectors_xlat_256[pSelector->m_selectors[3]];
+	}
+
 	static void convert_etc1s_to_dxt1(dxt1_block* pDst_block, const endpoint *pEndpoints, const selector* pSelector, bool use_threecolor_blocks)
 	{
 #if !BASISD_WRITE_NEW_DXT1_TABLES
@@ -2152,12 +2487,11 @@ namespace basist
 			return;
 		}
 
-		const uint32_t selector_range_table = g_etc1_to_dxt1_selector_range_index[low_selector][high_selector];
+		const etc1s_mapping_rows rows = get_etc1s_to_dxt1_mapping_rows(pEndpoints, pSelector);
 
-		//[32][8][RANGES][MAPPING]
-		const etc1_to_dxt1_56_solution* pTable_r = &g_etc1_to_dxt_5[(inten_table * 32 + base_color.r) * (NUM_ETC1_TO_DXT1_SELECTOR_RANGES * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS];
-		const etc1_to_dxt1_56_solution* pTable_g = &g_etc1_to_dxt_6[(inten_table * 32 + base_color.g) * (NUM_ETC1_TO_DXT1_SELECTOR_RANGES * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS];
-		const etc1_to_dxt1_56_solution* pTable_b = &g_etc1_to_dxt_5[(inten_table * 32 + base_color.b) * (NUM_ETC1_TO_DXT1_SELECTOR_RANGES * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_DXT1_SELECTOR_MAPPINGS];
+		const etc1_to_dxt1_56_solution* pTable_r = static_cast<const etc1_to_dxt1_56_solution*>(rows.m_pR);
+		const etc1_to_dxt1_56_solution* pTable_g = static_cast<const etc1_to_dxt1_56_solution*>(rows.m_pG);
+		const etc1_to_dxt1_56_solution* pTable_b = static_cast<const etc1_to_dxt1_56_solution*>(rows.m_pB);
 
 		uint32_t best_err = UINT_MAX;
 		uint32_t best_mapping = 0;
@@ -2168,59 +2502,39 @@ namespace basist
 		DO_ITER(5); DO_ITER(6); DO_ITER(7); DO_ITER(8); DO_ITER(9);
 #undef DO_ITER
 
-		uint32_t l = dxt1_block::pack_unscaled_color(pTable_r[best_mapping].m_lo, pTable_g[best_mapping].m_lo, pTable_b[best_mapping].m_lo);
-		uint32_t h = dxt1_block::pack_unscaled_color(pTable_r[best_mapping].m_hi, pTable_g[best_mapping].m_hi, pTable_b[best_mapping].m_hi);
-
-		const uint8_t* pSelectors_xlat_256 = &g_etc1_to_dxt1_selector_mappings_raw_dxt1_256[best_mapping][0];
+		convert_etc1s_to_dxt1_mapped(pDst_block, pSelector, pTable_r, pTable_g, pTable_b, best_mapping, use_threecolor_blocks);
+#endif
+	}
 
-		if (l < h)
-		{
-			std::swap(l, h);
-			pSelectors_xlat_256 = &g_etc1_to_dxt1_selector_mappings_raw_dxt1_inv_256[best_mapping][0];
-		}
-				
-		pDst_block->set_low_color(static_cast<uint16_t>(l));
-		pDst_block->set_high_color(static_cast<uint16_t>(h));
+	// Converts a batch of blocks. Special case blocks are converted as they're found, the rest share one call to the mapping kernel.
+	static void convert_etc1s_to_dxt1_batch(const etc1s_block_batch& batch, bool use_threecolor_blocks)
+	{
+		etc1s_mapping_rows rows[ETC1S_BLOCK_BATCH_SIZE] = {};
+		uint8_t block_indices[ETC1S_BLOCK_BATCH_SIZE];
+		uint8_t best_mappings[ETC1S_BLOCK_BATCH_SIZE];
+		uint32_t num_mapped_blocks = 0;
 
-		if (l == h)
+		for (uint32_t i = 0; i < batch.m_num_blocks; i++)
 		{
-			uint8_t mask = 0;
-
-			if (!use_threecolor_blocks)
+			if (is_etc1s_to_dxt1_special_block(batch.m_pEndpoints[i], batch.m_pSelectors[i]))
 			{
-				// This is an annoying edge case that impacts BC3.
-
-				// Make l > h
-				if (h > 0)
-					h--;
-				else
-				{
-					// l = h = 0
-					assert(l == h && h == 0);
-
-					h = 0;
-					l = 1;
-					mask = 0x55;
-				}
-
-				assert(l > h);
-				pDst_block->set_low_color(static_cast<uint16_t>(l));
-				pDst_block->set_high_color(static_cast<uint16_t>(h));
+				convert_etc1s_to_dxt1(static_cast<dxt1_block*>(batch.m_pDst_blocks[i]), batch.m_pEndpoints[i], batch.m_pSelectors[i], use_threecolor_blocks);
+				continue;
 			}
 
-			pDst_block->m_selectors[0] = mask;
-			pDst_block->m_selectors[1] = mask;
-			pDst_block->m_selectors[2] = mask;
-			pDst_block->m_selectors[3] = mask;
-
-			return;
+			rows[num_mapped_blocks] = get_etc1s_to_dxt1_mapping_rows(batch.m_pEndpoints[i], batch.m_pSelectors[i]);
+			block_indices[num_mapped_blocks++] = static_cast<uint8_t>(i);
 		}
 
-		pDst_block->m_selectors[0] = pSelectors_xlat_256[pSelector->m_selectors[0]];
-		pDst_block->m_selectors[1] = pSelectors_xlat_256[pSelector->m_selectors[1]];
-		pDst_block->m_selectors[2] = pSelectors_xlat_256[pSelector->m_selectors[2]];
-		pDst_block->m_selectors[3] = pSelectors_xlat_256[pSelector->m_selectors[3]];
-#endif
+		g_pFind_best_etc1s_mappings(rows, num_mapped_blocks, best_mappings);
+
+		for (uint32_t j = 0; j < num_mapped_blocks; j++)
+		{
+			const uint32_t i = block_indices[j];
+			convert_etc1s_to_dxt1_mapped(static_cast<dxt1_block*>(batch.m_pDst_blocks[i]), batch.m_pSelectors[i],
+				static_cast<const etc1_to_dxt1_56_solution*>(rows[j].m_pR), static_cast<const etc1_to_dxt1_56_solution*>(rows[j].m_pG), static_cast<const etc1_to_dxt1_56_solution*>(rows[j].m_pB),
+				best_mappings[j], use_threecolor_blocks);
+		}
 	}
 
 #if BASISD_ENABLE_DEBUG_FLAGS
@@ -3776,6 +4090,9 @@ namespace basist
 		{ 1, 2, 3, 3 },
 	};
 
+	// g_etc1_to_bc7_m5_selector_mappings applied to a byte of 4 selectors at once.
+	static uint8_t g_etc1_to_bc7_m5_selector_mappings_256[NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS][256];
+
 	struct etc1_to_bc7_m5_solution
 	{
 		uint8_t m_lo;
@@ -4151,6 +4468,72 @@ namespace basist
 			uint32_t h = g_etc1_to_bc7_m5a_selector_ranges[i].m_high;
 			g_etc1_to_bc7_m5a_selector_range_index[l][h] = i;
 		}
+
+		for (uint32_t sm = 0; sm < NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS; sm++)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t k = 0;
+				for (uint32_t s = 0; s < 4; s++)
+					k |= (g_etc1_to_bc7_m5_selector_mappings[sm][(i >> (s * 2)) & 3] << (s * 2));
+				g_etc1_to_bc7_m5_selector_mappings_256[sm][i] = (uint8_t)k;
+			}
+		}
+	}
+
+	static inline bool is_etc1s_to_bc7_m5_color_special_block(const selector* pSelector)
+	{
+		return pSelector->m_num_unique_selectors <= 2;
+	}
+
+	static inline etc1s_mapping_rows get_etc1s_to_bc7_m5_color_mapping_rows(const endpoint* pEndpoints, const selector* pSelector)
+	{
+		static_assert((NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS == NUM_ETC1S_SELECTOR_MAPPINGS) && (sizeof(etc1_to_bc7_m5_solution) == sizeof(etc1s_to_x_solution)), "The mapping kernels can't read this table");
+
+		const color32& base_color = pEndpoints->m_color5;
+		const uint32_t inten_table = pEndpoints->m_inten5;
+
+		const uint32_t selector_range_table = g_etc1_to_bc7_m5_selector_range_index[pSelector->m_lo_selector][pSelector->m_hi_selector];
+
+		//[32][8][RANGES][MAPPING]
+		etc1s_mapping_rows rows;
+		rows.m_pR = &g_etc1_to_bc7_m5_color[(inten_table * 32 + base_color.r) * (NUM_ETC1_TO_BC7_M5_SELECTOR_RANGES * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS];
+		rows.m_pG = &g_etc1_to_bc7_m5_color[(inten_table * 32 + base_color.g) * (NUM_ETC1_TO_BC7_M5_SELECTOR_RANGES * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS];
+		rows.m_pB = &g_etc1_to_bc7_m5_color[(inten_table * 32 + base_color.b) * (NUM_ETC1_TO_BC7_M5_SELECTOR_RANGES * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS];
+		return rows;
+	}
+
+	// Converts a block with more than 2 unique selectors using the given selector mapping.
+	static void convert_etc1s_to_bc7_m5_color_mapped(void* pDst, const selector* pSelector,
+		const etc1_to_bc7_m5_solution* pTable_r, const etc1_to_bc7_m5_solution* pTable_g, const etc1_to_bc7_m5_solution* pTable_b,
+		uint32_t best_mapping)
+	{
+		bc7_mode_5* pDst_block = static_cast<bc7_mode_5*>(pDst);
+
+		const uint8_t* pSelectors_xlat_256 = &g_etc1_to_bc7_m5_selector_mappings_256[best_mapping][0];
+
+		// All 16 translated selectors, 2 bits each, in pixel order.
+		uint32_t os = pSelectors_xlat_256[pSelector->m_selectors[0]] | (pSelectors_xlat_256[pSelector->m_selectors[1]] << 8) |
+			(pSelectors_xlat_256[pSelector->m_selectors[2]] << 16) | ((uint32_t)pSelectors_xlat_256[pSelector->m_selectors[3]] << 24);
+
+		uint64_t r0 = pTable_r[best_mapping].m_lo, g0 = pTable_g[best_mapping].m_lo, b0 = pTable_b[best_mapping].m_lo;
+		uint64_t r1 = pTable_r[best_mapping].m_hi, g1 = pTable_g[best_mapping].m_hi, b1 = pTable_b[best_mapping].m_hi;
+
+		if (os & 2)
+		{
+			std::swap(r0, r1);
+			std::swap(g0, g1);
+			std::swap(b0, b1);
+			os = ~os;
+		}
+
+		// The first selector's MSB is now 0 and is dropped (the anchor index has 1 bit), the rest have 2 bits.
+		const uint64_t output_bits = (os >> 1) | (os & 1);
+
+		// Write whole words rather than going through the bitfields: mode 5, rotation 0, the endpoints, alpha 255 and the
+		// color selectors. The alpha selectors are all 0.
+		pDst_block->m_lo_bits = (1 << 5) | (r0 << 8) | (r1 << 15) | (g0 << 22) | (g1 << 29) | (b0 << 36) | (b1 << 43) | (255ULL << 50) | (63ULL << 58);
+		pDst_block->m_hi_bits = 3 | (output_bits << 2);
 	}
 
 	static void convert_etc1s_to_bc7_m5_color(void* pDst, const endpoint* pEndpoints, const selector* pSelector)
@@ -4254,12 +4637,11 @@ namespace basist
 			return;
 		}
 
-		const uint32_t selector_range_table = g_etc1_to_bc7_m5_selector_range_index[low_selector][high_selector];
+		const etc1s_mapping_rows rows = get_etc1s_to_bc7_m5_color_mapping_rows(pEndpoints, pSelector);
 
-		//[32][8][RANGES][MAPPING]
-		const etc1_to_bc7_m5_solution* pTable_r = &g_etc1_to_bc7_m5_color[(inten_table * 32 + base_color_r) * (NUM_ETC1_TO_BC7_M5_SELECTOR_RANGES * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS];
-		const etc1_to_bc7_m5_solution* pTable_g = &g_etc1_to_bc7_m5_color[(inten_table * 32 + base_color_g) * (NUM_ETC1_TO_BC7_M5_SELECTOR_RANGES * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS];
-		const etc1_to_bc7_m5_solution* pTable_b = &g_etc1_to_bc7_m5_color[(inten_table * 32 + base_color_b) * (NUM_ETC1_TO_BC7_M5_SELECTOR_RANGES * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_BC7_M5_SELECTOR_MAPPINGS];
+		const etc1_to_bc7_m5_solution* pTable_r = static_cast<const etc1_to_bc7_m5_solution*>(rows.m_pR);
+		const etc1_to_bc7_m5_solution* pTable_g = static_cast<const etc1_to_bc7_m5_solution*>(rows.m_pG);
+		const etc1_to_bc7_m5_solution* pTable_b = static_cast<const etc1_to_bc7_m5_solution*>(rows.m_pB);
 
 		uint32_t best_err = UINT_MAX;
 		uint32_t best_mapping = 0;
@@ -4270,49 +4652,37 @@ namespace basist
 		DO_ITER(5); DO_ITER(6); DO_ITER(7); DO_ITER(8); DO_ITER(9);
 #undef DO_ITER
 
-		const uint8_t* pSelectors_xlat = &g_etc1_to_bc7_m5_selector_mappings[best_mapping][0];
+		convert_etc1s_to_bc7_m5_color_mapped(pDst, pSelector, pTable_r, pTable_g, pTable_b, best_mapping);
+	}
 
-		uint32_t s_inv = 0;
-		if (pSelectors_xlat[pSelector->get_selector(0, 0)] & 2)
-		{
-			pDst_block->m_lo.m_r0 = pTable_r[best_mapping].m_hi;
-			pDst_block->m_lo.m_g0 = pTable_g[best_mapping].m_hi;
-			pDst_block->m_lo.m_b0 = pTable_b[best_mapping].m_hi;
+	static void convert_etc1s_to_bc7_m5_color_batch(const etc1s_block_batch& batch)
+	{
+		etc1s_mapping_rows rows[ETC1S_BLOCK_BATCH_SIZE] = {};
+		uint8_t block_indices[ETC1S_BLOCK_BATCH_SIZE];
+		uint8_t best_mappings[ETC1S_BLOCK_BATCH_SIZE];
+		uint32_t num_mapped_blocks = 0;
 
-			pDst_block->m_lo.m_r1 = pTable_r[best_mapping].m_lo;
-			pDst_block->m_lo.m_g1 = pTable_g[best_mapping].m_lo;
-			pDst_block->m_lo.m_b1 = pTable_b[best_mapping].m_lo;
-			
-			s_inv = 3;
-		}
-		else
+		for (uint32_t i = 0; i < batch.m_num_blocks; i++)
 		{
-			pDst_block->m_lo.m_r0 = pTable_r[best_mapping].m_lo;
-			pDst_block->m_lo.m_g0 = pTable_g[best_mapping].m_lo;
-			pDst_block->m_lo.m_b0 = pTable_b[best_mapping].m_lo;
+			if (is_etc1s_to_bc7_m5_color_special_block(batch.m_pSelectors[i]))
+			{
+				convert_etc1s_to_bc7_m5_color(batch.m_pDst_blocks[i], batch.m_pEndpoints[i], batch.m_pSelectors[i]);
+				continue;
+			}
 
-			pDst_block->m_lo.m_r1 = pTable_r[best_mapping].m_hi;
-			pDst_block->m_lo.m_g1 = pTable_g[best_mapping].m_hi;
-			pDst_block->m_lo.m_b1 = pTable_b[best_mapping].m_hi;
+			rows[num_mapped_blocks] = get_etc1s_to_bc7_m5_color_mapping_rows(batch.m_pEndpoints[i], batch.m_pSelectors[i]);
+			block_indices[num_mapped_blocks++] = static_cast<uint8_t>(i);
 		}
 
-		uint32_t output_bits = 0, output_bit_ofs = 0;
+		g_pFind_best_etc1s_mappings(rows, num_mapped_blocks, best_mappings);
 
-		for (uint32_t y = 0; y < 4; y++)
+		for (uint32_t j = 0; j < num_mapped_blocks; j++)
 		{
-			for (uint32_t x = 0; x < 4; x++)
-			{
-				const uint32_t s = pSelector->get_selector(x, y);
-				
-				const uint32_t os = pSelectors_xlat[s] ^ s_inv;
-
-				output_bits |= (os << output_bit_ofs);
-
-				output_bit_ofs += (((x | y) == 0) ? 1 : 2);
-			}
+			const uint32_t i = block_indices[j];
+			convert_etc1s_to_bc7_m5_color_mapped(batch.m_pDst_blocks[i], batch.m_pSelectors[i],
+				static_cast<const etc1_to_bc7_m5_solution*>(rows[j].m_pR), static_cast<const etc1_to_bc7_m5_solution*>(rows[j].m_pG), static_cast<const etc1_to_bc7_m5_solution*>(rows[j].m_pB),
+				best_mappings[j]);
 		}
-
-		set_block_bits((uint8_t*)pDst, output_bits, 31, 66);
 	}
 
 	static void convert_etc1s_to_bc7_m5_alpha(void* pDst, const endpoint* pEndpoints, const selector* pSelector)
@@ -4859,6 +5229,9 @@ namespace basist
 #include "basisu_transcoder_tables_astc_0_255.inc"
 	};
 	static uint8_t g_etc1_to_astc_best_grayscale_mapping_0_255[32][8][NUM_ETC1_TO_ASTC_SELECTOR_RANGES];
+
+	// g_etc1_to_astc_selector_mappings applied to a byte of 4 selectors at once.
+	static uint8_t g_etc1_to_astc_selector_mappings_256[NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS][256];
 #endif
 
 	static uint32_t g_ise_to_unquant[48];
@@ -5222,33 +5595,6 @@ namespace basist
 			pBytes[ofs >> 3] |= (s_reverse_bits[pBlock->m_weights[i]] << (ofs & 7));
 		}
 	}
-
-	// CEM mode 8 (LDR RGB Direct), 8-bit endpoints, 2 bit weights
-	static void astc_pack_block_cem_8_weight_range2(uint32_t* pOutput, const astc_block_params* pBlock)
-	{
-		uint8_t* pBytes = reinterpret_cast<uint8_t*>(pOutput);
-
-		// Write constant block mode, color component selector, number of partitions, color endpoint mode
-		// https://www.khronos.org/registry/DataFormat/specs/1.2/dataformat.1.2.html#_block_mode
-		pBytes[0] = 0x42; pBytes[1] = 0x00; pBytes[2] = 0x01; pBytes[3] = 0x00;
-		
-		pOutput[1] = 0;
-		pOutput[2] = 0;
-		pOutput[3] = 0;
-
-		// Pack 6 endpoints (each ranging between [0,255]) as 8-bits starting at bit 17
-		int bit_pos = 17;
-		for (uint32_t i = 0; i < 6; i++)
-			astc_set_bits(pOutput, bit_pos, pBlock->m_endpoints[i], 8);
-
-		// Pack 16 2-bit weights, which are stored from the top down into the block in opposite bit order.
-		for (uint32_t i = 0; i < 16; i++)
-		{
-			static const uint8_t s_reverse_bits[4] = { 0, 2, 1, 3 };
-			const uint32_t ofs = 126 - (i * 2);
-			pBytes[ofs >> 3] |= (s_reverse_bits[pBlock->m_weights[i]] << (ofs & 7));
-		}
-	}
 #endif
 
 	// Optimal quantized [0,47] entry to use given [0,255] input
@@ -5310,6 +5656,17 @@ namespace basist
 				}
 			}
 		}
+
+		for (uint32_t sm = 0; sm < NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS; sm++)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t k = 0;
+				for (uint32_t s = 0; s < 4; s++)
+					k |= (g_etc1_to_astc_selector_mappings[sm][(i >> (s * 2)) & 3] << (s * 2));
+				g_etc1_to_astc_selector_mappings_256[sm][i] = (uint8_t)k;
+			}
+		}
 #endif
 
 		for (uint32_t i = 0; i < NUM_ETC1_TO_ASTC_SELECTOR_RANGES; i++)
@@ -5389,6 +5746,81 @@ namespace basist
 		}
 	}
 
+#if BASISD_SUPPORT_ASTC_HIGHER_OPAQUE_QUALITY
+	// Opaque blocks that aren't grayscale and have more than 2 unique selectors are converted using 8-bit endpoints.
+	static inline bool is_etc1s_to_astc_4x4_opaque_special_block(const endpoint* pEndpoints, const selector* pSelector)
+	{
+		const color32& base_color = pEndpoints->m_color5;
+		return (pSelector->m_num_unique_selectors <= 2) || ((base_color.r == base_color.g) && (base_color.r == base_color.b));
+	}
+
+	static inline etc1s_mapping_rows get_etc1s_to_astc_4x4_opaque_mapping_rows(const endpoint* pEndpoints, const selector* pSelector)
+	{
+		static_assert((NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS == NUM_ETC1S_SELECTOR_MAPPINGS) && (sizeof(etc1_to_astc_solution) == sizeof(etc1s_to_x_solution)), "The mapping kernels can't read this table");
+
+		const color32& base_color = pEndpoints->m_color5;
+		const uint32_t inten_table = pEndpoints->m_inten5;
+
+		// Convert ETC1S color
+		const uint32_t selector_range_table = g_etc1_to_astc_selector_range_index[pSelector->m_lo_selector][pSelector->m_hi_selector];
+
+		//[32][8][RANGES][MAPPING]
+		etc1s_mapping_rows rows;
+		rows.m_pR = &g_etc1_to_astc_0_255[(inten_table * 32 + base_color.r) * (NUM_ETC1_TO_ASTC_SELECTOR_RANGES * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS];
+		rows.m_pG = &g_etc1_to_astc_0_255[(inten_table * 32 + base_color.g) * (NUM_ETC1_TO_ASTC_SELECTOR_RANGES * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS];
+		rows.m_pB = &g_etc1_to_astc_0_255[(inten_table * 32 + base_color.b) * (NUM_ETC1_TO_ASTC_SELECTOR_RANGES * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS];
+		return rows;
+	}
+
+	static inline uint32_t reverse_bits32(uint32_t v)
+	{
+		v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+		v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+		v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+		v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+		return (v >> 16) | (v << 16);
+	}
+
+	// Converts an opaque block that isn't one of the special cases using the given selector mapping. Writes a
+	// CEM mode 8 (LDR RGB Direct) block with 8-bit endpoints and 2 bit weights a word at a time.
+	static void convert_etc1s_to_astc_4x4_opaque_mapped(void* pDst_block, const selector* pSelector,
+		const etc1_to_astc_solution* pTable_r, const etc1_to_astc_solution* pTable_g, const etc1_to_astc_solution* pTable_b,
+		uint32_t best_mapping)
+	{
+		uint64_t r0 = pTable_r[best_mapping].m_lo, g0 = pTable_g[best_mapping].m_lo, b0 = pTable_b[best_mapping].m_lo;
+		uint64_t r1 = pTable_r[best_mapping].m_hi, g1 = pTable_g[best_mapping].m_hi, b1 = pTable_b[best_mapping].m_hi;
+
+		const uint8_t* pSelectors_xlat_256 = &g_etc1_to_astc_selector_mappings_256[best_mapping][0];
+
+		// All 16 weights, 2 bits each, in pixel order.
+		uint32_t weights = pSelectors_xlat_256[pSelector->m_selectors[0]] | (pSelectors_xlat_256[pSelector->m_selectors[1]] << 8) |
+			(pSelectors_xlat_256[pSelector->m_selectors[2]] << 16) | ((uint32_t)pSelectors_xlat_256[pSelector->m_selectors[3]] << 24);
+
+		if ((r1 + g1 + b1) < (r0 + g0 + b0))
+		{
+			std::swap(r0, r1);
+			std::swap(g0, g1);
+			std::swap(b0, b1);
+			weights = ~weights;
+		}
+
+		// 6 endpoints (each ranging between [0,255]) as 8-bits starting at bit 17.
+		const uint64_t endpoints = r0 | (r1 << 8) | (g0 << 16) | (g1 << 24) | (b0 << 32) | (b1 << 40);
+
+		uint32_t block[4];
+
+		// Constant block mode, color component selector, number of partitions, color endpoint mode.
+		block[0] = 0x00010042 | (uint32_t)(endpoints << 17);
+		block[1] = (uint32_t)(endpoints >> 15);
+		block[2] = (uint32_t)(endpoints >> 47);
+
+		// The weights are stored from the top down into the block in opposite bit order.
+		block[3] = reverse_bits32(weights);
+
+		memcpy(pDst_block, block, sizeof(block));
+	}
+#endif // BASISD_SUPPORT_ASTC_HIGHER_OPAQUE_QUALITY
+
 	// Converts opaque or color+alpha ETC1S block to ASTC 4x4.
 	// This function tries to use the best ASTC mode given the block's actual contents.
 	static void convert_etc1s_to_astc_4x4(void* pDst_block, const endpoint* pEndpoints, const selector* pSelector, 
@@ -5657,13 +6089,11 @@ namespace basist
 		// Check for fully opaque blocks, if so use 8-bit endpoints for slightly higher opaque quality (higher than BC1, but lower than BC7 mode 6 opaque).
 		if ((num_unique_alpha_selectors == 1) && (constant_alpha_val == 255))
 		{
-			// Convert ETC1S color
-			const uint32_t selector_range_table = g_etc1_to_astc_selector_range_index[low_selector][high_selector];
+			const etc1s_mapping_rows rows = get_etc1s_to_astc_4x4_opaque_mapping_rows(pEndpoints, pSelector);
 
-			//[32][8][RANGES][MAPPING]
-			const etc1_to_astc_solution* pTable_r = &g_etc1_to_astc_0_255[(inten_table * 32 + base_color.r) * (NUM_ETC1_TO_ASTC_SELECTOR_RANGES * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS];
-			const etc1_to_astc_solution* pTable_g = &g_etc1_to_astc_0_255[(inten_table * 32 + base_color.g) * (NUM_ETC1_TO_ASTC_SELECTOR_RANGES * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS];
-			const etc1_to_astc_solution* pTable_b = &g_etc1_to_astc_0_255[(inten_table * 32 + base_color.b) * (NUM_ETC1_TO_ASTC_SELECTOR_RANGES * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS) + selector_range_table * NUM_ETC1_TO_ASTC_SELECTOR_MAPPINGS];
+			const etc1_to_astc_solution* pTable_r = static_cast<const etc1_to_astc_solution*>(rows.m_pR);
+			const etc1_to_astc_solution* pTable_g = static_cast<const etc1_to_astc_solution*>(rows.m_pG);
+			const etc1_to_astc_solution* pTable_b = static_cast<const etc1_to_astc_solution*>(rows.m_pB);
 
 			uint32_t best_err = UINT_MAX;
 			uint32_t best_mapping = 0;
@@ -5674,44 +6104,7 @@ namespace basist
 			DO_ITER(5); DO_ITER(6); DO_ITER(7); DO_ITER(8); DO_ITER(9);
 #undef DO_ITER
 
-			blk.m_endpoints[0] = pTable_r[best_mapping].m_lo;
-			blk.m_endpoints[1] = pTable_r[best_mapping].m_hi;
-
-			blk.m_endpoints[2] = pTable_g[best_mapping].m_lo;
-			blk.m_endpoints[3] = pTable_g[best_mapping].m_hi;
-
-			blk.m_endpoints[4] = pTable_b[best_mapping].m_lo;
-			blk.m_endpoints[5] = pTable_b[best_mapping].m_hi;
-
-			int s0 = blk.m_endpoints[0] + blk.m_endpoints[2] + blk.m_endpoints[4];
-			int s1 = blk.m_endpoints[1] + blk.m_endpoints[3] + blk.m_endpoints[5];
-			bool invert = false;
-
-			if (s1 < s0)
-			{
-				std::swap(blk.m_endpoints[0], blk.m_endpoints[1]);
-				std::swap(blk.m_endpoints[2], blk.m_endpoints[3]);
-				std::swap(blk.m_endpoints[4], blk.m_endpoints[5]);
-				invert = true;
-			}
-
-			const uint8_t* pSelectors_xlat = &g_etc1_to_astc_selector_mappings[best_mapping][0];
-
-			for (uint32_t y = 0; y < 4; y++)
-			{
-				for (uint32_t x = 0; x < 4; x++)
-				{
-					uint32_t s = pSelector->get_selector(x, y);
-					uint32_t as = pSelectors_xlat[s];
-					if (invert)
-						as = 3 - as;
-
-					blk.m_weights[x + y * 4] = static_cast<uint8_t>(as);
-				} // x
-			} // y
-
-			// Now pack to ASTC
-			astc_pack_block_cem_8_weight_range2(reinterpret_cast<uint32_t*>(pDst_block), &blk);
+			convert_etc1s_to_astc_4x4_opaque_mapped(pDst_block, pSelector, pTable_r, pTable_g, pTable_b, best_mapping);
 			return;
 		}
 #endif //#if BASISD_SUPPORT_ASTC_HIGHER_OPAQUE_QUALITY
@@ -5949,6 +6342,46 @@ namespace basist
 		// Now pack to ASTC
 		astc_pack_block_cem_12_weight_range2(reinterpret_cast<uint32_t *>(pDst_block), &blk);
 	}
+
+	// Only blocks without alpha take the path that searches for the best mapping, so only those are batched.
+	static void convert_etc1s_to_astc_4x4_batch(const etc1s_block_batch& batch, bool transcode_alpha, const endpoint* pEndpoint_codebook, const selector* pSelector_codebook)
+	{
+#if BASISD_SUPPORT_ASTC_HIGHER_OPAQUE_QUALITY
+		if (!transcode_alpha)
+		{
+			etc1s_mapping_rows rows[ETC1S_BLOCK_BATCH_SIZE] = {};
+			uint8_t block_indices[ETC1S_BLOCK_BATCH_SIZE];
+			uint8_t best_mappings[ETC1S_BLOCK_BATCH_SIZE];
+			uint32_t num_mapped_blocks = 0;
+
+			for (uint32_t i = 0; i < batch.m_num_blocks; i++)
+			{
+				if (is_etc1s_to_astc_4x4_opaque_special_block(batch.m_pEndpoints[i], batch.m_pSelectors[i]))
+				{
+					convert_etc1s_to_astc_4x4(batch.m_pDst_blocks[i], batch.m_pEndpoints[i], batch.m_pSelectors[i], false, pEndpoint_codebook, pSelector_codebook);
+					continue;
+				}
+
+				rows[num_mapped_blocks] = get_etc1s_to_astc_4x4_opaque_mapping_rows(batch.m_pEndpoints[i], batch.m_pSelectors[i]);
+				block_indices[num_mapped_blocks++] = static_cast<uint8_t>(i);
+			}
+
+			g_pFind_best_etc1s_mappings(rows, num_mapped_blocks, best_mappings);
+
+			for (uint32_t j = 0; j < num_mapped_blocks; j++)
+			{
+				const uint32_t i = block_indices[j];
+				convert_etc1s_to_astc_4x4_opaque_mapped(batch.m_pDst_blocks[i], batch.m_pSelectors[i],
+					static_cast<const etc1_to_astc_solution*>(rows[j].m_pR), static_cast<const etc1_to_astc_solution*>(rows[j].m_pG), static_cast<const etc1_to_astc_solution*>(rows[j].m_pB),
+					best_mappings[j]);
+			}
+			return;
+		}
+#endif
+
+		for (uint32_t i = 0; i < batch.m_num_blocks; i++)
+			convert_etc1s_to_astc_4x4(batch.m_pDst_blocks[i], batch.m_pEndpoints[i], batch.m_pSelectors[i], transcode_alpha, pEndpoint_codebook, pSelector_codebook);
+	}
 #endif
 
 #if BASISD_SUPPORT_ATC
@@ -7775,6 +8208,41 @@ namespace basist
 		return true;
 	}
 
+	// Converts and empties a batch of blocks queued by transcode_slice().
+	static void convert_etc1s_block_batch(etc1s_block_batch& batch, block_format fmt, bool bc1_allow_threecolor_blocks,
+		bool transcode_alpha, const endpoint* pEndpoint_codebook, const selector* pSelector_codebook)
+	{
+		BASISU_NOTE_UNUSED(bc1_allow_threecolor_blocks);
+		BASISU_NOTE_UNUSED(transcode_alpha);
+		BASISU_NOTE_UNUSED(pEndpoint_codebook);
+		BASISU_NOTE_UNUSED(pSelector_codebook);
+
+		switch (fmt)
+		{
+#if BASISD_SUPPORT_DXT1
+		case block_format::cBC1:
+			convert_etc1s_to_dxt1_batch(batch, bc1_allow_threecolor_blocks);
+			break;
+#endif
+#if BASISD_SUPPORT_BC7_MODE5
+		case block_format::cBC7:
+		case block_format::cBC7_M5_COLOR:
+			convert_etc1s_to_bc7_m5_color_batch(batch);
+			break;
+#endif
+#if BASISD_SUPPORT_ASTC
+		case block_format::cASTC_4x4:
+			convert_etc1s_to_astc_4x4_batch(batch, transcode_alpha, pEndpoint_codebook, pSelector_codebook);
+			break;
+#endif
+		default:
+			assert(0);
+			break;
+		}
+
+		batch.m_num_blocks = 0;
+	}
+
 	bool basisu_lowlevel_etc1s_transcoder::transcode_slice(void* pDst_blocks, uint32_t num_blocks_x, uint32_t num_blocks_y, const uint8_t* pImage_data, uint32_t image_data_size, block_format fmt,
 		uint32_t output_block_or_pixel_stride_in_bytes, bool bc1_allow_threecolor_blocks, const bool is_video, const bool is_alpha_slice, const uint32_t level_index, const uint32_t orig_width, const uint32_t orig_height, uint32_t output_row_pitch_in_blocks_or_pixels,
 		basisu_transcoder_state* pState, bool transcode_alpha, void *pAlpha_blocks, uint32_t output_rows_in_pixels)
@@ -7890,6 +8358,9 @@ namespace basist
 		const uint32_t SELECTOR_HISTORY_BUF_FIRST_SYMBOL_INDEX = (uint32_t)selectors.size();
 		const uint32_t SELECTOR_HISTORY_BUF_RLE_SYMBOL_INDEX = m_selector_history_buf_size + SELECTOR_HISTORY_BUF_FIRST_SYMBOL_INDEX;
 
+		// The BC1, BC7 and ASTC converters are given batches of blocks so their selector mapping searches can use SIMD.
+		etc1s_block_batch block_batch;
+
 		for (uint32_t block_y = 0; block_y < num_blocks_y; block_y++)
 		{
 			const uint32_t cur_block_endpoint_pred_array = block_y & 1;
@@ -8116,7 +8587,8 @@ namespace basist
 						convert_etc1s_to_dxt1_vis(static_cast<dxt1_block*>(pDst_block), pEndpoints, pSelector, bc1_allow_threecolor_blocks);
 					else
 #endif
-						convert_etc1s_to_dxt1(static_cast<dxt1_block*>(pDst_block), pEndpoints, pSelector, bc1_allow_threecolor_blocks);
+					if (block_batch.add(pDst_block, pEndpoints, pSelector))
+						convert_etc1s_block_batch(block_batch, fmt, bc1_allow_threecolor_blocks, transcode_alpha, &endpoints[0], &selectors[0]);
 #else
 					assert(0);
 #endif
@@ -8224,7 +8696,8 @@ namespace basist
 				{
 #if BASISD_SUPPORT_BC7_MODE5
 					void* pDst_block = static_cast<uint8_t*>(pDst_blocks) + (block_x + block_y * output_row_pitch_in_blocks_or_pixels) * output_block_or_pixel_stride_in_bytes;
-					convert_etc1s_to_bc7_m5_color(pDst_block, pEndpoints, pSelector);
+					if (block_batch.add(pDst_block, pEndpoints, pSelector))
+						convert_etc1s_block_batch(block_batch, fmt, bc1_allow_threecolor_blocks, transcode_alpha, &endpoints[0], &selectors[0]);
 #else
 					assert(0);
 #endif
@@ -8254,7 +8727,8 @@ namespace basist
 				{
 #if BASISD_SUPPORT_ASTC
 					void* pDst_block = static_cast<uint8_t*>(pDst_blocks) + (block_x + block_y * output_row_pitch_in_blocks_or_pixels) * output_block_or_pixel_stride_in_bytes;
-					convert_etc1s_to_astc_4x4(pDst_block, pEndpoints, pSelector, transcode_alpha, &endpoints[0], &selectors[0]);
+					if (block_batch.add(pDst_block, pEndpoints, pSelector))
+						convert_etc1s_block_batch(block_batch, fmt, bc1_allow_threecolor_blocks, transcode_alpha, &endpoints[0], &selectors[0]);
 #else
 					assert(0);
 #endif
@@ -8316,7 +8790,7 @@ namespace basist
 					assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint32_t);
 										
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 					
 					int colors[4];
@@ -8356,7 +8830,7 @@ namespace basist
 					assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint32_t);
 
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 					color32 colors[4];
@@ -8385,7 +8859,7 @@ namespace basist
 					assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint32_t);
 
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 					color32 colors[4];
@@ -8416,7 +8890,7 @@ namespace basist
 					assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
 
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 					color32 colors[4];
@@ -8459,7 +8933,7 @@ namespace basist
 					assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
 
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 					color32 colors[4];
@@ -8499,7 +8973,7 @@ namespace basist
 					assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
 
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 					color32 colors[4];
@@ -8530,7 +9004,7 @@ namespace basist
 					assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
 
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+					const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 					color32 colors[4];
@@ -8579,6 +9053,9 @@ namespace basist
 
 		} // block-y
 
+		if (block_batch.m_num_blocks)
+			convert_etc1s_block_batch(block_batch, fmt, bc1_allow_threecolor_blocks, transcode_alpha, &endpoints[0], &selectors[0]);
+
 		if (endpoint_pred_repeat_count != 0)
 		{
 			BASISU_DEVEL_ERROR("basisu_lowlevel_etc1s_transcoder::transcode_slice: endpoint_pred_repeat_count != 0. The file is corrupted or this is a bug\n");
@@ -9303,6 +9780,25 @@ namespace basist
 			else
 				transcode_uastc_to_pvrtc1_4_rgb((const uastc_block *)pImage_data, pDst_blocks, num_blocks_x, num_blocks_y, high_quality, from_alpha);
 		}
+		else if ((fmt == block_format::cBC7) || (fmt == block_format::cBC7_M5_COLOR) || (fmt == block_format::cASTC_4x4))
+		{
+			// These transcode a row at a time, so blocks can be grouped by mode and sent through per-mode kernels.
+			for (uint32_t block_y = 0; block_y < num_blocks_y; ++block_y, pSource_block += num_blocks_x)
+			{
+				void* pDst_row = (uint8_t*)pDst_blocks + block_y * output_row_pitch_in_blocks_or_pixels * output_block_or_pixel_stride_in_bytes;
+
+				if (fmt == block_format::cASTC_4x4)
+					status = transcode_uastc_to_astc(pSource_block, pDst_row, num_blocks_x, output_block_or_pixel_stride_in_bytes);
+				else
+					status = transcode_uastc_to_bc7(pSource_block, pDst_row, num_blocks_x, output_block_or_pixel_stride_in_bytes);
+
+				if (!status)
+				{
+					BASISU_DEVEL_ERROR("basisu_lowlevel_uastc_transcoder::transcode_slice: Transcoder failed to unpack a UASTC block - this is a bug, or the data was corrupted\n");
+					return false;
+				}
+			}
+		}
 		else
 		{
 			for (uint32_t block_y = 0; block_y < num_blocks_y; ++block_y)
@@ -9358,17 +9854,6 @@ namespace basist
 						status = transcode_uastc_to_bc5(*pSource_block, pDst_block, high_quality, channel0, channel1);
 						break;
 					}
-					case block_format::cBC7:
-					case block_format::cBC7_M5_COLOR: // for consistently with ETC1S
-					{
-						status = transcode_uastc_to_bc7(*pSource_block, pDst_block);
-						break;
-					}
-					case block_format::cASTC_4x4:
-					{
-						status = transcode_uastc_to_astc(*pSource_block, pDst_block);
-						break;
-					}
 					case block_format::cETC2_EAC_R11:
 					{
 						if (channel0 < 0)
@@ -9393,7 +9878,7 @@ namespace basist
 						assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
 						uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint32_t);
 
-						const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+						const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 						const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 						for (uint32_t y = 0; y < max_y; y++)
@@ -9422,7 +9907,7 @@ namespace basist
 						assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
 						uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
 
-						const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+						const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 						const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 						for (uint32_t y = 0; y < max_y; y++)
@@ -9451,7 +9936,7 @@ namespace basist
 						assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
 						uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
 
-						const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
+						const uint32_t max_x = basisu::minimum<int>(4, (int)orig_width - (int)block_x * 4);
 						const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
 						for (uint32_t y = 0; y < max_y; y++)
@@ -11500,24 +11985,86 @@ namespace basist
 	endpoint_err g_bc7_mode_6_optimal_endpoints[256][2]; // [c][pbit]
 	endpoint_err g_bc7_mode_5_optimal_endpoints[256]; // [c]
 
-	static inline void bc7_set_block_bits(uint8_t* pBytes, uint32_t val, uint32_t num_bits, uint32_t* pCur_ofs)
+	// An integer known at compile time. It converts to uint32_t, so the *_mode() helpers below can take either a runtime mode index or uint32_constant<>.
+	// The per-mode UASTC batch kernels use the latter, which lets the compiler fold away all of the mode dependent table lookups and branches.
+	template<uint32_t N> struct uint32_constant { constexpr operator uint32_t() const { return N; } };
+
+	// Accumulates a 128-bit block LSB first in two 64-bit words, instead of read-modify-writing it a byte at a time.
+	struct block128_bit_writer
 	{
-		assert((num_bits <= 32) && (val < (1ULL << num_bits)));
-		while (num_bits)
+		uint64_t m_lo, m_hi;
+		uint32_t m_ofs;
+
+		block128_bit_writer() : m_lo(0), m_hi(0), m_ofs(0) { }
+
+		inline void put_bits(uint32_t val, uint32_t num_bits)
 		{
-			const uint32_t n = basisu::minimumu(8 - (*pCur_ofs & 7), num_bits);
-			pBytes[*pCur_ofs >> 3] |= (uint8_t)(val << (*pCur_ofs & 7));
-			val >>= n;
-			num_bits -= n;
-			*pCur_ofs += n;
+			assert((num_bits <= 32) && (val < (1ULL << num_bits)));
+
+			if (m_ofs < 64)
+			{
+				m_lo |= (uint64_t)val << m_ofs;
+				if ((m_ofs + num_bits) > 64)
+					m_hi |= (uint64_t)val >> (64 - m_ofs);
+			}
+			else
+				m_hi |= (uint64_t)val << (m_ofs - 64);
+
+			m_ofs += num_bits;
+			assert(m_ofs <= 128);
+		}
+
+		inline void write(void* pBlock) const
+		{
+			uint8_t* pBytes = static_cast<uint8_t*>(pBlock);
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				pBytes[i] = (uint8_t)(m_lo >> (i * 8));
+				pBytes[8 + i] = (uint8_t)(m_hi >> (i * 8));
+			}
+		}
+	};
+
+	// Writes a block's 16 indices, dropping the implicit MSB of each subset's anchor index.
+	static inline void bc7_put_indices(block128_bit_writer& writer, const uint8_t* pIndices, uint32_t index_bits, const int anchor[3], uint32_t total_subsets)
+	{
+		assert((index_bits * 16) <= 64);
+
+		uint64_t bits = 0;
+		for (uint32_t i = 0; i < 16; i++)
+			bits |= (uint64_t)pIndices[i] << (i * index_bits);
+
+		// Remove the anchor MSBs from the highest index down, so the ones still to be removed don't move. Anchor 0 is always index 0.
+		int anchors[3] = { 0, 0, 0 };
+		if (total_subsets == 3)
+		{
+			anchors[0] = basisu::maximum(anchor[1], anchor[2]);
+			anchors[1] = basisu::minimum(anchor[1], anchor[2]);
+		}
+		else if (total_subsets == 2)
+			anchors[0] = anchor[1];
+
+		for (uint32_t k = 0; k < total_subsets; k++)
+		{
+			const uint32_t msb_ofs = anchors[k] * index_bits + index_bits - 1;
+			assert(((bits >> msb_ofs) & 1) == 0);
+			bits = (bits & ((1ULL << msb_ofs) - 1)) | ((bits >> (msb_ofs + 1)) << msb_ofs);
+		}
+
+		const uint32_t total_bits = index_bits * 16 - total_subsets;
+		if (total_bits > 32)
+		{
+			writer.put_bits((uint32_t)bits, 32);
+			writer.put_bits((uint32_t)(bits >> 32), total_bits - 32);
 		}
-		assert(*pCur_ofs <= 128);
+		else
+			writer.put_bits((uint32_t)bits, total_bits);
 	}
 
-	// TODO: Optimize this.
-	void encode_bc7_block(void* pBlock, const bc7_optimization_results* pResults)
+	template<typename mode_t>
+	static inline void encode_bc7_block_mode(void* pBlock, const bc7_optimization_results* pResults, mode_t best_mode)
 	{
-		const uint32_t best_mode = pResults->m_mode;
+		assert(pResults->m_mode == best_mode);
 
 		const uint32_t total_subsets = g_bc7_num_subsets[best_mode];
 		const uint32_t total_partitions = 1 << g_bc7_partition_bits[best_mode];
@@ -11613,28 +12160,25 @@ namespace basist
 			}
 		}
 
-		uint8_t* pBlock_bytes = (uint8_t*)(pBlock);
-		memset(pBlock_bytes, 0, BC7ENC_BLOCK_SIZE);
-
-		uint32_t cur_bit_ofs = 0;
-		bc7_set_block_bits(pBlock_bytes, 1 << best_mode, best_mode + 1, &cur_bit_ofs);
+		block128_bit_writer writer;
+		writer.put_bits(1 << best_mode, best_mode + 1);
 
 		if ((best_mode == 4) || (best_mode == 5))
-			bc7_set_block_bits(pBlock_bytes, pResults->m_rotation, 2, &cur_bit_ofs);
+			writer.put_bits(pResults->m_rotation, 2);
 
 		if (best_mode == 4)
-			bc7_set_block_bits(pBlock_bytes, pResults->m_index_selector, 1, &cur_bit_ofs);
+			writer.put_bits(pResults->m_index_selector, 1);
 
 		if (total_partitions > 1)
-			bc7_set_block_bits(pBlock_bytes, pResults->m_partition, (total_partitions == 64) ? 6 : 4, &cur_bit_ofs);
+			writer.put_bits(pResults->m_partition, (total_partitions == 64) ? 6 : 4);
 
 		const uint32_t total_comps = (best_mode >= 4) ? 4 : 3;
 		for (uint32_t comp = 0; comp < total_comps; comp++)
 		{
 			for (uint32_t subset = 0; subset < total_subsets; subset++)
 			{
-				bc7_set_block_bits(pBlock_bytes, low[subset].m_c[comp], (comp == 3) ? g_bc7_alpha_precision_table[best_mode] : g_bc7_color_precision_table[best_mode], &cur_bit_ofs);
-				bc7_set_block_bits(pBlock_bytes, high[subset].m_c[comp], (comp == 3) ? g_bc7_alpha_precision_table[best_mode] : g_bc7_color_precision_table[best_mode], &cur_bit_ofs);
+				writer.put_bits(low[subset].m_c[comp], (comp == 3) ? g_bc7_alpha_precision_table[best_mode] : g_bc7_color_precision_table[best_mode]);
+				writer.put_bits(high[subset].m_c[comp], (comp == 3) ? g_bc7_alpha_precision_table[best_mode] : g_bc7_color_precision_table[best_mode]);
 			}
 		}
 
@@ -11642,46 +12186,39 @@ namespace basist
 		{
 			for (uint32_t subset = 0; subset < total_subsets; subset++)
 			{
-				bc7_set_block_bits(pBlock_bytes, pbits[subset][0], 1, &cur_bit_ofs);
+				writer.put_bits(pbits[subset][0], 1);
 				if (!g_bc7_mode_has_shared_p_bits[best_mode])
-					bc7_set_block_bits(pBlock_bytes, pbits[subset][1], 1, &cur_bit_ofs);
+					writer.put_bits(pbits[subset][1], 1);
 			}
 		}
 
-		for (uint32_t y = 0; y < 4; y++)
-		{
-			for (uint32_t x = 0; x < 4; x++)
-			{
-				int idx = x + y * 4;
-
-				uint32_t n = pResults->m_index_selector ? get_bc7_alpha_index_size(best_mode, pResults->m_index_selector) : get_bc7_color_index_size(best_mode, pResults->m_index_selector);
-
-				if ((idx == anchor[0]) || (idx == anchor[1]) || (idx == anchor[2]))
-					n--;
-
-				bc7_set_block_bits(pBlock_bytes, pResults->m_index_selector ? alpha_selectors[idx] : color_selectors[idx], n, &cur_bit_ofs);
-			}
-		}
+		const uint32_t color_index_bits = get_bc7_color_index_size(best_mode, pResults->m_index_selector);
 
 		if (get_bc7_mode_has_seperate_alpha_selectors(best_mode))
 		{
-			for (uint32_t y = 0; y < 4; y++)
-			{
-				for (uint32_t x = 0; x < 4; x++)
-				{
-					int idx = x + y * 4;
-
-					uint32_t n = pResults->m_index_selector ? get_bc7_color_index_size(best_mode, pResults->m_index_selector) : get_bc7_alpha_index_size(best_mode, pResults->m_index_selector);
+			const uint32_t alpha_index_bits = get_bc7_alpha_index_size(best_mode, pResults->m_index_selector);
 
-					if ((idx == anchor[0]) || (idx == anchor[1]) || (idx == anchor[2]))
-						n--;
-
-					bc7_set_block_bits(pBlock_bytes, pResults->m_index_selector ? color_selectors[idx] : alpha_selectors[idx], n, &cur_bit_ofs);
-				}
+			if (pResults->m_index_selector)
+			{
+				bc7_put_indices(writer, alpha_selectors, alpha_index_bits, anchor, total_subsets);
+				bc7_put_indices(writer, color_selectors, color_index_bits, anchor, total_subsets);
+			}
+			else
+			{
+				bc7_put_indices(writer, color_selectors, color_index_bits, anchor, total_subsets);
+				bc7_put_indices(writer, alpha_selectors, alpha_index_bits, anchor, total_subsets);
 			}
 		}
+		else
+			bc7_put_indices(writer, color_selectors, color_index_bits, anchor, total_subsets);
+
+		assert(writer.m_ofs == 128);
+		writer.write(pBlock);
+	}
 
-		assert(cur_bit_ofs == 128);
+	void encode_bc7_block(void* pBlock, const bc7_optimization_results* pResults)
+	{
+		encode_bc7_block_mode(pBlock, pResults, pResults->m_mode);
 	}
 
 	// ASTC
@@ -11886,7 +12423,18 @@ namespace basist
 
 	const uint32_t g_uastc_mode_astc_block_mode[TOTAL_UASTC_MODES] = { 0x242, 0x42, 0x53, 0x42, 0x42, 0x53, 0x442, 0x42, 0, 0x42, 0x242, 0x442, 0x53, 0x441, 0x42, 0x242, 0x42, 0x442, 0x253 };
 
-	bool pack_astc_block(uint32_t* pDst, const astc_block_desc* pBlock, uint32_t uastc_mode)
+	static inline uint64_t reverse_bits64(uint64_t v)
+	{
+		v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+		v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+		v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+		v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+		v = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16);
+		return (v >> 32) | (v << 32);
+	}
+
+	template<typename mode_t>
+	static inline bool pack_astc_block_mode(uint32_t* pDst, const astc_block_desc* pBlock, mode_t uastc_mode)
 	{
 		assert(uastc_mode < TOTAL_UASTC_MODES);
 		uint8_t* pDst_bytes = reinterpret_cast<uint8_t*>(pDst);
@@ -11938,6 +12486,21 @@ namespace basist
 		astc_pack_bise(pDst, pBlock->m_endpoints, bit_pos, num_cem_pairs * 2, g_uastc_mode_endpoint_ranges[uastc_mode]);
 
 		// Write the weight bits in reverse bit order.
+		if ((total_weights * bits_per_weight) <= 64)
+		{
+			// Weight i's reversed bits end at bit 128-i*N, so the whole weight area is just the LSB first weight bitstream bit reversed.
+			uint64_t weight_bits = 0;
+			for (int i = 0; i < total_weights; i++)
+				weight_bits |= (uint64_t)pBlock->m_weights[i] << (i * bits_per_weight);
+
+			weight_bits = reverse_bits64(weight_bits);
+
+			for (uint32_t i = 0; i < 8; i++)
+				pDst_bytes[8 + i] |= (uint8_t)(weight_bits >> (i * 8));
+
+			return true;
+		}
+
 		switch (bits_per_weight)
 		{
 		case 1:
@@ -12020,6 +12583,11 @@ namespace basist
 		return true;
 	}
 
+	bool pack_astc_block(uint32_t* pDst, const astc_block_desc* pBlock, uint32_t uastc_mode)
+	{
+		return pack_astc_block_mode(pDst, pBlock, uastc_mode);
+	}
+
 	const uint8_t* get_anchor_indices(uint32_t subsets, uint32_t mode, uint32_t common_pattern, const uint8_t*& pPartition_pattern)
 	{
 		const uint8_t* pSubset_anchor_indices = g_zero_pattern;
@@ -12138,6 +12706,9 @@ namespace basist
 		return (w >> byte_bit_offset)& ((1U << codesize) - 1U);
 	}
 
+	template<typename mode_t>
+	static inline bool unpack_uastc_mode(const uastc_block& blk, mode_t mode, unpacked_uastc_block& unpacked, bool blue_contract_check, bool read_hints);
+
 	bool unpack_uastc(const uastc_block& blk, unpacked_uastc_block& unpacked, bool blue_contract_check, bool read_hints)
 	{
 		//memset(&unpacked, 0, sizeof(unpacked));
@@ -12169,6 +12740,12 @@ namespace basist
 		if (mode >= (int)TOTAL_UASTC_MODES)
 			return false;
 
+		return unpack_uastc_mode(blk, (uint32_t)mode, unpacked, blue_contract_check, read_hints);
+	}
+
+	template<typename mode_t>
+	static inline bool unpack_uastc_mode(const uastc_block& blk, mode_t mode, unpacked_uastc_block& unpacked, bool blue_contract_check, bool read_hints)
+	{
 		unpacked.m_mode = mode;
 
 		uint32_t bit_ofs = g_uastc_mode_huff_codes[mode][1];
@@ -12291,6 +12868,8 @@ namespace basist
 			total_planes = 2;
 			break;
 		default:
+			// Single plane. The encoder uses 0 for these too.
+			unpacked.m_astc.m_ccs = 0;
 			break;
 		}
 
@@ -12751,44 +13330,71 @@ namespace basist
 		return unpack_uastc(unpacked_blk, pPixels, srgb);
 	}
 
-	// Determines the best shared pbits to use to encode xl/xh
-	static void determine_shared_pbits(
-		uint32_t total_comps, uint32_t comp_bits, float xl[4], float xh[4],
-		color_quad_u8& bestMinColor, color_quad_u8& bestMaxColor, uint32_t best_pbits[2])
+	// The per-component parts of determine_shared_pbits() and determine_unique_pbits() only depend on the 8-bit input value and the p-bit,
+	// so they're computed once by uastc_init(). Each entry holds that component's squared error and its quantized value with the p-bit removed.
+	struct bc7_pbit_quant
 	{
-		const uint32_t total_bits = comp_bits + 1;
-		assert(total_bits >= 4 && total_bits <= 8);
+		float m_err;
+		uint8_t m_val;
+	};
 
+	static bc7_pbit_quant g_bc7_shared_pbit_quant[256][2]; // [v][p], 6-bit components
+	static bc7_pbit_quant g_bc7_unique_pbit_quant[2][256][2]; // [comp_bits == 7][v][p], 5 or 7-bit components
+
+	static inline uint32_t quantize_pbit_component(float x, uint32_t total_bits, int p, uint8_t& scaled)
+	{
 		const int iscalep = (1 << total_bits) - 1;
 		const float scalep = (float)iscalep;
 
-		float best_err = 1e+9f;
+		const uint8_t q = (uint8_t)(clampi(((int)((x * scalep - p) / 2.0f + .5f)) * 2 + p, p, iscalep - 1 + p));
 
-		for (int p = 0; p < 2; p++)
-		{
-			color_quad_u8 xMinColor, xMaxColor;
-			for (uint32_t c = 0; c < 4; c++)
-			{
-				xMinColor.m_c[c] = (uint8_t)(clampi(((int)((xl[c] * scalep - p) / 2.0f + .5f)) * 2 + p, p, iscalep - 1 + p));
-				xMaxColor.m_c[c] = (uint8_t)(clampi(((int)((xh[c] * scalep - p) / 2.0f + .5f)) * 2 + p, p, iscalep - 1 + p));
-			}
+		scaled = (uint8_t)(q << (8 - total_bits));
+		scaled |= (scaled >> total_bits);
+
+		return q;
+	}
 
-			color_quad_u8 scaledLow, scaledHigh;
+	static void init_bc7_pbit_quant_tables()
+	{
+		for (uint32_t v = 0; v < 256; v++)
+		{
+			const float x = v / 255.0f;
 
-			for (uint32_t i = 0; i < 4; i++)
+			for (int p = 0; p < 2; p++)
 			{
-				scaledLow.m_c[i] = (xMinColor.m_c[i] << (8 - total_bits));
-				scaledLow.m_c[i] |= (scaledLow.m_c[i] >> total_bits);
-				assert(scaledLow.m_c[i] <= 255);
+				uint8_t scaled;
+
+				// determine_shared_pbits() error metric
+				uint32_t q = quantize_pbit_component(x, 6 + 1, p, scaled);
+				g_bc7_shared_pbit_quant[v][p].m_err = basisu::squaref((scaled / 255.0f) - x);
+				g_bc7_shared_pbit_quant[v][p].m_val = (uint8_t)(q >> 1);
 
-				scaledHigh.m_c[i] = (xMaxColor.m_c[i] << (8 - total_bits));
-				scaledHigh.m_c[i] |= (scaledHigh.m_c[i] >> total_bits);
-				assert(scaledHigh.m_c[i] <= 255);
+				// determine_unique_pbits() error metric
+				for (uint32_t i = 0; i < 2; i++)
+				{
+					q = quantize_pbit_component(x, (i ? 7 : 5) + 1, p, scaled);
+					g_bc7_unique_pbit_quant[i][v][p].m_err = basisu::squaref(scaled - x * 255.0f);
+					g_bc7_unique_pbit_quant[i][v][p].m_val = (uint8_t)(q >> 1);
+				}
 			}
+		}
+	}
+
+	// Determines the best shared pbits to use to encode l/h
+	static void determine_shared_pbits(
+		uint32_t total_comps, uint32_t comp_bits, const uint8_t l[4], const uint8_t h[4],
+		color_quad_u8& bestMinColor, color_quad_u8& bestMaxColor, uint32_t best_pbits[2])
+	{
+		assert(comp_bits == 6);
+		BASISU_NOTE_UNUSED(comp_bits);
+
+		float best_err = 1e+9f;
 
+		for (int p = 0; p < 2; p++)
+		{
 			float err = 0;
 			for (uint32_t i = 0; i < total_comps; i++)
-				err += basisu::squaref((scaledLow.m_c[i] / 255.0f) - xl[i]) + basisu::squaref((scaledHigh.m_c[i] / 255.0f) - xh[i]);
+				err += g_bc7_shared_pbit_quant[l[i]][p].m_err + g_bc7_shared_pbit_quant[h[i]][p].m_err;
 
 			if (err < best_err)
 			{
@@ -12797,52 +13403,31 @@ namespace basist
 				best_pbits[1] = p;
 				for (uint32_t j = 0; j < 4; j++)
 				{
-					bestMinColor.m_c[j] = xMinColor.m_c[j] >> 1;
-					bestMaxColor.m_c[j] = xMaxColor.m_c[j] >> 1;
+					bestMinColor.m_c[j] = g_bc7_shared_pbit_quant[l[j]][p].m_val;
+					bestMaxColor.m_c[j] = g_bc7_shared_pbit_quant[h[j]][p].m_val;
 				}
 			}
 		}
 	}
 
-	// Determines the best unique pbits to use to encode xl/xh
+	// Determines the best unique pbits to use to encode l/h
 	static void determine_unique_pbits(
-		uint32_t total_comps, uint32_t comp_bits, float xl[4], float xh[4],
+		uint32_t total_comps, uint32_t comp_bits, const uint8_t l[4], const uint8_t h[4],
 		color_quad_u8& bestMinColor, color_quad_u8& bestMaxColor, uint32_t best_pbits[2])
 	{
-		const uint32_t total_bits = comp_bits + 1;
-		const int iscalep = (1 << total_bits) - 1;
-		const float scalep = (float)iscalep;
+		assert((comp_bits == 5) || (comp_bits == 7));
+		const bc7_pbit_quant (*pQuant)[2] = g_bc7_unique_pbit_quant[comp_bits == 7];
 
 		float best_err0 = 1e+9f;
 		float best_err1 = 1e+9f;
 
 		for (int p = 0; p < 2; p++)
 		{
-			color_quad_u8 xMinColor, xMaxColor;
-
-			for (uint32_t c = 0; c < 4; c++)
-			{
-				xMinColor.m_c[c] = (uint8_t)(clampi(((int)((xl[c] * scalep - p) / 2.0f + .5f)) * 2 + p, p, iscalep - 1 + p));
-				xMaxColor.m_c[c] = (uint8_t)(clampi(((int)((xh[c] * scalep - p) / 2.0f + .5f)) * 2 + p, p, iscalep - 1 + p));
-			}
-
-			color_quad_u8 scaledLow, scaledHigh;
-			for (uint32_t i = 0; i < 4; i++)
-			{
-				scaledLow.m_c[i] = (xMinColor.m_c[i] << (8 - total_bits));
-				scaledLow.m_c[i] |= (scaledLow.m_c[i] >> total_bits);
-				assert(scaledLow.m_c[i] <= 255);
-
-				scaledHigh.m_c[i] = (xMaxColor.m_c[i] << (8 - total_bits));
-				scaledHigh.m_c[i] |= (scaledHigh.m_c[i] >> total_bits);
-				assert(scaledHigh.m_c[i] <= 255);
-			}
-
 			float err0 = 0, err1 = 0;
 			for (uint32_t i = 0; i < total_comps; i++)
 			{
-				err0 += basisu::squaref(scaledLow.m_c[i] - xl[i] * 255.0f);
-				err1 += basisu::squaref(scaledHigh.m_c[i] - xh[i] * 255.0f);
+				err0 += pQuant[l[i]][p].m_err;
+				err1 += pQuant[h[i]][p].m_err;
 			}
 
 			if (err0 < best_err0)
@@ -12850,10 +13435,10 @@ namespace basist
 				best_err0 = err0;
 				best_pbits[0] = p;
 
-				bestMinColor.m_c[0] = xMinColor.m_c[0] >> 1;
-				bestMinColor.m_c[1] = xMinColor.m_c[1] >> 1;
-				bestMinColor.m_c[2] = xMinColor.m_c[2] >> 1;
-				bestMinColor.m_c[3] = xMinColor.m_c[3] >> 1;
+				bestMinColor.m_c[0] = pQuant[l[0]][p].m_val;
+				bestMinColor.m_c[1] = pQuant[l[1]][p].m_val;
+				bestMinColor.m_c[2] = pQuant[l[2]][p].m_val;
+				bestMinColor.m_c[3] = pQuant[l[3]][p].m_val;
 			}
 
 			if (err1 < best_err1)
@@ -12861,10 +13446,10 @@ namespace basist
 				best_err1 = err1;
 				best_pbits[1] = p;
 
-				bestMaxColor.m_c[0] = xMaxColor.m_c[0] >> 1;
-				bestMaxColor.m_c[1] = xMaxColor.m_c[1] >> 1;
-				bestMaxColor.m_c[2] = xMaxColor.m_c[2] >> 1;
-				bestMaxColor.m_c[3] = xMaxColor.m_c[3] >> 1;
+				bestMaxColor.m_c[0] = pQuant[h[0]][p].m_val;
+				bestMaxColor.m_c[1] = pQuant[h[1]][p].m_val;
+				bestMaxColor.m_c[2] = pQuant[h[2]][p].m_val;
+				bestMaxColor.m_c[3] = pQuant[h[3]][p].m_val;
 			}
 		}
 	}
@@ -12889,12 +13474,11 @@ namespace basist
 		return success;
 	}
 
-	bool transcode_uastc_to_bc7(const unpacked_uastc_block& unpacked_src_blk, bc7_optimization_results& dst_blk)
+	template<typename mode_t>
+	static inline bool transcode_uastc_to_bc7_mode(const unpacked_uastc_block& unpacked_src_blk, mode_t mode, bc7_optimization_results& dst_blk)
 	{
 		memset(&dst_blk, 0, sizeof(dst_blk));
 
-		const uint32_t mode = unpacked_src_blk.m_mode;
-
 		const uint32_t endpoint_range = g_uastc_mode_endpoint_ranges[mode];
 		const uint32_t total_comps = g_uastc_mode_comps[mode];
 
@@ -12917,11 +13501,11 @@ namespace basist
 			// MODE 15: DualPlane: 0, WeightRange : 8 (16), Subsets : 1, CEM : 4 (LA Direct), EndpointRange : 20 (256) - BC7 MODE6
 			dst_blk.m_mode = 6;
 
-			float xl[4], xh[4];
+			uint8_t xl[4], xh[4];
 			if (total_comps == 2)
 			{
-				xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0]].m_unquant / 255.0f;
-				xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1]].m_unquant / 255.0f;
+				xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0]].m_unquant;
+				xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1]].m_unquant;
 
 				xl[1] = xl[0];
 				xh[1] = xh[0];
@@ -12929,28 +13513,28 @@ namespace basist
 				xl[2] = xl[0];
 				xh[2] = xh[0];
 
-				xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2]].m_unquant / 255.0f;
-				xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3]].m_unquant / 255.0f;
+				xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2]].m_unquant;
+				xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3]].m_unquant;
 			}
 			else
 			{
-				xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0]].m_unquant / 255.0f;
-				xl[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2]].m_unquant / 255.0f;
-				xl[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[4]].m_unquant / 255.0f;
+				xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0]].m_unquant;
+				xl[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2]].m_unquant;
+				xl[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[4]].m_unquant;
 
-				xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1]].m_unquant / 255.0f;
-				xh[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3]].m_unquant / 255.0f;
-				xh[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[5]].m_unquant / 255.0f;
+				xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1]].m_unquant;
+				xh[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3]].m_unquant;
+				xh[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[5]].m_unquant;
 
 				if (total_comps == 4)
 				{
-					xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[6]].m_unquant / 255.0f;
-					xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[7]].m_unquant / 255.0f;
+					xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[6]].m_unquant;
+					xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[7]].m_unquant;
 				}
 				else
 				{
-					xl[3] = 1.0f;
-					xh[3] = 1.0f;
+					xl[3] = 255;
+					xh[3] = 255;
 				}
 			}
 
@@ -13002,16 +13586,16 @@ namespace basist
 			// Mode 1 uses endpoint range 20 - no need to use ASTC dequant tables.
 			dst_blk.m_mode = 3;
 
-			float xl[4], xh[4];
-			xl[0] = unpacked_src_blk.m_astc.m_endpoints[0] / 255.0f;
-			xl[1] = unpacked_src_blk.m_astc.m_endpoints[2] / 255.0f;
-			xl[2] = unpacked_src_blk.m_astc.m_endpoints[4] / 255.0f;
-			xl[3] = 1.0f;
+			uint8_t xl[4], xh[4];
+			xl[0] = unpacked_src_blk.m_astc.m_endpoints[0];
+			xl[1] = unpacked_src_blk.m_astc.m_endpoints[2];
+			xl[2] = unpacked_src_blk.m_astc.m_endpoints[4];
+			xl[3] = 255;
 
-			xh[0] = unpacked_src_blk.m_astc.m_endpoints[1] / 255.0f;
-			xh[1] = unpacked_src_blk.m_astc.m_endpoints[3] / 255.0f;
-			xh[2] = unpacked_src_blk.m_astc.m_endpoints[5] / 255.0f;
-			xh[3] = 1.0f;
+			xh[0] = unpacked_src_blk.m_astc.m_endpoints[1];
+			xh[1] = unpacked_src_blk.m_astc.m_endpoints[3];
+			xh[2] = unpacked_src_blk.m_astc.m_endpoints[5];
+			xh[3] = 255;
 
 			uint32_t best_pbits[2];
 			color_quad_u8 bestMinColor, bestMaxColor;
@@ -13044,21 +13628,19 @@ namespace basist
 
 			const bool invert_partition = g_astc_bc7_common_partitions2[unpacked_src_blk.m_common_pattern].m_invert;
 
-			float xl[4], xh[4];
-			xl[3] = 1.0f;
-			xh[3] = 1.0f;
+			uint8_t xl[4], xh[4];
+			xl[3] = 255;
+			xh[3] = 255;
 
 			for (uint32_t subset = 0; subset < 2; subset++)
 			{
 				for (uint32_t i = 0; i < 3; i++)
 				{
 					uint32_t v = unpacked_src_blk.m_astc.m_endpoints[i * 2 + subset * 6];
-					v = (v << 4) | v;
-					xl[i] = v / 255.0f;
+					xl[i] = (uint8_t)((v << 4) | v);
 
 					v = unpacked_src_blk.m_astc.m_endpoints[i * 2 + subset * 6 + 1];
-					v = (v << 4) | v;
-					xh[i] = v / 255.0f;
+					xh[i] = (uint8_t)((v << 4) | v);
 				}
 
 				uint32_t best_pbits[2] = { 0, 0 };
@@ -13122,16 +13704,16 @@ namespace basist
 
 			const bool invert_partition = g_astc_bc7_common_partitions2[unpacked_src_blk.m_common_pattern].m_invert;
 
-			float xl[4], xh[4];
-			xl[3] = 1.0f;
-			xh[3] = 1.0f;
+			uint8_t xl[4], xh[4];
+			xl[3] = 255;
+			xh[3] = 255;
 
 			for (uint32_t subset = 0; subset < 2; subset++)
 			{
 				for (uint32_t i = 0; i < 3; i++)
 				{
-					xl[i] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[i * 2 + subset * 6]].m_unquant / 255.0f;
-					xh[i] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[i * 2 + subset * 6 + 1]].m_unquant / 255.0f;
+					xl[i] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[i * 2 + subset * 6]].m_unquant;
+					xh[i] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[i * 2 + subset * 6 + 1]].m_unquant;
 				}
 
 				uint32_t best_pbits[2] = { 0, 0 };
@@ -13324,12 +13906,12 @@ namespace basist
 
 			for (uint32_t astc_subset = 0; astc_subset < 2; astc_subset++)
 			{
-				float xl[4], xh[4];
+				uint8_t xl[4], xh[4];
 
 				if (total_comps == 2)
 				{
-					xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0 + astc_subset * 4]].m_unquant / 255.0f;
-					xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1 + astc_subset * 4]].m_unquant / 255.0f;
+					xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0 + astc_subset * 4]].m_unquant;
+					xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1 + astc_subset * 4]].m_unquant;
 
 					xl[1] = xl[0];
 					xh[1] = xh[0];
@@ -13337,20 +13919,20 @@ namespace basist
 					xl[2] = xl[0];
 					xh[2] = xh[0];
 
-					xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2 + astc_subset * 4]].m_unquant / 255.0f;
-					xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3 + astc_subset * 4]].m_unquant / 255.0f;
+					xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2 + astc_subset * 4]].m_unquant;
+					xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3 + astc_subset * 4]].m_unquant;
 				}
 				else
 				{
-					xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0 + astc_subset * 8]].m_unquant / 255.0f;
-					xl[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2 + astc_subset * 8]].m_unquant / 255.0f;
-					xl[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[4 + astc_subset * 8]].m_unquant / 255.0f;
-					xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[6 + astc_subset * 8]].m_unquant / 255.0f;
-
-					xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1 + astc_subset * 8]].m_unquant / 255.0f;
-					xh[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3 + astc_subset * 8]].m_unquant / 255.0f;
-					xh[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[5 + astc_subset * 8]].m_unquant / 255.0f;
-					xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[7 + astc_subset * 8]].m_unquant / 255.0f;
+					xl[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[0 + astc_subset * 8]].m_unquant;
+					xl[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[2 + astc_subset * 8]].m_unquant;
+					xl[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[4 + astc_subset * 8]].m_unquant;
+					xl[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[6 + astc_subset * 8]].m_unquant;
+
+					xh[0] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[1 + astc_subset * 8]].m_unquant;
+					xh[1] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[3 + astc_subset * 8]].m_unquant;
+					xh[2] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[5 + astc_subset * 8]].m_unquant;
+					xh[3] = g_astc_unquant[endpoint_range][unpacked_src_blk.m_astc.m_endpoints[7 + astc_subset * 8]].m_unquant;
 				}
 
 				uint32_t best_pbits[2] = { 0, 0 };
@@ -13380,6 +13962,11 @@ namespace basist
 		return true;
 	}
 
+	bool transcode_uastc_to_bc7(const unpacked_uastc_block& unpacked_src_blk, bc7_optimization_results& dst_blk)
+	{
+		return transcode_uastc_to_bc7_mode(unpacked_src_blk, (uint32_t)unpacked_src_blk.m_mode, dst_blk);
+	}
+
 	bool transcode_uastc_to_bc7(const uastc_block& src_blk, bc7_optimization_results& dst_blk)
 	{
 		unpacked_uastc_block unpacked_src_blk;
@@ -13399,6 +13986,146 @@ namespace basist
 		return true;
 	}
 
+	// Per-mode batch kernels. Each one transcodes the blocks listed in pBlock_indices, which must all use UASTC mode MODE.
+	typedef bool (*transcode_uastc_blocks_func)(const uastc_block* pSrc_blocks, const uint8_t* pBlock_indices, uint32_t num_blocks, uint8_t* pDst_blocks, uint32_t output_block_stride_in_bytes);
+
+	template<uint32_t MODE>
+	static bool transcode_uastc_blocks_to_astc(const uastc_block* pSrc_blocks, const uint8_t* pBlock_indices, uint32_t num_blocks, uint8_t* pDst_blocks, uint32_t output_block_stride_in_bytes)
+	{
+		const uint32_constant<MODE> mode = uint32_constant<MODE>();
+
+		for (uint32_t i = 0; i < num_blocks; i++)
+		{
+			const uint32_t block_index = pBlock_indices[i];
+
+			unpacked_uastc_block unpacked_src_blk;
+			if (!unpack_uastc_mode(pSrc_blocks[block_index], mode, unpacked_src_blk, true, false))
+				return false;
+
+			if (!pack_astc_block_mode(reinterpret_cast<uint32_t*>(pDst_blocks + block_index * output_block_stride_in_bytes), &unpacked_src_blk.m_astc, mode))
+				return false;
+		}
+
+		return true;
+	}
+
+	// The BC7 mode each UASTC mode transcodes to. Solid color blocks pick BC7 mode 5 or 6 per block, so their entry is unused.
+	static constexpr uint8_t g_uastc_mode_bc7_modes[TOTAL_UASTC_MODES] = { 6, 3, 1, 2, 3, 6, 5, 2, 0, 7, 6, 5, 6, 5, 6, 6, 7, 5, 6 };
+
+	template<uint32_t MODE>
+	static bool transcode_uastc_blocks_to_bc7(const uastc_block* pSrc_blocks, const uint8_t* pBlock_indices, uint32_t num_blocks, uint8_t* pDst_blocks, uint32_t output_block_stride_in_bytes)
+	{
+		const uint32_constant<MODE> mode = uint32_constant<MODE>();
+
+		for (uint32_t i = 0; i < num_blocks; i++)
+		{
+			const uint32_t block_index = pBlock_indices[i];
+
+			unpacked_uastc_block unpacked_src_blk;
+			if (!unpack_uastc_mode(pSrc_blocks[block_index], mode, unpacked_src_blk, false, false))
+				return false;
+
+			bc7_optimization_results temp;
+			if (!transcode_uastc_to_bc7_mode(unpacked_src_blk, mode, temp))
+				return false;
+
+			encode_bc7_block_mode(pDst_blocks + block_index * output_block_stride_in_bytes, &temp, uint32_constant<g_uastc_mode_bc7_modes[MODE]>());
+		}
+
+		return true;
+	}
+
+	// Solid color blocks have nothing to specialize, so they go through the per-block functions.
+	static bool transcode_uastc_solid_blocks_to_astc(const uastc_block* pSrc_blocks, const uint8_t* pBlock_indices, uint32_t num_blocks, uint8_t* pDst_blocks, uint32_t output_block_stride_in_bytes)
+	{
+		for (uint32_t i = 0; i < num_blocks; i++)
+			if (!transcode_uastc_to_astc(pSrc_blocks[pBlock_indices[i]], pDst_blocks + pBlock_indices[i] * output_block_stride_in_bytes))
+				return false;
+
+		return true;
+	}
+
+	static bool transcode_uastc_solid_blocks_to_bc7(const uastc_block* pSrc_blocks, const uint8_t* pBlock_indices, uint32_t num_blocks, uint8_t* pDst_blocks, uint32_t output_block_stride_in_bytes)
+	{
+		for (uint32_t i = 0; i < num_blocks; i++)
+			if (!transcode_uastc_to_bc7(pSrc_blocks[pBlock_indices[i]], pDst_blocks + pBlock_indices[i] * output_block_stride_in_bytes))
+				return false;
+
+		return true;
+	}
+
+	static_assert(UASTC_MODE_INDEX_SOLID_COLOR == 8, "BASISD_UASTC_MODE_KERNELS expects solid color blocks to use mode 8");
+
+#define BASISD_UASTC_MODE_KERNELS(kernel, solid_kernel) { \
+		&kernel<0>, &kernel<1>, &kernel<2>, &kernel<3>, &kernel<4>, &kernel<5>, &kernel<6>, &kernel<7>, &solid_kernel, &kernel<9>, \
+		&kernel<10>, &kernel<11>, &kernel<12>, &kernel<13>, &kernel<14>, &kernel<15>, &kernel<16>, &kernel<17>, &kernel<18> }
+
+	static const transcode_uastc_blocks_func g_transcode_uastc_blocks_to_astc_kernels[TOTAL_UASTC_MODES] = BASISD_UASTC_MODE_KERNELS(transcode_uastc_blocks_to_astc, transcode_uastc_solid_blocks_to_astc);
+	static const transcode_uastc_blocks_func g_transcode_uastc_blocks_to_bc7_kernels[TOTAL_UASTC_MODES] = BASISD_UASTC_MODE_KERNELS(transcode_uastc_blocks_to_bc7, transcode_uastc_solid_blocks_to_bc7);
+
+#undef BASISD_UASTC_MODE_KERNELS
+
+	// Max. number of blocks transcode_uastc_blocks() sorts by mode at once. Keeps the block indices in a byte and the source blocks in L1.
+	const uint32_t UASTC_BLOCK_BATCH_SIZE = 256;
+
+	static bool transcode_uastc_blocks(const uastc_block* pSrc_blocks, void* pDst_blocks, uint32_t num_blocks, uint32_t output_block_stride_in_bytes, const transcode_uastc_blocks_func* pKernels)
+	{
+		uint8_t block_modes[UASTC_BLOCK_BATCH_SIZE];
+		uint8_t block_indices[UASTC_BLOCK_BATCH_SIZE];
+
+		for (uint32_t first_block = 0; first_block < num_blocks; first_block += UASTC_BLOCK_BATCH_SIZE)
+		{
+			const uint32_t total_blocks = basisu::minimum(UASTC_BLOCK_BATCH_SIZE, num_blocks - first_block);
+			const uastc_block* pSrc = pSrc_blocks + first_block;
+			uint8_t* pDst = static_cast<uint8_t*>(pDst_blocks) + first_block * output_block_stride_in_bytes;
+
+			// Decode each block's mode, then counting sort the blocks by mode. Within a mode the blocks stay in memory order.
+			uint32_t mode_offsets[TOTAL_UASTC_MODES + 1];
+			memset(mode_offsets, 0, sizeof(mode_offsets));
+
+			for (uint32_t i = 0; i < total_blocks; i++)
+			{
+				const uint32_t mode = g_uastc_huff_modes[pSrc[i].m_bytes[0] & 127];
+				if (mode >= TOTAL_UASTC_MODES)
+					return false;
+
+				block_modes[i] = (uint8_t)mode;
+				mode_offsets[mode + 1]++;
+			}
+
+			for (uint32_t mode = 0; mode < TOTAL_UASTC_MODES; mode++)
+				mode_offsets[mode + 1] += mode_offsets[mode];
+
+			uint32_t mode_next[TOTAL_UASTC_MODES];
+			memcpy(mode_next, mode_offsets, sizeof(mode_next));
+
+			for (uint32_t i = 0; i < total_blocks; i++)
+				block_indices[mode_next[block_modes[i]]++] = (uint8_t)i;
+
+			for (uint32_t mode = 0; mode < TOTAL_UASTC_MODES; mode++)
+			{
+				const uint32_t mode_total_blocks = mode_offsets[mode + 1] - mode_offsets[mode];
+				if (!mode_total_blocks)
+					continue;
+
+				if (!pKernels[mode](pSrc, &block_indices[mode_offsets[mode]], mode_total_blocks, pDst, output_block_stride_in_bytes))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool transcode_uastc_to_astc(const uastc_block* pSrc_blocks, void* pDst_blocks, uint32_t num_blocks, uint32_t output_block_stride_in_bytes)
+	{
+		return transcode_uastc_blocks(pSrc_blocks, pDst_blocks, num_blocks, output_block_stride_in_bytes, g_transcode_uastc_blocks_to_astc_kernels);
+	}
+
+	bool transcode_uastc_to_bc7(const uastc_block* pSrc_blocks, void* pDst_blocks, uint32_t num_blocks, uint32_t output_block_stride_in_bytes)
+	{
+		return transcode_uastc_blocks(pSrc_blocks, pDst_blocks, num_blocks, output_block_stride_in_bytes, g_transcode_uastc_blocks_to_bc7_kernels);
+	}
+
 	color32 apply_etc1_bias(const color32 &block_color, uint32_t bias, uint32_t limit, uint32_t subblock)
 	{
 		color32 result;
@@ -16588,10 +17315,116 @@ namespace basist
 			g_bc7_mode_5_optimal_endpoints[c] = best;
 
 		} // c
+
+		init_bc7_pbit_quant_tables();
 	}
 
 #endif // #if BASISD_SUPPORT_UASTC
 
+#if BASISD_WRITE_NEW_INIT_TABLES || BASISD_USE_BAKED_INIT_TABLES
+	// Every table filled in by basisu_transcoder_init(), in the order they appear in basisu_transcoder_tables_init.inc.
+	// X is invoked with the name of each table.
+#if BASISD_SUPPORT_DXT1 || BASISD_SUPPORT_UASTC
+	#define BASISD_INIT_TABLES_BC1(X) X(g_bc1_match5_equals_1) X(g_bc1_match5_equals_0) X(g_bc1_match6_equals_1) X(g_bc1_match6_equals_0)
+#else
+	#define BASISD_INIT_TABLES_BC1(X)
+#endif
+#if BASISD_SUPPORT_DXT1
+	#define BASISD_INIT_TABLES_DXT1(X) X(g_etc1_to_dxt1_selector_range_index) X(g_etc1_to_dxt1_selector_mappings_raw_dxt1_256) X(g_etc1_to_dxt1_selector_mappings_raw_dxt1_inv_256)
+#else
+	#define BASISD_INIT_TABLES_DXT1(X)
+#endif
+#if BASISD_SUPPORT_ASTC
+	#define BASISD_INIT_TABLES_ASTC(X) X(g_etc1_to_astc_best_grayscale_mapping) X(g_etc1_to_astc_selector_range_index) X(g_ise_to_unquant) X(g_astc_single_color_encoding_0) X(g_astc_single_color_encoding_1)
+#else
+	#define BASISD_INIT_TABLES_ASTC(X)
+#endif
+#if BASISD_SUPPORT_ASTC && BASISD_SUPPORT_ASTC_HIGHER_OPAQUE_QUALITY
+	#define BASISD_INIT_TABLES_ASTC_0_255(X) X(g_etc1_to_astc_best_grayscale_mapping_0_255) X(g_etc1_to_astc_selector_mappings_256)
+#else
+	#define BASISD_INIT_TABLES_ASTC_0_255(X)
+#endif
+#if BASISD_SUPPORT_BC7_MODE5
+	#define BASISD_INIT_TABLES_BC7_MODE5(X) X(g_etc1_to_bc7_m5_selector_range_index) X(g_etc1_to_bc7_m5a_selector_range_index) X(g_etc1_to_bc7_m5_selector_mappings_256)
+#else
+	#define BASISD_INIT_TABLES_BC7_MODE5(X)
+#endif
+#if BASISD_SUPPORT_ATC
+	#define BASISD_INIT_TABLES_ATC(X) X(g_pvrtc2_match45_equals_1) X(g_atc_match55_equals_1) X(g_atc_match56_equals_1) X(g_pvrtc2_match4) X(g_atc_match5) X(g_atc_match6) X(g_etc1s_to_atc_selector_range_index)
+#else
+	#define BASISD_INIT_TABLES_ATC(X)
+#endif
+#if BASISD_SUPPORT_PVRTC2
+	#define BASISD_INIT_TABLES_PVRTC2(X) X(g_pvrtc2_trans_match34) X(g_pvrtc2_trans_match44) X(g_pvrtc2_alpha_match33) X(g_pvrtc2_alpha_match33_0) X(g_pvrtc2_alpha_match33_3)
+#else
+	#define BASISD_INIT_TABLES_PVRTC2(X)
+#endif
+#if BASISD_SUPPORT_UASTC
+	#define BASISD_INIT_TABLES_UASTC(X) X(g_astc_unquant) X(g_bc7_mode_6_optimal_endpoints) X(g_bc7_mode_5_optimal_endpoints) X(g_bc7_shared_pbit_quant) X(g_bc7_unique_pbit_quant)
+#else
+	#define BASISD_INIT_TABLES_UASTC(X)
+#endif
+
+#define BASISD_INIT_TABLES(X) \
+	BASISD_INIT_TABLES_BC1(X) BASISD_INIT_TABLES_DXT1(X) BASISD_INIT_TABLES_ASTC(X) BASISD_INIT_TABLES_ASTC_0_255(X) \
+	BASISD_INIT_TABLES_BC7_MODE5(X) BASISD_INIT_TABLES_ATC(X) BASISD_INIT_TABLES_PVRTC2(X) BASISD_INIT_TABLES_UASTC(X)
+#endif
+
+#if BASISD_WRITE_NEW_INIT_TABLES
+	static void write_init_table(FILE* pFile, const char* pName, const void* pTable, size_t size)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pTable);
+
+		fprintf(pFile, "BASISD_BAKED_TABLE(%s, %u,", pName, (uint32_t)size);
+		for (size_t i = 0; i < size; i++)
+			fprintf(pFile, "%s%u,", ((i & 31) == 0) ? "\n" : "", pBytes[i]);
+		fprintf(pFile, "\n)\n");
+	}
+
+	bool basisu_transcoder_write_init_tables(const char* pFilename)
+	{
+		if (!g_transcoder_initialized)
+			basisu_transcoder_init();
+
+		FILE* pFile = fopen(pFilename, "w");
+		if (!pFile)
+			return false;
+
+		fprintf(pFile, "// Generated by basisu_transcoder_write_init_tables(). Do not edit.\n");
+
+#define BASISD_WRITE_INIT_TABLE(t) write_init_table(pFile, #t, &t, sizeof(t));
+		BASISD_INIT_TABLES(BASISD_WRITE_INIT_TABLE)
+#undef BASISD_WRITE_INIT_TABLE
+
+		const bool failed = ferror(pFile) != 0;
+		return (fclose(pFile) == 0) && !failed;
+	}
+#endif // #if BASISD_WRITE_NEW_INIT_TABLES
+
+#if BASISD_USE_BAKED_INIT_TABLES
+	static void transcoder_init_baked_tables()
+	{
+		// The static_assert catches an .inc generated by a build with different BASISD_SUPPORT_* settings or table layouts.
+#define BASISD_BAKED_TABLE(t, size, ...) \
+		{ \
+			static const uint8_t s_baked[] = { __VA_ARGS__ }; \
+			static_assert((sizeof(s_baked) == (size)) && (sizeof(t) == (size)), "basisu_transcoder_tables_init.inc does not match this build: " #t); \
+			memcpy(&t, s_baked, sizeof(t)); \
+		}
+#include "basisu_transcoder_tables_init.inc"
+#undef BASISD_BAKED_TABLE
+
+		// And catch one that is missing some of the tables this build computes.
+#define BASISD_BAKED_TABLE(t, size, ...) + 1
+#define BASISD_COUNT_INIT_TABLE(t) + 1
+		static_assert((0
+#include "basisu_transcoder_tables_init.inc"
+			) == (0 BASISD_INIT_TABLES(BASISD_COUNT_INIT_TABLE)), "basisu_transcoder_tables_init.inc does not match this build");
+#undef BASISD_COUNT_INIT_TABLE
+#undef BASISD_BAKED_TABLE
+	}
+#endif // #if BASISD_USE_BAKED_INIT_TABLES
+
 // ------------------------------------------------------------------------------------------------------ 
 // KTX2
 // ------------------------------------------------------------------------------------------------------ 
@@ -540,6 +540,11 @@ namespace basist
 
 	// basisu_transcoder_init() MUST be called before a .basis file can be transcoded.
 	void basisu_transcoder_init();
+
+#if BASISD_WRITE_NEW_INIT_TABLES
+	// Writes the tables computed by basisu_transcoder_init() to pFilename, for compiling in with BASISD_USE_BAKED_INIT_TABLES.
+	bool basisu_transcoder_write_init_tables(const char* pFilename);
+#endif
 		
 	enum debug_flags_t
 	{
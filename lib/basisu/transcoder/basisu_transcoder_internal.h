@@ -122,9 +122,12 @@ namespace basist
 			basisu::clear_vector(m_code_sizes);
 			basisu::clear_vector(m_lookup);
 			basisu::clear_vector(m_tree);
+			m_fast_lookup_bits = 0;
 		}
 
-		bool init(uint32_t total_syms, const uint8_t *pCode_sizes, uint32_t fast_lookup_bits = basisu::cHuffmanFastLookupBits)
+		// The fast lookup table covers the longest code, up to max_fast_lookup_bits, so most tables decode every symbol with one lookup
+		// and small tables don't pay for a big lookup.
+		bool init(uint32_t total_syms, const uint8_t *pCode_sizes, uint32_t max_fast_lookup_bits = basisu::cHuffmanFastLookupBits)
 		{
 			if (!total_syms)
 			{
@@ -135,6 +138,13 @@ namespace basist
 			m_code_sizes.resize(total_syms);
 			memcpy(&m_code_sizes[0], pCode_sizes, total_syms);
 
+			uint32_t max_code_size = 0;
+			for (uint32_t i = 0; i < total_syms; i++)
+				max_code_size = basisu::maximum<uint32_t>(max_code_size, pCode_sizes[i]);
+
+			const uint32_t fast_lookup_bits = basisu::clamp<uint32_t>(max_code_size, 1, max_fast_lookup_bits);
+			m_fast_lookup_bits = fast_lookup_bits;
+
 			const uint32_t huffman_fast_lookup_size = 1 << fast_lookup_bits;
 
 			m_lookup.resize(0);
@@ -266,6 +276,7 @@ namespace basist
 		const basisu::uint8_vec &get_code_sizes() const { return m_code_sizes; }
 		const basisu::int_vec get_lookup() const { return m_lookup; }
 		const basisu::int16_vec get_tree() const { return m_tree; }
+		uint32_t get_fast_lookup_bits() const { return m_fast_lookup_bits; }
 
 		bool is_valid() const { return m_code_sizes.size() > 0; }
 
@@ -273,6 +284,7 @@ namespace basist
 		basisu::uint8_vec m_code_sizes;
 		basisu::int_vec m_lookup;
 		basisu::int16_vec m_tree;
+		uint32_t m_fast_lookup_bits = 0;
 	};
 
 	class bitwise_decoder
@@ -316,25 +328,48 @@ namespace basist
 		{
 		}
 
-		inline uint32_t peek_bits(uint32_t num_bits)
+		// Makes sure at least num_bits are buffered. Away from the end of the buffer this loads a whole 64-bit word and keeps as many of
+		// its bytes as fit, with no per byte loop. Bits above m_bit_buf_size are then the stream's next bits, not zero, so ORing the same
+		// bytes in again later is harmless. The last 7 bytes are read one at a time, then zeros past the end.
+		inline void fill_bit_buf(uint32_t num_bits)
 		{
-			if (!num_bits)
-				return 0;
+			assert(num_bits <= 56);
 
-			assert(num_bits <= 25);
+			if (m_bit_buf_size >= num_bits)
+				return;
+
+			if (m_pBuf_end - m_pBuf >= 8)
+			{
+				const uint64_t word = (uint64_t)m_pBuf[0] | ((uint64_t)m_pBuf[1] << 8U) | ((uint64_t)m_pBuf[2] << 16U) | ((uint64_t)m_pBuf[3] << 24U) |
+					((uint64_t)m_pBuf[4] << 32U) | ((uint64_t)m_pBuf[5] << 40U) | ((uint64_t)m_pBuf[6] << 48U) | ((uint64_t)m_pBuf[7] << 56U);
+
+				m_bit_buf |= word << m_bit_buf_size;
+				m_pBuf += (63 - m_bit_buf_size) >> 3;
+				m_bit_buf_size |= 56;
+				return;
+			}
 
 			while (m_bit_buf_size < num_bits)
 			{
-				uint32_t c = 0;
+				uint64_t c = 0;
 				if (m_pBuf < m_pBuf_end)
 					c = *m_pBuf++;
 
 				m_bit_buf |= (c << m_bit_buf_size);
 				m_bit_buf_size += 8;
-				assert(m_bit_buf_size <= 32);
 			}
+		}
+
+		inline uint32_t peek_bits(uint32_t num_bits)
+		{
+			if (!num_bits)
+				return 0;
+
+			assert(num_bits <= 32);
 
-			return m_bit_buf & ((1 << num_bits) - 1);
+			fill_bit_buf(num_bits);
+
+			return (uint32_t)(m_bit_buf & ((1ULL << num_bits) - 1));
 		}
 
 		void remove_bits(uint32_t num_bits)
@@ -347,21 +382,7 @@ namespace basist
 
 		uint32_t get_bits(uint32_t num_bits)
 		{
-			if (num_bits > 25)
-			{
-				assert(num_bits <= 32);
-
-				const uint32_t bits0 = peek_bits(25);
-				m_bit_buf >>= 25;
-				m_bit_buf_size -= 25;
-				num_bits -= 25;
-
-				const uint32_t bits = peek_bits(num_bits);
-				m_bit_buf >>= num_bits;
-				m_bit_buf_size -= num_bits;
-
-				return bits0 | (bits << 25);
-			}
+			assert(num_bits <= 32);
 
 			const uint32_t bits = peek_bits(num_bits);
 
@@ -442,27 +463,19 @@ namespace basist
 			return v;
 		}
 
-		inline uint32_t decode_huffman(const huffman_decoding_table &ct, int fast_lookup_bits = basisu::cHuffmanFastLookupBits)
+		inline uint32_t decode_huffman(const huffman_decoding_table &ct)
 		{
 			assert(ct.m_code_sizes.size());
 
+			const int fast_lookup_bits = ct.m_fast_lookup_bits;
 			const uint32_t huffman_fast_lookup_size = 1 << fast_lookup_bits;
 						
-			while (m_bit_buf_size < 16)
-			{
-				uint32_t c = 0;
-				if (m_pBuf < m_pBuf_end)
-					c = *m_pBuf++;
-
-				m_bit_buf |= (c << m_bit_buf_size);
-				m_bit_buf_size += 8;
-				assert(m_bit_buf_size <= 32);
-			}
+			fill_bit_buf(basisu::cHuffmanMaxSupportedInternalCodeSize);
 						
 			int code_len;
 
 			int sym;
-			if ((sym = ct.m_lookup[m_bit_buf & (huffman_fast_lookup_size - 1)]) >= 0)
+			if ((sym = ct.m_lookup[(uint32_t)m_bit_buf & (huffman_fast_lookup_size - 1)]) >= 0)
 			{
 				code_len = sym >> 16;
 				sym &= 0xFFFF;
@@ -558,7 +571,7 @@ namespace basist
 		const uint8_t *m_pBuf_start;
 		const uint8_t *m_pBuf_end;
 
-		uint32_t m_bit_buf;
+		uint64_t m_bit_buf;
 		uint32_t m_bit_buf_size;
 	};
 
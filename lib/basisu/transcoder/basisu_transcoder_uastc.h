@@ -250,6 +250,11 @@ namespace basist
 	bool transcode_uastc_to_bc7(const uastc_block& src_blk, bc7_optimization_results& dst_blk);
 	bool transcode_uastc_to_bc7(const uastc_block& src_blk, void* pDst);
 
+	// Transcodes a run of blocks (typically a row), writing output blocks output_block_stride_in_bytes apart. Blocks are grouped by UASTC mode
+	// and each group is transcoded by a kernel specialized for that mode. The output is identical to transcoding each block on its own.
+	bool transcode_uastc_to_astc(const uastc_block* pSrc_blocks, void* pDst_blocks, uint32_t num_blocks, uint32_t output_block_stride_in_bytes);
+	bool transcode_uastc_to_bc7(const uastc_block* pSrc_blocks, void* pDst_blocks, uint32_t num_blocks, uint32_t output_block_stride_in_bytes);
+
 	void transcode_uastc_to_etc1(unpacked_uastc_block& unpacked_src_blk, color32 block_pixels[4][4], void* pDst);
 	bool transcode_uastc_to_etc1(const uastc_block& src_blk, void* pDst);
 	bool transcode_uastc_to_etc1(const uastc_block& src_blk, void* pDst, uint32_t channel);
@@ -0,0 +1,334 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file context.cpp
+ * @~English
+ *
+ * @brief Pool of Zstd contexts and scratch buffers that can be shared by
+ *        several textures and threads.
+ *
+ * Each of the internal acquire functions accepts a NULL context in which
+ * case it simply creates the object and the matching release function
+ * destroys it. Callers therefore use the same code with and without a
+ * context.
+ */
+
+#include "ktx.h"
+#include "ktxint.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <zstd.h>
+
+/*
+ * Number of idle objects of each kind kept for reuse. Anything released
+ * beyond this is freed. It only needs to cover the number of threads
+ * working concurrently with the context.
+ */
+static const size_t kMaxIdle = 16;
+
+/*
+ * Total capacity of the idle scratch buffers kept for reuse. A released
+ * buffer that would take the total above this is freed so the buffers
+ * grown for one large texture do not stay allocated for the lifetime of
+ * a context used for many small ones.
+ */
+static const ktx_size_t kMaxIdleBufferBytes = 32 * 1024 * 1024;
+
+/*
+ * Header placed before each scratch buffer handed out by a context so the
+ * buffer's capacity is known when it is returned. Keeps the buffer itself
+ * aligned as malloc would.
+ */
+union ktxScratchHeader {
+    ktx_size_t capacity;
+    max_align_t align;
+};
+
+/**
+ * @class ktxContext
+ * @~English
+ * @brief Reusable decompression and compression state.
+ *
+ * A ktxContext owns Zstd decompression and compression contexts and scratch
+ * buffers that are otherwise created and destroyed on every load, inflate or
+ * deflate operation. Attach it to textures with ktxTexture2_SetContext().
+ * A context may be shared by any number of textures and used from several
+ * threads at once.
+ *
+ * It is intended for processing many textures, often small ones, in turn.
+ * Up to 16 idle objects of each kind are kept but idle scratch buffers are
+ * limited to 32 MiB in total. Buffers for larger levels are allocated when
+ * needed and freed, not pooled, when released so the memory held by a
+ * long-lived context stays bounded whatever sizes it has seen.
+ */
+struct ktxContext {
+    std::mutex mutex;
+    std::vector<ZSTD_DCtx*> dctxs;
+    std::vector<ZSTD_CCtx*> cctxs;
+    std::vector<ktxScratchHeader*> buffers;
+    ktx_size_t bufferBytes = 0;  // Total capacity of buffers.
+
+    ~ktxContext() {
+        for (ZSTD_DCtx* dctx : dctxs)
+            ZSTD_freeDCtx(dctx);
+        for (ZSTD_CCtx* cctx : cctxs)
+            ZSTD_freeCCtx(cctx);
+        for (ktxScratchHeader* buffer : buffers)
+            free(buffer);
+    }
+};
+
+extern "C" {
+
+/**
+ * @memberof ktxContext
+ * @~English
+ * @brief Create a context for reusing decompression and compression state.
+ *
+ * The context starts empty. Zstd contexts and scratch buffers are added to
+ * it as operations using it release them and are reused by later
+ * operations. Destroy it with ktxContext_Destroy() after all textures using
+ * it have been destroyed or detached with ktxTexture2_SetContext().
+ *
+ * @param[in,out] ppContext pointer to a location in which to store the
+ *                          handle of the new context.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p ppContext is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the context.
+ */
+KTX_error_code
+ktxContext_Create(ktxContext** ppContext)
+{
+    if (!ppContext)
+        return KTX_INVALID_VALUE;
+
+    *ppContext = new (std::nothrow) ktxContext;
+    return *ppContext ? KTX_SUCCESS : KTX_OUT_OF_MEMORY;
+}
+
+/**
+ * @memberof ktxContext
+ * @~English
+ * @brief Destroy a context and all the state it holds.
+ *
+ * @param[in] context   handle of the context to destroy. May be @c NULL.
+ */
+void
+ktxContext_Destroy(ktxContext* context)
+{
+    delete context;
+}
+
+/**
+ * @memberof ktxContext @private
+ * @~English
+ * @brief Get a Zstd decompression context.
+ *
+ * @param[in] context   the context to take it from or @c NULL to create a
+ *                      new one.
+ *
+ * @return  the Zstd context or @c NULL if one could not be created.
+ */
+ZSTD_DCtx*
+ktxContext_acquireDCtx(ktxContext* context)
+{
+    if (context) {
+        std::lock_guard<std::mutex> lock(context->mutex);
+        if (!context->dctxs.empty()) {
+            ZSTD_DCtx* dctx = context->dctxs.back();
+            context->dctxs.pop_back();
+            return dctx;
+        }
+    }
+    return ZSTD_createDCtx();
+}
+
+/**
+ * @memberof ktxContext @private
+ * @~English
+ * @brief Return a Zstd decompression context from ktxContext_acquireDCtx().
+ *
+ * Session and parameters are reset so the next user starts from the same
+ * state as with a fresh ZSTD_DCtx.
+ *
+ * @param[in] context   the context it was acquired from.
+ * @param[in] dctx      the Zstd context. May be @c NULL.
+ */
+void
+ktxContext_releaseDCtx(ktxContext* context, ZSTD_DCtx* dctx)
+{
+    if (!dctx)
+        return;
+    if (context) {
+        ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+        std::lock_guard<std::mutex> lock(context->mutex);
+        if (context->dctxs.size() < kMaxIdle) {
+            try {
+                context->dctxs.push_back(dctx);
+                return;
+            } catch (std::bad_alloc&) { }
+        }
+    }
+    ZSTD_freeDCtx(dctx);
+}
+
+/**
+ * @memberof ktxContext @private
+ * @~English
+ * @brief Get a Zstd compression context.
+ *
+ * @param[in] context   the context to take it from or @c NULL to create a
+ *                      new one.
+ *
+ * @return  the Zstd context or @c NULL if one could not be created.
+ */
+ZSTD_CCtx*
+ktxContext_acquireCCtx(ktxContext* context)
+{
+    if (context) {
+        std::lock_guard<std::mutex> lock(context->mutex);
+        if (!context->cctxs.empty()) {
+            ZSTD_CCtx* cctx = context->cctxs.back();
+            context->cctxs.pop_back();
+            return cctx;
+        }
+    }
+    return ZSTD_createCCtx();
+}
+
+/**
+ * @memberof ktxContext @private
+ * @~English
+ * @brief Return a Zstd compression context from ktxContext_acquireCCtx().
+ *
+ * Session and parameters, e.g. the compression level and number of workers,
+ * are reset so they do not leak into the next user.
+ *
+ * @param[in] context   the context it was acquired from.
+ * @param[in] cctx      the Zstd context. May be @c NULL.
+ */
+void
+ktxContext_releaseCCtx(ktxContext* context, ZSTD_CCtx* cctx)
+{
+    if (!cctx)
+        return;
+    if (context) {
+        ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+        std::lock_guard<std::mutex> lock(context->mutex);
+        if (context->cctxs.size() < kMaxIdle) {
+            try {
+                context->cctxs.push_back(cctx);
+                return;
+            } catch (std::bad_alloc&) { }
+        }
+    }
+    ZSTD_freeCCtx(cctx);
+}
+
+/**
+ * @memberof ktxContext @private
+ * @~English
+ * @brief Get a scratch buffer of at least @p size bytes.
+ *
+ * The smallest idle buffer that is large enough is used. If there is none
+ * the largest idle buffer, if any, is replaced by one of the required size
+ * so the number of buffers held stays bounded by the concurrency of the
+ * users rather than the variety of sizes requested.
+ *
+ * @param[in] context   the context to take it from or @c NULL to use
+ *                      malloc.
+ * @param[in] size      required size in bytes.
+ *
+ * @return  pointer to the buffer or @c NULL if out of memory.
+ */
+void*
+ktxContext_acquireBuffer(ktxContext* context, ktx_size_t size)
+{
+    if (!context)
+        return malloc(size);
+
+    ktxScratchHeader* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(context->mutex);
+        auto& buffers = context->buffers;
+        auto best = buffers.end();
+        auto largest = buffers.end();
+        for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+            if ((*it)->capacity >= size
+                && (best == buffers.end() || (*it)->capacity < (*best)->capacity))
+                best = it;
+            if (largest == buffers.end()
+                || (*it)->capacity > (*largest)->capacity)
+                largest = it;
+        }
+        if (best != buffers.end()) {
+            buffer = *best;
+            buffers.erase(best);
+            context->bufferBytes -= buffer->capacity;
+            return buffer + 1;
+        }
+        if (largest != buffers.end()) {
+            buffer = *largest;
+            buffers.erase(largest);
+            context->bufferBytes -= buffer->capacity;
+        }
+    }
+    // Too small. Free rather than realloc as the contents are not needed.
+    free(buffer);
+    buffer = (ktxScratchHeader*)malloc(sizeof(ktxScratchHeader) + size);
+    if (!buffer)
+        return NULL;
+    buffer->capacity = size;
+    return buffer + 1;
+}
+
+/**
+ * @memberof ktxContext @private
+ * @~English
+ * @brief Return a buffer from ktxContext_acquireBuffer().
+ *
+ * The buffer is kept for reuse only while the idle buffers' total capacity
+ * stays within kMaxIdleBufferBytes. Otherwise it is freed.
+ *
+ * @param[in] context   the context it was acquired from.
+ * @param[in] pBuffer   the buffer. May be @c NULL.
+ */
+void
+ktxContext_releaseBuffer(ktxContext* context, void* pBuffer)
+{
+    if (!context) {
+        free(pBuffer);
+        return;
+    }
+    if (!pBuffer)
+        return;
+
+    ktxScratchHeader* buffer = (ktxScratchHeader*)pBuffer - 1;
+    {
+        std::lock_guard<std::mutex> lock(context->mutex);
+        if (context->buffers.size() < kMaxIdle
+            && buffer->capacity <= kMaxIdleBufferBytes - context->bufferBytes) {
+            try {
+                context->buffers.push_back(buffer);
+                context->bufferBytes += buffer->capacity;
+                return;
+            } catch (std::bad_alloc&) { }
+        }
+    }
+    free(buffer);
+}
+
+}
@@ -0,0 +1,744 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file encode_cache.cpp
+ * @~English
+ *
+ * @brief On-disk cache of compression results.
+ *
+ * Each entry is a file named after the hex of its key holding the parts of
+ * a ktxTexture2 that compression replaces. The key is a 128-bit
+ * MurmurHash3 of the library version, the compression parameters that
+ * affect the output and the texture's header, DFD, metadata and image
+ * data. The order in which entries were last used is kept in the
+ * directory's @c index file so eviction survives across runs.
+ */
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "encode_cache.h"
+#include "version.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Bump when anything changes that makes old entries unusable. Together
+ * with the library version it is part of every key.
+ */
+static const ktx_uint32_t kFileVersion = 1;
+static const char kFileMagic[8] = { 'K', 'T', 'X', 'c', 'a', 'c', 'h', 'e' };
+static const char kIndexName[] = "index";
+static const char kIndexHeader[] = "KTXencodecache 1";
+
+/*
+ * Header of an entry file. It is followed by the level index, the DFD,
+ * the serialized metadata, the supercompression global data and the image
+ * data. Entries are in native byte order; the magic makes them fail to
+ * load elsewhere rather than load wrongly.
+ */
+struct ktxEncodeCacheFileHeader {
+    char magic[8];
+    ktx_uint32_t fileVersion;
+    ktx_uint32_t numLevels;
+    ktxEncodeCacheKey key;
+    ktx_uint32_t vkFormat;
+    ktx_uint32_t supercompressionScheme;
+    ktx_uint32_t isCompressed;
+    ktx_uint32_t typeSize;
+    ktx_uint32_t requiredLevelAlignment;
+    ktx_uint32_t reserved;
+    ktxFormatSize formatSize;
+    ktx_uint64_t dfdByteLength;
+    ktx_uint64_t kvdByteLength;
+    ktx_uint64_t sgdByteLength;
+    ktx_uint64_t dataSize;
+};
+
+/*
+ * Streaming MurmurHash3_x64_128, placed in the public domain by its
+ * author Austin Appleby.
+ */
+class ktxKeyHasher {
+  public:
+    void add(const void* data, size_t size) {
+        const ktx_uint8_t* p = static_cast<const ktx_uint8_t*>(data);
+        length += size;
+        if (tailLength) {
+            size_t n = std::min(size, sizeof(tail) - tailLength);
+            memcpy(tail + tailLength, p, n);
+            tailLength += n;
+            p += n;
+            size -= n;
+            if (tailLength < sizeof(tail))
+                return;
+            block(tail);
+            tailLength = 0;
+        }
+        for (; size >= 16; p += 16, size -= 16)
+            block(p);
+        memcpy(tail, p, size);
+        tailLength = size;
+    }
+
+    template <typename T>
+    void addValue(T value) { add(&value, sizeof(value)); }
+
+    void finish(ktxEncodeCacheKey* pKey) {
+        ktx_uint64_t k1 = 0, k2 = 0;
+        for (size_t i = tailLength; i > 8; i--)
+            k2 ^= (ktx_uint64_t)tail[i - 1] << (8 * (i - 9));
+        if (tailLength > 8) {
+            k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+        }
+        for (size_t i = std::min(tailLength, (size_t)8); i > 0; i--)
+            k1 ^= (ktx_uint64_t)tail[i - 1] << (8 * (i - 1));
+        if (tailLength > 0) {
+            k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        }
+
+        h1 ^= length; h2 ^= length;
+        h1 += h2; h2 += h1;
+        h1 = fmix(h1); h2 = fmix(h2);
+        h1 += h2; h2 += h1;
+        memcpy(pKey->bytes, &h1, sizeof(h1));
+        memcpy(pKey->bytes + 8, &h2, sizeof(h2));
+    }
+
+  private:
+    static const ktx_uint64_t c1 = 0x87c37b91114253d5ULL;
+    static const ktx_uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    static ktx_uint64_t rotl(ktx_uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static ktx_uint64_t fmix(ktx_uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    void block(const ktx_uint8_t* p) {
+        ktx_uint64_t k1, k2;
+        memcpy(&k1, p, sizeof(k1));
+        memcpy(&k2, p + 8, sizeof(k2));
+
+        k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    ktx_uint64_t h1 = 0;
+    ktx_uint64_t h2 = 0;
+    ktx_uint64_t length = 0;
+    ktx_uint8_t tail[16];
+    size_t tailLength = 0;
+};
+
+/*
+ * Hash everything about @p This that compression reads.
+ */
+static KTX_error_code
+hashTexture(ktxKeyHasher& hasher, ktxTexture2* This)
+{
+    if (!This || !This->pData || !This->pDfd)
+        return KTX_INVALID_OPERATION;
+
+    hasher.addValue(This->vkFormat);
+    hasher.addValue(This->supercompressionScheme);
+    hasher.addValue(This->isCompressed);
+    hasher.addValue(This->isArray);
+    hasher.addValue(This->isCubemap);
+    hasher.addValue(This->generateMipmaps);
+    hasher.addValue(This->baseWidth);
+    hasher.addValue(This->baseHeight);
+    hasher.addValue(This->baseDepth);
+    hasher.addValue(This->numDimensions);
+    hasher.addValue(This->numLevels);
+    hasher.addValue(This->numLayers);
+    hasher.addValue(This->numFaces);
+    hasher.add(This->pDfd, This->pDfd[0]);
+
+    unsigned int kvdLen;
+    ktx_uint8_t* kvd;
+    KTX_error_code result = ktxHashList_Serialize(&This->kvDataHead,
+                                                  &kvdLen, &kvd);
+    if (result != KTX_SUCCESS)
+        return result;
+    hasher.addValue(kvdLen);
+    hasher.add(kvd, kvdLen);
+    free(kvd);
+
+    hasher.add(This->_private->_levelIndex,
+               This->numLevels * sizeof(ktxLevelIndexEntry));
+    hasher.addValue((ktx_uint64_t)This->dataSize);
+    hasher.add(This->pData, This->dataSize);
+    return KTX_SUCCESS;
+}
+
+static void
+hashStart(ktxKeyHasher& hasher, char kind)
+{
+    static const char tag[] = "libktx " STR(LIBKTX_VERSION);
+    hasher.add(tag, sizeof(tag));
+    hasher.addValue(kFileVersion);
+    hasher.addValue(kind);
+}
+
+static std::string
+keyName(const ktxEncodeCacheKey* pKey)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string name;
+    for (ktx_uint8_t byte : pKey->bytes) {
+        name += hex[byte >> 4];
+        name += hex[byte & 0xf];
+    }
+    return name;
+}
+
+/*
+ * The entries in memory mirror the directory's index. The files are only
+ * touched to load, store or evict an entry.
+ */
+struct ktxEncodeCache {
+    struct Entry {
+        std::string name;
+        ktx_uint64_t size;
+    };
+    typedef std::list<Entry> EntryList;
+
+    std::mutex mutex;
+    std::string directory;
+    ktx_uint64_t maxSize;
+    ktx_uint32_t maxEntries;
+    ktx_uint64_t totalSize = 0;
+    EntryList lru;          // Most recently used first.
+    std::unordered_map<std::string, EntryList::iterator> entries;
+    std::mt19937_64 random; // For temporary file names.
+
+    std::string path(const std::string& name) const {
+        return directory + "/" + name;
+    }
+
+    // Name unlikely to clash with that of another thread or process
+    // writing to the directory.
+    std::string tempName() {
+        static const char hex[] = "0123456789abcdef";
+        ktx_uint64_t r = random();
+        std::string name = "tmp-";
+        for (int i = 0; i < 16; i++, r >>= 4)
+            name += hex[r & 0xf];
+        return name;
+    }
+
+    // These must be called with the mutex held.
+    void add(const std::string& name, ktx_uint64_t size) {
+        remove(name, false);
+        lru.push_front(Entry{name, size});
+        entries[name] = lru.begin();
+        totalSize += size;
+    }
+
+    void remove(const std::string& name, bool deleteFile) {
+        auto it = entries.find(name);
+        if (it == entries.end())
+            return;
+        totalSize -= it->second->size;
+        lru.erase(it->second);
+        entries.erase(it);
+        if (deleteFile)
+            ::remove(path(name).c_str());
+    }
+
+    void evict() {
+        while (!lru.empty()
+               && ((maxSize && totalSize > maxSize)
+                   || (maxEntries && lru.size() > maxEntries))) {
+            std::string name = lru.back().name;
+            remove(name, true);
+        }
+    }
+
+    void readIndex();
+    KTX_error_code writeIndex();
+};
+
+void
+ktxEncodeCache::readIndex()
+{
+    FILE* f = ktxFOpenUTF8(path(kIndexName).c_str(), "r");
+    if (!f)
+        return;
+
+    char line[128];
+    if (fgets(line, sizeof(line), f)
+        && strncmp(line, kIndexHeader, sizeof(kIndexHeader) - 1) == 0) {
+        // Most recently used first, the same as lru.
+        char name[33];
+        unsigned long long size;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "%32s %llu", name, &size) != 2
+                || strlen(name) != 32 || entries.count(name))
+                continue;
+            lru.push_back(Entry{name, size});
+            entries[name] = std::prev(lru.end());
+            totalSize += size;
+        }
+    }
+    fclose(f);
+}
+
+KTX_error_code
+ktxEncodeCache::writeIndex()
+{
+    std::string temp = path(tempName());
+    FILE* f = ktxFOpenUTF8(temp.c_str(), "w");
+    if (!f)
+        return KTX_FILE_OPEN_FAILED;
+
+    bool ok = fprintf(f, "%s\n", kIndexHeader) > 0;
+    for (const Entry& entry : lru) {
+        if (!ok)
+            break;
+        ok = fprintf(f, "%s %llu\n", entry.name.c_str(),
+                     (unsigned long long)entry.size) > 0;
+    }
+    ok = (fclose(f) == 0) && ok;
+
+    // rename does not replace an existing file on Windows.
+    std::string index = path(kIndexName);
+    if (ok) {
+        ::remove(index.c_str());
+        ok = rename(temp.c_str(), index.c_str()) == 0;
+    }
+    if (!ok) {
+        ::remove(temp.c_str());
+        return KTX_FILE_WRITE_ERROR;
+    }
+    return KTX_SUCCESS;
+}
+
+static bool
+readAll(FILE* f, void* dst, ktx_uint64_t size)
+{
+    return size == 0 || fread(dst, 1, (size_t)size, f) == size;
+}
+
+static bool
+writeAll(FILE* f, const void* src, ktx_uint64_t size)
+{
+    return size == 0 || fwrite(src, 1, (size_t)size, f) == size;
+}
+
+extern "C" {
+
+/**
+ * @memberof ktxEncodeCache
+ * @~English
+ * @brief Open or create an encode cache in a directory.
+ *
+ * Entries left in @p directory by an earlier cache are reused. If they
+ * exceed the new limits the least recently used are evicted. A directory
+ * should only be used by one cache at a time.
+ *
+ * @param[in] directory     path, in UTF-8, of an existing directory in which
+ *                          to keep the cache.
+ * @param[in] maxSize       total size in bytes that the entries may occupy.
+ *                          0 means no limit.
+ * @param[in] maxEntries    number of entries the cache may hold. 0 means
+ *                          no limit.
+ * @param[in,out] ppCache   pointer to a location in which to store the
+ *                          handle of the new cache.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p directory or @p ppCache is @c NULL or
+ *                              @p directory is empty.
+ * @exception KTX_FILE_OPEN_FAILED @p directory is not writable.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the cache.
+ */
+KTX_error_code
+ktxEncodeCache_Create(const char* directory, ktx_uint64_t maxSize,
+                      ktx_uint32_t maxEntries, ktxEncodeCache** ppCache)
+{
+    if (!ppCache)
+        return KTX_INVALID_VALUE;
+    *ppCache = NULL;
+    if (!directory || !*directory)
+        return KTX_INVALID_VALUE;
+
+    ktxEncodeCache* cache;
+    try {
+        cache = new ktxEncodeCache;
+        cache->directory = directory;
+        cache->maxSize = maxSize;
+        cache->maxEntries = maxEntries;
+        cache->random.seed(std::random_device()());
+        cache->readIndex();
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    cache->evict();
+    if (cache->writeIndex() != KTX_SUCCESS) {
+        delete cache;
+        return KTX_FILE_OPEN_FAILED;
+    }
+    *ppCache = cache;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxEncodeCache
+ * @~English
+ * @brief Destroy an encode cache, leaving its entries on disk.
+ *
+ * No compression may be using the cache.
+ *
+ * @param[in] cache handle of the cache to destroy. May be @c NULL.
+ */
+void
+ktxEncodeCache_Destroy(ktxEncodeCache* cache)
+{
+    if (!cache)
+        return;
+    (void)cache->writeIndex();
+    delete cache;
+}
+
+/**
+ * @memberof ktxEncodeCache @private
+ * @~English
+ * @brief Compute the key of compressing a texture to Basis Universal.
+ *
+ * Fields of @p params that do not affect the output, @c verbose,
+ * @c noSSE, @c threadCount, @c separateRGToRGB_A and @c cache,
+ * are not part of the key.
+ *
+ * @exception KTX_INVALID_VALUE     @p params->structSize is not correct.
+ * @exception KTX_INVALID_OPERATION The texture's image data is not loaded.
+ */
+KTX_error_code
+ktxEncodeCache_basisKey(ktxTexture2* This, const ktxBasisParams* params,
+                        ktxEncodeCacheKey* pKey)
+{
+    if (!params || params->structSize != sizeof(ktxBasisParams))
+        return KTX_INVALID_VALUE;
+
+    ktxKeyHasher hasher;
+    hashStart(hasher, 'B');
+    hasher.addValue(params->uastc);
+    hasher.addValue(params->compressionLevel);
+    hasher.addValue(params->qualityLevel);
+    hasher.addValue(params->maxEndpoints);
+    hasher.addValue(params->endpointRDOThreshold);
+    hasher.addValue(params->maxSelectors);
+    hasher.addValue(params->selectorRDOThreshold);
+    hasher.add(params->inputSwizzle, sizeof(params->inputSwizzle));
+    hasher.addValue(params->normalMap);
+    hasher.addValue(params->preSwizzle);
+    hasher.addValue(params->noEndpointRDO);
+    hasher.addValue(params->noSelectorRDO);
+    hasher.addValue(params->uastcFlags);
+    hasher.addValue(params->uastcRDO);
+    hasher.addValue(params->uastcRDOQualityScalar);
+    hasher.addValue(params->uastcRDODictSize);
+    hasher.addValue(params->uastcRDOMaxSmoothBlockErrorScale);
+    hasher.addValue(params->uastcRDOMaxSmoothBlockStdDev);
+    hasher.addValue(params->uastcRDODontFavorSimplerModes);
+    hasher.addValue(params->uastcRDONoMultithreading);
+
+    KTX_error_code result = hashTexture(hasher, This);
+    if (result == KTX_SUCCESS)
+        hasher.finish(pKey);
+    return result;
+}
+
+/**
+ * @memberof ktxEncodeCache @private
+ * @~English
+ * @brief Compute the key of compressing a texture to ASTC.
+ *
+ * @c verbose, @c threadCount and @c cache are not part of the key.
+ *
+ * @exception KTX_INVALID_VALUE     @p params->structSize is not correct.
+ * @exception KTX_INVALID_OPERATION The texture's image data is not loaded.
+ */
+KTX_error_code
+ktxEncodeCache_astcKey(ktxTexture2* This, const ktxAstcParams* params,
+                       ktxEncodeCacheKey* pKey)
+{
+    if (!params || params->structSize != sizeof(ktxAstcParams))
+        return KTX_INVALID_VALUE;
+
+    ktxKeyHasher hasher;
+    hashStart(hasher, 'A');
+    hasher.addValue(params->blockDimension);
+    hasher.addValue(params->mode);
+    hasher.addValue(params->qualityLevel);
+    hasher.addValue(params->normalMap);
+    hasher.addValue(params->perceptual);
+    hasher.add(params->inputSwizzle, sizeof(params->inputSwizzle));
+
+    KTX_error_code result = hashTexture(hasher, This);
+    if (result == KTX_SUCCESS)
+        hasher.finish(pKey);
+    return result;
+}
+
+/**
+ * @memberof ktxEncodeCache @private
+ * @~English
+ * @brief Replace the content of a texture with a cached compression result.
+ *
+ * The texture is unchanged unless KTX_SUCCESS is returned. An entry that
+ * cannot be read is dropped from the cache.
+ *
+ * @exception KTX_NOT_FOUND      There is no usable entry for @p pKey.
+ * @exception KTX_OUT_OF_MEMORY  Not enough memory to hold the entry.
+ */
+KTX_error_code
+ktxEncodeCache_load(ktxEncodeCache* cache, const ktxEncodeCacheKey* pKey,
+                    ktxTexture2* This)
+{
+    std::string name = keyName(pKey);
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        auto it = cache->entries.find(name);
+        if (it == cache->entries.end())
+            return KTX_NOT_FOUND;
+        cache->lru.splice(cache->lru.begin(), cache->lru, it->second);
+        path = cache->path(name);
+    }
+
+    ktxEncodeCacheFileHeader header;
+    ktxLevelIndexEntry* levelIndex = NULL;
+    ktx_uint32_t* dfd = NULL;
+    ktx_uint8_t* kvd = NULL;
+    ktx_uint8_t* sgd = NULL;
+    ktx_uint8_t* data = NULL;
+    ktxHashList kvDataHead = NULL;
+    KTX_error_code result = KTX_FILE_DATA_ERROR;
+
+    FILE* f = ktxFOpenUTF8(path.c_str(), "rb");
+    if (!f)
+        goto drop;
+    if (!readAll(f, &header, sizeof(header))
+        || memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0
+        || header.fileVersion != kFileVersion
+        || memcmp(&header.key, pKey, sizeof(*pKey)) != 0
+        || header.numLevels != This->numLevels
+        || header.dfdByteLength < sizeof(ktx_uint32_t)
+        || header.kvdByteLength > UINT32_MAX
+        || header.dataSize > SIZE_MAX)
+        goto drop;
+
+    levelIndex = (ktxLevelIndexEntry*)malloc(header.numLevels
+                                             * sizeof(ktxLevelIndexEntry));
+    dfd = (ktx_uint32_t*)malloc((size_t)header.dfdByteLength);
+    kvd = (ktx_uint8_t*)malloc((size_t)header.kvdByteLength + 1);
+    sgd = (ktx_uint8_t*)malloc((size_t)header.sgdByteLength + 1);
+    data = (ktx_uint8_t*)malloc((size_t)header.dataSize + 1);
+    if (!levelIndex || !dfd || !kvd || !sgd || !data) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+    if (!readAll(f, levelIndex, header.numLevels * sizeof(ktxLevelIndexEntry))
+        || !readAll(f, dfd, header.dfdByteLength)
+        || !readAll(f, kvd, header.kvdByteLength)
+        || !readAll(f, sgd, header.sgdByteLength)
+        || !readAll(f, data, header.dataSize)
+        || fgetc(f) != EOF
+        || dfd[0] != header.dfdByteLength)
+        goto drop;
+    for (ktx_uint32_t level = 0; level < header.numLevels; level++) {
+        if (levelIndex[level].byteOffset > header.dataSize
+            || levelIndex[level].byteLength
+               > header.dataSize - levelIndex[level].byteOffset)
+            goto drop;
+    }
+    if (header.kvdByteLength != 0) {
+        result = ktxHashList_Deserialize(&kvDataHead,
+                                         (unsigned int)header.kvdByteLength,
+                                         kvd);
+        if (result != KTX_SUCCESS) {
+            result = KTX_FILE_DATA_ERROR;
+            goto drop;
+        }
+    }
+    fclose(f);
+    f = NULL;
+
+    // Now modify the texture.
+    memcpy(This->_private->_levelIndex, levelIndex,
+           header.numLevels * sizeof(ktxLevelIndexEntry));
+    free(This->pDfd);
+    This->pDfd = dfd;
+    dfd = NULL;
+    ktxHashList_Destruct(&This->kvDataHead);
+    This->kvDataHead = kvDataHead;
+    free(This->_private->_supercompressionGlobalData);
+    if (header.sgdByteLength) {
+        This->_private->_supercompressionGlobalData = sgd;
+        sgd = NULL;
+    } else {
+        This->_private->_supercompressionGlobalData = NULL;
+    }
+    This->_private->_sgdByteLength = header.sgdByteLength;
+    ktxTexture2_freeImageData(This);
+    This->pData = data;
+    This->dataSize = (ktx_size_t)header.dataSize;
+    data = NULL;
+    This->vkFormat = header.vkFormat;
+    This->supercompressionScheme =
+                    (ktxSupercmpScheme)header.supercompressionScheme;
+    This->isCompressed = header.isCompressed;
+    This->_protected->_formatSize = header.formatSize;
+    This->_protected->_typeSize = header.typeSize;
+    This->_private->_requiredLevelAlignment = header.requiredLevelAlignment;
+    result = KTX_SUCCESS;
+    goto cleanup;
+
+drop:
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->remove(name, true);
+    }
+    ktxHashList_Destruct(&kvDataHead);
+    if (result == KTX_FILE_DATA_ERROR)
+        result = KTX_NOT_FOUND;
+
+cleanup:
+    if (f)
+        fclose(f);
+    free(levelIndex);
+    free(dfd);
+    free(kvd);
+    free(sgd);
+    free(data);
+    return result;
+}
+
+/**
+ * @memberof ktxEncodeCache @private
+ * @~English
+ * @brief Add the compressed content of a texture to the cache.
+ *
+ * The texture is not modified. Entries are written to a temporary file and
+ * renamed into place so a reader never sees a partial entry. Least
+ * recently used entries are evicted to stay within the cache's limits. An
+ * entry larger than the size limit is not stored.
+ *
+ * @exception KTX_FILE_WRITE_ERROR  The entry could not be written.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory to serialize the
+ *                                  texture's metadata.
+ */
+KTX_error_code
+ktxEncodeCache_store(ktxEncodeCache* cache, const ktxEncodeCacheKey* pKey,
+                     ktxTexture2* This)
+{
+    unsigned int kvdLen;
+    ktx_uint8_t* kvd;
+    KTX_error_code result = ktxHashList_Serialize(&This->kvDataHead,
+                                                  &kvdLen, &kvd);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktxEncodeCacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.fileVersion = kFileVersion;
+    header.numLevels = This->numLevels;
+    header.key = *pKey;
+    header.vkFormat = This->vkFormat;
+    header.supercompressionScheme = This->supercompressionScheme;
+    header.isCompressed = This->isCompressed;
+    header.typeSize = This->_protected->_typeSize;
+    header.requiredLevelAlignment = This->_private->_requiredLevelAlignment;
+    header.formatSize = This->_protected->_formatSize;
+    header.dfdByteLength = This->pDfd[0];
+    header.kvdByteLength = kvdLen;
+    header.sgdByteLength = This->_private->_sgdByteLength;
+    header.dataSize = This->dataSize;
+
+    ktx_uint64_t size = sizeof(header)
+                        + header.numLevels * sizeof(ktxLevelIndexEntry)
+                        + header.dfdByteLength + header.kvdByteLength
+                        + header.sgdByteLength + header.dataSize;
+
+    std::string name = keyName(pKey);
+    std::string temp;
+    try {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (cache->maxSize && size > cache->maxSize) {
+            free(kvd);
+            return KTX_SUCCESS;
+        }
+        temp = cache->path(cache->tempName());
+    } catch (std::bad_alloc&) {
+        free(kvd);
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    FILE* f = ktxFOpenUTF8(temp.c_str(), "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        ok = writeAll(f, &header, sizeof(header))
+             && writeAll(f, This->_private->_levelIndex,
+                         header.numLevels * sizeof(ktxLevelIndexEntry))
+             && writeAll(f, This->pDfd, header.dfdByteLength)
+             && writeAll(f, kvd, header.kvdByteLength)
+             && writeAll(f, This->_private->_supercompressionGlobalData,
+                         header.sgdByteLength)
+             && writeAll(f, This->pData, header.dataSize);
+        ok = (fclose(f) == 0) && ok;
+    }
+    free(kvd);
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    std::string path = cache->path(name);
+    if (ok) {
+        ::remove(path.c_str());
+        ok = rename(temp.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        ::remove(temp.c_str());
+        cache->remove(name, false);
+        return KTX_FILE_WRITE_ERROR;
+    }
+    try {
+        cache->add(name, size);
+    } catch (std::bad_alloc&) {
+        ::remove(path.c_str());
+        return KTX_OUT_OF_MEMORY;
+    }
+    cache->evict();
+    return cache->writeIndex();
+}
+
+}
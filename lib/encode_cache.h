@@ -0,0 +1,94 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file encode_cache.h
+ * @~English
+ *
+ * @brief Lookup and store functions of the on-disk encode cache.
+ *
+ * These are private and should not be used outside the library.
+ */
+
+#ifndef _ENCODE_CACHE_H_
+#define _ENCODE_CACHE_H_
+
+#include "ktx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Identifies the result of one compression: a hash of everything that
+ * determines it.
+ */
+typedef struct ktxEncodeCacheKey {
+    ktx_uint8_t bytes[16];
+} ktxEncodeCacheKey;
+
+KTX_error_code
+ktxEncodeCache_basisKey(ktxTexture2* This, const ktxBasisParams* params,
+                        ktxEncodeCacheKey* pKey);
+KTX_error_code
+ktxEncodeCache_astcKey(ktxTexture2* This, const ktxAstcParams* params,
+                       ktxEncodeCacheKey* pKey);
+
+KTX_error_code
+ktxEncodeCache_load(ktxEncodeCache* cache, const ktxEncodeCacheKey* pKey,
+                    ktxTexture2* This);
+KTX_error_code
+ktxEncodeCache_store(ktxEncodeCache* cache, const ktxEncodeCacheKey* pKey,
+                     ktxTexture2* This);
+
+#ifdef __cplusplus
+}
+
+static inline KTX_error_code
+ktxEncodeCache_key(ktxTexture2* This, const ktxBasisParams* params,
+                   ktxEncodeCacheKey* pKey)
+{
+    return ktxEncodeCache_basisKey(This, params, pKey);
+}
+
+static inline KTX_error_code
+ktxEncodeCache_key(ktxTexture2* This, const ktxAstcParams* params,
+                   ktxEncodeCacheKey* pKey)
+{
+    return ktxEncodeCache_astcKey(This, params, pKey);
+}
+
+/*
+ * Compress @p This with @p compress unless @p params->cache holds the
+ * result of an identical compression, in which case that is restored
+ * instead. A successful compression is added to the cache. Failing to
+ * use the cache never fails the compression.
+ */
+template <typename Params>
+static KTX_error_code
+ktxEncodeCache_compress(ktxTexture2* This, Params* params,
+                        KTX_error_code (*compress)(ktxTexture2*, Params*))
+{
+    ktxEncodeCacheKey key;
+
+    if (!params || !params->cache
+        || ktxEncodeCache_key(This, params, &key) != KTX_SUCCESS)
+        return compress(This, params);
+
+    if (ktxEncodeCache_load(params->cache, &key, This) == KTX_SUCCESS)
+        return KTX_SUCCESS;
+
+    KTX_error_code result = compress(This, params);
+    if (result == KTX_SUCCESS)
+        (void)ktxEncodeCache_store(params->cache, &key, This);
+    return result;
+}
+#endif
+
+#endif /* _ENCODE_CACHE_H_ */
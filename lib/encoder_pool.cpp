@@ -0,0 +1,251 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file encoder_pool.cpp
+ * @~English
+ *
+ * @brief Encoder thread pool and batch compression of several textures.
+ */
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "encoder_pool.h"
+#include "encode_cache.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+/*
+ * Amount of work in compressing a texture, for ordering a batch.
+ */
+static ktx_uint64_t
+textureWork(const ktxTexture2* texture)
+{
+    return (ktx_uint64_t)texture->baseWidth * texture->baseHeight
+           * texture->baseDepth * texture->numLayers * texture->numFaces;
+}
+
+/*
+ * Compress each of @p textures with @p compress on @p pool, or on a pool
+ * of @p params->threadCount threads if @p pool is @c NULL.
+ *
+ * The largest textures are started first so the small ones fill in the
+ * gaps at the end instead of one big texture running alone after
+ * everything else has finished. The encoders start their own threads so
+ * the pool's threads are divided between the textures running at once,
+ * giving each encoder its share instead of the pool's full size. Only
+ * this batch's jobs are waited for so other threads can run batches on
+ * the same pool at the same time.
+ */
+template <typename Params>
+static KTX_error_code
+compressBatch(ktxTexture2** textures, ktx_uint32_t textureCount,
+              ktxEncoderPool* pool, Params* params, KTX_error_code* pResults,
+              KTX_error_code (*compress)(ktxTexture2*, Params*))
+{
+    if (!textures || !params)
+        return KTX_INVALID_VALUE;
+    if (params->structSize != sizeof(Params))
+        return KTX_INVALID_VALUE;
+    for (ktx_uint32_t i = 0; i < textureCount; i++) {
+        if (!textures[i])
+            return KTX_INVALID_VALUE;
+    }
+    if (textureCount == 0)
+        return KTX_SUCCESS;
+
+    ktxEncoderPool* ownPool = NULL;
+    if (!pool) {
+        KTX_error_code result = ktxEncoderPool_Create(params->threadCount,
+                                                       &ownPool);
+        if (result != KTX_SUCCESS)
+            return result;
+        pool = ownPool;
+    }
+
+    KTX_error_code result = KTX_SUCCESS;
+    try {
+        basisu::job_pool& jobPool = pool->jobPool;
+        ktx_uint32_t poolThreads = (ktx_uint32_t)jobPool.get_total_threads();
+        Params batchParams = *params;
+        batchParams.threadCount
+                = MAX(1, poolThreads / MIN(textureCount, poolThreads));
+
+        std::vector<ktx_uint32_t> order(textureCount);
+        std::vector<KTX_error_code> results(textureCount, KTX_SUCCESS);
+        std::vector<basisu::job_pool::job_handle> jobs;
+        jobs.reserve(textureCount);
+        for (ktx_uint32_t i = 0; i < textureCount; i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+                         [textures](ktx_uint32_t a, ktx_uint32_t b) {
+                             return textureWork(textures[a])
+                                    > textureWork(textures[b]);
+                         });
+
+        for (ktx_uint32_t i : order) {
+            ktxTexture2* texture = textures[i];
+            KTX_error_code* pResult = &results[i];
+            Params* pParams = &batchParams;
+            jobs.push_back(jobPool.add_job([=]() {
+                *pResult = ktxEncodeCache_compress(texture, pParams, compress);
+            }, nullptr, 0));
+        }
+        jobPool.wait_for(jobs.data(), (uint32_t)jobs.size());
+
+        // Report the first failure in input order, as a serial loop would.
+        for (ktx_uint32_t i = 0; i < textureCount; i++) {
+            if (pResults)
+                pResults[i] = results[i];
+            if (result == KTX_SUCCESS)
+                result = results[i];
+        }
+    } catch (std::bad_alloc&) {
+        result = KTX_OUT_OF_MEMORY;
+    }
+
+    ktxEncoderPool_Destroy(ownPool);
+    return result;
+}
+
+extern "C" {
+
+/**
+ * @memberof ktxEncoderPool
+ * @~English
+ * @brief Create a pool of encoder threads.
+ *
+ * @param[in] threadCount   number of threads to use, including the thread
+ *                          that waits on a compression. 0 means use the
+ *                          number of hardware threads.
+ * @param[in,out] ppPool    pointer to a location in which to store the
+ *                          handle of the new pool.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p ppPool is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the pool.
+ */
+KTX_error_code
+ktxEncoderPool_Create(ktx_uint32_t threadCount, ktxEncoderPool** ppPool)
+{
+    if (!ppPool)
+        return KTX_INVALID_VALUE;
+
+    threadCount = ktxParallel_threadCount(threadCount, ~0U);
+    try {
+        *ppPool = new ktxEncoderPool(threadCount);
+    } catch (std::bad_alloc&) {
+        *ppPool = NULL;
+        return KTX_OUT_OF_MEMORY;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxEncoderPool
+ * @~English
+ * @brief Destroy a pool of encoder threads.
+ *
+ * No compression may be using the pool.
+ *
+ * @param[in] pool  handle of the pool to destroy. May be @c NULL.
+ */
+void
+ktxEncoderPool_Destroy(ktxEncoderPool* pool)
+{
+    delete pool;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Encode and possibly supercompress several textures to a Basis
+ *        Universal format.
+ *
+ * Equivalent to calling ktxTexture2_CompressBasisEx() on each texture with
+ * @p params but the textures are compressed concurrently on @p pool, or on
+ * a pool of @p params->threadCount threads created for the call if that is
+ * @c NULL. Each texture's encoder is given an equal share of the pool's
+ * threads in place of @p params->threadCount. When @p params->cache is set
+ * each texture is looked up in and added to the cache.
+ *
+ * Several threads may compress batches on the same pool at once. Each call
+ * returns when its own textures are done.
+ *
+ * @param[in]     textures      array of pointers to the textures.
+ * @param[in]     textureCount  number of textures in @p textures.
+ * @param[in]     pool          pool on which to compress the textures.
+ *                              May be @c NULL.
+ * @param[in]     params        parameters used for every texture.
+ * @param[out]    pResults      optional array of @p textureCount elements
+ *                              receiving the result for each texture.
+ *
+ * @return      KTX_SUCCESS if every texture was compressed, otherwise the
+ *              error for the first texture in @p textures that failed.
+ *
+ * @exception KTX_INVALID_VALUE @p textures or @p params is @c NULL, an
+ *                              element of @p textures is @c NULL or
+ *                              @p params->structSize is not correct.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to create the pool.
+ * @exception ...               Any error from ktxTexture2_CompressBasisEx().
+ */
+KTX_error_code
+ktxTexture2_CompressBasisBatch(ktxTexture2** textures,
+                               ktx_uint32_t textureCount,
+                               ktxEncoderPool* pool,
+                               ktxBasisParams* params,
+                               KTX_error_code* pResults)
+{
+    return compressBatch(textures, textureCount, pool, params, pResults,
+                         ktxTexture2_CompressBasisEx);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Encode several textures to ASTC.
+ *
+ * Equivalent to calling ktxTexture2_CompressAstcEx() on each texture with
+ * @p params but the textures are compressed concurrently. See
+ * ktxTexture2_CompressBasisBatch() for details.
+ *
+ * @param[in]     textures      array of pointers to the textures.
+ * @param[in]     textureCount  number of textures in @p textures.
+ * @param[in]     pool          pool on which to compress the textures.
+ *                              May be @c NULL.
+ * @param[in]     params        parameters used for every texture.
+ * @param[out]    pResults      optional array of @p textureCount elements
+ *                              receiving the result for each texture.
+ *
+ * @return      KTX_SUCCESS if every texture was compressed, otherwise the
+ *              error for the first texture in @p textures that failed.
+ *
+ * @exception KTX_INVALID_VALUE @p textures or @p params is @c NULL, an
+ *                              element of @p textures is @c NULL or
+ *                              @p params->structSize is not correct.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to create the pool.
+ * @exception ...               Any error from ktxTexture2_CompressAstcEx().
+ */
+KTX_error_code
+ktxTexture2_CompressAstcBatch(ktxTexture2** textures,
+                              ktx_uint32_t textureCount,
+                              ktxEncoderPool* pool,
+                              ktxAstcParams* params,
+                              KTX_error_code* pResults)
+{
+    return compressBatch(textures, textureCount, pool, params, pResults,
+                         ktxTexture2_CompressAstcEx);
+}
+
+}
@@ -0,0 +1,39 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file encoder_pool.h
+ * @~English
+ *
+ * @brief Definition of the encoder thread pool shared by compressions.
+ *
+ * These are private and should not be used outside the library.
+ */
+
+#ifndef _ENCODER_POOL_H_
+#define _ENCODER_POOL_H_
+
+#include "ktx.h"
+#include "basisu/encoder/basisu_enc.h"
+
+/*
+ * A ktxEncoderPool is a basisu::job_pool on which the batch functions run
+ * one job per texture. Each job calls the texture's encoder, which starts
+ * its own threads, so the pool schedules whole textures and not the work
+ * within a texture. ktxEtc1sCodebook_Create() uses a private pool as the
+ * basis_compressor's m_pJob_pool while training.
+ */
+struct ktxEncoderPool {
+    basisu::job_pool jobPool;
+
+    explicit ktxEncoderPool(ktx_uint32_t threadCount)
+        : jobPool(threadCount) { }
+};
+
+#endif /* _ENCODER_POOL_H_ */
@@ -0,0 +1,439 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file etc1s_codebook.cpp
+ * @~English
+ *
+ * @brief Loading, saving and setting ETC1S codebooks shared by a set of
+ *        textures.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "etc1s_codebook.h"
+
+/**
+ * @class ktxEtc1sCodebook
+ * @~English
+ * @brief ETC1S endpoint and selector codebooks shared by a set of textures.
+ *
+ * Every BasisLZ/ETC1S texture normally carries the endpoint and selector
+ * codebooks trained for it in its supercompression global data. For a set
+ * of related textures, e.g. terrain tiles, train the codebooks once on a
+ * sample of them with ktxEtc1sCodebook_Create() and encode each texture
+ * against them. That skips the clusterization, the most expensive part of
+ * the encode, and leaves the codebooks out of each file. Save them with
+ * ktxEtc1sCodebook_WriteToNamedFile() or ktxEtc1sCodebook_WriteToMemory()
+ * and, to transcode such a texture, load them and set them on it with
+ * ktxTexture2_SetEtc1sCodebook().
+ *
+ * @note ktxTexture2_CompressBasisEx() cannot encode against shared
+ * codebooks yet. Only training, saving, loading and transcoding are
+ * supported.
+ *
+ * A codebook is not modified after it is created so it may be used by any
+ * number of textures and threads at once. A texture encoded against shared
+ * codebooks records a hash of them in its @c KTX_ETC1S_CODEBOOK_KEY
+ * metadata so transcoding with the wrong ones fails instead of producing
+ * garbage.
+ */
+
+/*
+ * Header of a saved codebook. It is followed by the Huffman coded
+ * endpoints then the selectors. Values are little-endian.
+ */
+struct ktxEtc1sCodebookFileHeader {
+    ktx_uint8_t identifier[8];
+    ktx_uint32_t version;
+    ktx_uint32_t endpointCount;
+    ktx_uint32_t selectorCount;
+    ktx_uint32_t endpointsByteLength;
+    ktx_uint32_t selectorsByteLength;
+};
+
+static const ktx_uint8_t kIdentifier[8] = {
+    'K', 'T', 'X', 'e', 't', 'c', '1', 's'
+};
+static const ktx_uint32_t kFileVersion = 1;
+
+static void
+storeUint32(ktx_uint8_t* dst, ktx_uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        dst[i] = (ktx_uint8_t)(value >> (8 * i));
+}
+
+static ktx_uint32_t
+loadUint32(const ktx_uint8_t* src)
+{
+    ktx_uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value |= (ktx_uint32_t)src[i] << (8 * i);
+    return value;
+}
+
+/*
+ * 64-bit FNV-1a of @p size bytes at @p data, continuing from @p hash. It
+ * identifies codebooks, it doesn't need to resist deliberate collisions.
+ */
+static ktx_uint64_t
+fnv1a(ktx_uint64_t hash, const ktx_uint8_t* data, ktx_size_t size)
+{
+    for (ktx_size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * Set @p codebook->id to the hex of a hash of the counts and the coded
+ * endpoints and selectors, as saved by ktxEtc1sCodebook_WriteToMemory().
+ */
+static void
+setId(ktxEtc1sCodebook* codebook)
+{
+    ktx_uint8_t counts[8];
+    storeUint32(counts, codebook->endpointCount);
+    storeUint32(counts + 4, codebook->selectorCount);
+
+    ktx_uint64_t hash = fnv1a(0xcbf29ce484222325ULL, counts, sizeof(counts));
+    hash = fnv1a(hash, codebook->endpoints.data(), codebook->endpoints.size());
+    hash = fnv1a(hash, codebook->selectors.data(), codebook->selectors.size());
+
+    static const char hexDigits[] = "0123456789abcdef";
+    for (int i = 0; i < 16; i++)
+        codebook->id[i] = hexDigits[(hash >> (60 - 4 * i)) & 0xf];
+    codebook->id[16] = '\0';
+}
+
+/**
+ * @memberof ktxEtc1sCodebook @private
+ * @~English
+ * @brief Set the codebooks and decode them.
+ *
+ * @exception KTX_FILE_DATA_ERROR   The codebooks could not be decoded.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the codebooks.
+ */
+KTX_error_code
+ktxEtc1sCodebook_init(ktxEtc1sCodebook* codebook,
+                      ktx_uint32_t endpointCount,
+                      const ktx_uint8_t* endpoints, ktx_size_t endpointsSize,
+                      ktx_uint32_t selectorCount,
+                      const ktx_uint8_t* selectors, ktx_size_t selectorsSize)
+{
+    // See ktxTexture2_initTranscoder.
+    static const bool transcoderInitialized
+                                = (basist::basisu_transcoder_init(), true);
+    (void)transcoderInitialized;
+
+    if (!endpointCount || !selectorCount || !endpointsSize || !selectorsSize
+        || endpointsSize > UINT32_MAX || selectorsSize > UINT32_MAX)
+        return KTX_FILE_DATA_ERROR;
+
+    try {
+        codebook->endpoints.assign(endpoints, endpoints + endpointsSize);
+        codebook->selectors.assign(selectors, selectors + selectorsSize);
+        codebook->endpointCount = endpointCount;
+        codebook->selectorCount = selectorCount;
+        setId(codebook);
+        if (!codebook->transcoder.decode_palettes(
+                endpointCount, codebook->endpoints.data(),
+                (uint32_t)endpointsSize,
+                selectorCount, codebook->selectors.data(),
+                (uint32_t)selectorsSize))
+            return KTX_FILE_DATA_ERROR;
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Record the shared codebooks a texture was encoded against.
+ *
+ * Replaces any @c KTX_ETC1S_CODEBOOK_KEY metadata of @p This with the id
+ * of @p codebook. ktxTexture2_SetEtc1sCodebook() then only accepts
+ * codebooks with the same id for transcoding.
+ *
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the metadata.
+ */
+KTX_error_code
+ktxTexture2_setEtc1sCodebookKey(ktxTexture2* This,
+                                const ktxEtc1sCodebook* codebook)
+{
+    ktxHashList_DeleteKVPair(&This->kvDataHead, KTX_ETC1S_CODEBOOK_KEY);
+    return ktxHashList_AddKVPair(&This->kvDataHead, KTX_ETC1S_CODEBOOK_KEY,
+                                 sizeof(codebook->id), codebook->id);
+}
+
+extern "C" {
+
+/**
+ * @memberof ktxEtc1sCodebook
+ * @~English
+ * @brief Create codebooks from ones saved in memory.
+ *
+ * @param[in] bytes         pointer to the saved codebooks, as written by
+ *                          ktxEtc1sCodebook_WriteToMemory().
+ * @param[in] size          size of the data at @p bytes.
+ * @param[in,out] ppCodebook pointer to a location in which to store the
+ *                          handle of the new codebooks.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p bytes or @p ppCodebook is @c NULL.
+ * @exception KTX_UNKNOWN_FILE_FORMAT
+ *                                  The data are not saved codebooks.
+ * @exception KTX_FILE_DATA_ERROR   The codebooks are corrupt.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the codebooks.
+ */
+KTX_error_code
+ktxEtc1sCodebook_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
+                                  ktxEtc1sCodebook** ppCodebook)
+{
+    if (!bytes || !ppCodebook)
+        return KTX_INVALID_VALUE;
+    *ppCodebook = NULL;
+
+    if (size < sizeof(ktxEtc1sCodebookFileHeader)
+        || memcmp(bytes, kIdentifier, sizeof(kIdentifier)) != 0
+        || loadUint32(bytes + 8) != kFileVersion)
+        return KTX_UNKNOWN_FILE_FORMAT;
+
+    ktx_uint32_t endpointCount = loadUint32(bytes + 12);
+    ktx_uint32_t selectorCount = loadUint32(bytes + 16);
+    ktx_size_t endpointsByteLength = loadUint32(bytes + 20);
+    ktx_size_t selectorsByteLength = loadUint32(bytes + 24);
+    const ktx_uint8_t* endpoints = bytes + sizeof(ktxEtc1sCodebookFileHeader);
+    if (size - sizeof(ktxEtc1sCodebookFileHeader)
+        < endpointsByteLength + selectorsByteLength)
+        return KTX_FILE_DATA_ERROR;
+
+    ktxEtc1sCodebook* codebook = new (std::nothrow) ktxEtc1sCodebook;
+    if (!codebook)
+        return KTX_OUT_OF_MEMORY;
+    KTX_error_code result = ktxEtc1sCodebook_init(codebook,
+                                endpointCount, endpoints, endpointsByteLength,
+                                selectorCount, endpoints + endpointsByteLength,
+                                selectorsByteLength);
+    if (result != KTX_SUCCESS) {
+        delete codebook;
+        return result;
+    }
+    *ppCodebook = codebook;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxEtc1sCodebook
+ * @~English
+ * @brief Create codebooks from ones saved in a named file.
+ *
+ * The file name must be encoded in utf-8. On Windows convert unicode names
+ * to utf-8 with @c WideCharToMultiByte(CP_UTF8, ...) before calling.
+ *
+ * @param[in] filename      pointer to a char array containing the file name.
+ * @param[in,out] ppCodebook pointer to a location in which to store the
+ *                          handle of the new codebooks.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p filename or @p ppCodebook is @c NULL.
+ * @exception KTX_FILE_OPEN_FAILED  The file could not be opened.
+ * @exception KTX_FILE_READ_ERROR   An error occurred while reading the file.
+ *
+ * For other exceptions, see ktxEtc1sCodebook_CreateFromMemory().
+ */
+KTX_error_code
+ktxEtc1sCodebook_CreateFromNamedFile(const char* const filename,
+                                     ktxEtc1sCodebook** ppCodebook)
+{
+    if (!filename || !ppCodebook)
+        return KTX_INVALID_VALUE;
+    *ppCodebook = NULL;
+
+    FILE* f = ktxFOpenUTF8(filename, "rb");
+    if (!f)
+        return KTX_FILE_OPEN_FAILED;
+
+    KTX_error_code result = KTX_FILE_READ_ERROR;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        size = ftell(f);
+        if (fseek(f, 0, SEEK_SET) != 0)
+            size = -1;
+    }
+    if (size >= 0) {
+        ktx_uint8_t* bytes = (ktx_uint8_t*)malloc(size ? size : 1);
+        if (!bytes)
+            result = KTX_OUT_OF_MEMORY;
+        else if (fread(bytes, 1, size, f) == (size_t)size)
+            result = ktxEtc1sCodebook_CreateFromMemory(bytes, size,
+                                                       ppCodebook);
+        free(bytes);
+    }
+    fclose(f);
+    return result;
+}
+
+/**
+ * @memberof ktxEtc1sCodebook
+ * @~English
+ * @brief Save codebooks to a block of memory.
+ *
+ * The memory is allocated by the library. The caller must free it.
+ *
+ * @param[in] codebook      handle of the codebooks to save.
+ * @param[in,out] ppDstBytes pointer to a location in which to store the
+ *                          address of the block of memory.
+ * @param[in,out] pSize     pointer to a location in which to store the size
+ *                          of the data.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     Any of the parameters is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the data.
+ */
+KTX_error_code
+ktxEtc1sCodebook_WriteToMemory(ktxEtc1sCodebook* codebook,
+                               ktx_uint8_t** ppDstBytes, ktx_size_t* pSize)
+{
+    if (!codebook || !ppDstBytes || !pSize)
+        return KTX_INVALID_VALUE;
+
+    const ktx_size_t headerSize = sizeof(ktxEtc1sCodebookFileHeader);
+    ktx_size_t size = headerSize + codebook->endpoints.size()
+                    + codebook->selectors.size();
+    ktx_uint8_t* bytes = (ktx_uint8_t*)malloc(size);
+    if (!bytes)
+        return KTX_OUT_OF_MEMORY;
+
+    memcpy(bytes, kIdentifier, sizeof(kIdentifier));
+    storeUint32(bytes + 8, kFileVersion);
+    storeUint32(bytes + 12, codebook->endpointCount);
+    storeUint32(bytes + 16, codebook->selectorCount);
+    storeUint32(bytes + 20, (ktx_uint32_t)codebook->endpoints.size());
+    storeUint32(bytes + 24, (ktx_uint32_t)codebook->selectors.size());
+    memcpy(bytes + headerSize, codebook->endpoints.data(),
+           codebook->endpoints.size());
+    memcpy(bytes + headerSize + codebook->endpoints.size(),
+           codebook->selectors.data(), codebook->selectors.size());
+
+    *ppDstBytes = bytes;
+    *pSize = size;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxEtc1sCodebook
+ * @~English
+ * @brief Save codebooks to a named file.
+ *
+ * The file name must be encoded in utf-8. On Windows convert unicode names
+ * to utf-8 with @c WideCharToMultiByte(CP_UTF8, ...) before calling.
+ *
+ * @param[in] codebook      handle of the codebooks to save.
+ * @param[in] dstname       pointer to a char array containing the file name.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p codebook or @p dstname is @c NULL.
+ * @exception KTX_FILE_OPEN_FAILED  The file could not be opened.
+ * @exception KTX_FILE_WRITE_ERROR  An error occurred while writing the file.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the data.
+ */
+KTX_error_code
+ktxEtc1sCodebook_WriteToNamedFile(ktxEtc1sCodebook* codebook,
+                                  const char* const dstname)
+{
+    if (!codebook || !dstname)
+        return KTX_INVALID_VALUE;
+
+    ktx_uint8_t* bytes;
+    ktx_size_t size;
+    KTX_error_code result = ktxEtc1sCodebook_WriteToMemory(codebook, &bytes,
+                                                           &size);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    FILE* f = ktxFOpenUTF8(dstname, "wb");
+    if (!f) {
+        free(bytes);
+        return KTX_FILE_OPEN_FAILED;
+    }
+    bool ok = fwrite(bytes, 1, size, f) == size;
+    ok = (fclose(f) == 0) && ok;
+    free(bytes);
+    return ok ? KTX_SUCCESS : KTX_FILE_WRITE_ERROR;
+}
+
+/**
+ * @memberof ktxEtc1sCodebook
+ * @~English
+ * @brief Destroy codebooks.
+ *
+ * No texture may still have them set.
+ *
+ * @param[in] codebook  handle of the codebooks to destroy. May be @c NULL.
+ */
+void
+ktxEtc1sCodebook_Destroy(ktxEtc1sCodebook* codebook)
+{
+    delete codebook;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Set the ETC1S codebooks of a texture encoded against shared ones.
+ *
+ * A BasisLZ/ETC1S texture encoded against shared codebooks has no
+ * codebooks of its own and records the id of the ones it was encoded
+ * against in its @c KTX_ETC1S_CODEBOOK_KEY metadata. Transcoding it fails
+ * with @c KTX_INVALID_OPERATION until codebooks with that id are set with
+ * this. The metadata is needed to recognize such a texture so it must not
+ * be created with @c KTX_TEXTURE_CREATE_SKIP_KVDATA_BIT or
+ * @c KTX_TEXTURE_CREATE_RAW_KVDATA_BIT. The codebooks are ignored for
+ * other textures.
+ *
+ * The texture keeps only a pointer to @p codebook. It neither copies the
+ * codebooks nor takes ownership of them, and no reference is counted. The
+ * caller must keep @p codebook alive until the texture is destroyed or
+ * the codebooks are detached by setting @c NULL. Copies made with
+ * ktxTexture2_CreateCopy() share the pointer, so this applies to them
+ * too. Whether the codebooks match is checked when transcoding, not here.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] codebook  the codebooks to use or @c NULL.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This is @c NULL.
+ */
+KTX_error_code
+ktxTexture2_SetEtc1sCodebook(ktxTexture2* This, ktxEtc1sCodebook* codebook)
+{
+    if (This == NULL)
+        return KTX_INVALID_VALUE;
+
+    This->_private->_etc1sCodebook = codebook;
+    return KTX_SUCCESS;
+}
+
+}
@@ -0,0 +1,67 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file etc1s_codebook.h
+ * @~English
+ *
+ * @brief Definition of the ETC1S codebooks shared by a set of textures.
+ *
+ * These are private and should not be used outside the library.
+ */
+
+#ifndef _ETC1S_CODEBOOK_H_
+#define _ETC1S_CODEBOOK_H_
+
+#include "ktx.h"
+#include "basisu/transcoder/basisu_transcoder.h"
+
+#include <vector>
+
+/*
+ * The codebooks are kept both in the Huffman coded form they are saved in,
+ * which is also what the BasisLZ global data of a texture would hold, and
+ * decoded. The Basis encoder and the BasisLZ transcoder both take
+ * &transcoder as their global codebooks. id, a hash of the coded
+ * codebooks, is what a texture encoded against them records in its
+ * KTX_ETC1S_CODEBOOK_KEY metadata.
+ */
+struct ktxEtc1sCodebook {
+    ktx_uint32_t endpointCount;
+    ktx_uint32_t selectorCount;
+    std::vector<ktx_uint8_t> endpoints;
+    std::vector<ktx_uint8_t> selectors;
+    basist::basisu_lowlevel_etc1s_transcoder transcoder;
+    char id[17];
+
+    ktxEtc1sCodebook() : endpointCount(0), selectorCount(0), id() { }
+};
+
+/*
+ * Set @p codebook to the given Huffman coded endpoints and selectors and
+ * decode them.
+ */
+KTX_error_code
+ktxEtc1sCodebook_init(ktxEtc1sCodebook* codebook,
+                      ktx_uint32_t endpointCount,
+                      const ktx_uint8_t* endpoints, ktx_size_t endpointsSize,
+                      ktx_uint32_t selectorCount,
+                      const ktx_uint8_t* selectors, ktx_size_t selectorsSize);
+
+/*
+ * Record in @p This's metadata that it was encoded against @p codebook.
+ * An encoder that leaves the codebooks out of a texture's global data
+ * must call this so the transcoder can tell the right codebooks from
+ * others with the same endpoint and selector counts.
+ */
+KTX_error_code
+ktxTexture2_setEtc1sCodebookKey(ktxTexture2* This,
+                                const ktxEtc1sCodebook* codebook);
+
+#endif /* _ETC1S_CODEBOOK_H_ */
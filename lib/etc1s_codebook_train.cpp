@@ -0,0 +1,210 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file etc1s_codebook_train.cpp
+ * @~English
+ *
+ * @brief Training ETC1S codebooks shared by a set of textures.
+ */
+
+#include <new>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "vkformat_enum.h"
+#include "encoder_pool.h"
+#include "etc1s_codebook.h"
+#include "basisu/encoder/basisu_comp.h"
+#include "basisu/transcoder/basisu_file_headers.h"
+
+/*
+ * Number of components of the formats that can be trained on, or 0 for
+ * any other format.
+ */
+static ktx_uint32_t
+trainingComponentCount(const ktxTexture2* texture)
+{
+    if (texture->supercompressionScheme != KTX_SS_NONE)
+        return 0;
+    switch (texture->vkFormat) {
+      case VK_FORMAT_R8_UNORM:
+      case VK_FORMAT_R8_SRGB:
+        return 1;
+      case VK_FORMAT_R8G8_UNORM:
+      case VK_FORMAT_R8G8_SRGB:
+        return 2;
+      case VK_FORMAT_R8G8B8_UNORM:
+      case VK_FORMAT_R8G8B8_SRGB:
+        return 3;
+      case VK_FORMAT_R8G8B8A8_UNORM:
+      case VK_FORMAT_R8G8B8A8_SRGB:
+        return 4;
+      default:
+        return 0;
+    }
+}
+
+/*
+ * Append every image of @p texture, each level, layer, face and depth
+ * slice, to @p images.
+ */
+static void
+appendImages(ktxTexture2* texture, ktx_uint32_t componentCount,
+             basisu::vector<basisu::image>& images)
+{
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_uint32_t width = MAX(1, texture->baseWidth >> level);
+        ktx_uint32_t height = MAX(1, texture->baseHeight >> level);
+        ktx_uint32_t faceSlices = texture->numFaces == 6
+                                ? 6 : MAX(1, texture->baseDepth >> level);
+        for (ktx_uint32_t layer = 0; layer < texture->numLayers; layer++) {
+            for (ktx_uint32_t faceSlice = 0; faceSlice < faceSlices;
+                 faceSlice++) {
+                ktx_size_t offset;
+                ktxTexture_GetImageOffset(ktxTexture(texture), level, layer,
+                                          faceSlice, &offset);
+                images.push_back(basisu::image());
+                images.back().init(texture->pData + offset, width, height,
+                                   componentCount);
+            }
+        }
+    }
+}
+
+extern "C" {
+
+/**
+ * @memberof ktxEtc1sCodebook
+ * @ingroup writer
+ * @~English
+ * @brief Train ETC1S codebooks on a sample of related textures.
+ *
+ * Every image of every sample texture is used. The codebooks are trained
+ * the way ktxTexture2_CompressBasisEx() trains those for a single texture
+ * so @p params->qualityLevel, @p params->maxEndpoints,
+ * @p params->maxSelectors and @p params->compressionLevel control their
+ * size and quality. As the codebooks must cover every texture later
+ * encoded against them, give enough endpoints and selectors for the whole
+ * set. @p params->threadCount controls threading. The remaining
+ * parameters, such as swizzles and normal map mode, do not transform the
+ * samples so apply them to the samples beforehand if needed. The transfer
+ * function of the first sample selects perceptual or linear error metrics.
+ *
+ * @param[in]     samples       array of pointers to the sample textures.
+ * @param[in]     sampleCount   number of textures in @p samples.
+ * @param[in]     params        pointer to Basis params object.
+ * @param[in,out] ppCodebook    pointer to a location in which to store the
+ *                              handle of the new codebooks.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p samples, @p params or @p ppCodebook is
+ *                              @c NULL, @p sampleCount is 0, an element of
+ *                              @p samples is @c NULL or
+ *                              @p params->structSize is not correct.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p params->uastc is set, a sample's image
+ *                              data is not loaded or a sample is not in an
+ *                              uncompressed 8-bit R, RG, RGB or RGBA format.
+ * @exception KTX_INVALID_OPERATION
+ *                              Training failed.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for training.
+ */
+KTX_error_code
+ktxEtc1sCodebook_Create(ktxTexture2** samples, ktx_uint32_t sampleCount,
+                        ktxBasisParams* params, ktxEtc1sCodebook** ppCodebook)
+{
+    if (!samples || !sampleCount || !params || !ppCodebook)
+        return KTX_INVALID_VALUE;
+    if (params->structSize != sizeof(ktxBasisParams))
+        return KTX_INVALID_VALUE;
+    *ppCodebook = NULL;
+    if (params->uastc)
+        return KTX_INVALID_OPERATION;
+    for (ktx_uint32_t i = 0; i < sampleCount; i++) {
+        if (!samples[i])
+            return KTX_INVALID_VALUE;
+        if (!samples[i]->pData || !trainingComponentCount(samples[i]))
+            return KTX_INVALID_OPERATION;
+    }
+
+    basisu::basisu_encoder_init();
+
+    ktxEncoderPool* pool;
+    KTX_error_code result = ktxEncoderPool_Create(params->threadCount, &pool);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktxEtc1sCodebook* codebook = NULL;
+    try {
+        basisu::basis_compressor_params cparams;
+        for (ktx_uint32_t i = 0; i < sampleCount; i++) {
+            appendImages(samples[i], trainingComponentCount(samples[i]),
+                         cparams.m_source_images);
+        }
+        cparams.m_tex_type = basist::cBASISTexType2D;
+        cparams.m_uastc = false;
+        cparams.m_mip_gen = false;
+        cparams.m_status_output = params->verbose;
+        cparams.m_perceptual = ktxTexture2_GetOETF(samples[0])
+                               == KHR_DF_TRANSFER_SRGB;
+        cparams.m_compression_level = (int)params->compressionLevel;
+        if (params->qualityLevel) {
+            cparams.m_quality_level = (int)params->qualityLevel;
+        } else {
+            cparams.m_max_endpoint_clusters = params->maxEndpoints;
+            cparams.m_max_selector_clusters = params->maxSelectors;
+        }
+        if (params->endpointRDOThreshold > 0)
+            cparams.m_endpoint_rdo_thresh = params->endpointRDOThreshold;
+        if (params->selectorRDOThreshold > 0)
+            cparams.m_selector_rdo_thresh = params->selectorRDOThreshold;
+        cparams.m_no_endpoint_rdo = params->noEndpointRDO;
+        cparams.m_no_selector_rdo = params->noSelectorRDO;
+        cparams.m_multithreading = pool->jobPool.get_total_threads() > 1;
+        cparams.m_pJob_pool = &pool->jobPool;
+
+        basisu::basis_compressor compressor;
+        if (!compressor.init(cparams)
+            || compressor.process() != basisu::basis_compressor::cECSuccess) {
+            result = KTX_INVALID_OPERATION;
+        } else {
+            // The codebooks are the same as in a .basis file's header.
+            const basisu::uint8_vec& basisFile
+                                        = compressor.get_output_basis_file();
+            const basist::basis_file_header& header
+                = *reinterpret_cast<const basist::basis_file_header*>(
+                                                         basisFile.data());
+            codebook = new ktxEtc1sCodebook;
+            result = ktxEtc1sCodebook_init(codebook,
+                        header.m_total_endpoints,
+                        basisFile.data() + header.m_endpoint_cb_file_ofs,
+                        header.m_endpoint_cb_file_size,
+                        header.m_total_selectors,
+                        basisFile.data() + header.m_selector_cb_file_ofs,
+                        header.m_selector_cb_file_size);
+            if (result == KTX_FILE_DATA_ERROR)
+                result = KTX_INVALID_OPERATION;
+        }
+    } catch (std::bad_alloc&) {
+        result = KTX_OUT_OF_MEMORY;
+    }
+
+    ktxEncoderPool_Destroy(pool);
+    if (result != KTX_SUCCESS) {
+        delete codebook;
+        return result;
+    }
+    *ppCodebook = codebook;
+    return KTX_SUCCESS;
+}
+
+}
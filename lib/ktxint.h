@@ -228,7 +228,8 @@ ktx_size_t ktxCompressZLIBBounds(ktx_size_t srcLength);
  *
  * Compresses data using miniz (ZLIB)
  */
-KTX_error_code ktxCompressZLIBInt(unsigned char* pDest,
+KTX_error_code ktxCompressZLIBInt(ktxContext* context,
+                                  unsigned char* pDest,
                                   ktx_size_t* pDestLength,
                                   const unsigned char* pSrc,
                                   ktx_size_t srcLength,
@@ -240,11 +241,91 @@ KTX_error_code ktxCompressZLIBInt(unsigned char* pDest,
  *
  * Uncompresses data using miniz (ZLIB)
  */
-KTX_error_code ktxUncompressZLIBInt(unsigned char* pDest,
+KTX_error_code ktxUncompressZLIBInt(ktxContext* context,
+                                    unsigned char* pDest,
                                     ktx_size_t* pDestLength,
                                     const unsigned char* pSrc,
                                     ktx_size_t srcLength);
 
+/*
+ * @internal
+ * PFNKTXPARALLELJOB
+ *
+ * Job callback for ktxParallel_for. threadIndex is < the threadCount
+ * given to ktxParallel_for.
+ */
+typedef KTX_error_code (*PFNKTXPARALLELJOB)(ktx_uint32_t jobIndex,
+                                            ktx_uint32_t threadIndex,
+                                            void* userdata);
+
+/*
+ * @internal
+ * ktxParallel_threadCount
+ *
+ * Returns the number of threads to use for jobCount jobs. 0 requested
+ * means the number of hardware threads.
+ */
+ktx_uint32_t ktxParallel_threadCount(ktx_uint32_t requested,
+                                     ktx_uint32_t jobCount);
+
+/*
+ * @internal
+ * ktxParallel_for
+ *
+ * Runs jobCount independent jobs on up to threadCount threads, including
+ * the calling thread.
+ */
+KTX_error_code ktxParallel_for(ktx_uint32_t jobCount,
+                               ktx_uint32_t threadCount,
+                               PFNKTXPARALLELJOB job, void* userdata);
+
+/*
+ * @internal
+ * ktxWorker
+ *
+ * A background thread that runs submitted jobs one at a time in the
+ * order they were submitted. Destroying it runs the remaining jobs then
+ * joins the thread, or, when destroyed by one of its own jobs, detaches it.
+ */
+typedef struct ktxWorker ktxWorker;
+typedef void (*PFNKTXWORKERJOB)(void* userdata);
+
+KTX_error_code ktxWorker_create(ktxWorker** ppWorker);
+KTX_error_code ktxWorker_submit(ktxWorker* worker, PFNKTXWORKERJOB job,
+                                void* userdata);
+void ktxWorker_destroy(ktxWorker* worker);
+
+/*
+ * @internal
+ * ktxEvent
+ *
+ * A flag set once by one thread and waited for by others.
+ */
+typedef struct ktxEvent ktxEvent;
+
+ktxEvent* ktxEvent_create(void);
+void ktxEvent_set(ktxEvent* event);
+ktx_bool_t ktxEvent_isSet(ktxEvent* event);
+void ktxEvent_wait(ktxEvent* event);
+void ktxEvent_destroy(ktxEvent* event);
+
+/*
+ * @internal
+ * ktxContext
+ *
+ * Acquire and release pooled Zstd contexts and scratch buffers. With a
+ * NULL context acquire creates the object and release destroys it.
+ */
+struct ZSTD_DCtx_s;
+struct ZSTD_CCtx_s;
+
+struct ZSTD_DCtx_s* ktxContext_acquireDCtx(ktxContext* context);
+void ktxContext_releaseDCtx(ktxContext* context, struct ZSTD_DCtx_s* dctx);
+struct ZSTD_CCtx_s* ktxContext_acquireCCtx(ktxContext* context);
+void ktxContext_releaseCCtx(ktxContext* context, struct ZSTD_CCtx_s* cctx);
+void* ktxContext_acquireBuffer(ktxContext* context, ktx_size_t size);
+void ktxContext_releaseBuffer(ktxContext* context, void* pBuffer);
+
 /*
  * Pad nbytes to next multiple of n
  */
@@ -220,6 +220,36 @@ ktxMem_expand(ktxMem *pMem, const ktx_size_t newsize)
     return KTX_SUCCESS;
 }
 
+/**
+ * @~English
+ * @brief Allocate exactly enough memory for a ktxMem to hold @p size bytes.
+ *
+ * Does nothing if the allocation is already at least @p size bytes.
+ *
+ * @param [in] pMem          pointer to ktxMem struct to expand.
+ * @param [in] size          size required.
+ *
+ * @return     KTX_SUCCESS on success, KTX_OUT_OF_MEMORY on error.
+ *
+ * @exception  KTX_OUT_OF_MEMORY    System failed to allocate sufficient pMemory.
+ */
+static KTX_error_code
+ktxMem_reserve(ktxMem *pMem, const ktx_size_t size)
+{
+    ktx_uint8_t* bytes;
+
+    if (size <= pMem->alloc_size)
+        return KTX_SUCCESS;
+
+    bytes = (ktx_uint8_t*)realloc(pMem->bytes, size);
+    if (!bytes)
+        return KTX_OUT_OF_MEMORY;
+
+    pMem->bytes = bytes;
+    pMem->alloc_size = size;
+    return KTX_SUCCESS;
+}
+
 /**
  * @~English
  * @brief Read bytes from a ktxMemStream.
@@ -499,6 +529,35 @@ KTX_error_code ktxMemStream_construct(ktxStream* str,
     return result;
 }
 
+/**
+ * @~English
+ * @brief Allocate memory for a read-write ktxMemStream to hold @p size bytes.
+ *
+ * Lets a writer that knows how much it will write avoid the stream's
+ * repeated doubling of its memory as data is written.
+ *
+ * @param [in] str      pointer to the ktxStream.
+ * @param [in] size     number of bytes to allocate.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p str is @c NULL.
+ * @exception KTX_INVALID_OPERATION @p str is a read-only stream.
+ * @exception KTX_OUT_OF_MEMORY     system failed to allocate sufficient memory.
+ */
+KTX_error_code ktxMemStream_reserve(ktxStream* str, const ktx_size_t size)
+{
+    ktxMem* mem;
+
+    if (!str || (mem = str->data.mem) == 0)
+        return KTX_INVALID_VALUE;
+
+    if (mem->robytes)
+        return KTX_INVALID_OPERATION; /* read-only */
+
+    return ktxMem_reserve(mem, size);
+}
+
 /**
  * @~English
  * @brief Initialize a read-only ktxMemStream.
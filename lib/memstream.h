@@ -36,6 +36,11 @@ KTX_error_code ktxMemStream_construct(ktxStream* str,
 KTX_error_code ktxMemStream_construct_ro(ktxStream* str,
                                          const ktx_uint8_t* pBytes,
                                          const ktx_size_t size);
+/*
+ * Allocate memory for a read-write ktxMemStream to hold a known amount
+ * of data.
+ */
+KTX_error_code ktxMemStream_reserve(ktxStream* str, const ktx_size_t size);
 void ktxMemStream_destruct(ktxStream* str);
 
 KTX_error_code ktxMemStream_getdata(ktxStream* str, ktx_uint8_t** ppBytes);
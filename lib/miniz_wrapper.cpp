@@ -21,6 +21,7 @@
 #include "ktxint.h"
 
 #include <assert.h>
+#include <string.h>
 
 #if !KTX_FEATURE_WRITE
 // The reader does not link with the basisu components that already include a
@@ -39,17 +40,40 @@
 // This is needed because while miniz is defined as a header in basisu it's
 // not declaring the functions as static or inline, hence causing multiple
 // conflicting definitions at link-time.
-namespace buminiz {
-    typedef unsigned long mz_ulong;
-    enum { MZ_OK = 0, MZ_STREAM_END = 1, MZ_NEED_DICT = 2, MZ_ERRNO = -1, MZ_STREAM_ERROR = -2, MZ_DATA_ERROR = -3, MZ_MEM_ERROR = -4, MZ_BUF_ERROR = -5, MZ_VERSION_ERROR = -6, MZ_PARAM_ERROR = -10000 };
-    mz_ulong mz_compressBound(mz_ulong source_len);
-    int mz_compress2(unsigned char *pDest, mz_ulong *pDest_len, const unsigned char *pSource, mz_ulong source_len, int level);
-    int mz_uncompress(unsigned char *pDest, mz_ulong *pDest_len, const unsigned char *pSource, mz_ulong source_len);
-}
+#define MINIZ_HEADER_FILE_ONLY
+#include "basisu/encoder/basisu_miniz.h"
+#undef MINIZ_HEADER_FILE_ONLY
 #endif
 
 using namespace buminiz;
 
+/*
+ * miniz allocation callbacks taking the inflater's and deflater's state from
+ * a ktxContext so it is not allocated afresh, and zeroed, for every level.
+ */
+static void*
+ktxContext_mzAlloc(void* opaque, size_t items, size_t size)
+{
+    return ktxContext_acquireBuffer((ktxContext*)opaque, items * size);
+}
+
+static void
+ktxContext_mzFree(void* opaque, void* address)
+{
+    ktxContext_releaseBuffer((ktxContext*)opaque, address);
+}
+
+static void
+ktxContext_initMzStream(ktxContext* context, mz_stream* stream)
+{
+    memset(stream, 0, sizeof(*stream));
+    if (context) {
+        stream->zalloc = ktxContext_mzAlloc;
+        stream->zfree = ktxContext_mzFree;
+        stream->opaque = context;
+    }
+}
+
 extern "C" {
 
 /**
@@ -70,6 +94,10 @@ ktx_size_t ktxCompressZLIBBounds(ktx_size_t srcLength) {
  * @~English
  * @brief Compresses data using miniz (ZLIB)
  *
+ * This is mz_compress2() with the deflater's state taken from @p context.
+ *
+ * @param context       context from which to take scratch memory. May be
+ *                      @c NULL.
  * @param pDest         destination data buffer
  * @param pDestLength   destination data buffer size
  *                      (filled with written byte count on success)
@@ -79,17 +107,34 @@ ktx_size_t ktxCompressZLIBBounds(ktx_size_t srcLength) {
  *
  * @author Daniel Rakos, RasterGrid
  */
-KTX_error_code ktxCompressZLIBInt(unsigned char* pDest,
+KTX_error_code ktxCompressZLIBInt(ktxContext* context,
+                                  unsigned char* pDest,
                                   ktx_size_t* pDestLength,
                                   const unsigned char* pSrc,
                                   ktx_size_t srcLength,
                                   ktx_uint32_t level) {
     if ((srcLength | *pDestLength) > 0xFFFFFFFFU) return KTX_INVALID_VALUE;
-    mz_ulong mzCompressedSize = (mz_ulong)*pDestLength;
-    int status = mz_compress2(pDest, &mzCompressedSize, pSrc, (mz_ulong)srcLength, level);
+    mz_stream stream;
+    ktxContext_initMzStream(context, &stream);
+    stream.next_in = pSrc;
+    stream.avail_in = (mz_uint32)srcLength;
+    stream.next_out = pDest;
+    stream.avail_out = (mz_uint32)*pDestLength;
+
+    int status = mz_deflateInit(&stream, level);
+    if (status == MZ_OK) {
+        status = mz_deflate(&stream, MZ_FINISH);
+        if (status == MZ_STREAM_END) {
+            status = mz_deflateEnd(&stream);
+        } else {
+            mz_deflateEnd(&stream);
+            if (status == MZ_OK)
+                status = MZ_BUF_ERROR;
+        }
+    }
     switch (status) {
     case MZ_OK:
-        *pDestLength = mzCompressedSize;
+        *pDestLength = stream.total_out;
         return KTX_SUCCESS;
     case MZ_PARAM_ERROR:
         return KTX_INVALID_VALUE;
@@ -118,6 +163,10 @@ KTX_error_code ktxCompressZLIBInt(unsigned char* pDest,
  * @~English
  * @brief Uncompresses data using miniz (ZLIB)
  *
+ * This is mz_uncompress() with the inflater's state taken from @p context.
+ *
+ * @param context       context from which to take scratch memory. May be
+ *                      @c NULL.
  * @param pDest         destination data buffer
  * @param pDestLength   destination data buffer size
  *                      (filled with written byte count on success)
@@ -126,16 +175,33 @@ KTX_error_code ktxCompressZLIBInt(unsigned char* pDest,
  *
  * @author Daniel Rakos, RasterGrid
  */
-KTX_error_code ktxUncompressZLIBInt(unsigned char* pDest,
+KTX_error_code ktxUncompressZLIBInt(ktxContext* context,
+                                    unsigned char* pDest,
                                     ktx_size_t* pDestLength,
                                     const unsigned char* pSrc,
                                     ktx_size_t srcLength) {
     if ((srcLength | *pDestLength) > 0xFFFFFFFFU) return KTX_INVALID_VALUE;
-    mz_ulong mzUncompressedSize = (mz_ulong)*pDestLength;
-    int status = mz_uncompress(pDest, &mzUncompressedSize, pSrc, (mz_ulong)srcLength);
+    mz_stream stream;
+    ktxContext_initMzStream(context, &stream);
+    stream.next_in = pSrc;
+    stream.avail_in = (mz_uint32)srcLength;
+    stream.next_out = pDest;
+    stream.avail_out = (mz_uint32)*pDestLength;
+
+    int status = mz_inflateInit(&stream);
+    if (status == MZ_OK) {
+        status = mz_inflate(&stream, MZ_FINISH);
+        if (status == MZ_STREAM_END) {
+            status = mz_inflateEnd(&stream);
+        } else {
+            mz_inflateEnd(&stream);
+            if (status == MZ_BUF_ERROR && !stream.avail_in)
+                status = MZ_DATA_ERROR;
+        }
+    }
     switch (status) {
     case MZ_OK:
-        *pDestLength = mzUncompressedSize;
+        *pDestLength = stream.total_out;
         return KTX_SUCCESS;
     case MZ_BUF_ERROR:
         return KTX_DECOMPRESS_LENGTH_ERROR; // buffer too small
@@ -0,0 +1,44 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file mktranscodertables.cpp
+ * @~English
+ *
+ * @brief Build-time generator for the Basis Universal transcoder lookup
+ *        tables that basisu_transcoder_init() would otherwise compute.
+ *
+ * Usage: mktranscodertables <output .inc file>
+ *
+ * The transcoder is compiled into this program, rather than linked, so it can
+ * be built with BASISD_WRITE_NEW_INIT_TABLES while taking every other BASISD_*
+ * setting from libktx. See cmake/transcodertables.cmake.
+ */
+
+#undef BASISD_USE_BAKED_INIT_TABLES
+#define BASISD_USE_BAKED_INIT_TABLES 0
+#undef BASISD_WRITE_NEW_INIT_TABLES
+#define BASISD_WRITE_NEW_INIT_TABLES 1
+#include "basisu_transcoder.cpp"
+
+#include <stdio.h>
+
+int
+main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <output file>\n", argv[0]);
+        return 1;
+    }
+    if (!basist::basisu_transcoder_write_init_tables(argv[1])) {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,410 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @~English
+ *
+ * @brief Implementation of a read-only ktxStream for memory-mapped files.
+ *
+ * The whole file is mapped private and copy-on-write so pointers into the
+ * mapping can be handed out as writable image data without the writes
+ * reaching the file.
+ */
+
+#if !defined(_WIN32)
+  #define _DEFAULT_SOURCE 1  // For declaration of madvise.
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+  #include <io.h>
+  #define KTX_MMAP_SUPPORTED 1
+#elif defined(__unix__) || defined(__APPLE__) || defined(__EMSCRIPTEN__)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/types.h>
+  #include <unistd.h>
+  #define KTX_MMAP_SUPPORTED 1
+#else
+  #define KTX_MMAP_SUPPORTED 0
+#endif
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "mmapstream.h"
+#include "unused.h"
+
+/**
+ * @~English
+ * @brief Read bytes from a ktxMmapStream.
+ *
+ * @param [in]  str     pointer to the ktxStream from which to read.
+ * @param [out] dst     pointer to a block of memory with a size
+ *                      of at least @p count bytes, converted to a void*.
+ * @param [in]  count   total count of bytes to be read.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p dst is @c NULL.
+ * @exception KTX_FILE_UNEXPECTED_EOF not enough data to satisfy the request.
+ */
+static KTX_error_code
+ktxMmapStream_read(ktxStream* str, void* dst, const ktx_size_t count)
+{
+    if (!str || !dst)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMmap);
+
+    if (count > str->data.mapped.size - str->data.mapped.pos)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    memcpy(dst, str->data.mapped.address + str->data.mapped.pos, count);
+    str->data.mapped.pos += count;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Skip bytes in a ktxMmapStream.
+ *
+ * @param [in] str           pointer to the ktxStream on which to operate.
+ * @param [in] count         number of bytes to skip.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str is @c NULL.
+ * @exception KTX_FILE_UNEXPECTED_EOF not enough data to satisfy the request.
+ */
+static KTX_error_code
+ktxMmapStream_skip(ktxStream* str, const ktx_size_t count)
+{
+    if (!str)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMmap);
+
+    if (count > str->data.mapped.size - str->data.mapped.pos)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    str->data.mapped.pos += count;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Write bytes to a ktxMmapStream.
+ *
+ * ktxMmapStreams are read-only so this always fails.
+ *
+ * @return      KTX_INVALID_OPERATION.
+ */
+static KTX_error_code
+ktxMmapStream_write(ktxStream* str, const void* src,
+                    const ktx_size_t size, const ktx_size_t count)
+{
+    UNUSED(str);
+    UNUSED(src);
+    UNUSED(size);
+    UNUSED(count);
+
+    return KTX_INVALID_OPERATION;
+}
+
+/**
+ * @~English
+ * @brief Get the current read position in a ktxMmapStream.
+ *
+ * @param [in] str      pointer to the ktxStream to query.
+ * @param [in,out] pos  pointer to variable to receive the offset value.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p pos is @c NULL.
+ */
+static KTX_error_code
+ktxMmapStream_getpos(ktxStream* str, ktx_off_t* const pos)
+{
+    if (!str || !pos)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMmap);
+
+    *pos = (ktx_off_t)str->data.mapped.pos;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Set the current read position in a ktxMmapStream.
+ *
+ * Offset of 0 is the start of the file.
+ *
+ * @param [in] str    pointer to the ktxStream whose read position is to be set.
+ * @param [in] pos    the offset value to set.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str is @c NULL.
+ * @exception KTX_INVALID_OPERATION @p pos is > the size of the file.
+ */
+static KTX_error_code
+ktxMmapStream_setpos(ktxStream* str, const ktx_off_t pos)
+{
+    if (!str)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMmap);
+
+    if ((ktx_size_t)pos > str->data.mapped.size)
+        return KTX_INVALID_OPERATION;
+
+    str->data.mapped.pos = (ktx_size_t)pos;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Get the size of a ktxMmapStream in bytes.
+ *
+ * @param [in] str       pointer to the ktxStream whose size is to be queried.
+ * @param [in,out] size  pointer to a variable in which size will be written.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p size is @c NULL.
+ */
+static KTX_error_code
+ktxMmapStream_getsize(ktxStream* str, ktx_size_t* const size)
+{
+    if (!str || !size)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMmap);
+
+    *size = str->data.mapped.size;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Map the whole of a file, private and copy-on-write.
+ *
+ * @param [in] file      the file to map.
+ * @param [out] ppAddress pointer to a variable to receive the address of the
+ *                        mapping.
+ * @param [out] pSize     pointer to a variable to receive the size of the
+ *                        mapping.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_ISPIPE the file is not a regular file.
+ * @exception KTX_FILE_OVERFLOW the file is too large to map.
+ * @exception KTX_FILE_READ_ERROR the file could not be mapped.
+ * @exception KTX_FILE_UNEXPECTED_EOF the file is empty.
+ * @exception KTX_UNSUPPORTED_FEATURE the platform does not support mapping.
+ */
+static KTX_error_code
+ktxMmapStream_map(FILE* file, ktx_uint8_t** ppAddress, ktx_size_t* pSize)
+{
+#if defined(_WIN32)
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(file));
+    HANDLE hMapping;
+    LARGE_INTEGER fileSize;
+    void* address;
+
+    if (hFile == INVALID_HANDLE_VALUE || GetFileType(hFile) != FILE_TYPE_DISK)
+        return KTX_FILE_ISPIPE;
+    if (!GetFileSizeEx(hFile, &fileSize))
+        return KTX_FILE_READ_ERROR;
+    if (fileSize.QuadPart == 0)
+        return KTX_FILE_UNEXPECTED_EOF;
+    if ((ULONGLONG)fileSize.QuadPart > (ULONGLONG)SIZE_MAX)
+        return KTX_FILE_OVERFLOW;
+
+    hMapping = CreateFileMappingW(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (hMapping == NULL)
+        return KTX_FILE_READ_ERROR;
+    address = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+    // The view keeps the mapping object alive.
+    CloseHandle(hMapping);
+    if (address == NULL)
+        return KTX_FILE_READ_ERROR;
+
+    *ppAddress = (ktx_uint8_t*)address;
+    *pSize = (ktx_size_t)fileSize.QuadPart;
+    return KTX_SUCCESS;
+#elif KTX_MMAP_SUPPORTED
+    struct stat statbuf;
+    void* address;
+
+    if (fstat(fileno(file), &statbuf) < 0)
+        return errno == EOVERFLOW ? KTX_FILE_OVERFLOW : KTX_FILE_READ_ERROR;
+    if (!S_ISREG(statbuf.st_mode))
+        return KTX_FILE_ISPIPE;
+    if (statbuf.st_size == 0)
+        return KTX_FILE_UNEXPECTED_EOF;
+    if ((uintmax_t)statbuf.st_size > (uintmax_t)SIZE_MAX)
+        return KTX_FILE_OVERFLOW;
+
+    address = mmap(NULL, (size_t)statbuf.st_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE, fileno(file), 0);
+    if (address == MAP_FAILED)
+        return KTX_FILE_READ_ERROR;
+#if defined(MADV_SEQUENTIAL)
+    // Headers and levels are read front to back. Encourage aggressive
+    // read-ahead and early reclaim of pages already consumed.
+    (void)madvise(address, (size_t)statbuf.st_size, MADV_SEQUENTIAL);
+#endif
+
+    *ppAddress = (ktx_uint8_t*)address;
+    *pSize = (ktx_size_t)statbuf.st_size;
+    return KTX_SUCCESS;
+#else
+    UNUSED(file);
+    UNUSED(ppAddress);
+    UNUSED(pSize);
+    return KTX_UNSUPPORTED_FEATURE;
+#endif
+}
+
+/**
+ * @~English
+ * @brief Release a mapping made by a ktxMmapStream.
+ *
+ * @param [in] address the address of the mapping, as returned by
+ *                     ktxMmapStream_detachData().
+ * @param [in] size    the size of the mapping, as returned by
+ *                     ktxMmapStream_detachData().
+ */
+void
+ktxMmapStream_unmap(ktx_uint8_t* address, ktx_size_t size)
+{
+#if defined(_WIN32)
+    UNUSED(size);
+    UnmapViewOfFile(address);
+#elif KTX_MMAP_SUPPORTED
+    munmap(address, size);
+#else
+    UNUSED(address);
+    UNUSED(size);
+#endif
+}
+
+/**
+ * @~English
+ * @brief Initialize a read-only ktxMmapStream.
+ *
+ * The whole of @p file is mapped. The FILE is not used after this returns
+ * so the caller may close it. The mapping is released when the stream is
+ * destructed unless ownership has been taken with
+ * ktxMmapStream_detachData().
+ *
+ * @param [in] str      pointer to the ktxStream to initialize.
+ * @param [in] file     pointer to the FILE to map.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p file is @c NULL.
+ *
+ * For other exceptions, see ktxMmapStream_map().
+ */
+KTX_error_code
+ktxMmapStream_construct(ktxStream* str, FILE* file)
+{
+    KTX_error_code result;
+    ktx_uint8_t* address;
+    ktx_size_t size;
+
+    if (!str || !file)
+        return KTX_INVALID_VALUE;
+
+    result = ktxMmapStream_map(file, &address, &size);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    str->data.mapped.address = address;
+    str->data.mapped.size = size;
+    str->data.mapped.pos = 0;
+    str->readpos = 0;
+    str->type = eStreamTypeMmap;
+    str->read = ktxMmapStream_read;
+    str->skip = ktxMmapStream_skip;
+    str->write = ktxMmapStream_write;
+    str->getpos = ktxMmapStream_getpos;
+    str->setpos = ktxMmapStream_setpos;
+    str->getsize = ktxMmapStream_getsize;
+    str->destruct = ktxMmapStream_destruct;
+    str->closeOnDestruct = KTX_TRUE;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Take ownership of the mapping of a ktxMmapStream.
+ *
+ * The stream remains usable until it is destructed but destructing it no
+ * longer releases the mapping. The caller must release it with
+ * ktxMmapStream_unmap().
+ *
+ * @param [in] str        pointer to the ktxStream whose mapping to detach.
+ * @param [out] ppAddress pointer to a variable to receive the address of the
+ *                        mapping.
+ * @param [out] pSize     pointer to a variable to receive the size of the
+ *                        mapping.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE any of the arguments is @c NULL.
+ * @exception KTX_INVALID_OPERATION the mapping has already been detached.
+ */
+KTX_error_code
+ktxMmapStream_detachData(ktxStream* str, ktx_uint8_t** ppAddress,
+                         ktx_size_t* pSize)
+{
+    if (!str || !ppAddress || !pSize)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMmap);
+
+    if (!str->closeOnDestruct)
+        return KTX_INVALID_OPERATION;
+
+    *ppAddress = str->data.mapped.address;
+    *pSize = str->data.mapped.size;
+    str->closeOnDestruct = KTX_FALSE;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Destruct the stream, releasing the mapping if still owned.
+ *
+ * @param [in] str pointer to the ktxStream to destruct.
+ */
+void
+ktxMmapStream_destruct(ktxStream* str)
+{
+    assert(str && str->type == eStreamTypeMmap);
+
+    if (str->closeOnDestruct)
+        ktxMmapStream_unmap(str->data.mapped.address, str->data.mapped.size);
+    str->data.mapped.address = 0;
+}
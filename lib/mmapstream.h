@@ -0,0 +1,41 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file
+ * @~English
+ *
+ * @brief Interface of ktxStream for memory-mapped files.
+ */
+
+#ifndef MMAPSTREAM_H
+#define MMAPSTREAM_H
+
+#include "ktx.h"
+
+/*
+ * Initialize a read-only ktxStream reading from a memory mapping of
+ * the whole of a FILE. The FILE is not needed after this returns.
+ */
+KTX_error_code ktxMmapStream_construct(ktxStream* str, FILE* file);
+
+void ktxMmapStream_destruct(ktxStream* str);
+
+/*
+ * Transfer ownership of the mapping to the caller. The mapping stays valid
+ * after the stream is destructed and must be released with
+ * ktxMmapStream_unmap().
+ */
+KTX_error_code ktxMmapStream_detachData(ktxStream* str,
+                                        ktx_uint8_t** ppAddress,
+                                        ktx_size_t* pSize);
+
+void ktxMmapStream_unmap(ktx_uint8_t* address, ktx_size_t size);
+
+#endif /* MMAPSTREAM_H */
@@ -0,0 +1,336 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023-2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file parallel.cpp
+ * @~English
+ *
+ * @brief Minimal fork-join helper for running independent jobs, such as the
+ *        inflation of individual mip levels, on several threads.
+ *
+ * The library is otherwise written in C. This provides a C interface to
+ * std::thread so the C code does not need to deal with platform threading
+ * APIs.
+ */
+
+#include "ktx.h"
+#include "ktxint.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/**
+ * @internal
+ * @~English
+ * @brief A single background thread running jobs in submission order.
+ */
+struct ktxWorker {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::pair<PFNKTXWORKERJOB, void*>> jobs;
+    bool stopping = false;
+    bool detached = false; /*!< Destroyed by one of its own jobs. The
+                                thread deletes the worker when it exits. */
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+                break; // Stopping and nothing left to do.
+            auto job = jobs.front();
+            jobs.pop_front();
+            lock.unlock();
+            job.first(job.second);
+            lock.lock();
+        }
+        bool deleteSelf = detached;
+        lock.unlock();
+        if (deleteSelf)
+            delete this;
+    }
+};
+
+/**
+ * @internal
+ * @~English
+ * @brief A flag one thread can set and others can wait for.
+ */
+struct ktxEvent {
+    std::mutex mutex;
+    std::condition_variable signaled;
+    bool set = false;
+};
+
+extern "C" {
+
+/**
+ * @internal
+ * @~English
+ * @brief Decide how many threads to use for a set of jobs.
+ *
+ * @param requested number of threads requested by the caller. 0 means use
+ *                  the number of hardware threads.
+ * @param jobCount  number of independent jobs to be run.
+ *
+ * @return the number of threads, including the calling thread, to use. Never
+ *         more than @p jobCount and never less than 1.
+ */
+ktx_uint32_t
+ktxParallel_threadCount(ktx_uint32_t requested, ktx_uint32_t jobCount)
+{
+    ktx_uint32_t threadCount = requested;
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount > jobCount)
+        threadCount = jobCount;
+    return threadCount ? threadCount : 1;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Run @p jobCount jobs on up to @p threadCount threads.
+ *
+ * The calling thread participates as thread 0. Jobs are handed out in
+ * increasing index order. Each job is told the index of the thread running it
+ * so callers can keep per-thread state, e.g. a decompression context, in an
+ * array of @p threadCount elements.
+ *
+ * All jobs are run even if one fails, so the result does not depend on thread
+ * scheduling. If more than one job fails the error from the job with the
+ * lowest index is returned, matching what a serial loop that stops at the
+ * first error would return.
+ *
+ * If a worker thread cannot be created the remaining jobs are run on the
+ * threads that were created.
+ *
+ * @param jobCount    number of jobs.
+ * @param threadCount maximum number of threads to use. Must be > 0. Use
+ *                    ktxParallel_threadCount() to choose it.
+ * @param job         function to call for each job.
+ * @param userdata    pointer passed through to @p job.
+ *
+ * @return KTX_SUCCESS if all jobs succeeded, otherwise the error of the
+ *         lowest numbered job that failed.
+ */
+KTX_error_code
+ktxParallel_for(ktx_uint32_t jobCount, ktx_uint32_t threadCount,
+                PFNKTXPARALLELJOB job, void* userdata)
+{
+    if (jobCount == 0)
+        return KTX_SUCCESS;
+
+    if (threadCount <= 1 || jobCount == 1) {
+        KTX_error_code result = KTX_SUCCESS;
+        for (ktx_uint32_t i = 0; i < jobCount; i++) {
+            KTX_error_code jobResult = job(i, 0, userdata);
+            if (jobResult != KTX_SUCCESS && result == KTX_SUCCESS)
+                result = jobResult;
+        }
+        return result;
+    }
+
+    std::atomic<ktx_uint32_t> nextJob(0);
+    std::atomic<ktx_uint32_t> firstFailedJob(jobCount);
+    std::vector<KTX_error_code> results(jobCount, KTX_SUCCESS);
+
+    auto worker = [&](ktx_uint32_t threadIndex) {
+        ktx_uint32_t i;
+        while ((i = nextJob.fetch_add(1)) < jobCount) {
+            results[i] = job(i, threadIndex, userdata);
+            if (results[i] != KTX_SUCCESS) {
+                ktx_uint32_t failed = firstFailedJob.load();
+                while (i < failed
+                       && !firstFailedJob.compare_exchange_weak(failed, i))
+                    ;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (ktx_uint32_t t = 1; t < threadCount; t++) {
+        try {
+            threads.emplace_back(worker, t);
+        } catch (const std::system_error&) {
+            break; // Carry on with the threads we have.
+        }
+    }
+    worker(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    ktx_uint32_t failed = firstFailedJob.load();
+    return failed < jobCount ? results[failed] : KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Create a ktxWorker and start its thread.
+ *
+ * @param[out] ppWorker pointer to a location in which to store the address
+ *                      of the new worker.
+ *
+ * @return KTX_SUCCESS on success, KTX_OUT_OF_MEMORY if the worker or its
+ *         thread could not be created.
+ */
+KTX_error_code
+ktxWorker_create(ktxWorker** ppWorker)
+{
+    ktxWorker* worker = new (std::nothrow) ktxWorker;
+    if (!worker)
+        return KTX_OUT_OF_MEMORY;
+    try {
+        worker->thread = std::thread(&ktxWorker::run, worker);
+    } catch (const std::system_error&) {
+        delete worker;
+        return KTX_OUT_OF_MEMORY;
+    }
+    *ppWorker = worker;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Queue a job to be run on a ktxWorker's thread.
+ *
+ * Jobs run one at a time in the order they were submitted.
+ *
+ * @param worker   the worker to run the job.
+ * @param job      function to call.
+ * @param userdata pointer passed through to @p job.
+ *
+ * @return KTX_SUCCESS on success, KTX_OUT_OF_MEMORY if the job could not be
+ *         queued.
+ */
+KTX_error_code
+ktxWorker_submit(ktxWorker* worker, PFNKTXWORKERJOB job, void* userdata)
+{
+    try {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->jobs.emplace_back(job, userdata);
+    } catch (const std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    worker->wake.notify_one();
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Run any queued jobs to completion then destroy a ktxWorker.
+ *
+ * May be called from one of the worker's own jobs, e.g. a completion
+ * callback that destroys the object owning the worker. A thread cannot join
+ * itself so the queued jobs are then run on the calling thread before this
+ * returns and the thread deletes the worker when the current job returns.
+ *
+ * @param worker the worker to destroy.
+ */
+void
+ktxWorker_destroy(ktxWorker* worker)
+{
+    if (std::this_thread::get_id() == worker->thread.get_id()) {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        while (!worker->jobs.empty()) {
+            auto job = worker->jobs.front();
+            worker->jobs.pop_front();
+            lock.unlock();
+            job.first(job.second);
+            lock.lock();
+        }
+        worker->stopping = true;
+        worker->detached = true;
+        worker->thread.detach();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->stopping = true;
+    }
+    worker->wake.notify_one();
+    worker->thread.join();
+    delete worker;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Create an unset ktxEvent.
+ *
+ * @return the new event or @c NULL if there is not enough memory.
+ */
+ktxEvent*
+ktxEvent_create(void)
+{
+    return new (std::nothrow) ktxEvent;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Set a ktxEvent, releasing any waiting threads.
+ *
+ * The event may be destroyed by a waiter as soon as this returns.
+ */
+void
+ktxEvent_set(ktxEvent* event)
+{
+    std::lock_guard<std::mutex> lock(event->mutex);
+    event->set = true;
+    event->signaled.notify_all();
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Query whether a ktxEvent has been set.
+ */
+ktx_bool_t
+ktxEvent_isSet(ktxEvent* event)
+{
+    std::lock_guard<std::mutex> lock(event->mutex);
+    return event->set;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Block until a ktxEvent has been set.
+ */
+void
+ktxEvent_wait(ktxEvent* event)
+{
+    std::unique_lock<std::mutex> lock(event->mutex);
+    event->signaled.wait(lock, [event] { return event->set; });
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Destroy a ktxEvent.
+ */
+void
+ktxEvent_destroy(ktxEvent* event)
+{
+    delete event;
+}
+
+}
@@ -34,6 +34,7 @@
 #include "formatsize.h"
 #include "filestream.h"
 #include "memstream.h"
+#include "mmapstream.h"
 #include "texture1.h"
 #include "texture2.h"
 #include "unused.h"
@@ -198,7 +199,8 @@ ktxTexture_constructFromStream(ktxTexture* This, ktxStream* pStream,
     assert(pStream->data.mem != NULL);
     assert(pStream->type == eStreamTypeFile
            || pStream->type == eStreamTypeMemory
-           || pStream->type == eStreamTypeCustom);
+           || pStream->type == eStreamTypeCustom
+           || pStream->type == eStreamTypeMmap);
 
     This->_protected = (struct ktxTexture_protected *)
                                 malloc(sizeof(struct ktxTexture_protected));
@@ -274,7 +276,8 @@ ktxDetermineFileType_(ktxStream* pStream, ktxFileType_* pFileType,
     assert(pStream->data.mem != NULL);
     assert(pStream->type == eStreamTypeFile
            || pStream->type == eStreamTypeMemory
-           || pStream->type == eStreamTypeCustom);
+           || pStream->type == eStreamTypeCustom
+           || pStream->type == eStreamTypeMmap);
 
     result = pStream->read(pStream, pHeader, sizeof(ktx2_ident_ref));
     if (result == KTX_SUCCESS) {
@@ -412,7 +415,15 @@ ktxTexture_CreateFromNamedFile(const char* const filename,
     if (!file)
        return KTX_FILE_OPEN_FAILED;
 
-    result = ktxFileStream_construct(&stream, file, KTX_TRUE);
+    result = KTX_UNSUPPORTED_FEATURE;
+    if (createFlags & KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT) {
+        // Falls back to stdio when the file cannot be mapped, e.g. a pipe.
+        result = ktxMmapStream_construct(&stream, file);
+        if (result == KTX_SUCCESS)
+            fclose(file);
+    }
+    if (result != KTX_SUCCESS)
+        result = ktxFileStream_construct(&stream, file, KTX_TRUE);
     if (result == KTX_SUCCESS) {
         result = ktxTexture_CreateFromStream(&stream, createFlags, newTex);
     }
@@ -33,6 +33,7 @@
 #include "ktxint.h"
 #include "filestream.h"
 #include "memstream.h"
+#include "mmapstream.h"
 #include "texture2.h"
 #include "unused.h"
 
@@ -517,6 +518,9 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
         goto cleanup;
     }
     memcpy(This->_private, orig->_private, privateSize);
+    This->_private->_mappedData = NULL;
+    This->_private->_mappedSize = 0;
+    This->_private->_levelLoader = NULL;
     if (orig->_private->_sgdByteLength > 0) {
         This->_private->_supercompressionGlobalData
                         = (ktx_uint8_t*)malloc(orig->_private->_sgdByteLength);
@@ -980,7 +984,9 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
      * Load the images, if requested.
      */
     if (createFlags & KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT) {
-        result = ktxTexture2_LoadImageData(This, NULL, 0);
+        ktx_uint32_t threadCount =
+            createFlags & KTX_TEXTURE_CREATE_PARALLEL_INFLATE_BIT ? 0 : 1;
+        result = ktxTexture2_LoadImageDataEx(This, NULL, 0, threadCount);
     }
     if (result != KTX_SUCCESS)
         goto cleanup;
@@ -1114,7 +1120,15 @@ ktxTexture2_constructFromNamedFile(ktxTexture2* This,
     if (!file)
        return KTX_FILE_OPEN_FAILED;
 
-    result = ktxFileStream_construct(&stream, file, KTX_TRUE);
+    result = KTX_UNSUPPORTED_FEATURE;
+    if (createFlags & KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT) {
+        // Falls back to stdio when the file cannot be mapped, e.g. a pipe.
+        result = ktxMmapStream_construct(&stream, file);
+        if (result == KTX_SUCCESS)
+            fclose(file);
+    }
+    if (result != KTX_SUCCESS)
+        result = ktxFileStream_construct(&stream, file, KTX_TRUE);
     if (result == KTX_SUCCESS)
         result = ktxTexture2_constructFromStream(This, &stream, createFlags);
 
@@ -1169,15 +1183,45 @@ ktxTexture2_constructFromMemory(ktxTexture2* This,
 void
 ktxTexture2_destruct(ktxTexture2* This)
 {
+    // Finish pending level loads before anything they use goes away.
+    if (This->_private && This->_private->_levelLoader)
+        ktxWorker_destroy(This->_private->_levelLoader);
     if (This->pDfd) free(This->pDfd);
     if (This->_private) {
       ktx_uint8_t* sgd = This->_private->_supercompressionGlobalData;
       if (sgd) free(sgd);
+      // Unmap here as ktxTexture_destruct would try to free it.
+      ktxTexture2_freeImageData(This);
       free(This->_private);
     }
     ktxTexture_destruct(ktxTexture(This));
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Release the image data pointed at by pData.
+ *
+ * The data is either freed or, if it points into a file mapping, unmapped.
+ * pData is set to @c NULL.
+ *
+ * @param[in] This pointer to the ktxTexture2 whose image data is to be
+ *                 released.
+ */
+void
+ktxTexture2_freeImageData(ktxTexture2* This)
+{
+    if (This->_private->_mappedData) {
+        ktxMmapStream_unmap(This->_private->_mappedData,
+                            This->_private->_mappedSize);
+        This->_private->_mappedData = NULL;
+        This->_private->_mappedSize = 0;
+    } else {
+        free(This->pData);
+    }
+    This->pData = NULL;
+}
+
 /**
  * @memberof ktxTexture2
  * @ingroup writer
@@ -1369,6 +1413,13 @@ ktxTexture2_CreateFromStdioStream(FILE* stdioStream,
  * will minimize memory usage by allowing, for example, loading the images
  * directly from the source into a Vulkan staging buffer.
  *
+ * When the create flag KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT is set the file
+ * is memory-mapped and read through the mapping. If the images are not
+ * supercompressed, loading them, at creation or later with
+ * ktxTexture2_LoadImageData(), makes pData point into the mapping without
+ * copying anything. The mapping is released when the texture is destroyed.
+ * If the file cannot be mapped it is read with stdio as usual.
+ *
  * The create flag KTX_TEXTURE_CREATE_RAW_KVDATA_BIT should not be used. It is
  * provided solely to enable implementation of the @e libktx v1 API on top of
  * ktxTexture.
@@ -2164,18 +2215,19 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
 
     // Allocate memory sufficient for the base level
     dataSize = levelIndex[0].byteLength;
-    dataBuf = malloc(dataSize);
+    dataBuf = ktxContext_acquireBuffer(This->_private->_context, dataSize);
     if (!dataBuf)
         return KTX_OUT_OF_MEMORY;
     if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
         uncompressedDataSize = levelIndex[0].uncompressedByteLength;
-        uncompressedDataBuf = malloc(uncompressedDataSize);
+        uncompressedDataBuf = ktxContext_acquireBuffer(This->_private->_context,
+                                                       uncompressedDataSize);
         if (!uncompressedDataBuf) {
             result = KTX_OUT_OF_MEMORY;
             goto cleanup;
         }
         if (This->supercompressionScheme == KTX_SS_ZSTD) {
-            dctx = ZSTD_createDCtx();
+            dctx = ktxContext_acquireDCtx(This->_private->_context);
         }
         pData = uncompressedDataBuf;
     } else {
@@ -2219,14 +2271,18 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
                 ZSTD_ErrorCode error = ZSTD_getErrorCode(levelSize);
                 switch(error) {
                   case ZSTD_error_dstSize_tooSmall:
-                    return KTX_DECOMPRESS_LENGTH_ERROR; // inflatedDataCapacity too small.
+                    result = KTX_DECOMPRESS_LENGTH_ERROR; // inflatedDataCapacity too small.
+                    break;
                   case ZSTD_error_checksum_wrong:
-                    return KTX_DECOMPRESS_CHECKSUM_ERROR;
+                    result = KTX_DECOMPRESS_CHECKSUM_ERROR;
+                    break;
                   case ZSTD_error_memory_allocation:
-                    return KTX_OUT_OF_MEMORY;
+                    result = KTX_OUT_OF_MEMORY;
+                    break;
                   default:
-                    return KTX_FILE_DATA_ERROR;
+                    result = KTX_FILE_DATA_ERROR;
                 }
+                goto cleanup;
             }
 
             // We don't fix up the texture's dataSize, levelIndex or
@@ -2236,16 +2292,21 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
             //nindex[level].uncompressedByteLength = nindex[level].byteLength =
                                                                 //levelByteLength;
         } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
-            result = ktxUncompressZLIBInt(uncompressedDataBuf,
-                                            &uncompressedDataSize,
-                                            dataBuf,
-                                            levelSize);
+            ktx_size_t inflatedSize = uncompressedDataSize;
+            result = ktxUncompressZLIBInt(This->_private->_context,
+                                          uncompressedDataBuf,
+                                          &inflatedSize,
+                                          dataBuf,
+                                          levelSize);
             if (result != KTX_SUCCESS)
-                return result;
+                goto cleanup;
+            levelSize = inflatedSize;
         }
 
-        if (levelIndex[level].uncompressedByteLength != levelSize)
-            return KTX_DECOMPRESS_LENGTH_ERROR;
+        if (levelIndex[level].uncompressedByteLength != levelSize) {
+            result = KTX_DECOMPRESS_LENGTH_ERROR;
+            goto cleanup;
+        }
 
 #if IS_BIG_ENDIAN
         switch (prtctd->_typeSize) {
@@ -2302,22 +2363,221 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
     stream->destruct(stream);
     This->_private->_firstLevelFileOffset = 0;
 cleanup:
-    free(dataBuf);
-    if (uncompressedDataBuf) free(uncompressedDataBuf);
-    if (dctx) ZSTD_freeDCtx(dctx);
+    ktxContext_releaseBuffer(This->_private->_context, dataBuf);
+    ktxContext_releaseBuffer(This->_private->_context, uncompressedDataBuf);
+    ktxContext_releaseDCtx(This->_private->_context, dctx);
 
     return result;
 }
 
+/**
+ * @internal
+ * @~English
+ * @brief Inflate a single Zstd or ZLIB supercompressed level.
+ *
+ * @param[in]     This      pointer to the ktxTexture2 object of interest.
+ * @param[in]     level     the level to inflate.
+ * @param[in,out] pLevel    pointer to memory for the inflated level data.
+ * @param[in]     levelCapacity size of @p pLevel.
+ * @param[in]     pDeflated pointer to the deflated level data.
+ * @param[in]     deflatedByteLength size of the data at @p pDeflated.
+ * @param[out]    pLevelByteLength set to the size of the data written to
+ *                          @p pLevel.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p pLevel is too small.
+ * @exception KTX_DECOMPRESS_LENGTH_ERROR
+ *                                  The inflated level is not the size given
+ *                                  in the level index.
+ * @exception KTX_DECOMPRESS_CHECKSUM_ERROR
+ *                                  A Zstd checksum is wrong.
+ * @exception KTX_FILE_DATA_ERROR   The level cannot be inflated.
+ */
+static KTX_error_code
+ktxTexture2_inflateLevelInt(ktxTexture2* This, ktx_uint32_t level,
+                            ktx_uint8_t* pLevel, ktx_size_t levelCapacity,
+                            const ktx_uint8_t* pDeflated,
+                            ktx_size_t deflatedByteLength,
+                            ktx_size_t* pLevelByteLength)
+{
+    ktxLevelIndexEntry* levelIndex = This->_private->_levelIndex;
+    ktx_size_t levelByteLength = deflatedByteLength;
+    KTX_error_code result;
+
+    if (This->supercompressionScheme == KTX_SS_ZSTD) {
+        if (levelCapacity < levelIndex[level].uncompressedByteLength)
+            return KTX_INVALID_VALUE;
+        ZSTD_DCtx* dctx = ktxContext_acquireDCtx(This->_private->_context);
+        if (!dctx)
+            return KTX_OUT_OF_MEMORY;
+        levelByteLength = ZSTD_decompressDCtx(dctx, pLevel,
+                                              levelIndex[level].uncompressedByteLength,
+                                              pDeflated, levelByteLength);
+        ktxContext_releaseDCtx(This->_private->_context, dctx);
+        if (ZSTD_isError(levelByteLength)) {
+            ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLength);
+            switch(error) {
+              case ZSTD_error_dstSize_tooSmall:
+                return KTX_DECOMPRESS_LENGTH_ERROR;
+              case ZSTD_error_checksum_wrong:
+                return KTX_DECOMPRESS_CHECKSUM_ERROR;
+              case ZSTD_error_memory_allocation:
+                return KTX_OUT_OF_MEMORY;
+              default:
+                return KTX_FILE_DATA_ERROR;
+            }
+        }
+    } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
+        if (levelCapacity < levelIndex[level].uncompressedByteLength)
+            return KTX_INVALID_VALUE;
+        ktx_size_t inflatedByteLength = levelIndex[level].uncompressedByteLength;
+        result = ktxUncompressZLIBInt(This->_private->_context,
+                                      pLevel, &inflatedByteLength,
+                                      pDeflated, levelByteLength);
+        if (result != KTX_SUCCESS)
+            return result;
+        levelByteLength = inflatedByteLength;
+    }
+
+    if (levelIndex[level].uncompressedByteLength != levelByteLength)
+        return KTX_DECOMPRESS_LENGTH_ERROR;
+
+    *pLevelByteLength = levelByteLength;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Read a single level's image data from the source stream.
+ *
+ * If the level is Zstd or ZLIB supercompressed it is read into @p pScratch
+ * and inflated into @p pLevel. Otherwise it is read directly into @p pLevel.
+ * The stream remains active so other levels can be read later.
+ *
+ * @param[in]     This      pointer to the ktxTexture2 object of interest.
+ * @param[in]     level     the level to read.
+ * @param[in,out] pLevel    pointer to memory for the, inflated, level data.
+ * @param[in]     levelCapacity size of @p pLevel.
+ * @param[in,out] pScratch  pointer to memory for the deflated level data.
+ *                          Not used, and may be NULL, unless the texture is
+ *                          Zstd or ZLIB supercompressed.
+ * @param[in]     scratchCapacity size of @p pScratch.
+ * @param[out]    pLevelByteLength set to the size of the data written to
+ *                          @p pLevel.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_OPERATION The texture has no active source stream.
+ * @exception KTX_INVALID_VALUE     @p pLevel or @p pScratch is too small.
+ * @exception KTX_DECOMPRESS_LENGTH_ERROR
+ *                                  The inflated level is not the size given
+ *                                  in the level index.
+ * @exception KTX_DECOMPRESS_CHECKSUM_ERROR
+ *                                  A Zstd checksum is wrong.
+ * @exception KTX_FILE_DATA_ERROR   The level cannot be inflated.
+ * @exception KTX_FILE_READ_ERROR   An error occurred while reading the source.
+ * @exception KTX_FILE_UNEXPECTED_EOF
+ *                                  Not enough data in the source.
+ */
+KTX_error_code
+ktxTexture2_readLevelInt(ktxTexture2* This, ktx_uint32_t level,
+                         ktx_uint8_t* pLevel, ktx_size_t levelCapacity,
+                         ktx_uint8_t* pScratch, ktx_size_t scratchCapacity,
+                         ktx_size_t* pLevelByteLength)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    ktxStream* stream = (ktxStream *)&prtctd->_stream;
+    ktxLevelIndexEntry* levelIndex = This->_private->_levelIndex;
+    ktx_size_t levelByteLength = levelIndex[level].byteLength;
+    ktx_bool_t deflated = This->supercompressionScheme == KTX_SS_ZSTD
+                          || This->supercompressionScheme == KTX_SS_ZLIB;
+    ktx_uint8_t* pRead = deflated ? pScratch : pLevel;
+    ktx_size_t readCapacity = deflated ? scratchCapacity : levelCapacity;
+    KTX_error_code result;
+
+    if (!ktxTexture_isActiveStream((ktxTexture*)This))
+        return KTX_INVALID_OPERATION;
+
+    if (pRead == NULL || readCapacity < levelByteLength)
+        return KTX_INVALID_VALUE;
+
+    // Use setpos so we skip any padding.
+    result = stream->setpos(stream, ktxTexture2_levelFileOffset(This, level));
+    if (result != KTX_SUCCESS)
+        return result;
+
+    result = stream->read(stream, pRead, levelByteLength);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (deflated)
+        return ktxTexture2_inflateLevelInt(This, level, pLevel, levelCapacity,
+                                           pScratch, levelByteLength,
+                                           pLevelByteLength);
+
+    *pLevelByteLength = levelByteLength;
+    return KTX_SUCCESS;
+}
+
 KTX_error_code
 ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity);
+                           ktx_size_t inflatedDataCapacity,
+                           ktx_uint32_t threadCount);
 
 KTX_error_code
 ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity);
+                           ktx_size_t inflatedDataCapacity,
+                           ktx_uint32_t threadCount);
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Point pData at the images in the file mapping of a ktxMmapStream.
+ *
+ * Ownership of the mapping moves from the stream to the texture and the
+ * stream is destructed, as when the images are loaded by copying.
+ *
+ * @param[in] This pointer to the ktxTexture2 whose images are to be mapped.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_UNEXPECTED_EOF
+ *                              The file is too short to hold the images.
+ */
+static KTX_error_code
+ktxTexture2_mapImageData(ktxTexture2* This)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    DECLARE_PRIVATE(ktxTexture2);
+    ktxStream* stream = &prtctd->_stream;
+    ktx_uint8_t* address;
+    ktx_size_t size;
+    KTX_error_code result;
+
+    assert(stream->type == eStreamTypeMmap);
+
+    if (private->_firstLevelFileOffset > stream->data.mapped.size
+        || This->dataSize > stream->data.mapped.size
+                            - private->_firstLevelFileOffset)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    result = ktxMmapStream_detachData(stream, &address, &size);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    private->_mappedData = address;
+    private->_mappedSize = size;
+    This->pData = address + private->_firstLevelFileOffset;
+
+    // No further need for stream or file offset.
+    stream->destruct(stream);
+    private->_firstLevelFileOffset = 0;
+    return KTX_SUCCESS;
+}
 
 /**
  * @memberof ktxTexture2
@@ -2350,6 +2610,42 @@ ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
 KTX_error_code
 ktxTexture2_LoadImageData(ktxTexture2* This,
                           ktx_uint8_t* pBuffer, ktx_size_t bufSize)
+{
+    return ktxTexture2_LoadImageDataEx(This, pBuffer, bufSize, 1);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Load all the image data from the ktxTexture2's source, inflating
+ *        supercompressed levels on multiple threads.
+ *
+ * Identical to ktxTexture2\_LoadImageData() except that, when the data is
+ * supercompressed with Zstd or ZLIB, up to @p threadCount levels are inflated
+ * concurrently. Each level is inflated straight to its final position so the
+ * result is the same as that from ktxTexture2\_LoadImageData(). Textures
+ * with a single level or no supercompression gain nothing.
+ *
+ * @param[in] This pointer to the ktxTexture object of interest.
+ * @param[in] pBuffer pointer to the buffer in which to load the image data.
+ * @param[in] bufSize size of the buffer pointed at by @p pBuffer.
+ * @param[in] threadCount maximum number of threads to use, including the
+ *                        calling thread. 0 means use the number of hardware
+ *                        threads.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This is NULL.
+ * @exception KTX_INVALID_VALUE @p bufSize is less than the the image data size.
+ * @exception KTX_INVALID_OPERATION
+ *                              The data has already been loaded or the
+ *                              ktxTexture was not created from a KTX source.
+ * @exception KTX_OUT_OF_MEMORY Insufficient memory for the image data.
+ */
+KTX_error_code
+ktxTexture2_LoadImageDataEx(ktxTexture2* This,
+                            ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                            ktx_uint32_t threadCount)
 {
     DECLARE_PROTECTED(ktxTexture);
     DECLARE_PRIVATE(ktxTexture2);
@@ -2369,6 +2665,13 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         // This Texture not created from a stream or images already loaded;
         return KTX_INVALID_OPERATION;
 
+    if (pBuffer == NULL && prtctd->_stream.type == eStreamTypeMmap
+        && This->supercompressionScheme == KTX_SS_NONE
+        && !(IS_BIG_ENDIAN && prtctd->_typeSize > 1)) {
+        // The images are already in their final form in the file.
+        return ktxTexture2_mapImageData(This);
+    }
+
     if (pBuffer == NULL) {
         This->pData = malloc(inflatedDataCapacity);
         if (This->pData == NULL)
@@ -2382,7 +2685,8 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
 
     if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
         // Create buffer to hold deflated data.
-        pDeflatedData = malloc(This->dataSize);
+        pDeflatedData = ktxContext_acquireBuffer(private->_context,
+                                                 This->dataSize);
         if (pDeflatedData == NULL)
             return KTX_OUT_OF_MEMORY;
         pReadBuf = pDeflatedData;
@@ -2407,12 +2711,14 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         assert(pDeflatedData != NULL);
         if (This->supercompressionScheme == KTX_SS_ZSTD) {
             result = ktxTexture2_inflateZstdInt(This, pDeflatedData, pDest,
-                                                inflatedDataCapacity);
+                                                inflatedDataCapacity,
+                                                threadCount);
         } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
             result = ktxTexture2_inflateZLIBInt(This, pDeflatedData, pDest,
-                                                inflatedDataCapacity);
+                                                inflatedDataCapacity,
+                                                threadCount);
         }
-        free(pDeflatedData);
+        ktxContext_releaseBuffer(private->_context, pDeflatedData);
         if (result != KTX_SUCCESS) {
             if (pBuffer == NULL) {
                 free(This->pData);
@@ -2453,6 +2759,424 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
     return result;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Set the context from which the texture takes its decompression and
+ *        compression state.
+ *
+ * Once set, the Zstd contexts, miniz state and scratch buffers used by
+ * ktxTexture2_LoadImageData(), ktxTexture2_LoadLevels(),
+ * ktxTexture2_IterateLoadLevelFaces(), ktxTexture2_TranscodeLevel(),
+ * ktxTexture2_DeflateZstd() and ktxTexture2_DeflateZLIB() on this texture
+ * are taken from, and returned to, @p context instead of being created and
+ * destroyed by each call. Set the same context on many textures to avoid
+ * this cost when loading lots of small textures.
+ *
+ * To use a context when loading the image data of a texture created from a
+ * file, stream or memory, create it without
+ * @c KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, set the context then call
+ * ktxTexture2_LoadImageData().
+ *
+ * The context must not be changed while an asynchronous level load is in
+ * progress and must outlive the texture or be detached first by setting
+ * @c NULL. Copies made with ktxTexture2_CreateCopy() share the context.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] context   the context to use or @c NULL to create and destroy
+ *                      the state on each call.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This is @c NULL.
+ */
+KTX_error_code
+ktxTexture2_SetContext(ktxTexture2* This, ktxContext* context)
+{
+    if (This == NULL)
+        return KTX_INVALID_VALUE;
+
+    This->_private->_context = context;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Return the size a level has once loaded, i.e. after any inflation.
+ */
+static ktx_size_t
+ktxTexture2_loadedLevelSize(ktxTexture2* This, ktx_uint32_t level)
+{
+    ktxLevelIndexEntry* levelIndex = This->_private->_levelIndex;
+
+    if (This->supercompressionScheme == KTX_SS_ZSTD
+        || This->supercompressionScheme == KTX_SS_ZLIB)
+        return levelIndex[level].uncompressedByteLength;
+    else
+        return levelIndex[level].byteLength;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Return the size of the buffer needed by ktxTexture2\_LoadLevels().
+ *
+ * This is the sum of the sizes of levels @p firstLevel to
+ * @p firstLevel + @p levelCount - 1 after any Zstd or ZLIB inflation.
+ *
+ * @param[in] This       pointer to the ktxTexture2 object of interest.
+ * @param[in] firstLevel first level of the range.
+ * @param[in] levelCount number of levels in the range.
+ * @param[out] pSize     pointer to a variable in which to store the size.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pSize is NULL, @p levelCount is
+ *                              0 or the range extends beyond the last level.
+ */
+KTX_error_code
+ktxTexture2_GetLevelsDataSize(ktxTexture2* This, ktx_uint32_t firstLevel,
+                              ktx_uint32_t levelCount, ktx_size_t* pSize)
+{
+    ktx_size_t size = 0;
+
+    if (This == NULL || pSize == NULL || levelCount == 0
+        || firstLevel >= This->numLevels
+        || levelCount > This->numLevels - firstLevel)
+        return KTX_INVALID_VALUE;
+
+    for (ktx_uint32_t level = firstLevel; level < firstLevel + levelCount;
+         level++)
+        size += ktxTexture2_loadedLevelSize(This, level);
+
+    *pSize = size;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Load a range of levels into a caller-provided buffer.
+ *
+ * Levels @p firstLevel to @p firstLevel + @p levelCount - 1 are written to
+ * @p pBuffer in order of increasing level number, i.e. largest first, with
+ * no padding between them. Levels supercompressed with Zstd or ZLIB are
+ * inflated. Use ktxTexture2\_GetLevelsDataSize() to find the size needed.
+ *
+ * If the image data has not been loaded only the requested levels are read
+ * from the source. The texture is not modified so any subset of levels can
+ * be loaded, in any order, as many times as needed, e.g. the small levels
+ * now and the large ones when they are needed. If the image data is loaded
+ * the levels are copied from it, inflating them if it has been deflated in
+ * memory with ktxTexture2\_DeflateZstd() or ktxTexture2\_DeflateZLIB().
+ *
+ * @param[in] This       pointer to the ktxTexture2 object of interest.
+ * @param[in] firstLevel first level to load.
+ * @param[in] levelCount number of levels to load.
+ * @param[in] pBuffer    pointer to the buffer in which to load the levels.
+ * @param[in] bufSize    size of the buffer pointed at by @p pBuffer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p pBuffer is NULL, @p bufSize is too small
+ *                              or the level range is invalid.
+ * @exception KTX_INVALID_OPERATION
+ *                              The image data is not loaded and the
+ *                              ktxTexture2 was not created from a KTX source.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for inflation scratch space.
+ *
+ * For other exceptions see ktxTexture2\_LoadImageData().
+ */
+KTX_error_code
+ktxTexture2_LoadLevels(ktxTexture2* This, ktx_uint32_t firstLevel,
+                       ktx_uint32_t levelCount,
+                       ktx_uint8_t* pBuffer, ktx_size_t bufSize)
+{
+    ktxLevelIndexEntry* levelIndex;
+    ktx_size_t levelsSize, offset, levelByteLength;
+    ktx_size_t scratchSize = 0;
+    ktx_uint8_t* pScratch = NULL;
+    ktx_uint32_t level;
+    KTX_error_code result;
+
+    if (pBuffer == NULL)
+        return KTX_INVALID_VALUE;
+
+    result = ktxTexture2_GetLevelsDataSize(This, firstLevel, levelCount,
+                                           &levelsSize);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (bufSize < levelsSize)
+        return KTX_INVALID_VALUE;
+
+    levelIndex = This->_private->_levelIndex;
+
+    if (This->pData != NULL) {
+        // The data is still deflated if it was deflated in memory, e.g. by
+        // ktxTexture2_DeflateZstd, rather than loaded from a source.
+        ktx_bool_t deflated = This->supercompressionScheme == KTX_SS_ZSTD
+                              || This->supercompressionScheme == KTX_SS_ZLIB;
+        offset = 0;
+        for (level = firstLevel; level < firstLevel + levelCount; level++) {
+            ktx_size_t levelSize = ktxTexture2_loadedLevelSize(This, level);
+            ktx_uint8_t* pLevel = This->pData + levelIndex[level].byteOffset;
+            if (deflated) {
+                result = ktxTexture2_inflateLevelInt(This, level,
+                                                     pBuffer + offset,
+                                                     levelSize, pLevel,
+                                                     levelIndex[level].byteLength,
+                                                     &levelByteLength);
+                if (result != KTX_SUCCESS)
+                    return result;
+            } else {
+                memcpy(pBuffer + offset, pLevel, levelSize);
+            }
+            offset += levelSize;
+        }
+        return KTX_SUCCESS;
+    }
+
+    if (!ktxTexture_isActiveStream((ktxTexture*)This))
+        return KTX_INVALID_OPERATION;
+
+    if (This->supercompressionScheme == KTX_SS_ZSTD
+        || This->supercompressionScheme == KTX_SS_ZLIB) {
+        for (level = firstLevel; level < firstLevel + levelCount; level++)
+            scratchSize = MAX(scratchSize, levelIndex[level].byteLength);
+        pScratch = ktxContext_acquireBuffer(This->_private->_context,
+                                            scratchSize);
+        if (pScratch == NULL)
+            return KTX_OUT_OF_MEMORY;
+    }
+
+    // Read the smallest level first, the order they are in the file, so the
+    // reads move forward through the source.
+    offset = levelsSize;
+    for (level = firstLevel + levelCount; level-- > firstLevel; ) {
+        ktx_size_t levelSize = ktxTexture2_loadedLevelSize(This, level);
+        offset -= levelSize;
+        result = ktxTexture2_readLevelInt(This, level, pBuffer + offset,
+                                          levelSize, pScratch, scratchSize,
+                                          &levelByteLength);
+        if (result != KTX_SUCCESS)
+            break;
+    }
+    ktxContext_releaseBuffer(This->_private->_context, pScratch);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief State of a load started by ktxTexture2_LoadLevelsAsync().
+ */
+struct ktxLevelLoad {
+    ktxTexture2* texture;
+    ktx_uint32_t firstLevel;
+    ktx_uint32_t levelCount;
+    ktx_uint8_t* pBuffer;
+    ktx_size_t bufSize;
+    PFNKTXLEVELLOADCB pfnComplete;
+    void* userdata;
+    KTX_error_code result;
+    ktxEvent* done; /*!< NULL if the caller did not ask for a handle. */
+};
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Run a ktxLevelLoad. Job function for the texture's I/O thread.
+ */
+static void
+ktxTexture2_runLevelLoad(void* userdata)
+{
+    ktxLevelLoad* load = (ktxLevelLoad*)userdata;
+    ktxEvent* done = load->done;
+
+    load->result = ktxTexture2_LoadLevels(load->texture, load->firstLevel,
+                                          load->levelCount,
+                                          load->pBuffer, load->bufSize);
+    if (load->pfnComplete)
+        load->pfnComplete(load->texture, load->firstLevel, load->levelCount,
+                          load->result, load->userdata);
+    // The handle owner may free load as soon as done is set.
+    if (done)
+        ktxEvent_set(done);
+    else
+        free(load);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Load a range of levels into a caller-provided buffer on a
+ *        background I/O thread.
+ *
+ * As ktxTexture2\_LoadLevels() except that the levels are read and inflated
+ * on a background thread owned by the texture while this returns
+ * immediately. Loads on a texture run one at a time in the order they were
+ * started. The arguments are validated before this returns.
+ *
+ * On completion @p pfnComplete, if not NULL, is called on the I/O thread.
+ * If @p ppLoad is not NULL a handle is stored there that can be polled with
+ * ktxLevelLoad\_IsComplete() or waited on with ktxLevelLoad\_Wait(). It
+ * must be released with ktxLevelLoad\_Destroy().
+ *
+ * @p pBuffer must stay valid until the load completes. While loads are
+ * pending do not call other functions that read from the texture's source,
+ * such as ktxTexture2\_LoadImageData(). Destroying the texture waits for
+ * pending loads to complete. The texture may be destroyed from
+ * @p pfnComplete. Any loads still pending are then completed on the I/O
+ * thread before ktxTexture\_Destroy() returns. Do not call
+ * ktxLevelLoad\_Wait() or ktxLevelLoad\_Destroy() from @p pfnComplete on a
+ * load that is still pending; it will never complete.
+ *
+ * If the I/O thread cannot be started, or the load cannot be queued, any
+ * pending loads are completed then the load is done on the calling thread
+ * before this returns.
+ *
+ * @param[in] This        pointer to the ktxTexture2 object of interest.
+ * @param[in] firstLevel  first level to load.
+ * @param[in] levelCount  number of levels to load.
+ * @param[in] pBuffer     pointer to the buffer in which to load the levels.
+ * @param[in] bufSize     size of the buffer pointed at by @p pBuffer.
+ * @param[in] pfnComplete function to call when the load completes. May be
+ *                        NULL.
+ * @param[in] userdata    pointer passed through to @p pfnComplete.
+ * @param[out] ppLoad     pointer to a location in which to store the handle
+ *                        of the load. May be NULL.
+ *
+ * @return      KTX_SUCCESS if the load was started, other KTX_* enum values
+ *              on error. Errors from the load itself are reported through
+ *              @p pfnComplete and ktxLevelLoad\_Wait().
+ *
+ * @exception KTX_INVALID_VALUE @p pBuffer is NULL, @p bufSize is too small
+ *                              or the level range is invalid.
+ * @exception KTX_INVALID_OPERATION
+ *                              The image data is not loaded and the
+ *                              ktxTexture2 was not created from a KTX source.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to start the load.
+ */
+KTX_error_code
+ktxTexture2_LoadLevelsAsync(ktxTexture2* This, ktx_uint32_t firstLevel,
+                            ktx_uint32_t levelCount,
+                            ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                            PFNKTXLEVELLOADCB pfnComplete, void* userdata,
+                            ktxLevelLoad** ppLoad)
+{
+    ktxLevelLoad* load;
+    ktx_size_t levelsSize;
+    KTX_error_code result;
+
+    if (pBuffer == NULL)
+        return KTX_INVALID_VALUE;
+
+    result = ktxTexture2_GetLevelsDataSize(This, firstLevel, levelCount,
+                                           &levelsSize);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (bufSize < levelsSize)
+        return KTX_INVALID_VALUE;
+    if (This->pData == NULL && !ktxTexture_isActiveStream((ktxTexture*)This))
+        return KTX_INVALID_OPERATION;
+
+    load = (ktxLevelLoad*)malloc(sizeof(ktxLevelLoad));
+    if (load == NULL)
+        return KTX_OUT_OF_MEMORY;
+    load->texture = This;
+    load->firstLevel = firstLevel;
+    load->levelCount = levelCount;
+    load->pBuffer = pBuffer;
+    load->bufSize = bufSize;
+    load->pfnComplete = pfnComplete;
+    load->userdata = userdata;
+    load->result = KTX_SUCCESS;
+    load->done = NULL;
+    if (ppLoad != NULL) {
+        load->done = ktxEvent_create();
+        if (load->done == NULL) {
+            free(load);
+            return KTX_OUT_OF_MEMORY;
+        }
+        *ppLoad = load;
+    }
+
+    if (This->_private->_levelLoader == NULL)
+        result = ktxWorker_create(&This->_private->_levelLoader);
+    if (result == KTX_SUCCESS)
+        result = ktxWorker_submit(This->_private->_levelLoader,
+                                  ktxTexture2_runLevelLoad, load);
+    if (result != KTX_SUCCESS) {
+        // No I/O thread or no room in its queue. Load synchronously, after
+        // any loads already queued so they do not read the source at the
+        // same time.
+        if (This->_private->_levelLoader != NULL) {
+            ktxWorker_destroy(This->_private->_levelLoader);
+            This->_private->_levelLoader = NULL;
+        }
+        ktxTexture2_runLevelLoad(load);
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxLevelLoad
+ * @~English
+ * @brief Query whether an asynchronous level load has completed.
+ *
+ * @param[in] load handle of the load.
+ *
+ * @return @c KTX_TRUE if the load, including its completion callback, has
+ *         completed, @c KTX_FALSE otherwise.
+ */
+ktx_bool_t
+ktxLevelLoad_IsComplete(ktxLevelLoad* load)
+{
+    if (load == NULL)
+        return KTX_FALSE;
+    return ktxEvent_isSet(load->done);
+}
+
+/**
+ * @memberof ktxLevelLoad
+ * @~English
+ * @brief Wait for an asynchronous level load to complete.
+ *
+ * @param[in] load handle of the load.
+ *
+ * @return      The result of the load.
+ *
+ * @exception KTX_INVALID_VALUE @p load is NULL.
+ */
+KTX_error_code
+ktxLevelLoad_Wait(ktxLevelLoad* load)
+{
+    if (load == NULL)
+        return KTX_INVALID_VALUE;
+    ktxEvent_wait(load->done);
+    return load->result;
+}
+
+/**
+ * @memberof ktxLevelLoad
+ * @~English
+ * @brief Release the handle of an asynchronous level load.
+ *
+ * Waits for the load to complete if it has not already.
+ *
+ * @param[in] load handle of the load.
+ */
+void
+ktxLevelLoad_Destroy(ktxLevelLoad* load)
+{
+    if (load == NULL)
+        return;
+    ktxEvent_wait(load->done);
+    ktxEvent_destroy(load->done);
+    free(load);
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
@@ -2466,6 +3190,144 @@ ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level)
     return This->_private->_levelIndex[level].byteOffset;
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief State shared by the jobs inflating the levels of a ktxTexture2.
+ */
+typedef struct ktxInflateLevelsState {
+    ktxTexture2* This;
+    ktx_uint8_t* pDeflatedData;
+    ktx_uint8_t* pInflatedData;
+    ktxLevelIndexEntry* nindex;  /*!< Level index of the inflated data. */
+    ZSTD_DCtx** dctxs;           /*!< One Zstd context per thread. */
+} ktxInflateLevelsState;
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Calculate the level index the texture will have after inflation.
+ *
+ * Levels are laid out smallest first, each padded to
+ * @p uncompressedLevelAlignment. Since the offsets depend only on the
+ * uncompressed lengths recorded in the file, each level can then be
+ * inflated independently of the others.
+ *
+ * @param[in] This          pointer to the ktxTexture2 object of interest.
+ * @param[out] nindex       pointer to an array of numLevels entries in which
+ *                          to write the new level index.
+ * @param[in] uncompressedLevelAlignment alignment of levels after inflation.
+ * @param[in] inflatedDataCapacity capacity of the buffer that will receive
+ *                                 the inflated data.
+ * @param[out] pInflatedByteLength pointer to where to write the size of the
+ *                                 inflated data.
+ *
+ * @exception KTX_DECOMPRESS_LENGTH_ERROR
+ *                          @p inflatedDataCapacity is too small.
+ */
+static KTX_error_code
+ktxTexture2_calcInflatedLevelIndex(ktxTexture2* This,
+                                   ktxLevelIndexEntry* nindex,
+                                   ktx_uint32_t uncompressedLevelAlignment,
+                                   ktx_size_t inflatedDataCapacity,
+                                   ktx_size_t* pInflatedByteLength)
+{
+    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
+    ktx_size_t levelOffset = 0;
+
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        ktx_size_t levelByteLength = cindex[level].uncompressedByteLength;
+        if (levelByteLength > inflatedDataCapacity
+            || levelOffset > inflatedDataCapacity - levelByteLength)
+            return KTX_DECOMPRESS_LENGTH_ERROR;
+
+        nindex[level].byteOffset = levelOffset;
+        nindex[level].uncompressedByteLength = nindex[level].byteLength =
+                                                            levelByteLength;
+        levelOffset += _KTX_PADN(uncompressedLevelAlignment, levelByteLength);
+    }
+    *pInflatedByteLength = levelOffset;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Update a ktxTexture2 object to describe its inflated data.
+ *
+ * @param[in] This          pointer to the ktxTexture2 object of interest.
+ * @param[in] nindex        the new level index.
+ * @param[in] uncompressedLevelAlignment alignment of the inflated levels.
+ * @param[in] inflatedByteLength size of the inflated data.
+ */
+static void
+ktxTexture2_setInflated(ktxTexture2* This, ktxLevelIndexEntry* nindex,
+                        ktx_uint32_t uncompressedLevelAlignment,
+                        ktx_size_t inflatedByteLength)
+{
+    DECLARE_PROTECTED(ktxTexture);
+
+    This->dataSize = inflatedByteLength;
+    This->supercompressionScheme = KTX_SS_NONE;
+    memcpy(This->_private->_levelIndex, nindex,
+           This->numLevels * sizeof(ktxLevelIndexEntry)); // Update level index
+    This->_private->_requiredLevelAlignment = uncompressedLevelAlignment;
+    // Set bytesPlane as we're now sized.
+    uint32_t* bdb = This->pDfd + 1;
+    // blockSizeInBits was set to the inflated size on file load.
+    bdb[KHR_DF_WORD_BYTESPLANE0] = prtctd->_formatSize.blockSizeInBits / 8;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Inflate a single level using Zstandard.
+ *
+ * PFNKTXPARALLELJOB for ktxTexture2_inflateZstdInt. @p level is the job
+ * index so the largest levels are started first.
+ */
+static KTX_error_code
+ktxTexture2_inflateZstdLevel(ktx_uint32_t level, ktx_uint32_t threadIndex,
+                             void* userdata)
+{
+    ktxInflateLevelsState* state = userdata;
+    ktxLevelIndexEntry* cindex = state->This->_private->_levelIndex;
+    ktxLevelIndexEntry* nindex = state->nindex;
+    ZSTD_DCtx* dctx = state->dctxs[threadIndex];
+
+    if (dctx == NULL) {
+        dctx = ktxContext_acquireDCtx(state->This->_private->_context);
+        if (dctx == NULL)
+            return KTX_OUT_OF_MEMORY;
+        state->dctxs[threadIndex] = dctx;
+    }
+
+    size_t levelByteLength =
+        ZSTD_decompressDCtx(dctx,
+                            state->pInflatedData + nindex[level].byteOffset,
+                            nindex[level].byteLength,
+                            &state->pDeflatedData[cindex[level].byteOffset],
+                            cindex[level].byteLength);
+    if (ZSTD_isError(levelByteLength)) {
+        ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLength);
+        switch(error) {
+          case ZSTD_error_dstSize_tooSmall:
+            return KTX_DECOMPRESS_LENGTH_ERROR; // More data than expected.
+          case ZSTD_error_checksum_wrong:
+            return KTX_DECOMPRESS_CHECKSUM_ERROR;
+          case ZSTD_error_memory_allocation:
+            return KTX_OUT_OF_MEMORY;
+          default:
+            return KTX_FILE_DATA_ERROR;
+        }
+    }
+
+    if (cindex[level].uncompressedByteLength != levelByteLength)
+        return KTX_DECOMPRESS_LENGTH_ERROR;
+
+    return KTX_SUCCESS;
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
@@ -2474,6 +3336,10 @@ ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level)
  * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
  * all be updated after successful inflation to reflect the inflated data.
  *
+ * Levels are independent Zstd frames so they are inflated directly to their
+ * final offsets and, when @p threadCount allows, in parallel. The result is
+ * identical whatever the number of threads.
+ *
  * @param[in] This                    pointer to the ktxTexture2 object of interest.
  * @param[in] pDeflatedData pointer to a buffer containing the deflated data
  *                         of the entire texture.
@@ -2481,21 +3347,19 @@ ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level)
  *                             data.
  * @param[in] inflatedDataCapacity capacity of the buffer pointed at by
  *                                @p pInflatedData.
+ * @param[in] threadCount maximum number of threads to use. 0 means the
+ *                        number of hardware threads.
  */
 KTX_error_code
 ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity)
+                           ktx_size_t inflatedDataCapacity,
+                           ktx_uint32_t threadCount)
 {
-    DECLARE_PROTECTED(ktxTexture);
-    ktx_uint32_t levelIndexByteLength =
-                            This->numLevels * sizeof(ktxLevelIndexEntry);
-    uint64_t levelOffset = 0;
-    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
-    ktxLevelIndexEntry* nindex;
+    ktxInflateLevelsState state;
     ktx_uint32_t uncompressedLevelAlignment;
-
-    ZSTD_DCtx* dctx;
+    ktx_size_t inflatedByteLength;
+    KTX_error_code result;
 
     if (pDeflatedData == NULL)
         return KTX_INVALID_VALUE;
@@ -2506,60 +3370,79 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
     if (This->supercompressionScheme != KTX_SS_ZSTD)
         return KTX_INVALID_OPERATION;
 
-    nindex = malloc(levelIndexByteLength);
-    if (nindex == NULL)
-        return KTX_OUT_OF_MEMORY;
+    threadCount = ktxParallel_threadCount(threadCount, This->numLevels);
+
+    state.This = This;
+    state.pDeflatedData = pDeflatedData;
+    state.pInflatedData = pInflatedData;
+    state.nindex = ktxContext_acquireBuffer(This->_private->_context,
+                            This->numLevels * sizeof(ktxLevelIndexEntry));
+    state.dctxs = ktxContext_acquireBuffer(This->_private->_context,
+                                           threadCount * sizeof(ZSTD_DCtx*));
+    if (state.dctxs)
+        memset(state.dctxs, 0, threadCount * sizeof(ZSTD_DCtx*));
+    if (state.nindex == NULL || state.dctxs == NULL) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
 
     uncompressedLevelAlignment =
         ktxTexture2_calcPostInflationLevelAlignment(This);
 
-    ktx_size_t inflatedByteLength = 0;
-    dctx = ZSTD_createDCtx();
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        size_t levelByteLength =
-            ZSTD_decompressDCtx(dctx, pInflatedData + levelOffset,
-                              inflatedDataCapacity,
-                              &pDeflatedData[cindex[level].byteOffset],
-                              cindex[level].byteLength);
-        if (ZSTD_isError(levelByteLength)) {
-            ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLength);
-            switch(error) {
-              case ZSTD_error_dstSize_tooSmall:
-                return KTX_DECOMPRESS_LENGTH_ERROR; // inflatedDataCapacity too small.
-              case ZSTD_error_checksum_wrong:
-                return KTX_DECOMPRESS_CHECKSUM_ERROR;
-              case ZSTD_error_memory_allocation:
-                return KTX_OUT_OF_MEMORY;
-              default:
-                return KTX_FILE_DATA_ERROR;
-            }
-        }
+    result = ktxTexture2_calcInflatedLevelIndex(This, state.nindex,
+                                                uncompressedLevelAlignment,
+                                                inflatedDataCapacity,
+                                                &inflatedByteLength);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
 
-        if (This->_private->_levelIndex[level].uncompressedByteLength != levelByteLength)
-            return KTX_DECOMPRESS_LENGTH_ERROR;
+    result = ktxParallel_for(This->numLevels, threadCount,
+                             ktxTexture2_inflateZstdLevel, &state);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
 
-        nindex[level].byteOffset = levelOffset;
-        nindex[level].uncompressedByteLength = nindex[level].byteLength =
-                                                            levelByteLength;
-        ktx_size_t paddedLevelByteLength
-              = _KTX_PADN(uncompressedLevelAlignment, levelByteLength);
-        inflatedByteLength += paddedLevelByteLength;
-        levelOffset += paddedLevelByteLength;
-        inflatedDataCapacity -= paddedLevelByteLength;
+    // Now modify the texture.
+    ktxTexture2_setInflated(This, state.nindex, uncompressedLevelAlignment,
+                            inflatedByteLength);
+
+cleanup:
+    if (state.dctxs) {
+        for (ktx_uint32_t i = 0; i < threadCount; i++)
+            ktxContext_releaseDCtx(This->_private->_context, state.dctxs[i]);
+        ktxContext_releaseBuffer(This->_private->_context, state.dctxs);
     }
-    ZSTD_freeDCtx(dctx);
+    ktxContext_releaseBuffer(This->_private->_context, state.nindex);
+    return result;
+}
 
-    // Now modify the texture.
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Inflate a single level using miniz (ZLIB).
+ *
+ * PFNKTXPARALLELJOB for ktxTexture2_inflateZLIBInt.
+ */
+static KTX_error_code
+ktxTexture2_inflateZLIBLevel(ktx_uint32_t level, ktx_uint32_t threadIndex,
+                             void* userdata)
+{
+    ktxInflateLevelsState* state = userdata;
+    ktxLevelIndexEntry* cindex = state->This->_private->_levelIndex;
+    ktxLevelIndexEntry* nindex = state->nindex;
+    size_t levelByteLength = nindex[level].byteLength;
+    KTX_error_code result;
+    (void)threadIndex;
 
-    This->dataSize = inflatedByteLength;
-    This->supercompressionScheme = KTX_SS_NONE;
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(nindex);
-    This->_private->_requiredLevelAlignment = uncompressedLevelAlignment;
-    // Set bytesPlane as we're now sized.
-    uint32_t* bdb = This->pDfd + 1;
-    // blockSizeInBits was set to the inflated size on file load.
-    bdb[KHR_DF_WORD_BYTESPLANE0] = prtctd->_formatSize.blockSizeInBits / 8;
+    result = ktxUncompressZLIBInt(state->This->_private->_context,
+                                  state->pInflatedData + nindex[level].byteOffset,
+                                  &levelByteLength,
+                                  &state->pDeflatedData[cindex[level].byteOffset],
+                                  cindex[level].byteLength);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (cindex[level].uncompressedByteLength != levelByteLength)
+        return KTX_DECOMPRESS_LENGTH_ERROR;
 
     return KTX_SUCCESS;
 }
@@ -2572,6 +3455,9 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
  * The texture's levelIndex, dataSize, DFD and supercompressionScheme will
  * all be updated after successful inflation to reflect the inflated data.
  *
+ * As with ktxTexture2_inflateZstdInt(), levels are inflated directly to
+ * their final offsets, in parallel when @p threadCount allows.
+ *
  * @param[in] This              pointer to the ktxTexture2 object of interest.
  * @param[in] pDeflatedData     pointer to a buffer containing the deflated
  *                              data of the entire texture.
@@ -2579,19 +3465,19 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
  *                              inflated data.
  * @param[in] inflatedDataCapacity capacity of the buffer pointed at by
  *                                @p pInflatedData.
+ * @param[in] threadCount maximum number of threads to use. 0 means the
+ *                        number of hardware threads.
  */
 KTX_error_code
 ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity)
+                           ktx_size_t inflatedDataCapacity,
+                           ktx_uint32_t threadCount)
 {
-    DECLARE_PROTECTED(ktxTexture);
-    ktx_uint32_t levelIndexByteLength =
-                            This->numLevels * sizeof(ktxLevelIndexEntry);
-    uint64_t levelOffset = 0;
-    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
-    ktxLevelIndexEntry* nindex;
+    ktxInflateLevelsState state;
     ktx_uint32_t uncompressedLevelAlignment;
+    ktx_size_t inflatedByteLength;
+    KTX_error_code result;
 
     if (pDeflatedData == NULL)
         return KTX_INVALID_VALUE;
@@ -2602,49 +3488,35 @@ ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
     if (This->supercompressionScheme != KTX_SS_ZLIB)
         return KTX_INVALID_OPERATION;
 
-    nindex = malloc(levelIndexByteLength);
-    if (nindex == NULL)
+    state.This = This;
+    state.pDeflatedData = pDeflatedData;
+    state.pInflatedData = pInflatedData;
+    state.dctxs = NULL;
+    state.nindex = ktxContext_acquireBuffer(This->_private->_context,
+                            This->numLevels * sizeof(ktxLevelIndexEntry));
+    if (state.nindex == NULL)
         return KTX_OUT_OF_MEMORY;
 
     uncompressedLevelAlignment =
         ktxTexture2_calcPostInflationLevelAlignment(This);
 
-    ktx_size_t inflatedByteLength = 0;
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        size_t levelByteLength = inflatedDataCapacity;
-        KTX_error_code result = ktxUncompressZLIBInt(pInflatedData + levelOffset,
-                                                    &levelByteLength,
-                                                    &pDeflatedData[cindex[level].byteOffset],
-                                                    cindex[level].byteLength);
-        if (result != KTX_SUCCESS)
-            return result;
-
-        if (This->_private->_levelIndex[level].uncompressedByteLength != levelByteLength)
-            return KTX_DECOMPRESS_LENGTH_ERROR;
-
-        nindex[level].byteOffset = levelOffset;
-        nindex[level].uncompressedByteLength = nindex[level].byteLength =
-                                                            levelByteLength;
-        ktx_size_t paddedLevelByteLength
-              = _KTX_PADN(uncompressedLevelAlignment, levelByteLength);
-        inflatedByteLength += paddedLevelByteLength;
-        levelOffset += paddedLevelByteLength;
-        inflatedDataCapacity -= paddedLevelByteLength;
+    result = ktxTexture2_calcInflatedLevelIndex(This, state.nindex,
+                                                uncompressedLevelAlignment,
+                                                inflatedDataCapacity,
+                                                &inflatedByteLength);
+    if (result == KTX_SUCCESS) {
+        threadCount = ktxParallel_threadCount(threadCount, This->numLevels);
+        result = ktxParallel_for(This->numLevels, threadCount,
+                                 ktxTexture2_inflateZLIBLevel, &state);
+    }
+    if (result == KTX_SUCCESS) {
+        // Now modify the texture.
+        ktxTexture2_setInflated(This, state.nindex, uncompressedLevelAlignment,
+                                inflatedByteLength);
     }
 
-    // Now modify the texture.
-
-    This->dataSize = inflatedByteLength;
-    This->supercompressionScheme = KTX_SS_NONE;
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(nindex);
-    This->_private->_requiredLevelAlignment = uncompressedLevelAlignment;
-    // Set bytesPlane as we're now sized.
-    uint32_t* bdb = This->pDfd + 1;
-    // blockSizeInBits was set to the inflated size on file load.
-    bdb[KHR_DF_WORD_BYTESPLANE0] = prtctd->_formatSize.blockSizeInBits / 8;
-
-    return KTX_SUCCESS;
+    ktxContext_releaseBuffer(This->_private->_context, state.nindex);
+    return result;
 }
 
 #if !KTX_FEATURE_WRITE
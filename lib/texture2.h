@@ -37,6 +37,16 @@ typedef struct ktxTexture2_private {
     ktx_uint64_t _firstLevelFileOffset; /*!< Always 0, unless the texture was
                                          created from a stream and the image
                                          data is not yet loaded. */
+    ktx_uint8_t* _mappedData; /*!< Start of the file mapping pData points
+                                   into, if the image data is mapped. */
+    ktx_size_t _mappedSize;   /*!< Size of the file mapping. */
+    struct ktxWorker* _levelLoader; /*!< I/O thread for asynchronous level
+                                         loads. Created on first use. */
+    ktxContext* _context;     /*!< Source of reusable decompression and
+                                   compression state. Not owned. */
+    const ktxEtc1sCodebook* _etc1sCodebook; /*!< Shared ETC1S codebooks for a
+                                                 texture encoded without its
+                                                 own. Not owned. */
     // Must be last so it can grow.
     ktxLevelIndexEntry _levelIndex[1]; /*!< Offsets in this index are from the
                                         start of the image data. Use
@@ -57,11 +67,19 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
                                          KTX_header2* pHeader,
                                          ktxTextureCreateFlags createFlags);
 
+void ktxTexture2_freeImageData(ktxTexture2* This);
+
 ktx_uint64_t ktxTexture2_calcDataSizeTexture(ktxTexture2* This);
 ktx_size_t ktxTexture2_calcLevelOffset(ktxTexture2* This, ktx_uint32_t level);
 ktx_uint32_t ktxTexture2_calcRequiredLevelAlignment(ktxTexture2* This);
+uint32_t lcm4(uint32_t a);
 ktx_uint64_t ktxTexture2_levelFileOffset(ktxTexture2* This, ktx_uint32_t level);
 ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level);
+KTX_error_code
+ktxTexture2_readLevelInt(ktxTexture2* This, ktx_uint32_t level,
+                         ktx_uint8_t* pLevel, ktx_size_t levelCapacity,
+                         ktx_uint8_t* pScratch, ktx_size_t scratchCapacity,
+                         ktx_size_t* pLevelByteLength);
 
 #ifdef __cplusplus
 }
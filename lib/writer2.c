@@ -332,32 +332,40 @@ ktx_bool_t __disableWriterMetadata__ = KTX_FALSE;
 #endif
 
 /**
- * @memberof ktxTexture2
+ * @memberof ktxTexture2 @private
  * @~English
- * @brief Write a ktxTexture object to a ktxStream in KTX format.
+ * @brief The parts of a KTX file that precede the level data.
+ */
+typedef struct ktxFilePrefix {
+    KTX_header2 header;
+    ktx_uint8_t* pKvd;               /*!< Serialized metadata. Free with
+                                          free(). */
+    ktx_uint32_t align8PadLen;       /*!< Padding before the SGD. */
+    ktx_uint32_t initialLevelPadLen; /*!< Padding before the first level. */
+    ktx_uint64_t levelDataOffset;    /*!< File offset of the first level. */
+} ktxFilePrefix;
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Lay out the header, DFD, metadata and supercompression global data
+ *        of a texture's KTX file.
  *
- * @param[in] This      pointer to the target ktxTexture object.
- * @param[in] dststr    destination ktxStream.
+ * Adds the library's id to the KTXwriter metadata, as every written file
+ * gets it.
  *
- * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ * @param[in]  This           pointer to the ktxTexture2 object of interest.
+ * @param[in]  scheme         supercompression scheme of the written levels.
+ * @param[in]  levelAlignment required alignment of the first level.
+ * @param[out] prefix         the layout.
  *
- * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
- * @exception KTX_INVALID_OPERATION
- *                              The ktxTexture does not contain any image data.
- * @exception KTX_INVALID_OPERATION
- *                              Both kvDataHead and kvData are set in the
- *                              ktxTexture
- * @exception KTX_INVALID_OPERATION
- *                              The length of the already set writerId metadata
- *                              plus the library's version id exceeds the
- *                              maximum allowed.
- * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
- *                              the system.
- * @exception KTX_FILE_WRITE_ERROR
- *                              An error occurred while writing the file.
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *              See ktxTexture2\_WriteToStream() for the errors.
  */
-KTX_error_code
-ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
+static KTX_error_code
+ktxTexture2_buildFilePrefix(ktxTexture2* This, ktxSupercmpScheme scheme,
+                            ktx_uint32_t levelAlignment,
+                            ktxFilePrefix* prefix)
 {
     DECLARE_PRIVATE(ktxTexture2);
     KTX_header2 header = { .identifier = KTX2_IDENTIFIER_REF };
@@ -366,17 +374,9 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     ktx_uint8_t* pKvd;
     ktx_uint32_t align8PadLen = 0;
     ktx_uint64_t sgdLen;
-    ktx_uint32_t initialLevelPadLen;
     ktx_uint32_t levelIndexSize;
     ktx_uint64_t baseOffset;
 
-    if (!dststr) {
-        return KTX_INVALID_VALUE;
-    }
-
-    if (This->pData == NULL)
-        return KTX_INVALID_OPERATION;
-
     header.vkFormat = This->vkFormat;
     header.typeSize = This->_protected->_typeSize;
     header.pixelWidth = This->baseWidth;
@@ -387,7 +387,7 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     header.faceCount = This->numFaces;
     assert (This->generateMipmaps? This->numLevels == 1 : This->numLevels >= 1);
     header.levelCount = This->generateMipmaps ? 0 : This->numLevels;
-    header.supercompressionScheme = This->supercompressionScheme;
+    header.supercompressionScheme = scheme;
 
     levelIndexSize = sizeof(ktxLevelIndexEntry) * This->numLevels;
 
@@ -459,51 +459,98 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     header.supercompressionGlobalData.byteLength = sgdLen;
     baseOffset += sgdLen;
 
-    initialLevelPadLen = _KTX_PADN_LEN(This->_private->_requiredLevelAlignment,
-                                       baseOffset);
-    baseOffset += initialLevelPadLen;
+    prefix->header = header;
+    prefix->pKvd = kvdLen != 0 ? pKvd : NULL;
+    prefix->align8PadLen = align8PadLen;
+    prefix->initialLevelPadLen = _KTX_PADN_LEN(levelAlignment, baseOffset);
+    prefix->levelDataOffset = baseOffset + prefix->initialLevelPadLen;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Write a level index with file-adjusted offsets.
+ *
+ * @param[in] dststr          destination ktxStream.
+ * @param[in] levelIndex      the level index with offsets relative to the
+ *                            first level.
+ * @param[in] numLevels       number of entries in @p levelIndex.
+ * @param[in] levelDataOffset file offset of the first level.
+ */
+static KTX_error_code
+ktxWriteLevelIndex(ktxStream* dststr, const ktxLevelIndexEntry* levelIndex,
+                   ktx_uint32_t numLevels, ktx_uint64_t levelDataOffset)
+{
+    ktx_uint32_t levelIndexSize = sizeof(ktxLevelIndexEntry) * numLevels;
+    KTX_error_code result;
+
+    ktxLevelIndexEntry* fileIndex = (ktxLevelIndexEntry*)malloc(levelIndexSize);
+    if (!fileIndex)
+        return KTX_OUT_OF_MEMORY;
+    for (ktx_uint32_t level = 0; level < numLevels; level++) {
+        fileIndex[level].byteLength = levelIndex[level].byteLength;
+        fileIndex[level].uncompressedByteLength
+                         = levelIndex[level].uncompressedByteLength;
+        fileIndex[level].byteOffset = levelIndex[level].byteOffset
+                                    + levelDataOffset;
+    }
+    result = dststr->write(dststr, fileIndex, levelIndexSize, 1);
+    free(fileIndex);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Write everything that precedes the level data in a KTX file.
+ *
+ * @param[in] This       pointer to the ktxTexture2 object of interest.
+ * @param[in] prefix     layout from ktxTexture2\_buildFilePrefix().
+ * @param[in] pDfd       the DFD to write.
+ * @param[in] levelIndex level index with offsets relative to the first level.
+ * @param[in] dststr     destination ktxStream.
+ */
+static KTX_error_code
+ktxTexture2_writeFilePrefix(ktxTexture2* This, const ktxFilePrefix* prefix,
+                            const ktx_uint32_t* pDfd,
+                            const ktxLevelIndexEntry* levelIndex,
+                            ktxStream* dststr)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    const KTX_header2* header = &prefix->header;
+    KTX_error_code result;
 
     // write header and indices
-    result = dststr->write(dststr, &header, sizeof(header), 1);
+    result = dststr->write(dststr, header, sizeof(*header), 1);
     if (result != KTX_SUCCESS)
         return result;
 
-    // Create a copy of the level index with file-adjusted offsets and write it.
-    ktxLevelIndexEntry* levelIndex
-                            = (ktxLevelIndexEntry*)malloc(levelIndexSize);
-    if (!levelIndex)
-        return KTX_OUT_OF_MEMORY;
-    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
-        levelIndex[level].byteLength = private->_levelIndex[level].byteLength;
-        levelIndex[level].uncompressedByteLength
-                         = private->_levelIndex[level].uncompressedByteLength;
-        levelIndex[level].byteOffset = private->_levelIndex[level].byteOffset;
-        levelIndex[level].byteOffset += baseOffset;
-    }
-    result = dststr->write(dststr, levelIndex, levelIndexSize, 1);
-    free(levelIndex);
+    result = ktxWriteLevelIndex(dststr, levelIndex, This->numLevels,
+                                prefix->levelDataOffset);
     if (result != KTX_SUCCESS)
         return result;
 
-   // write data format descriptor
-   result = dststr->write(dststr, This->pDfd, 1, *This->pDfd);
+    // write data format descriptor
+    result = dststr->write(dststr, pDfd, 1, *pDfd);
+    if (result != KTX_SUCCESS)
+        return result;
 
-   // write keyValueData
-    if (kvdLen != 0) {
-        assert(pKvd != NULL);
+    // write keyValueData
+    if (header->keyValueData.byteLength != 0) {
+        assert(prefix->pKvd != NULL);
 
-        result = dststr->write(dststr, pKvd, 1, kvdLen);
-        free(pKvd);
-        if (result != KTX_SUCCESS) {
-             return result;
-        }
+        result = dststr->write(dststr, prefix->pKvd, 1,
+                               header->keyValueData.byteLength);
+        if (result != KTX_SUCCESS)
+            return result;
     }
 
     char padding[32] = { 0 };
     // write supercompressionGlobalData & sgdPadding
     if (private->_sgdByteLength != 0) {
-        if (align8PadLen) {
-            result = dststr->write(dststr, padding, 1, align8PadLen);
+        if (prefix->align8PadLen) {
+            result = dststr->write(dststr, padding, 1, prefix->align8PadLen);
             if (result != KTX_SUCCESS) {
                  return result;
             }
@@ -516,12 +563,32 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
         }
     }
 
-    if (initialLevelPadLen) {
-        result = dststr->write(dststr, padding, 1, initialLevelPadLen);
-        if (result != KTX_SUCCESS) {
-             return result;
-        }
+    if (prefix->initialLevelPadLen) {
+        result = dststr->write(dststr, padding, 1,
+                               prefix->initialLevelPadLen);
     }
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Write a texture's KTX file, laid out by
+ *        ktxTexture2\_buildFilePrefix(), to a ktxStream.
+ */
+static KTX_error_code
+ktxTexture2_writeFile(ktxTexture2* This, const ktxFilePrefix* prefix,
+                      ktxStream* dststr)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    KTX_error_code result;
+
+    result = ktxTexture2_writeFilePrefix(This, prefix, This->pDfd,
+                                         private->_levelIndex, dststr);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    char padding[32] = { 0 };
 
     // write the image data
     for (ktx_int32_t level = This->numLevels-1; level >= 0 && result == KTX_SUCCESS; --level)
@@ -536,7 +603,8 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
         result = dststr->getpos(dststr, (ktx_off_t*)&pos);
         // Could fail if stdout is a pipe
         if (result == KTX_SUCCESS)
-            assert(pos == private->_levelIndex[level].byteOffset + baseOffset);
+            assert(pos == private->_levelIndex[level].byteOffset
+                          + prefix->levelDataOffset);
         else
             assert(result == KTX_FILE_ISPIPE);
 #endif
@@ -579,6 +647,73 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     return result;
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Size of a texture's KTX file laid out by
+ *        ktxTexture2\_buildFilePrefix().
+ */
+static ktx_size_t
+ktxTexture2_fileSize(ktxTexture2* This, const ktxFilePrefix* prefix)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+
+    // Level 0 is last in the file.
+    return (ktx_size_t)(prefix->levelDataOffset
+                        + private->_levelIndex[0].byteOffset
+                        + private->_levelIndex[0].byteLength);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture object to a ktxStream in KTX format.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data.
+ * @exception KTX_INVALID_OPERATION
+ *                              Both kvDataHead and kvData are set in the
+ *                              ktxTexture
+ * @exception KTX_INVALID_OPERATION
+ *                              The length of the already set writerId metadata
+ *                              plus the library's version id exceeds the
+ *                              maximum allowed.
+ * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
+ *                              the system.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    ktxFilePrefix prefix;
+    KTX_error_code result;
+
+    if (!dststr) {
+        return KTX_INVALID_VALUE;
+    }
+
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    result = ktxTexture2_buildFilePrefix(This, This->supercompressionScheme,
+                                         private->_requiredLevelAlignment,
+                                         &prefix);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    result = ktxTexture2_writeFile(This, &prefix, dststr);
+    free(prefix.pKvd);
+    return result;
+}
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -725,7 +860,9 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
                           ktx_uint8_t** ppDstBytes, ktx_size_t* pSize)
 {
     struct ktxStream dststr;
+    ktxFilePrefix prefix;
     KTX_error_code result;
+    ktx_size_t fileSize;
     ktx_size_t strSize;
 
     if (!This || !ppDstBytes || !pSize)
@@ -733,20 +870,38 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
 
     *ppDstBytes = NULL;
 
-    result = ktxMemStream_construct(&dststr, KTX_FALSE);
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    result = ktxTexture2_buildFilePrefix(This, This->supercompressionScheme,
+                                         This->_private->_requiredLevelAlignment,
+                                         &prefix);
     if (result != KTX_SUCCESS)
         return result;
 
-    result = ktxTexture2_WriteToStream(This, &dststr);
-    if(result != KTX_SUCCESS)
-    {
-        ktxMemStream_destruct(&dststr);
-        return result;
+    // Allocate the whole file up front rather than letting the stream
+    // double its memory, and copy it, as the file is written.
+    fileSize = ktxTexture2_fileSize(This, &prefix);
+    result = ktxMemStream_construct(&dststr, KTX_FALSE);
+    if (result == KTX_SUCCESS) {
+        result = ktxMemStream_reserve(&dststr, fileSize);
+        if (result == KTX_SUCCESS)
+            result = ktxTexture2_writeFile(This, &prefix, &dststr);
+        if (result != KTX_SUCCESS) {
+            ktxMemStream_getdata(&dststr, ppDstBytes);
+            free(*ppDstBytes);
+            *ppDstBytes = NULL;
+            ktxMemStream_destruct(&dststr);
+        }
     }
+    free(prefix.pKvd);
+    if (result != KTX_SUCCESS)
+        return result;
 
     ktxMemStream_getdata(&dststr, ppDstBytes);
     dststr.getsize(&dststr, &strSize);
-    *pSize = (GLsizei)strSize;
+    assert(strSize == fileSize);
+    *pSize = strSize;
     /* This function does not free the memory pointed at by the
      * value obtained from ktxMemStream_getdata() thanks to the
      * KTX_FALSE passed to the constructor above.
@@ -758,169 +913,453 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
 
 /**
  * @memberof ktxTexture2
+ * @ingroup writer
  * @~English
- * @brief Deflate the data in a ktxTexture2 object using Zstandard.
+ * @brief Get the size of the KTX file the texture will be written as.
  *
- * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
- * all be updated after successful deflation to reflect the deflated data.
+ * This is the exact number of bytes ktxTexture2\_WriteToMemory(),
+ * ktxTexture2\_WriteToStream() and the other write functions will write:
+ * header, level index, DFD, metadata, supercompression global data, the
+ * levels and the padding between them. Nothing is written and the image
+ * data need not be loaded. Use it to size memory in advance, e.g. for a
+ * custom ktxStream passed to ktxTexture2\_WriteToStream() that writes into
+ * an application's own buffer.
  *
- * @param[in] This pointer to the ktxTexture2 object of interest.
- * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
- *            between 1 and 22 are accepted. The lower the level the faster. Values
- *            above 20 should be used with caution as they require more memory.
+ * As when writing, the library's id is added to the texture's KTXwriter
+ * metadata and included in the size. The size is valid until the texture's
+ * metadata or image data are next changed.
+ *
+ * @param[in]  This     pointer to the ktxTexture2 object of interest.
+ * @param[out] pSize    pointer to location to store the size in bytes of
+ *                      the KTX file.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pSize is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              Both kvDataHead and kvData are set in the
+ *                              ktxTexture or the metadata is invalid. See
+ *                              ktxTexture2\_WriteToStream().
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to serialize the metadata.
  */
 KTX_error_code
-ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
+ktxTexture2_GetSerializedSize(ktxTexture2* This, ktx_size_t* pSize)
 {
-    ktx_uint32_t levelIndexByteLength =
-                            This->numLevels * sizeof(ktxLevelIndexEntry);
-    ktx_uint8_t* workBuf;
-    ktx_uint8_t* cmpData;
-    ktx_size_t dstRemainingByteLength = 0;
-    ktx_size_t byteLengthCmp = 0;
-    ktx_size_t levelOffset = 0;
-    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
-    ktxLevelIndexEntry* nindex;
-    ktx_uint8_t* pCmpDst;
+    ktxFilePrefix prefix;
+    KTX_error_code result;
 
-    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    if (!This || !pSize)
+        return KTX_INVALID_VALUE;
 
-    if (This->supercompressionScheme != KTX_SS_NONE)
-        return KTX_INVALID_OPERATION;
+    result = ktxTexture2_buildFilePrefix(This, This->supercompressionScheme,
+                                         This->_private->_requiredLevelAlignment,
+                                         &prefix);
+    if (result != KTX_SUCCESS)
+        return result;
+    free(prefix.pKvd);
 
-    // On rare occasions the deflated data can be a few bytes larger than
-    // the source data. Calculating the dst buffer size using
-    // ZSTD_compressBound provides a suitable size plus compression is said
-    // to run faster when the dst buffer is >= compressBound.
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        dstRemainingByteLength += ZSTD_compressBound(cindex[level].byteLength);
-    }
+    *pSize = ktxTexture2_fileSize(This, &prefix);
+    return KTX_SUCCESS;
+}
 
-    workBuf = malloc(dstRemainingByteLength + levelIndexByteLength);
-    if (workBuf == NULL)
-        return KTX_OUT_OF_MEMORY;
-    nindex = (ktxLevelIndexEntry*)workBuf;
-    pCmpDst = &workBuf[levelIndexByteLength];
+/**
+ * @internal
+ * @~English
+ * @brief Levels at least this big are split into jobs for Zstd's own
+ *        worker threads rather than being compressed alongside other levels.
+ *
+ * Matches the minimum job size Zstd uses for multithreaded compression.
+ */
+#define KTX_ZSTD_MT_MIN_LEVEL_BYTE_LENGTH (1 << 20)
 
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        size_t levelByteLengthCmp =
-            ZSTD_compressCCtx(cctx, pCmpDst + levelOffset,
-                              dstRemainingByteLength,
-                              &This->pData[cindex[level].byteOffset],
-                              cindex[level].byteLength,
-                              compressionLevel);
-        if (ZSTD_isError(levelByteLengthCmp)) {
-            free(workBuf);
-            ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLengthCmp);
-            switch(error) {
-              case ZSTD_error_parameter_outOfBound:
-                return KTX_INVALID_VALUE;
-              case ZSTD_error_dstSize_tooSmall:
-#ifdef DEBUG
-                assert(false && "Deflate dstSize too small.");
-#else
-                return KTX_OUT_OF_MEMORY;
-#endif
-              case ZSTD_error_workSpace_tooSmall:
+/**
+ * @internal
+ * @~English
+ * @brief Largest windowLog accepted by Zstd decoders without raising their
+ *        window limit, i.e. ZSTD_WINDOWLOG_LIMIT_DEFAULT.
+ */
+#define KTX_ZSTD_WINDOWLOG_LIMIT 27
+
+/**
+ * @internal
+ * @~English
+ * @brief Map a Zstd compression error to a KTX_error_code.
+ */
+static KTX_error_code
+ktxZstdCompressError(size_t zstdResult)
+{
+    ZSTD_ErrorCode error = ZSTD_getErrorCode(zstdResult);
+    switch(error) {
+      case ZSTD_error_parameter_unsupported:
+      case ZSTD_error_parameter_outOfBound:
+        return KTX_INVALID_VALUE;
+      case ZSTD_error_dstSize_tooSmall:
 #ifdef DEBUG
-                assert(false && "Deflate workspace too small.");
-#else
-                return KTX_OUT_OF_MEMORY;
+        assert(false && "Deflate dstSize too small.");
 #endif
-              case ZSTD_error_memory_allocation:
-                return KTX_OUT_OF_MEMORY;
-              default:
-                // The remaining errors look like they should only
-                // occur during decompression but just in case.
+        return KTX_OUT_OF_MEMORY;
+      case ZSTD_error_workSpace_tooSmall:
 #ifdef DEBUG
-                assert(true);
-#else
-                return KTX_INVALID_OPERATION;
+        assert(false && "Deflate workspace too small.");
 #endif
-            }
-        }
-        nindex[level].byteOffset = levelOffset;
-        nindex[level].uncompressedByteLength = cindex[level].byteLength;
-        nindex[level].byteLength = levelByteLengthCmp;
-        byteLengthCmp += levelByteLengthCmp;
-        levelOffset += levelByteLengthCmp;
-        dstRemainingByteLength -= levelByteLengthCmp;
-    }
-    ZSTD_freeCCtx(cctx);
-
-    // Move the compressed data into a correctly sized buffer.
-    cmpData = malloc(byteLengthCmp);
-    if (cmpData == NULL) {
-        free(workBuf);
         return KTX_OUT_OF_MEMORY;
+      case ZSTD_error_memory_allocation:
+        return KTX_OUT_OF_MEMORY;
+      default:
+        // The remaining errors look like they should only
+        // occur during decompression but just in case.
+        return KTX_INVALID_OPERATION;
     }
-    // Now modify the texture.
-    memcpy(cmpData, pCmpDst, byteLengthCmp); // Copy data to sized buffer.
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(workBuf);
-    free(This->pData);
-    This->pData = cmpData;
-    This->dataSize = byteLengthCmp;
-    This->supercompressionScheme = KTX_SS_ZSTD;
-    This->_private->_requiredLevelAlignment = 1;
-    // Clear bytesPlane to indicate we're now unsized.
-    uint32_t* bdb = This->pDfd + 1;
-    bdb[KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
-
-    return KTX_SUCCESS;
 }
 
 /**
- * @memberof ktxTexture2
+ * @internal
  * @~English
- * @brief Deflate the data in a ktxTexture2 object using miniz (ZLIB).
+ * @brief Create a Zstd compression context configured from @p params.
  *
- * The texture's levelIndex, dataSize, DFD and supercompressionScheme will
- * all be updated after successful deflation to reflect the deflated data.
+ * Release it with ktxContext_releaseCCtx().
  *
- * @param[in] This pointer to the ktxTexture2 object of interest.
- * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
- *            between 1 and 9 are accepted. The lower the level the faster.
+ * @param[in] context   context from which to take the Zstd context. May be
+ *                      @c NULL.
+ * @param[in] params    the compression parameters.
+ * @param[in] nbWorkers number of Zstd worker threads. 0 compresses on the
+ *                      calling thread.
+ * @param[out] pCctx    pointer to where to write the new context.
  */
-KTX_error_code
-ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t compressionLevel)
+static KTX_error_code
+ktxZstdCreateCCtx(ktxContext* context, const ktxZstdParams* params,
+                  ktx_uint32_t nbWorkers, ZSTD_CCtx** pCctx)
 {
-    ktx_uint32_t levelIndexByteLength =
-                            This->numLevels * sizeof(ktxLevelIndexEntry);
-    ktx_uint8_t* workBuf;
-    ktx_uint8_t* cmpData;
-    ktx_size_t dstRemainingByteLength = 0;
-    ktx_size_t byteLengthCmp = 0;
-    ktx_size_t levelOffset = 0;
-    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
-    ktxLevelIndexEntry* nindex;
-    ktx_uint8_t* pCmpDst;
+    ZSTD_CCtx* cctx = ktxContext_acquireCCtx(context);
+    size_t zresult;
 
-    if (This->supercompressionScheme != KTX_SS_NONE)
-        return KTX_INVALID_OPERATION;
+    if (cctx == NULL)
+        return KTX_OUT_OF_MEMORY;
 
-    // On rare occasions the deflated data can be a few bytes larger than
-    // the source data. Calculating the dst buffer size using
-    // mz_deflateBound provides a conservative size to account for that.
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        dstRemainingByteLength += ktxCompressZLIBBounds(cindex[level].byteLength);
+    zresult = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+                                     (int)params->compressionLevel);
+    if (!ZSTD_isError(zresult) && params->enableLongDistanceMatching)
+        zresult = ZSTD_CCtx_setParameter(cctx,
+                                         ZSTD_c_enableLongDistanceMatching, 1);
+    if (!ZSTD_isError(zresult) && params->windowLog != 0)
+        zresult = ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog,
+                                         (int)params->windowLog);
+    if (!ZSTD_isError(zresult) && nbWorkers != 0)
+        zresult = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers,
+                                         (int)nbWorkers);
+    if (ZSTD_isError(zresult)) {
+        ktxContext_releaseCCtx(context, cctx);
+        return ktxZstdCompressError(zresult);
     }
+    *pCctx = cctx;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief State shared by the jobs deflating the levels of a ktxTexture2.
+ */
+typedef struct ktxDeflateLevelsState {
+    ktxTexture2* This;
+    const ktxZstdParams* params;
+    ktx_uint8_t* pCmpDst;        /*!< Buffer with a compressBound sized
+                                      slot for each level. Becomes the
+                                      texture's data once packed. */
+    ktxLevelIndexEntry* nindex;  /*!< byteOffset is the level's slot in
+                                      pCmpDst until the data is packed. */
+    ktx_uint32_t* jobLevels;     /*!< Level compressed by each job. */
+    ZSTD_CCtx** cctxs;           /*!< One Zstd context per thread. */
+} ktxDeflateLevelsState;
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Deflate a single level into its slot in the work buffer.
+ */
+static KTX_error_code
+ktxTexture2_deflateZstdLevel(ktxDeflateLevelsState* state, ZSTD_CCtx* cctx,
+                             ktx_uint32_t level)
+{
+    ktxLevelIndexEntry* cindex = state->This->_private->_levelIndex;
+    ktxLevelIndexEntry* nindex = state->nindex;
+
+    size_t levelByteLengthCmp =
+        ZSTD_compress2(cctx, state->pCmpDst + nindex[level].byteOffset,
+                       nindex[level].byteLength,
+                       &state->This->pData[cindex[level].byteOffset],
+                       cindex[level].byteLength);
+    if (ZSTD_isError(levelByteLengthCmp))
+        return ktxZstdCompressError(levelByteLengthCmp);
+
+    nindex[level].byteLength = levelByteLengthCmp;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief PFNKTXPARALLELJOB deflating one of the levels too small to be
+ *        worth splitting.
+ */
+static KTX_error_code
+ktxTexture2_deflateZstdLevelJob(ktx_uint32_t jobIndex,
+                                ktx_uint32_t threadIndex, void* userdata)
+{
+    ktxDeflateLevelsState* state = userdata;
+    ZSTD_CCtx* cctx = state->cctxs[threadIndex];
+
+    if (cctx == NULL) {
+        KTX_error_code result =
+            ktxZstdCreateCCtx(state->This->_private->_context, state->params,
+                              0, &cctx);
+        if (result != KTX_SUCCESS)
+            return result;
+        state->cctxs[threadIndex] = cctx;
+    }
+    return ktxTexture2_deflateZstdLevel(state, cctx,
+                                        state->jobLevels[jobIndex]);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object using Zstandard.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * @param[in] This pointer to the ktxTexture2 object of interest.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
+ *            between 1 and 22 are accepted. The lower the level the faster. Values
+ *            above 20 should be used with caution as they require more memory.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
+{
+    ktxZstdParams params = {0};
+
+    params.structSize = sizeof(params);
+    params.compressionLevel = compressionLevel;
+    params.threadCount = 1;
+    return ktxTexture2_DeflateZstdEx(This, &params);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object using Zstandard with
+ *        extended parameters.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * When @c params->threadCount is greater than 1, levels of at least 1 MiB
+ * are each compressed by Zstd using that many worker threads, one level
+ * after another, then the remaining, smaller, levels are compressed
+ * concurrently, one level per thread. Each level is still a single Zstd
+ * frame so the result can be read by any KTX2 reader.
+ *
+ * @param[in] This   pointer to the ktxTexture2 object of interest.
+ * @param[in] params pointer to a ktxZstdParams struct.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_OPERATION
+ *                              The texture is already supercompressed.
+ * @exception KTX_INVALID_VALUE @p params is NULL, @c params->structSize is
+ *                              not sizeof(ktxZstdParams) or
+ *                              @c params->windowLog is out of range.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to carry out compression.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstdEx(ktxTexture2* This, ktxZstdParams* params)
+{
+    ktxDeflateLevelsState state;
+    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
+    ktxContext* context = This->_private->_context;
+    ktx_size_t workBufByteLength = 0;
+    ktx_size_t byteLengthCmp = 0;
+    ktx_uint32_t threadCount;
+    ktx_uint32_t numJobs = 0;
+    ktx_uint8_t* cmpData;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (This->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
 
-    workBuf = malloc(dstRemainingByteLength + levelIndexByteLength);
-    if (workBuf == NULL)
+    if (params == NULL || params->structSize != sizeof(ktxZstdParams))
+        return KTX_INVALID_VALUE;
+
+    // Readers, including this library, use Zstd's default window limit.
+    if (params->windowLog != 0
+        && (params->windowLog < (ktx_uint32_t)
+                            ZSTD_cParam_getBounds(ZSTD_c_windowLog).lowerBound
+            || params->windowLog > KTX_ZSTD_WINDOWLOG_LIMIT))
+        return KTX_INVALID_VALUE;
+
+    threadCount = params->threadCount ? params->threadCount : 1;
+
+    memset(&state, 0, sizeof(state));
+    state.This = This;
+    state.params = params;
+    state.nindex = ktxContext_acquireBuffer(context,
+                            This->numLevels * sizeof(ktxLevelIndexEntry));
+    state.jobLevels = ktxContext_acquireBuffer(context,
+                            This->numLevels * sizeof(ktx_uint32_t));
+    state.cctxs = ktxContext_acquireBuffer(context,
+                            threadCount * sizeof(ZSTD_CCtx*));
+    if (state.cctxs)
+        memset(state.cctxs, 0, threadCount * sizeof(ZSTD_CCtx*));
+    if (!state.nindex || !state.jobLevels || !state.cctxs) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+
+    // On rare occasions the deflated data can be a few bytes larger than
+    // the source data. Calculating the dst buffer size using
+    // ZSTD_compressBound provides a suitable size plus compression is said
+    // to run faster when the dst buffer is >= compressBound. Each level
+    // gets its own slot so levels can be compressed in any order. The slots
+    // are in file order so the levels can be packed in place afterwards.
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        state.nindex[level].byteOffset = workBufByteLength;
+        state.nindex[level].byteLength =
+                            ZSTD_compressBound(cindex[level].byteLength);
+        state.nindex[level].uncompressedByteLength = cindex[level].byteLength;
+        workBufByteLength += state.nindex[level].byteLength;
+    }
+
+    // Not from the context as it becomes the texture's data.
+    state.pCmpDst = malloc(workBufByteLength);
+    if (state.pCmpDst == NULL) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        if (threadCount > 1
+            && cindex[level].byteLength >= KTX_ZSTD_MT_MIN_LEVEL_BYTE_LENGTH) {
+            ZSTD_CCtx* mtcctx;
+            result = ktxZstdCreateCCtx(context, params, threadCount, &mtcctx);
+            if (result != KTX_SUCCESS)
+                goto cleanup;
+            result = ktxTexture2_deflateZstdLevel(&state, mtcctx, level);
+            ktxContext_releaseCCtx(context, mtcctx);
+            if (result != KTX_SUCCESS)
+                goto cleanup;
+        } else {
+            state.jobLevels[numJobs++] = level;
+        }
+    }
+
+    result = ktxParallel_for(numJobs,
+                             ktxParallel_threadCount(threadCount, numJobs),
+                             ktxTexture2_deflateZstdLevelJob, &state);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    // Pack the levels. Each only moves towards the start of the buffer,
+    // past levels already packed.
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        if (state.nindex[level].byteOffset != byteLengthCmp)
+            memmove(state.pCmpDst + byteLengthCmp,
+                    state.pCmpDst + state.nindex[level].byteOffset,
+                    state.nindex[level].byteLength);
+        state.nindex[level].byteOffset = byteLengthCmp;
+        byteLengthCmp += state.nindex[level].byteLength;
+    }
+
+    // Shrink the buffer to fit. If that fails the original buffer remains
+    // valid and is kept.
+    cmpData = realloc(state.pCmpDst, byteLengthCmp);
+    if (cmpData == NULL)
+        cmpData = state.pCmpDst;
+    state.pCmpDst = NULL;
+
+    // Now modify the texture.
+    memcpy(cindex, state.nindex, This->numLevels * sizeof(ktxLevelIndexEntry));
+    ktxTexture2_freeImageData(This);
+    This->pData = cmpData;
+    This->dataSize = byteLengthCmp;
+    This->supercompressionScheme = KTX_SS_ZSTD;
+    This->_private->_requiredLevelAlignment = 1;
+    // Clear bytesPlane to indicate we're now unsized.
+    uint32_t* bdb = This->pDfd + 1;
+    bdb[KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
+
+cleanup:
+    if (state.cctxs) {
+        for (ktx_uint32_t i = 0; i < threadCount; i++)
+            ktxContext_releaseCCtx(context, state.cctxs[i]);
+        ktxContext_releaseBuffer(context, state.cctxs);
+    }
+    free(state.pCmpDst);
+    ktxContext_releaseBuffer(context, state.jobLevels);
+    ktxContext_releaseBuffer(context, state.nindex);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object using miniz (ZLIB).
+ *
+ * The texture's levelIndex, dataSize, DFD and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * @param[in] This pointer to the ktxTexture2 object of interest.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
+ *            between 1 and 9 are accepted. The lower the level the faster.
+ */
+KTX_error_code
+ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t compressionLevel)
+{
+    ktx_uint32_t levelIndexByteLength =
+                            This->numLevels * sizeof(ktxLevelIndexEntry);
+    ktx_uint8_t* cmpData;
+    ktx_size_t dstRemainingByteLength = 0;
+    ktx_size_t byteLengthCmp = 0;
+    ktx_size_t levelOffset = 0;
+    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
+    ktxLevelIndexEntry* nindex;
+    ktx_uint8_t* pCmpDst;
+    ktxContext* context = This->_private->_context;
+
+    if (This->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
+
+    // On rare occasions the deflated data can be a few bytes larger than
+    // the source data. Calculating the dst buffer size using
+    // mz_deflateBound provides a conservative size to account for that.
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        dstRemainingByteLength += ktxCompressZLIBBounds(cindex[level].byteLength);
+    }
+
+    nindex = ktxContext_acquireBuffer(context, levelIndexByteLength);
+    // Not from the context as it becomes the texture's data.
+    pCmpDst = malloc(dstRemainingByteLength);
+    if (nindex == NULL || pCmpDst == NULL) {
+        ktxContext_releaseBuffer(context, nindex);
+        free(pCmpDst);
         return KTX_OUT_OF_MEMORY;
-    nindex = (ktxLevelIndexEntry*)workBuf;
-    pCmpDst = &workBuf[levelIndexByteLength];
+    }
 
+    // Levels are deflated one after another in file order so are packed
+    // as they are written.
     for (int32_t level = This->numLevels - 1; level >= 0; level--) {
         size_t levelByteLengthCmp = dstRemainingByteLength;
-        KTX_error_code result = ktxCompressZLIBInt(pCmpDst + levelOffset,
-                                                    &levelByteLengthCmp,
-                                                    &This->pData[cindex[level].byteOffset],
-                                                    cindex[level].byteLength,
-                                                    compressionLevel);
-        if (result != KTX_SUCCESS)
+        KTX_error_code result = ktxCompressZLIBInt(context,
+                                                   pCmpDst + levelOffset,
+                                                   &levelByteLengthCmp,
+                                                   &This->pData[cindex[level].byteOffset],
+                                                   cindex[level].byteLength,
+                                                   compressionLevel);
+        if (result != KTX_SUCCESS) {
+            ktxContext_releaseBuffer(context, nindex);
+            free(pCmpDst);
             return result;
+        }
 
         nindex[level].byteOffset = levelOffset;
         nindex[level].uncompressedByteLength = cindex[level].byteLength;
@@ -930,17 +1369,16 @@ ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t compressionLevel)
         dstRemainingByteLength -= levelByteLengthCmp;
     }
 
-    // Move the compressed data into a correctly sized buffer.
-    cmpData = malloc(byteLengthCmp);
-    if (cmpData == NULL) {
-        free(workBuf);
-        return KTX_OUT_OF_MEMORY;
-    }
+    // Shrink the buffer to fit. If that fails the original buffer remains
+    // valid and is kept.
+    cmpData = realloc(pCmpDst, byteLengthCmp);
+    if (cmpData == NULL)
+        cmpData = pCmpDst;
+
     // Now modify the texture.
-    memcpy(cmpData, pCmpDst, byteLengthCmp); // Copy data to sized buffer.
     memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(workBuf);
-    free(This->pData);
+    ktxContext_releaseBuffer(context, nindex);
+    ktxTexture2_freeImageData(This);
     This->pData = cmpData;
     This->dataSize = byteLengthCmp;
     This->supercompressionScheme = KTX_SS_ZLIB;
@@ -952,4 +1390,721 @@ ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t compressionLevel)
     return KTX_SUCCESS;
 }
 
+/**
+ * @internal
+ * @~English
+ * @brief Size of the chunks in which a ktxStreamWriter deflates, copies and
+ *        pads data.
+ */
+#define KTX_STREAM_WRITER_CHUNK_SIZE (1 << 20)
+
+/**
+ * @internal
+ * @~English
+ * @brief Where a level given to a ktxStreamWriter is.
+ */
+typedef enum ktxStreamWriterLevelState {
+    KTX_STREAM_WRITER_LEVEL_PENDING, /*!< Not yet given. */
+    KTX_STREAM_WRITER_LEVEL_SPILLED, /*!< In the spill stream, waiting for
+                                          the preceding levels. */
+    KTX_STREAM_WRITER_LEVEL_WRITTEN  /*!< In the destination. */
+} ktxStreamWriterLevelState;
+
+/**
+ * @internal
+ * @~English
+ * @brief Streaming KTX2 writer.
+ *
+ * Levels are stored smallest first. A level that can be placed in the
+ * destination when it arrives is written there directly. Otherwise it is
+ * deflated into the spill stream, a temporary file, and copied into place
+ * once the levels preceding it have been written.
+ */
+struct ktxStreamWriter {
+    ktxStream* dststr;           /*!< Destination. */
+    ktxStream ownedStream;       /*!< Destination when created from a FILE. */
+    ktx_bool_t ownsStream;
+    ktx_off_t startPos;          /*!< Position of the KTX data in dststr. */
+    ktx_bool_t seekable;         /*!< dststr supports getpos and setpos. */
+    ktxSupercmpScheme scheme;
+    ktx_uint32_t compressionLevel;
+    ktx_uint32_t threadCount;
+    ktxContext* context;
+    ktxTexture2* texture;        /*!< Only used for writing the prefix. */
+    ktxFilePrefix prefix;
+    ktx_uint32_t* pDfd;          /*!< DFD to write. */
+    ktx_uint32_t numLevels;
+    ktxLevelIndexEntry* levelIndex; /*!< Offsets relative to the first
+                                         level. */
+    ktxStreamWriterLevelState* levelStates;
+    ktx_uint64_t* spillOffsets;  /*!< Where spilled levels are. */
+    ktx_int32_t nextLevel;       /*!< Next level to append when levels are
+                                      placed as they come, -1 when all
+                                      have been. */
+    ktx_uint64_t dataEnd;        /*!< End of the level data written so far,
+                                      relative to the first level. */
+    ktx_bool_t prefixWritten;
+    ktxStream spill;
+    ktx_bool_t hasSpill;
+    ktx_uint64_t spillEnd;
+    ktx_bool_t finished;
+    KTX_error_code error;        /*!< First write error. The output is
+                                      unusable after one. */
+};
+
+/**
+ * @memberof ktxStreamWriter @private
+ * @~English
+ * @brief Write @p count zero bytes to @p str.
+ */
+static KTX_error_code
+ktxStreamWriter_writeZeros(ktxStream* str, ktx_uint64_t count)
+{
+    char padding[4096] = { 0 };
+    KTX_error_code result = KTX_SUCCESS;
+
+    while (count != 0 && result == KTX_SUCCESS) {
+        ktx_size_t n = count < sizeof(padding) ? (ktx_size_t)count
+                                               : sizeof(padding);
+        result = str->write(str, padding, 1, n);
+        count -= n;
+    }
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter @private
+ * @~English
+ * @brief Deflate, if requested, a level and write it at the current position
+ *        of @p str.
+ *
+ * Zstd streams its output in chunks so only the level itself needs to be in
+ * memory. ZLIB needs a work buffer the size of the deflated level.
+ *
+ * @param[in]  w        the writer.
+ * @param[in]  pData    the level's data.
+ * @param[in]  dataSize size of the data at @p pData.
+ * @param[in]  str      the stream to write to.
+ * @param[out] pLength  pointer to where to write the number of bytes
+ *                      written.
+ */
+static KTX_error_code
+ktxStreamWriter_deflateLevel(ktxStreamWriter* w,
+                             const ktx_uint8_t* pData, ktx_size_t dataSize,
+                             ktxStream* str, ktx_uint64_t* pLength)
+{
+    KTX_error_code result;
+
+    if (w->scheme == KTX_SS_NONE) {
+        *pLength = dataSize;
+        return str->write(str, pData, 1, dataSize);
+    }
+
+    if (w->scheme == KTX_SS_ZLIB) {
+        ktx_size_t cmpLength = ktxCompressZLIBBounds(dataSize);
+        ktx_uint8_t* pCmp = ktxContext_acquireBuffer(w->context, cmpLength);
+        if (pCmp == NULL)
+            return KTX_OUT_OF_MEMORY;
+        result = ktxCompressZLIBInt(w->context, pCmp, &cmpLength,
+                                    pData, dataSize, w->compressionLevel);
+        if (result == KTX_SUCCESS)
+            result = str->write(str, pCmp, 1, cmpLength);
+        ktxContext_releaseBuffer(w->context, pCmp);
+        *pLength = cmpLength;
+        return result;
+    }
+
+    ktxZstdParams params = {0};
+    ZSTD_CCtx* cctx;
+    ZSTD_outBuffer output;
+    ZSTD_inBuffer input = { pData, dataSize, 0 };
+    size_t remaining;
+
+    params.structSize = sizeof(params);
+    params.compressionLevel = w->compressionLevel;
+    result = ktxZstdCreateCCtx(w->context, &params,
+                               w->threadCount > 1 ? w->threadCount : 0,
+                               &cctx);
+    if (result != KTX_SUCCESS)
+        return result;
+    output.size = KTX_STREAM_WRITER_CHUNK_SIZE;
+    output.dst = ktxContext_acquireBuffer(w->context, output.size);
+    if (output.dst == NULL) {
+        ktxContext_releaseCCtx(w->context, cctx);
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    // The pledged size puts the content size in the frame header, as
+    // ZSTD_compress2 does.
+    remaining = ZSTD_CCtx_setPledgedSrcSize(cctx, dataSize);
+    *pLength = 0;
+    while (!ZSTD_isError(remaining)) {
+        output.pos = 0;
+        remaining = ZSTD_compressStream2(cctx, &output, &input, ZSTD_e_end);
+        if (ZSTD_isError(remaining))
+            break;
+        result = str->write(str, output.dst, 1, output.pos);
+        if (result != KTX_SUCCESS)
+            break;
+        *pLength += output.pos;
+        if (remaining == 0)
+            break;
+    }
+    if (ZSTD_isError(remaining))
+        result = ktxZstdCompressError(remaining);
+
+    ktxContext_releaseBuffer(w->context, output.dst);
+    ktxContext_releaseCCtx(w->context, cctx);
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter @private
+ * @~English
+ * @brief Append a level, deflated into @p pLength bytes, after the level
+ *        data written so far and record its location.
+ *
+ * Exactly one of @p pData and @p spillOffset + @p spillLength is used: the
+ * level is deflated from @p pData or, when that is @c NULL, copied from the
+ * spill stream.
+ */
+static KTX_error_code
+ktxStreamWriter_appendLevel(ktxStreamWriter* w, ktx_uint32_t level,
+                            const ktx_uint8_t* pData, ktx_size_t dataSize,
+                            ktx_uint64_t spillOffset, ktx_uint64_t spillLength)
+{
+    ktxLevelIndexEntry* entry = &w->levelIndex[level];
+    ktx_uint64_t length;
+    KTX_error_code result;
+
+    // Uncompressed levels have fixed, aligned, offsets. Supercompressed ones
+    // follow each other with no padding.
+    if (w->scheme == KTX_SS_NONE) {
+        assert(entry->byteOffset >= w->dataEnd);
+        result = ktxStreamWriter_writeZeros(w->dststr,
+                                            entry->byteOffset - w->dataEnd);
+        if (result != KTX_SUCCESS)
+            return result;
+    } else {
+        entry->byteOffset = w->dataEnd;
+    }
+
+    if (pData) {
+        result = ktxStreamWriter_deflateLevel(w, pData, dataSize,
+                                              w->dststr, &length);
+    } else {
+        ktx_uint8_t* pChunk = ktxContext_acquireBuffer(w->context,
+                                            KTX_STREAM_WRITER_CHUNK_SIZE);
+        if (pChunk == NULL)
+            return KTX_OUT_OF_MEMORY;
+        result = w->spill.setpos(&w->spill, (ktx_off_t)spillOffset);
+        for (length = 0; length < spillLength && result == KTX_SUCCESS;) {
+            ktx_size_t n = (ktx_size_t)MIN(spillLength - length,
+                                           KTX_STREAM_WRITER_CHUNK_SIZE);
+            result = w->spill.read(&w->spill, pChunk, n);
+            if (result == KTX_SUCCESS)
+                result = w->dststr->write(w->dststr, pChunk, 1, n);
+            length += n;
+        }
+        ktxContext_releaseBuffer(w->context, pChunk);
+    }
+    if (result != KTX_SUCCESS)
+        return result;
+
+    entry->byteLength = length;
+    w->dataEnd = entry->byteOffset + length;
+    w->levelStates[level] = KTX_STREAM_WRITER_LEVEL_WRITTEN;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxStreamWriter @private
+ * @~English
+ * @brief Append the spilled levels that are next in file order.
+ */
+static KTX_error_code
+ktxStreamWriter_drainSpill(ktxStreamWriter* w)
+{
+    while (w->nextLevel >= 0
+           && w->levelStates[w->nextLevel] == KTX_STREAM_WRITER_LEVEL_SPILLED) {
+        KTX_error_code result;
+        result = ktxStreamWriter_appendLevel(w, w->nextLevel, NULL, 0,
+                                        w->spillOffsets[w->nextLevel],
+                                        w->levelIndex[w->nextLevel].byteLength);
+        if (result != KTX_SUCCESS)
+            return result;
+        w->nextLevel--;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxStreamWriter @private
+ * @~English
+ * @brief Deflate a level into the spill stream, creating it if necessary.
+ *
+ * The spill stream is a temporary file or, if one cannot be created,
+ * memory.
+ */
+static KTX_error_code
+ktxStreamWriter_spillLevel(ktxStreamWriter* w, ktx_uint32_t level,
+                           const ktx_uint8_t* pData, ktx_size_t dataSize)
+{
+    KTX_error_code result;
+    ktx_uint64_t length;
+
+    if (!w->hasSpill) {
+        FILE* tmp = tmpfile();
+        if (tmp)
+            result = ktxFileStream_construct(&w->spill, tmp, KTX_TRUE);
+        else
+            result = ktxMemStream_construct(&w->spill, KTX_TRUE);
+        if (result != KTX_SUCCESS) {
+            if (tmp)
+                fclose(tmp);
+            return result;
+        }
+        w->hasSpill = KTX_TRUE;
+    }
+
+    // The spill stream may have been read since the last level was added.
+    result = w->spill.setpos(&w->spill, (ktx_off_t)w->spillEnd);
+    if (result == KTX_SUCCESS)
+        result = ktxStreamWriter_deflateLevel(w, pData, dataSize,
+                                              &w->spill, &length);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    w->spillOffsets[level] = w->spillEnd;
+    w->spillEnd += length;
+    w->levelIndex[level].byteLength = length;
+    w->levelStates[level] = KTX_STREAM_WRITER_LEVEL_SPILLED;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxStreamWriter @private
+ * @~English
+ * @brief Write an uncompressed level at its final location in a seekable
+ *        destination.
+ *
+ * When the level is beyond the data written so far, the gap, which
+ * the smaller levels will later fill, is first written with zeros as
+ * streams cannot be positioned beyond their end.
+ */
+static KTX_error_code
+ktxStreamWriter_placeLevel(ktxStreamWriter* w, ktx_uint32_t level,
+                           const ktx_uint8_t* pData, ktx_size_t dataSize)
+{
+    ktxLevelIndexEntry* entry = &w->levelIndex[level];
+    ktx_off_t dataPos = w->startPos + (ktx_off_t)w->prefix.levelDataOffset;
+    KTX_error_code result;
+
+    if (entry->byteOffset > w->dataEnd) {
+        result = w->dststr->setpos(w->dststr,
+                                   dataPos + (ktx_off_t)w->dataEnd);
+        if (result == KTX_SUCCESS)
+            result = ktxStreamWriter_writeZeros(w->dststr,
+                                         entry->byteOffset - w->dataEnd);
+    } else {
+        result = w->dststr->setpos(w->dststr,
+                                   dataPos + (ktx_off_t)entry->byteOffset);
+    }
+    if (result == KTX_SUCCESS)
+        result = w->dststr->write(w->dststr, pData, 1, dataSize);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    w->dataEnd = MAX(w->dataEnd, entry->byteOffset + dataSize);
+    w->levelStates[level] = KTX_STREAM_WRITER_LEVEL_WRITTEN;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxStreamWriter
+ * @ingroup writer
+ * @~English
+ * @brief Create a writer that writes a KTX2 file to a ktxStream one level at
+ *        a time.
+ *
+ * Unlike ktxTexture2\_WriteToStream() the texture's images need not be in
+ * memory. @p texture, which can be created with
+ * @c KTX_TEXTURE_CREATE_NO_STORAGE, supplies the header, DFD and metadata.
+ * The levels are then given, in any order, to ktxStreamWriter\_WriteLevel()
+ * and, if requested, supercompressed as they arrive. Peak memory use is
+ * about one level.
+ *
+ * Levels are stored smallest first. When @p dststr is seekable, e.g. a file
+ * or memory, uncompressed levels are written straight to their final
+ * location and supercompressed levels given smallest first are appended as
+ * they come. The level index is back-patched by ktxStreamWriter\_Finish().
+ * Supercompressed levels given out of order, and any levels that cannot be
+ * placed in a non-seekable stream, such as a pipe, are written to a
+ * temporary file and copied into place once the levels before them have
+ * been written. With a non-seekable stream and supercompression the whole
+ * file is written by ktxStreamWriter\_Finish().
+ *
+ * The library's id is added to the texture's KTXwriter metadata, as by
+ * ktxTexture2\_WriteToStream(). Metadata changed after this call is not
+ * written. @p texture is not otherwise used after this call but its
+ * ktxContext, if any, is used by the writer so must outlive it.
+ *
+ * @param[in]  texture   pointer to the ktxTexture2 describing the file.
+ * @param[in]  dststr    destination ktxStream. Its position is the start of
+ *                       the KTX data.
+ * @param[in]  params    pointer to a ktxStreamWriterParams struct.
+ * @param[out] ppWriter  pointer to a location in which to store the handle
+ *                       of the new writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p texture, @p dststr, @p params or
+ *                              @p ppWriter is NULL, @c params->structSize
+ *                              is not sizeof(ktxStreamWriterParams) or
+ *                              @c params->supercompressionScheme is not
+ *                              @c KTX_SS_NONE, @c KTX_SS_ZSTD or
+ *                              @c KTX_SS_ZLIB.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p texture is supercompressed or its
+ *                              metadata is invalid. See
+ *                              ktxTexture2\_WriteToStream().
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the writer.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the header.
+ */
+KTX_error_code
+ktxStreamWriter_Create(ktxTexture2* texture, ktxStream* dststr,
+                       ktxStreamWriterParams* params,
+                       ktxStreamWriter** ppWriter)
+{
+    ktxStreamWriter* w;
+    KTX_error_code result;
+    ktx_uint32_t levelAlignment;
+
+    if (!texture || !dststr || !params || !ppWriter)
+        return KTX_INVALID_VALUE;
+    if (params->structSize != sizeof(ktxStreamWriterParams))
+        return KTX_INVALID_VALUE;
+    if (params->supercompressionScheme != KTX_SS_NONE
+        && params->supercompressionScheme != KTX_SS_ZSTD
+        && params->supercompressionScheme != KTX_SS_ZLIB)
+        return KTX_INVALID_VALUE;
+    // The images are given uncompressed.
+    if (texture->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
+
+    w = calloc(1, sizeof(ktxStreamWriter));
+    if (w == NULL)
+        return KTX_OUT_OF_MEMORY;
+    w->dststr = dststr;
+    w->scheme = params->supercompressionScheme;
+    w->compressionLevel = params->compressionLevel;
+    w->threadCount = params->threadCount;
+    w->context = texture->_private->_context;
+    w->texture = texture;
+    w->numLevels = texture->numLevels;
+    w->nextLevel = texture->numLevels - 1;
+    w->seekable = dststr->getpos(dststr, &w->startPos) == KTX_SUCCESS;
+
+    w->pDfd = malloc(*texture->pDfd);
+    w->levelIndex = malloc(w->numLevels * sizeof(ktxLevelIndexEntry));
+    w->levelStates = calloc(w->numLevels, sizeof(ktxStreamWriterLevelState));
+    w->spillOffsets = calloc(w->numLevels, sizeof(ktx_uint64_t));
+    if (!w->pDfd || !w->levelIndex || !w->levelStates || !w->spillOffsets) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+    memcpy(w->pDfd, texture->pDfd, *texture->pDfd);
+    memcpy(w->levelIndex, texture->_private->_levelIndex,
+           w->numLevels * sizeof(ktxLevelIndexEntry));
+
+    if (w->scheme == KTX_SS_NONE) {
+        levelAlignment = texture->_private->_requiredLevelAlignment;
+    } else {
+        levelAlignment = 1;
+        // Clear bytesPlane to indicate the data is unsized.
+        uint32_t* bdb = w->pDfd + 1;
+        bdb[KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
+    }
+
+    result = ktxTexture2_buildFilePrefix(texture, w->scheme, levelAlignment,
+                                         &w->prefix);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    // Uncompressed levels have known locations so the level index is
+    // complete. Otherwise it is written now, to reserve its space, only if
+    // it can be back-patched.
+    if (w->scheme == KTX_SS_NONE || w->seekable) {
+        result = ktxTexture2_writeFilePrefix(texture, &w->prefix, w->pDfd,
+                                             w->levelIndex, dststr);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+        w->prefixWritten = KTX_TRUE;
+    }
+
+    *ppWriter = w;
+    return KTX_SUCCESS;
+
+cleanup:
+    ktxStreamWriter_Destroy(w);
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter
+ * @ingroup writer
+ * @~English
+ * @brief Create a writer that writes a KTX2 file to a stdio stream one level
+ *        at a time.
+ *
+ * See ktxStreamWriter\_Create(). @p dstsstr must remain open until the
+ * writer is destroyed. Pipes, e.g. stdout, are supported.
+ *
+ * @param[in]  texture   pointer to the ktxTexture2 describing the file.
+ * @param[in]  dstsstr   destination stdio stream.
+ * @param[in]  params    pointer to a ktxStreamWriterParams struct.
+ * @param[out] ppWriter  pointer to a location in which to store the handle
+ *                       of the new writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *              See ktxStreamWriter\_Create().
+ */
+KTX_error_code
+ktxStreamWriter_CreateForStdioStream(ktxTexture2* texture, FILE* dstsstr,
+                                     ktxStreamWriterParams* params,
+                                     ktxStreamWriter** ppWriter)
+{
+    ktxStream stream;
+    KTX_error_code result;
+
+    if (!dstsstr || !ppWriter)
+        return KTX_INVALID_VALUE;
+
+    result = ktxFileStream_construct(&stream, dstsstr, KTX_FALSE);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    // Create on the local stream then point the writer at its own copy.
+    result = ktxStreamWriter_Create(texture, &stream, params, ppWriter);
+    if (result == KTX_SUCCESS) {
+        (*ppWriter)->ownedStream = stream;
+        (*ppWriter)->dststr = &(*ppWriter)->ownedStream;
+        (*ppWriter)->ownsStream = KTX_TRUE;
+    }
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter
+ * @ingroup writer
+ * @~English
+ * @brief Create a writer that writes a KTX2 file to a named file one level
+ *        at a time.
+ *
+ * See ktxStreamWriter\_Create(). The file is closed when the writer is
+ * destroyed. The file name must be encoded in utf-8.
+ *
+ * @param[in]  texture   pointer to the ktxTexture2 describing the file.
+ * @param[in]  dstname   destination file name.
+ * @param[in]  params    pointer to a ktxStreamWriterParams struct.
+ * @param[out] ppWriter  pointer to a location in which to store the handle
+ *                       of the new writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_OPEN_FAILED The file could not be opened.
+ *
+ * For other exceptions see ktxStreamWriter\_Create().
+ */
+KTX_error_code
+ktxStreamWriter_CreateForNamedFile(ktxTexture2* texture,
+                                   const char* const dstname,
+                                   ktxStreamWriterParams* params,
+                                   ktxStreamWriter** ppWriter)
+{
+    KTX_error_code result;
+    FILE* dst;
+
+    if (!dstname || !ppWriter)
+        return KTX_INVALID_VALUE;
+
+    dst = ktxFOpenUTF8(dstname, "wb");
+    if (!dst)
+        return KTX_FILE_OPEN_FAILED;
+
+    result = ktxStreamWriter_CreateForStdioStream(texture, dst, params,
+                                                  ppWriter);
+    if (result == KTX_SUCCESS)
+        (*ppWriter)->ownedStream.closeOnDestruct = KTX_TRUE;
+    else
+        fclose(dst);
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter
+ * @ingroup writer
+ * @~English
+ * @brief Write a level of the texture.
+ *
+ * @p pData holds all the images of @p level, laid out as in a ktxTexture2's
+ * image data. It is only read during the call so it can be reused for the
+ * next level. Levels can be given in any order, though giving them smallest
+ * first avoids the temporary file when supercompressing.
+ *
+ * @param[in] writer     handle of the writer.
+ * @param[in] level      the level to write.
+ * @param[in] pData      pointer to the level's images.
+ * @param[in] dataSize   size of the data at @p pData. Must be the level's
+ *                       size as given by ktxTexture\_GetLevelSize() or
+ *                       ktxTexture\_calcLevelSize() for the texture passed
+ *                       at creation.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p writer or @p pData is NULL, @p level is out
+ *                              of range or @p dataSize is not the level's
+ *                              size.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p level has already been written,
+ *                              ktxStreamWriter\_Finish() has been called or
+ *                              an earlier write failed.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to supercompress the
+ *                              level.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing.
+ */
+KTX_error_code
+ktxStreamWriter_WriteLevel(ktxStreamWriter* writer, ktx_uint32_t level,
+                           const ktx_uint8_t* pData, ktx_size_t dataSize)
+{
+    ktxStreamWriter* w = writer;
+    KTX_error_code result;
+
+    if (!w || !pData || level >= w->numLevels)
+        return KTX_INVALID_VALUE;
+    if (dataSize != w->levelIndex[level].uncompressedByteLength)
+        return KTX_INVALID_VALUE;
+    if (w->finished || w->error != KTX_SUCCESS
+        || w->levelStates[level] != KTX_STREAM_WRITER_LEVEL_PENDING)
+        return KTX_INVALID_OPERATION;
+
+    if (w->scheme == KTX_SS_NONE && w->seekable) {
+        result = ktxStreamWriter_placeLevel(w, level, pData, dataSize);
+    } else if (w->prefixWritten && (ktx_int32_t)level == w->nextLevel) {
+        result = ktxStreamWriter_appendLevel(w, level, pData, dataSize, 0, 0);
+        if (result == KTX_SUCCESS) {
+            w->nextLevel--;
+            result = ktxStreamWriter_drainSpill(w);
+        }
+    } else {
+        result = ktxStreamWriter_spillLevel(w, level, pData, dataSize);
+    }
+    if (result != KTX_SUCCESS)
+        w->error = result;
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter
+ * @ingroup writer
+ * @~English
+ * @brief Complete the file once every level has been written.
+ *
+ * Copies any levels still in the temporary file into place and writes the
+ * final level index. The destination is left positioned after the KTX data.
+ *
+ * @param[in] writer     handle of the writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p writer is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              Not every level has been written,
+ *                              ktxStreamWriter\_Finish() has already been
+ *                              called or an earlier write failed.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing.
+ */
+KTX_error_code
+ktxStreamWriter_Finish(ktxStreamWriter* writer)
+{
+    ktxStreamWriter* w = writer;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (!w)
+        return KTX_INVALID_VALUE;
+    if (w->finished || w->error != KTX_SUCCESS)
+        return KTX_INVALID_OPERATION;
+    for (ktx_uint32_t level = 0; level < w->numLevels; level++) {
+        if (w->levelStates[level] == KTX_STREAM_WRITER_LEVEL_PENDING)
+            return KTX_INVALID_OPERATION;
+    }
+
+    if (!w->prefixWritten) {
+        // Every level is in the spill stream. Lay them out in file order.
+        ktx_uint64_t offset = 0;
+        for (ktx_int32_t level = w->numLevels - 1; level >= 0; level--) {
+            w->levelIndex[level].byteOffset = offset;
+            offset += w->levelIndex[level].byteLength;
+        }
+        result = ktxTexture2_writeFilePrefix(w->texture, &w->prefix, w->pDfd,
+                                             w->levelIndex, w->dststr);
+        if (result == KTX_SUCCESS)
+            w->prefixWritten = KTX_TRUE;
+    }
+    if (result == KTX_SUCCESS)
+        result = ktxStreamWriter_drainSpill(w);
+
+    if (result == KTX_SUCCESS && w->seekable) {
+        if (w->scheme != KTX_SS_NONE) {
+            // Back-patch the level index, which follows the header.
+            result = w->dststr->setpos(w->dststr,
+                                       w->startPos + sizeof(KTX_header2));
+            if (result == KTX_SUCCESS)
+                result = ktxWriteLevelIndex(w->dststr, w->levelIndex,
+                                            w->numLevels,
+                                            w->prefix.levelDataOffset);
+        }
+        if (result == KTX_SUCCESS)
+            result = w->dststr->setpos(w->dststr, w->startPos
+                        + (ktx_off_t)(w->prefix.levelDataOffset + w->dataEnd));
+    }
+
+    if (result != KTX_SUCCESS)
+        w->error = result;
+    else
+        w->finished = KTX_TRUE;
+    return result;
+}
+
+/**
+ * @memberof ktxStreamWriter
+ * @ingroup writer
+ * @~English
+ * @brief Destroy a writer.
+ *
+ * Destroying a writer before ktxStreamWriter\_Finish() has succeeded leaves
+ * an incomplete file.
+ *
+ * @param[in] writer     handle of the writer. May be @c NULL.
+ */
+void
+ktxStreamWriter_Destroy(ktxStreamWriter* writer)
+{
+    if (!writer)
+        return;
+    if (writer->hasSpill)
+        writer->spill.destruct(&writer->spill);
+    if (writer->ownsStream)
+        writer->ownedStream.destruct(&writer->ownedStream);
+    free(writer->prefix.pKvd);
+    free(writer->pDfd);
+    free(writer->levelIndex);
+    free(writer->levelStates);
+    free(writer->spillOffsets);
+    free(writer);
+}
+
 /** @} */
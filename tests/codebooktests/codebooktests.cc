@@ -0,0 +1,268 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file codebooktests.cc
+ * @~English
+ *
+ * @brief Tests of transcoding BasisLZ/ETC1S textures with shared ETC1S
+ *        codebooks.
+ *
+ * The codebooks of a test image are moved out of its supercompression
+ * global data into a ktxEtc1sCodebook, making a texture like one encoded
+ * against shared codebooks. Transcoding it with the codebooks set must
+ * give the same images as transcoding the original.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ktxtest.h"
+#include "basis_sgd.h"
+#include "etc1s_codebook.h"
+
+namespace {
+
+void
+appendUint32(std::vector<ktx_uint8_t>& bytes, ktx_uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        bytes.push_back((ktx_uint8_t)(value >> (8 * i)));
+}
+
+// Turn @p texture into one encoded against shared codebooks by moving the
+// codebooks in its supercompression global data into a ktxEtc1sCodebook,
+// as stored by ktxEtc1sCodebook_WriteToMemory(). If @p recordKey the
+// codebook's id is recorded in the texture's metadata as the encoder does.
+ktxEtc1sCodebook*
+detachCodebook(ktxTexture2* texture, bool recordKey)
+{
+    ktx_uint8_t* bgd = texture->_private->_supercompressionGlobalData;
+    ktxBasisLzGlobalHeader header = *(ktxBasisLzGlobalHeader*)bgd;
+    ktx_size_t sgdByteLength = (ktx_size_t)texture->_private->_sgdByteLength;
+    ktx_uint32_t imageCount
+        = (ktx_uint32_t)((sgdByteLength - sizeof(header)
+                          - header.endpointsByteLength
+                          - header.selectorsByteLength
+                          - header.tablesByteLength
+                          - header.extendedByteLength)
+                         / sizeof(ktxBasisLzEtc1sImageDesc));
+    ktx_uint8_t* endpoints = BGD_ENDPOINTS_ADDR(bgd, imageCount);
+    ktx_uint8_t* tables = BGD_TABLES_ADDR(bgd, header, imageCount);
+
+    std::vector<ktx_uint8_t> bytes = { 'K', 'T', 'X', 'e', 't', 'c', '1', 's' };
+    appendUint32(bytes, 1);
+    appendUint32(bytes, header.endpointCount);
+    appendUint32(bytes, header.selectorCount);
+    appendUint32(bytes, header.endpointsByteLength);
+    appendUint32(bytes, header.selectorsByteLength);
+    bytes.insert(bytes.end(), endpoints, tables);
+    ktxEtc1sCodebook* codebook = nullptr;
+    EXPECT_EQ(ktxEtc1sCodebook_CreateFromMemory(bytes.data(), bytes.size(),
+                                                &codebook),
+              KTX_SUCCESS);
+    if (!codebook)
+        return nullptr;
+
+    std::vector<ktx_uint8_t> sgd(bgd, endpoints);
+    sgd.insert(sgd.end(), tables, bgd + sgdByteLength);
+    ktxBasisLzGlobalHeader* newHeader = (ktxBasisLzGlobalHeader*)sgd.data();
+    newHeader->endpointsByteLength = 0;
+    newHeader->selectorsByteLength = 0;
+    memcpy(bgd, sgd.data(), sgd.size());
+    texture->_private->_sgdByteLength = sgd.size();
+
+    if (recordKey)
+        EXPECT_EQ(ktxTexture2_setEtc1sCodebookKey(texture, codebook),
+                  KTX_SUCCESS);
+    return codebook;
+}
+
+class SharedCodebookTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        reference = createTexture("etc1s_array.ktx2",
+                                  KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+        texture = createTexture("etc1s_array.ktx2",
+                                KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+        ASSERT_TRUE(reference != nullptr && texture != nullptr);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(reference, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+    }
+
+    void TearDown() override {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+        if (reference)
+            ktxTexture_Destroy(ktxTexture(reference));
+        ktxEtc1sCodebook_Destroy(codebook);
+    }
+
+    void expectTranscodedMatchesReference() {
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+        ASSERT_EQ(texture->dataSize, reference->dataSize);
+        EXPECT_EQ(memcmp(texture->pData, reference->pData,
+                         texture->dataSize), 0);
+    }
+
+    ktxTexture2* reference = nullptr;
+    ktxTexture2* texture = nullptr;
+    ktxEtc1sCodebook* codebook = nullptr;
+};
+
+TEST_F(SharedCodebookTest, TranscodesWithSharedCodebook) {
+    codebook = detachCodebook(texture, true);
+    ASSERT_TRUE(codebook != nullptr);
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, codebook), KTX_SUCCESS);
+    expectTranscodedMatchesReference();
+}
+
+TEST_F(SharedCodebookTest, TranscodesImagesWithSharedCodebook) {
+    codebook = detachCodebook(texture, true);
+    ASSERT_TRUE(codebook != nullptr);
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, codebook), KTX_SUCCESS);
+
+    ktxTexture2* original = createTexture("etc1s_array.ktx2",
+                                          KTX_TEXTURE_CREATE_NO_FLAGS);
+    ASSERT_TRUE(original != nullptr);
+    ktx_uint32_t rowPitch;
+    ktx_size_t imageSize;
+    ASSERT_EQ(ktxTexture2_GetTranscodedImageLayout(texture, 0, KTX_TTF_BC7_RGBA,
+                                                   1, &rowPitch, &imageSize),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> expected(imageSize), actual(imageSize);
+    for (ktx_uint32_t layer = 0; layer < texture->numLayers; layer++) {
+        ASSERT_EQ(ktxTexture2_TranscodeImage(original, 0, layer, 0,
+                                             KTX_TTF_BC7_RGBA, 0,
+                                             expected.data(), imageSize, 0),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeImage(texture, 0, layer, 0,
+                                             KTX_TTF_BC7_RGBA, 0,
+                                             actual.data(), imageSize, 0),
+                  KTX_SUCCESS);
+        EXPECT_EQ(actual, expected) << "Layer " << layer;
+    }
+    ktxTexture_Destroy(ktxTexture(original));
+}
+
+TEST_F(SharedCodebookTest, CodebookRoundTripsThroughMemory) {
+    ktxEtc1sCodebook* detached = detachCodebook(texture, true);
+    ASSERT_TRUE(detached != nullptr);
+    ktx_uint8_t* bytes = nullptr;
+    ktx_size_t size = 0;
+    ASSERT_EQ(ktxEtc1sCodebook_WriteToMemory(detached, &bytes, &size),
+              KTX_SUCCESS);
+    ktxEtc1sCodebook_Destroy(detached);
+
+    ASSERT_EQ(ktxEtc1sCodebook_CreateFromMemory(bytes, size, &codebook),
+              KTX_SUCCESS);
+    free(bytes);
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, codebook), KTX_SUCCESS);
+    expectTranscodedMatchesReference();
+}
+
+TEST_F(SharedCodebookTest, CodebookRoundTripsThroughFile) {
+    ktxEtc1sCodebook* detached = detachCodebook(texture, true);
+    ASSERT_TRUE(detached != nullptr);
+    std::string path = ::testing::TempDir() + "ktxCodebookTest"
+                     + std::to_string(std::random_device()()) + ".bin";
+    ASSERT_EQ(ktxEtc1sCodebook_WriteToNamedFile(detached, path.c_str()),
+              KTX_SUCCESS);
+    ktxEtc1sCodebook_Destroy(detached);
+
+    ASSERT_EQ(ktxEtc1sCodebook_CreateFromNamedFile(path.c_str(), &codebook),
+              KTX_SUCCESS);
+    remove(path.c_str());
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, codebook), KTX_SUCCESS);
+    expectTranscodedMatchesReference();
+}
+
+TEST_F(SharedCodebookTest, RejectsDamagedCodebooks) {
+    ktxEtc1sCodebook* detached = detachCodebook(texture, true);
+    ASSERT_TRUE(detached != nullptr);
+    ktx_uint8_t* bytes = nullptr;
+    ktx_size_t size = 0;
+    ASSERT_EQ(ktxEtc1sCodebook_WriteToMemory(detached, &bytes, &size),
+              KTX_SUCCESS);
+    ktxEtc1sCodebook_Destroy(detached);
+    std::vector<ktx_uint8_t> saved(bytes, bytes + size);
+    free(bytes);
+
+    std::vector<ktx_uint8_t> damaged = saved;
+    damaged[0] = 'X';
+    EXPECT_EQ(ktxEtc1sCodebook_CreateFromMemory(damaged.data(),
+                                                damaged.size(), &codebook),
+              KTX_UNKNOWN_FILE_FORMAT);
+    EXPECT_EQ(ktxEtc1sCodebook_CreateFromMemory(saved.data(), 8, &codebook),
+              KTX_UNKNOWN_FILE_FORMAT);
+    EXPECT_EQ(ktxEtc1sCodebook_CreateFromMemory(saved.data(),
+                                                saved.size() - 1, &codebook),
+              KTX_FILE_DATA_ERROR);
+    EXPECT_EQ(ktxEtc1sCodebook_CreateFromMemory(nullptr, saved.size(),
+                                                &codebook),
+              KTX_INVALID_VALUE);
+    EXPECT_TRUE(codebook == nullptr);
+    EXPECT_EQ(ktxEtc1sCodebook_CreateFromNamedFile(
+                  (testImagesPath + "no_such_file.bin").c_str(), &codebook),
+              KTX_FILE_OPEN_FAILED);
+}
+
+TEST_F(SharedCodebookTest, MissingCodebookIsInvalidOperation) {
+    codebook = detachCodebook(texture, true);
+    ASSERT_TRUE(codebook != nullptr);
+    EXPECT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0),
+              KTX_INVALID_OPERATION);
+}
+
+TEST_F(SharedCodebookTest, OtherCodebookIsInvalidOperation) {
+    codebook = detachCodebook(texture, true);
+    ASSERT_TRUE(codebook != nullptr);
+    ktxTexture2* other = createTexture("etc1s_video.ktx2",
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+    ASSERT_TRUE(other != nullptr);
+    ktxEtc1sCodebook* otherCodebook = detachCodebook(other, true);
+    ASSERT_TRUE(otherCodebook != nullptr);
+
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, otherCodebook),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0),
+              KTX_INVALID_OPERATION);
+
+    ktxTexture_Destroy(ktxTexture(other));
+    ktxEtc1sCodebook_Destroy(otherCodebook);
+}
+
+TEST_F(SharedCodebookTest, OtherIdIsInvalidOperation) {
+    codebook = detachCodebook(texture, true);
+    ASSERT_TRUE(codebook != nullptr);
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, codebook), KTX_SUCCESS);
+
+    // Same counts, different codebooks.
+    char* id;
+    ktx_uint32_t idLen;
+    ASSERT_EQ(ktxHashList_FindValue(&texture->kvDataHead,
+                                    KTX_ETC1S_CODEBOOK_KEY, &idLen,
+                                    (void**)&id),
+              KTX_SUCCESS);
+    ASSERT_EQ(idLen, 17U);
+    id[0] = id[0] == '0' ? '1' : '0';
+    EXPECT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0),
+              KTX_INVALID_OPERATION);
+}
+
+TEST_F(SharedCodebookTest, MissingKeyIsFileDataError) {
+    codebook = detachCodebook(texture, false);
+    ASSERT_TRUE(codebook != nullptr);
+    ASSERT_EQ(ktxTexture2_SetEtc1sCodebook(texture, codebook), KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0),
+              KTX_FILE_DATA_ERROR);
+}
+
+} // namespace
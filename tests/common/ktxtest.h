@@ -0,0 +1,149 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file ktxtest.h
+ * @~English
+ *
+ * @brief Helpers shared by the libktx unit tests.
+ *
+ * Each test executable is linked with ktxtest_main.cc whose main() takes
+ * the path of the test images as its only argument.
+ */
+
+#ifndef _KTXTEST_H_
+#define _KTXTEST_H_
+
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "vkformat_enum.h"
+
+// Path of the test images, ending in '/'.
+extern std::string testImagesPath;
+
+inline ktxTexture2*
+createTexture(const std::string& name, ktxTextureCreateFlags createFlags)
+{
+    ktxTexture2* texture = nullptr;
+    KTX_error_code result
+        = ktxTexture2_CreateFromNamedFile((testImagesPath + name).c_str(),
+                                          createFlags, &texture);
+    EXPECT_EQ(result, KTX_SUCCESS) << "Creating from " << name << ": "
+                                   << ktxErrorString(result);
+    return texture;
+}
+
+// Images of one level, with any supercompression inflated, from a texture
+// whose image data is loaded.
+inline std::vector<ktx_uint8_t>
+levelData(ktxTexture2* texture, ktx_uint32_t level)
+{
+    ktx_size_t offset = ktxTexture2_levelDataOffset(texture, level);
+    ktx_size_t size;
+    EXPECT_EQ(ktxTexture2_GetLevelsDataSize(texture, level, 1, &size),
+              KTX_SUCCESS);
+    return std::vector<ktx_uint8_t>(texture->pData + offset,
+                                    texture->pData + offset + size);
+}
+
+struct TextureShape {
+    const char* name;
+    ktx_uint32_t vkFormat;
+    ktx_uint32_t width, height, depth;
+    ktx_uint32_t layers, faces, levels;
+};
+
+inline std::ostream&
+operator<<(std::ostream& os, const TextureShape& shape)
+{
+    return os << shape.name;
+}
+
+// Shapes of textures to create and write, covering arrays, cube maps, 3D,
+// block compressed and non-power-of-two textures.
+inline const TextureShape textureShapes[] = {
+    { "rgba8_2d_mipmapped", VK_FORMAT_R8G8B8A8_UNORM, 67, 33, 1, 1, 1, 7 },
+    { "rgba8_array", VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, 5, 1, 7 },
+    { "r8_cube", VK_FORMAT_R8_UNORM, 32, 32, 1, 1, 6, 6 },
+    { "rgb8_3d", VK_FORMAT_R8G8B8_UNORM, 17, 9, 13, 1, 1, 5 },
+    { "bc1_2d", VK_FORMAT_BC1_RGB_UNORM_BLOCK, 100, 60, 1, 1, 1, 7 },
+    { "rgba16f_one_level", VK_FORMAT_R16G16B16A16_SFLOAT, 40, 40, 1, 1, 1, 1 },
+};
+
+// Create a texture of @p shape whose images are filled with a pattern
+// that deflates to something smaller but not trivially so.
+inline ktxTexture2*
+createPatternTexture(const TextureShape& shape, unsigned int seed)
+{
+    ktxTextureCreateInfo createInfo = {};
+    createInfo.vkFormat = shape.vkFormat;
+    createInfo.baseWidth = shape.width;
+    createInfo.baseHeight = shape.height;
+    createInfo.baseDepth = shape.depth;
+    createInfo.numDimensions = shape.depth > 1 ? 3 : shape.height > 1 ? 2 : 1;
+    createInfo.numLevels = shape.levels;
+    createInfo.numLayers = shape.layers;
+    createInfo.numFaces = shape.faces;
+    createInfo.isArray = shape.layers > 1;
+    createInfo.generateMipmaps = KTX_FALSE;
+
+    ktxTexture2* texture = nullptr;
+    EXPECT_EQ(ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                 &texture), KTX_SUCCESS);
+    if (!texture)
+        return nullptr;
+    std::minstd_rand random(seed);
+    for (ktx_size_t i = 0; i < texture->dataSize; i++)
+        texture->pData[i] = (ktx_uint8_t)(((i * 7) + (i >> 9))
+                                          ^ (random() & 3));
+    return texture;
+}
+
+inline std::vector<ktx_uint8_t>
+writeToMemory(ktxTexture2* texture)
+{
+    ktx_uint8_t* bytes = nullptr;
+    ktx_size_t size = 0;
+    EXPECT_EQ(ktxTexture_WriteToMemory(ktxTexture(texture), &bytes, &size),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> result(bytes, bytes + size);
+    free(bytes);
+    return result;
+}
+
+// Reload @p bytes and check they hold the images of @p source, whose
+// image data is loaded, supercompressed with @p scheme.
+inline void
+expectReloadMatches(const std::vector<ktx_uint8_t>& bytes,
+                    ktxTexture2* source, ktxSupercmpScheme scheme)
+{
+    ktxTexture2* reloaded = nullptr;
+    ASSERT_EQ(ktxTexture2_CreateFromMemory(bytes.data(), bytes.size(),
+                                           KTX_TEXTURE_CREATE_NO_FLAGS,
+                                           &reloaded),
+              KTX_SUCCESS);
+    EXPECT_EQ(reloaded->supercompressionScheme, scheme);
+    EXPECT_EQ(ktxTexture_LoadImageData(ktxTexture(reloaded), nullptr, 0),
+              KTX_SUCCESS);
+    ASSERT_EQ(reloaded->numLevels, source->numLevels);
+    for (ktx_uint32_t level = 0; level < source->numLevels; level++)
+        EXPECT_EQ(levelData(reloaded, level), levelData(source, level))
+            << "Level " << level;
+    ktxTexture_Destroy(ktxTexture(reloaded));
+}
+
+#endif /* _KTXTEST_H_ */
@@ -0,0 +1,40 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file ktxtest_main.cc
+ * @~English
+ *
+ * @brief main() of the libktx unit tests.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "ktxtest.h"
+
+std::string testImagesPath;
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    // The path is not needed, nor given by CTest, to list the tests.
+    if (argc != 2 && !::testing::GTEST_FLAG(list_tests)) {
+        std::cerr << "Usage: " << argv[0] << " <test images path>\n";
+        return -1;
+    }
+    if (argc == 2)
+        testImagesPath = argv[1];
+    if (!testImagesPath.empty() && testImagesPath.back() != '/')
+        testImagesPath += '/';
+
+    return RUN_ALL_TESTS();
+}
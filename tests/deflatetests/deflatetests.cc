@@ -0,0 +1,200 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file deflatetests.cc
+ * @~English
+ *
+ * @brief Tests of deflating KTX2 textures in place and writing them to
+ *        memory.
+ *
+ * Deflated textures are written, reloaded and their levels compared with
+ * those of an identical texture that was not deflated.
+ */
+
+#include <ostream>
+#include <stdio.h>
+#include <string.h>
+
+#include "ktxtest.h"
+extern "C" {
+#include "memstream.h"
+}
+
+namespace {
+
+enum DeflateMode { Zstd, ZstdThreaded, Zlib };
+
+struct DeflateParam {
+    TextureShape shape;
+    DeflateMode mode;
+    bool withContext;
+};
+
+std::ostream&
+operator<<(std::ostream& os, const DeflateParam& param)
+{
+    return os << param.shape.name << " mode " << param.mode
+              << (param.withContext ? " with context" : "");
+}
+
+/////////////////////////////////////////////////////////////////////
+// Test fixture, parameterized by shape, deflater and use of context
+/////////////////////////////////////////////////////////////////////
+
+class DeflateTest : public ::testing::TestWithParam<DeflateParam> {
+  protected:
+    void SetUp() override {
+        source = createPatternTexture(GetParam().shape, 1);
+        texture = createPatternTexture(GetParam().shape, 1);
+        ASSERT_TRUE(source != nullptr && texture != nullptr);
+        if (GetParam().withContext) {
+            ASSERT_EQ(ktxContext_Create(&context), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_SetContext(texture, context), KTX_SUCCESS);
+        }
+    }
+
+    void TearDown() override {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+        if (source)
+            ktxTexture_Destroy(ktxTexture(source));
+        ktxContext_Destroy(context);
+    }
+
+    KTX_error_code deflate() {
+        switch (GetParam().mode) {
+          case Zstd:
+            return ktxTexture2_DeflateZstd(texture, 5);
+          case ZstdThreaded: {
+            ktxZstdParams params = {};
+            params.structSize = sizeof(params);
+            params.compressionLevel = 5;
+            params.threadCount = 4;
+            return ktxTexture2_DeflateZstdEx(texture, &params);
+          }
+          default:
+            return ktxTexture2_DeflateZLIB(texture, 6);
+        }
+    }
+
+    ktxSupercmpScheme scheme() {
+        return GetParam().mode == Zlib ? KTX_SS_ZLIB : KTX_SS_ZSTD;
+    }
+
+    ktxTexture2* source = nullptr;
+    ktxTexture2* texture = nullptr;
+    ktxContext* context = nullptr;
+};
+
+std::vector<DeflateParam>
+deflateParams()
+{
+    std::vector<DeflateParam> params;
+    for (const TextureShape& shape : textureShapes)
+        for (DeflateMode mode : { Zstd, ZstdThreaded, Zlib })
+            for (bool withContext : { false, true })
+                params.push_back({ shape, mode, withContext });
+    return params;
+}
+
+INSTANTIATE_TEST_SUITE_P(ShapesAndDeflaters, DeflateTest,
+                         ::testing::ValuesIn(deflateParams()));
+
+TEST_P(DeflateTest, WrittenLevelsInflateToSource) {
+    ASSERT_EQ(deflate(), KTX_SUCCESS);
+    EXPECT_EQ(texture->supercompressionScheme, scheme());
+    expectReloadMatches(writeToMemory(texture), source, scheme());
+}
+
+TEST_P(DeflateTest, ImageDataIsPackedLevels) {
+    ASSERT_EQ(deflate(), KTX_SUCCESS);
+
+    // The deflated levels are stored back to back, smallest first, with
+    // nothing after them.
+    ktxLevelIndexEntry* levelIndex = texture->_private->_levelIndex;
+    ktx_uint64_t expectedOffset = 0;
+    for (ktx_uint32_t level = texture->numLevels; level-- > 0;) {
+        EXPECT_EQ(levelIndex[level].byteOffset, expectedOffset)
+            << "Level " << level;
+        EXPECT_GT(levelIndex[level].byteLength, 0U);
+        expectedOffset += levelIndex[level].byteLength;
+    }
+    EXPECT_EQ(texture->dataSize, expectedOffset);
+}
+
+TEST_P(DeflateTest, LoadLevelsInflatesDeflatedImageData) {
+    ASSERT_EQ(deflate(), KTX_SUCCESS);
+
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_size_t size;
+        ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, level, 1, &size),
+                  KTX_SUCCESS);
+        std::vector<ktx_uint8_t> buffer(size);
+        ASSERT_EQ(ktxTexture2_LoadLevels(texture, level, 1,
+                                         buffer.data(), buffer.size()),
+                  KTX_SUCCESS);
+        EXPECT_EQ(buffer, levelData(source, level)) << "Level " << level;
+    }
+}
+
+TEST_P(DeflateTest, WriteToMemoryMatchesWriteToStream) {
+    ASSERT_EQ(deflate(), KTX_SUCCESS);
+    std::vector<ktx_uint8_t> bytes = writeToMemory(texture);
+
+    FILE* file = tmpfile();
+    ASSERT_TRUE(file != nullptr);
+    ASSERT_EQ(ktxTexture_WriteToStdioStream(ktxTexture(texture), file),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> written((size_t)ftell(file));
+    rewind(file);
+    ASSERT_EQ(fread(written.data(), 1, written.size(), file), written.size());
+    fclose(file);
+    EXPECT_EQ(bytes, written);
+}
+
+//////////////////////////////
+// ktxMemStream_reserve
+//////////////////////////////
+
+TEST(MemStreamReserveTest, KeepsDataWrittenAfterReserving) {
+    ktxStream stream;
+    ASSERT_EQ(ktxMemStream_construct(&stream, KTX_FALSE), KTX_SUCCESS);
+    const char head[] = "head";
+    ASSERT_EQ(stream.write(&stream, head, 1, sizeof(head)), KTX_SUCCESS);
+    ASSERT_EQ(ktxMemStream_reserve(&stream, 1000), KTX_SUCCESS);
+    // Reserving less than is held changes nothing.
+    ASSERT_EQ(ktxMemStream_reserve(&stream, 2), KTX_SUCCESS);
+    std::vector<ktx_uint8_t> tail(1200);
+    for (size_t i = 0; i < tail.size(); i++)
+        tail[i] = (ktx_uint8_t)i;
+    ASSERT_EQ(stream.write(&stream, tail.data(), 1, tail.size()),
+              KTX_SUCCESS);
+
+    ktx_uint8_t* data;
+    ktx_size_t size;
+    ktxMemStream_getdata(&stream, &data);
+    stream.getsize(&stream, &size);
+    ASSERT_EQ(size, sizeof(head) + tail.size());
+    EXPECT_EQ(memcmp(data, head, sizeof(head)), 0);
+    EXPECT_EQ(memcmp(data + sizeof(head), tail.data(), tail.size()), 0);
+    stream.destruct(&stream);
+}
+
+TEST(MemStreamReserveTest, RejectsReadOnlyStream) {
+    const ktx_uint8_t bytes[4] = {};
+    ktxStream stream;
+    ASSERT_EQ(ktxMemStream_construct_ro(&stream, bytes, sizeof(bytes)),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxMemStream_reserve(&stream, 100), KTX_INVALID_OPERATION);
+    stream.destruct(&stream);
+    EXPECT_EQ(ktxMemStream_reserve(nullptr, 100), KTX_INVALID_VALUE);
+}
+
+} // namespace
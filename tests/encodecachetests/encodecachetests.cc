@@ -0,0 +1,198 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file encodecachetests.cc
+ * @~English
+ *
+ * @brief Tests of the on-disk encode cache.
+ *
+ * Textures are compressed through ktxEncodeCache_compress(), the lookup
+ * the batch functions make, with a stand-in encoder that counts its
+ * calls so hits and misses can be told apart. The textures given back by
+ * hits are written out and compared with those the encoder produced.
+ */
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "ktxtest.h"
+#include "encode_cache.h"
+
+namespace {
+
+class EncodeCacheTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        directory = std::filesystem::path(::testing::TempDir())
+                  / ("ktxEncodeCacheTest"
+                     + std::to_string(std::random_device()()));
+        std::filesystem::create_directories(directory);
+        ASSERT_EQ(ktxEncodeCache_Create(directory.u8string().c_str(), 0, 0,
+                                        &cache),
+                  KTX_SUCCESS);
+        params.structSize = sizeof(params);
+        params.uastc = KTX_TRUE;
+        params.cache = cache;
+        compressCalls = 0;
+    }
+
+    void TearDown() override {
+        ktxEncodeCache_Destroy(cache);
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    void reopen(ktx_uint64_t maxSize, ktx_uint32_t maxEntries) {
+        ktxEncodeCache_Destroy(cache);
+        cache = nullptr;
+        ASSERT_EQ(ktxEncodeCache_Create(directory.u8string().c_str(),
+                                        maxSize, maxEntries, &cache),
+                  KTX_SUCCESS);
+        params.cache = cache;
+    }
+
+    // Stands in for an encoder. Marks its output so a cache hit can be
+    // told from the unchanged input.
+    static KTX_error_code compress(ktxTexture2* texture,
+                                   ktxBasisParams* params) {
+        compressCalls++;
+        KTX_error_code result = ktxTexture2_DeflateZstd(texture,
+                                                        params->qualityLevel
+                                                        + 1);
+        if (result == KTX_SUCCESS)
+            result = ktxHashList_AddKVPair(&texture->kvDataHead,
+                                           "testEncoder", 4, "yes");
+        return result;
+    }
+
+    ktxTexture2* compressed(const TextureShape& shape, unsigned int seed) {
+        ktxTexture2* texture = createPatternTexture(shape, seed);
+        EXPECT_TRUE(texture != nullptr);
+        if (texture)
+            EXPECT_EQ(ktxEncodeCache_compress(texture, &params, compress),
+                      KTX_SUCCESS);
+        return texture;
+    }
+
+    static int compressCalls;
+    std::filesystem::path directory;
+    ktxEncodeCache* cache = nullptr;
+    ktxBasisParams params = {};
+};
+
+int EncodeCacheTest::compressCalls;
+
+TEST_F(EncodeCacheTest, HitReturnsStoredResult) {
+    ktxTexture2* first = compressed(textureShapes[0], 4);
+    ktxTexture2* second = compressed(textureShapes[0], 4);
+    ASSERT_TRUE(first != nullptr && second != nullptr);
+
+    EXPECT_EQ(compressCalls, 1);
+    EXPECT_EQ(second->supercompressionScheme, KTX_SS_ZSTD);
+    EXPECT_EQ(writeToMemory(second), writeToMemory(first));
+    ktxTexture_Destroy(ktxTexture(first));
+    ktxTexture_Destroy(ktxTexture(second));
+}
+
+TEST_F(EncodeCacheTest, HitsForEveryShape) {
+    for (const TextureShape& shape : textureShapes) {
+        SCOPED_TRACE(shape.name);
+        ktxTexture2* first = compressed(shape, 5);
+        ktxTexture2* second = compressed(shape, 5);
+        ASSERT_TRUE(first != nullptr && second != nullptr);
+        EXPECT_EQ(writeToMemory(second), writeToMemory(first));
+        ktxTexture_Destroy(ktxTexture(first));
+        ktxTexture_Destroy(ktxTexture(second));
+    }
+    EXPECT_EQ(compressCalls, (int)std::size(textureShapes));
+}
+
+TEST_F(EncodeCacheTest, DifferentInputOrParamsMiss) {
+    ktxTexture2* textures[3];
+    textures[0] = compressed(textureShapes[0], 4);
+    textures[1] = compressed(textureShapes[0], 5);
+    params.qualityLevel = 2;
+    textures[2] = compressed(textureShapes[0], 4);
+
+    EXPECT_EQ(compressCalls, 3);
+    for (ktxTexture2* texture : textures)
+        ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST_F(EncodeCacheTest, NoCacheAlwaysCompresses) {
+    params.cache = nullptr;
+    ktxTexture2* first = compressed(textureShapes[0], 4);
+    ktxTexture2* second = compressed(textureShapes[0], 4);
+
+    EXPECT_EQ(compressCalls, 2);
+    ktxTexture_Destroy(ktxTexture(first));
+    ktxTexture_Destroy(ktxTexture(second));
+}
+
+TEST_F(EncodeCacheTest, EntriesPersistAcrossCaches) {
+    ktxTexture2* first = compressed(textureShapes[1], 6);
+    reopen(0, 0);
+    ktxTexture2* second = compressed(textureShapes[1], 6);
+
+    EXPECT_EQ(compressCalls, 1);
+    EXPECT_EQ(writeToMemory(second), writeToMemory(first));
+    ktxTexture_Destroy(ktxTexture(first));
+    ktxTexture_Destroy(ktxTexture(second));
+}
+
+TEST_F(EncodeCacheTest, LeastRecentlyUsedEntryIsEvicted) {
+    reopen(0, 2);
+
+    ktxTexture2* textures[5];
+    textures[0] = compressed(textureShapes[0], 7);
+    textures[1] = compressed(textureShapes[0], 8);
+    textures[2] = compressed(textureShapes[0], 7);  // Hit. 8 is now oldest.
+    textures[3] = compressed(textureShapes[0], 9);  // Evicts 8.
+    textures[4] = compressed(textureShapes[0], 7);  // Hit.
+    EXPECT_EQ(compressCalls, 3);
+
+    ktxTexture2* evicted = compressed(textureShapes[0], 8);
+    EXPECT_EQ(compressCalls, 4);
+    ktxTexture_Destroy(ktxTexture(evicted));
+    for (ktxTexture2* texture : textures)
+        ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST_F(EncodeCacheTest, ReopeningWithLowerLimitEvicts) {
+    ktxTexture2* first = compressed(textureShapes[0], 10);
+    ktxTexture2* second = compressed(textureShapes[0], 11);
+    reopen(0, 1);
+    ktxTexture2* again = compressed(textureShapes[0], 10);
+
+    EXPECT_EQ(compressCalls, 3);
+    ktxTexture_Destroy(ktxTexture(first));
+    ktxTexture_Destroy(ktxTexture(second));
+    ktxTexture_Destroy(ktxTexture(again));
+}
+
+TEST(EncodeCacheCreateTest, RejectsInvalidArguments) {
+    ktxEncodeCache* cache = nullptr;
+    EXPECT_EQ(ktxEncodeCache_Create(nullptr, 0, 0, &cache),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxEncodeCache_Create("", 0, 0, &cache), KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxEncodeCache_Create(::testing::TempDir().c_str(), 0, 0,
+                                    nullptr),
+              KTX_INVALID_VALUE);
+    std::filesystem::path missing
+        = std::filesystem::path(::testing::TempDir()) / "no_such_directory"
+        / "cache";
+    EXPECT_EQ(ktxEncodeCache_Create(missing.u8string().c_str(), 0, 0,
+                                    &cache),
+              KTX_FILE_OPEN_FAILED);
+    EXPECT_TRUE(cache == nullptr);
+}
+
+} // namespace
@@ -0,0 +1,262 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file leveltests.cc
+ * @~English
+ *
+ * @brief Tests of loading KTX2 levels into caller memory with
+ *        ktxTexture2_LoadLevels() and ktxTexture2_LoadLevelsAsync().
+ *
+ * The levels loaded are compared with those loaded in full by
+ * ktxTexture2_CreateFromNamedFile() with
+ * KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT.
+ */
+
+#include <atomic>
+#include <string.h>
+
+#include "ktxtest.h"
+
+namespace {
+
+//////////////////////////////
+// Helpers
+//////////////////////////////
+
+// Compare a buffer filled by ktxTexture2_LoadLevels() with the levels of
+// the fully loaded reference texture.
+void
+expectLevelsMatch(ktxTexture2* reference, ktx_uint32_t firstLevel,
+                  ktx_uint32_t levelCount,
+                  const std::vector<ktx_uint8_t>& buffer)
+{
+    size_t offset = 0;
+    for (ktx_uint32_t level = firstLevel; level < firstLevel + levelCount;
+         level++) {
+        std::vector<ktx_uint8_t> expected = levelData(reference, level);
+        ASSERT_LE(offset + expected.size(), buffer.size());
+        EXPECT_EQ(memcmp(buffer.data() + offset, expected.data(),
+                         expected.size()), 0) << "Level " << level;
+        offset += expected.size();
+    }
+    EXPECT_EQ(offset, buffer.size());
+}
+
+/////////////////////////////////////////
+// Test fixture, parameterized by file
+/////////////////////////////////////////
+
+class LevelLoadTest : public ::testing::TestWithParam<const char*> {
+  protected:
+    void SetUp() override {
+        reference = createTexture(GetParam(),
+                                  KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+        texture = createTexture(GetParam(),
+                                KTX_TEXTURE_CREATE_NO_FLAGS);
+        ASSERT_TRUE(reference != nullptr && texture != nullptr);
+    }
+
+    void TearDown() override {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+        if (reference)
+            ktxTexture_Destroy(ktxTexture(reference));
+    }
+
+    ktxTexture2* reference = nullptr;
+    ktxTexture2* texture = nullptr;
+};
+
+// Zstd and ZLIB levels are inflated. BasisLZ levels are returned as stored.
+INSTANTIATE_TEST_SUITE_P(Files, LevelLoadTest,
+                         ::testing::Values("uastc_cube.ktx2",
+                                           "uastc_cube_zstd.ktx2",
+                                           "uastc_cube_zlib.ktx2",
+                                           "etc1s_array.ktx2"));
+
+//////////////////////////////
+// LoadLevels
+//////////////////////////////
+
+TEST_P(LevelLoadTest, LoadsEveryRangeOfLevels) {
+    ktx_uint32_t numLevels = texture->numLevels;
+    ASSERT_GT(numLevels, 1U);
+
+    for (ktx_uint32_t first = 0; first < numLevels; first++) {
+        for (ktx_uint32_t count = 1; count <= numLevels - first; count++) {
+            ktx_size_t size;
+            ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, first, count,
+                                                    &size), KTX_SUCCESS);
+            std::vector<ktx_uint8_t> buffer(size);
+            ASSERT_EQ(ktxTexture2_LoadLevels(texture, first, count,
+                                             buffer.data(), buffer.size()),
+                      KTX_SUCCESS) << "Levels " << first << "+" << count;
+            expectLevelsMatch(reference, first, count, buffer);
+        }
+    }
+    EXPECT_TRUE(texture->pData == nullptr)
+        << "LoadLevels must not load the texture's image data.";
+}
+
+TEST_P(LevelLoadTest, LoadsSmallestLevelsFirst) {
+    for (ktx_uint32_t level = texture->numLevels; level-- > 0;) {
+        ktx_size_t size;
+        ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, level, 1, &size),
+                  KTX_SUCCESS);
+        std::vector<ktx_uint8_t> buffer(size);
+        ASSERT_EQ(ktxTexture2_LoadLevels(texture, level, 1,
+                                         buffer.data(), buffer.size()),
+                  KTX_SUCCESS);
+        expectLevelsMatch(reference, level, 1, buffer);
+    }
+}
+
+TEST_P(LevelLoadTest, CopiesFromLoadedImageData) {
+    ktx_size_t size;
+    ASSERT_EQ(ktxTexture2_GetLevelsDataSize(reference, 1,
+                                            reference->numLevels - 1, &size),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> buffer(size);
+    ASSERT_EQ(ktxTexture2_LoadLevels(reference, 1, reference->numLevels - 1,
+                                     buffer.data(), buffer.size()),
+              KTX_SUCCESS);
+    expectLevelsMatch(reference, 1, reference->numLevels - 1, buffer);
+}
+
+TEST_P(LevelLoadTest, RejectsInvalidArguments) {
+    ktx_size_t size;
+    ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, 0, 1, &size),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> buffer(size);
+
+    EXPECT_EQ(ktxTexture2_LoadLevels(texture, 0, 1, buffer.data(), size - 1),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_LoadLevels(texture, 0, 1, nullptr, size),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_LoadLevels(texture, 0, 0, buffer.data(), size),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_LoadLevels(texture, texture->numLevels - 1, 2,
+                                     buffer.data(), size),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_GetLevelsDataSize(texture, texture->numLevels, 1,
+                                            &size),
+              KTX_INVALID_VALUE);
+}
+
+//////////////////////////////
+// LoadLevelsAsync
+//////////////////////////////
+
+struct AsyncCounts {
+    std::atomic<int> completed{0};
+    std::atomic<int> failed{0};
+};
+
+void KTX_APIENTRY
+countCompletion(ktxTexture2*, ktx_uint32_t, ktx_uint32_t,
+                KTX_error_code result, void* userdata)
+{
+    AsyncCounts* counts = static_cast<AsyncCounts*>(userdata);
+    if (result != KTX_SUCCESS)
+        counts->failed++;
+    counts->completed++;
+}
+
+TEST_P(LevelLoadTest, LoadsLevelsAsynchronously) {
+    ktx_uint32_t numLevels = texture->numLevels;
+    std::vector<std::vector<ktx_uint8_t>> buffers(numLevels);
+    std::vector<ktxLevelLoad*> loads(numLevels);
+    AsyncCounts counts;
+
+    // Smallest first, as an application streaming levels in would.
+    for (ktx_uint32_t level = numLevels; level-- > 0;) {
+        ktx_size_t size;
+        ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, level, 1, &size),
+                  KTX_SUCCESS);
+        buffers[level].resize(size);
+        ASSERT_EQ(ktxTexture2_LoadLevelsAsync(texture, level, 1,
+                                              buffers[level].data(), size,
+                                              countCompletion, &counts,
+                                              &loads[level]),
+                  KTX_SUCCESS);
+    }
+    for (ktx_uint32_t level = 0; level < numLevels; level++) {
+        EXPECT_EQ(ktxLevelLoad_Wait(loads[level]), KTX_SUCCESS);
+        EXPECT_TRUE(ktxLevelLoad_IsComplete(loads[level]));
+        ktxLevelLoad_Destroy(loads[level]);
+        expectLevelsMatch(reference, level, 1, buffers[level]);
+    }
+    EXPECT_EQ(counts.completed, (int)numLevels);
+    EXPECT_EQ(counts.failed, 0);
+}
+
+TEST_P(LevelLoadTest, DestroyCompletesPendingLoads) {
+    ktx_size_t size;
+    ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, 0, texture->numLevels,
+                                            &size), KTX_SUCCESS);
+    std::vector<ktx_uint8_t> whole(size), again(size);
+    AsyncCounts counts;
+
+    ASSERT_EQ(ktxTexture2_LoadLevelsAsync(texture, 0, texture->numLevels,
+                                          whole.data(), whole.size(),
+                                          countCompletion, &counts, nullptr),
+              KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture2_LoadLevelsAsync(texture, 0, texture->numLevels,
+                                          again.data(), again.size(),
+                                          countCompletion, &counts, nullptr),
+              KTX_SUCCESS);
+    ktx_uint32_t numLevels = texture->numLevels;
+    ktxTexture_Destroy(ktxTexture(texture));
+    texture = nullptr;
+
+    EXPECT_EQ(counts.completed, 2);
+    EXPECT_EQ(counts.failed, 0);
+    expectLevelsMatch(reference, 0, numLevels, whole);
+    expectLevelsMatch(reference, 0, numLevels, again);
+}
+
+TEST_P(LevelLoadTest, AsyncRejectsInvalidArguments) {
+    ktx_size_t size;
+    ASSERT_EQ(ktxTexture2_GetLevelsDataSize(texture, 0, 1, &size),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> buffer(size);
+    ktxLevelLoad* load = nullptr;
+
+    EXPECT_EQ(ktxTexture2_LoadLevelsAsync(texture, 0, 1, buffer.data(),
+                                          size - 1, nullptr, nullptr, &load),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_LoadLevelsAsync(texture, texture->numLevels, 1,
+                                          buffer.data(), size,
+                                          nullptr, nullptr, &load),
+              KTX_INVALID_VALUE);
+}
+
+//////////////////////////////
+// Memory-mapped files
+//////////////////////////////
+
+TEST_P(LevelLoadTest, LoadsLevelsFromMappedFile) {
+    ktxTexture2* mapped = createTexture(GetParam(),
+                                        KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT);
+    ASSERT_TRUE(mapped != nullptr);
+
+    ktx_size_t size;
+    ASSERT_EQ(ktxTexture2_GetLevelsDataSize(mapped, 1, mapped->numLevels - 1,
+                                            &size), KTX_SUCCESS);
+    std::vector<ktx_uint8_t> buffer(size);
+    ASSERT_EQ(ktxTexture2_LoadLevels(mapped, 1, mapped->numLevels - 1,
+                                     buffer.data(), buffer.size()),
+              KTX_SUCCESS);
+    expectLevelsMatch(reference, 1, mapped->numLevels - 1, buffer);
+    EXPECT_TRUE(mapped->pData == nullptr);
+    ktxTexture_Destroy(ktxTexture(mapped));
+}
+
+} // namespace
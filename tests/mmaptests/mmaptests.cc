@@ -0,0 +1,127 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file mmaptests.cc
+ * @~English
+ *
+ * @brief Tests of creating KTX2 textures from memory-mapped files with
+ *        KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT.
+ *
+ * The images are compared with those loaded through the stdio stream.
+ */
+
+#include <string.h>
+
+#include "ktxtest.h"
+
+namespace {
+
+/////////////////////////////////////////
+// Test fixture, parameterized by file
+/////////////////////////////////////////
+
+class MappedFileTest : public ::testing::TestWithParam<const char*> {
+  protected:
+    void SetUp() override {
+        reference = createTexture(GetParam(),
+                                  KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+        ASSERT_TRUE(reference != nullptr);
+    }
+
+    void TearDown() override {
+        if (reference)
+            ktxTexture_Destroy(ktxTexture(reference));
+    }
+
+    void expectImagesMatch(ktxTexture2* mapped) {
+        ASSERT_TRUE(mapped->pData != nullptr);
+        ASSERT_EQ(mapped->dataSize, reference->dataSize);
+        EXPECT_EQ(memcmp(mapped->pData, reference->pData, mapped->dataSize),
+                  0);
+        EXPECT_EQ(mapped->supercompressionScheme,
+                  reference->supercompressionScheme);
+    }
+
+    ktxTexture2* reference = nullptr;
+};
+
+// Zstd and ZLIB images are inflated. BasisLZ images are loaded as stored.
+INSTANTIATE_TEST_SUITE_P(Files, MappedFileTest,
+                         ::testing::Values("uastc_cube.ktx2",
+                                           "uastc_cube_zstd.ktx2",
+                                           "uastc_cube_zlib.ktx2",
+                                           "etc1s_array.ktx2"));
+
+TEST_P(MappedFileTest, LoadsSameImages) {
+    ktx_uint32_t scheme;
+    {
+        ktxTexture2* unloaded = createTexture(GetParam(),
+                                              KTX_TEXTURE_CREATE_NO_FLAGS);
+        ASSERT_TRUE(unloaded != nullptr);
+        scheme = unloaded->supercompressionScheme;
+        ktxTexture_Destroy(ktxTexture(unloaded));
+    }
+    ktxTexture2* mapped = createTexture(GetParam(),
+                                     KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT
+                                     | KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+    ASSERT_TRUE(mapped != nullptr);
+
+    EXPECT_EQ(ktxTexture2_getStream(mapped)->type, eStreamTypeMmap);
+    expectImagesMatch(mapped);
+
+    // Images that are not supercompressed are used in place. Others are
+    // inflated into memory of their own and the mapping is released.
+    ktx_uint8_t* mapping = mapped->_private->_mappedData;
+    if (scheme == KTX_SS_NONE) {
+        ASSERT_TRUE(mapping != nullptr);
+        EXPECT_GE(mapped->pData, mapping);
+        EXPECT_LE(mapped->pData + mapped->dataSize,
+                  mapping + mapped->_private->_mappedSize);
+    } else {
+        EXPECT_TRUE(mapping == nullptr);
+    }
+    ktxTexture_Destroy(ktxTexture(mapped));
+}
+
+TEST_P(MappedFileTest, LoadsImageDataLater) {
+    ktxTexture2* mapped = createTexture(GetParam(),
+                                        KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT);
+    ASSERT_TRUE(mapped != nullptr);
+    EXPECT_TRUE(mapped->pData == nullptr);
+
+    ASSERT_EQ(ktxTexture_LoadImageData(ktxTexture(mapped), nullptr, 0),
+              KTX_SUCCESS);
+    expectImagesMatch(mapped);
+    ktxTexture_Destroy(ktxTexture(mapped));
+}
+
+TEST_P(MappedFileTest, LoadsImageDataIntoCallerBuffer) {
+    ktxTexture2* mapped = createTexture(GetParam(),
+                                        KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT);
+    ASSERT_TRUE(mapped != nullptr);
+
+    std::vector<ktx_uint8_t> buffer(reference->dataSize);
+    ASSERT_EQ(ktxTexture_LoadImageData(ktxTexture(mapped), buffer.data(),
+                                       buffer.size()),
+              KTX_SUCCESS);
+    EXPECT_EQ(memcmp(buffer.data(), reference->pData, buffer.size()), 0);
+    ktxTexture_Destroy(ktxTexture(mapped));
+}
+
+TEST(MappedFileErrorTest, MissingFileFails) {
+    ktxTexture2* texture = nullptr;
+    EXPECT_EQ(ktxTexture2_CreateFromNamedFile(
+                  (testImagesPath + "no_such_file.ktx2").c_str(),
+                  KTX_TEXTURE_CREATE_MAP_IMAGE_DATA_BIT, &texture),
+              KTX_FILE_OPEN_FAILED);
+    EXPECT_TRUE(texture == nullptr);
+}
+
+} // namespace
@@ -0,0 +1,197 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file sizetests.cc
+ * @~English
+ *
+ * @brief Tests of the size-only queries, ktxTexture2_GetSerializedSize()
+ *        and ktxTexture2_GetTranscodedSize().
+ *
+ * The sizes are compared with those of the output of
+ * ktxTexture_WriteToMemory() and ktxTexture2_TranscodeBasis().
+ */
+
+#include <string>
+#include <tuple>
+
+#include "ktxtest.h"
+
+namespace {
+
+//////////////////////////////
+// GetSerializedSize
+//////////////////////////////
+
+void
+expectSerializedSizeMatches(ktxTexture2* texture)
+{
+    ktx_size_t size = 0;
+    ASSERT_EQ(ktxTexture2_GetSerializedSize(texture, &size), KTX_SUCCESS);
+    EXPECT_EQ(size, writeToMemory(texture).size());
+    // Asking does not change the answer.
+    ktx_size_t again = 0;
+    ASSERT_EQ(ktxTexture2_GetSerializedSize(texture, &again), KTX_SUCCESS);
+    EXPECT_EQ(again, size);
+}
+
+class SerializedSizeTest : public ::testing::TestWithParam<const char*> { };
+
+INSTANTIATE_TEST_SUITE_P(Files, SerializedSizeTest,
+                         ::testing::Values("etc1s_array.ktx2",
+                                           "etc1s_video.ktx2",
+                                           "uastc_cube.ktx2",
+                                           "uastc_cube_zstd.ktx2",
+                                           "uastc_cube_zlib.ktx2",
+                                           "uastc_video.ktx2"));
+
+TEST_P(SerializedSizeTest, MatchesWriteToMemory) {
+    ktxTexture2* texture = createTexture(GetParam(),
+                                         KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+    ASSERT_TRUE(texture != nullptr);
+    expectSerializedSizeMatches(texture);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST_P(SerializedSizeTest, MatchesWriteToMemoryAfterTranscoding) {
+    ktxTexture2* texture = createTexture(GetParam(),
+                                         KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+    ASSERT_TRUE(texture != nullptr);
+    ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_BC7_RGBA, 0),
+              KTX_SUCCESS);
+    expectSerializedSizeMatches(texture);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST_P(SerializedSizeTest, MatchesWriteToMemoryAfterDeflating) {
+    for (int zlib = 0; zlib < 2; zlib++) {
+        ktxTexture2* texture
+            = createTexture(GetParam(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+        ASSERT_TRUE(texture != nullptr);
+        if (texture->supercompressionScheme == KTX_SS_NONE) {
+            ASSERT_EQ(zlib ? ktxTexture2_DeflateZLIB(texture, 6)
+                           : ktxTexture2_DeflateZstd(texture, 5),
+                      KTX_SUCCESS);
+            expectSerializedSizeMatches(texture);
+        }
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+
+TEST(SerializedSizeShapeTest, MatchesWriteToMemoryForCreatedTextures) {
+    for (const TextureShape& shape : textureShapes) {
+        SCOPED_TRACE(shape.name);
+        ktxTexture2* texture = createPatternTexture(shape, 3);
+        ASSERT_TRUE(texture != nullptr);
+        expectSerializedSizeMatches(texture);
+        ASSERT_EQ(ktxHashList_AddKVPair(&texture->kvDataHead,
+                                        KTX_ORIENTATION_KEY, 3, "rd"),
+                  KTX_SUCCESS);
+        expectSerializedSizeMatches(texture);
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+
+TEST(SerializedSizeShapeTest, RejectsInvalidArguments) {
+    ktxTexture2* texture = createPatternTexture(textureShapes[0], 3);
+    ASSERT_TRUE(texture != nullptr);
+    ktx_size_t size;
+    EXPECT_EQ(ktxTexture2_GetSerializedSize(texture, nullptr),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_GetSerializedSize(nullptr, &size),
+              KTX_INVALID_VALUE);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+////////////////////////////////////////////////////////////
+// GetTranscodedSize, parameterized by file and target format
+////////////////////////////////////////////////////////////
+
+const char*
+formatName(ktx_transcode_fmt_e format)
+{
+    switch (format) {
+      case KTX_TTF_RGBA32: return "RGBA32";
+      case KTX_TTF_BC7_RGBA: return "BC7_RGBA";
+      case KTX_TTF_ETC1_RGB: return "ETC1_RGB";
+      case KTX_TTF_RGB565: return "RGB565";
+      default: return "other";
+    }
+}
+
+typedef std::tuple<const char*, ktx_transcode_fmt_e> TranscodeParam;
+
+class TranscodedSizeTest : public ::testing::TestWithParam<TranscodeParam> { };
+
+std::string
+transcodeParamName(const ::testing::TestParamInfo<TranscodeParam>& info)
+{
+    std::string name = std::get<0>(info.param);
+    name = name.substr(0, name.find('.'));
+    return name + "_" + formatName(std::get<1>(info.param));
+}
+
+INSTANTIATE_TEST_SUITE_P(FilesAndFormats, TranscodedSizeTest,
+                         ::testing::Combine(
+                             ::testing::Values("etc1s_array.ktx2",
+                                               "etc1s_video.ktx2",
+                                               "uastc_cube_zstd.ktx2",
+                                               "uastc_video.ktx2"),
+                             ::testing::Values(KTX_TTF_RGBA32,
+                                               KTX_TTF_RGB565,
+                                               KTX_TTF_BC7_RGBA,
+                                               KTX_TTF_ETC1_RGB)),
+                         transcodeParamName);
+
+TEST_P(TranscodedSizeTest, MatchesTranscodeBasis) {
+    const char* fileName = std::get<0>(GetParam());
+    ktx_transcode_fmt_e format = std::get<1>(GetParam());
+
+    // The size is known without loading the image data.
+    ktxTexture2* unloaded = createTexture(fileName,
+                                          KTX_TEXTURE_CREATE_NO_FLAGS);
+    ASSERT_TRUE(unloaded != nullptr);
+    ktx_size_t size = 0;
+    ASSERT_EQ(ktxTexture2_GetTranscodedSize(unloaded, format, &size),
+              KTX_SUCCESS);
+    EXPECT_TRUE(unloaded->pData == nullptr);
+    ktxTexture_Destroy(ktxTexture(unloaded));
+
+    ktxTexture2* texture = createTexture(fileName,
+                                         KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+    ASSERT_TRUE(texture != nullptr);
+    ktx_size_t levelsSize = 0;
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_size_t levelSize;
+        ASSERT_EQ(ktxTexture2_GetTranscodedLevelSize(texture, level, format,
+                                                     &levelSize),
+                  KTX_SUCCESS);
+        levelsSize += levelSize;
+    }
+
+    ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, format, 0), KTX_SUCCESS);
+    EXPECT_EQ(size, texture->dataSize);
+    // Levels are padded to the alignment of the target format.
+    EXPECT_GE(size, levelsSize);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST(TranscodedSizeErrorTest, RejectsInvalidArguments) {
+    ktxTexture2* texture = createTexture("etc1s_array.ktx2",
+                                         KTX_TEXTURE_CREATE_NO_FLAGS);
+    ASSERT_TRUE(texture != nullptr);
+    ktx_size_t size;
+    EXPECT_EQ(ktxTexture2_GetTranscodedSize(texture, KTX_TTF_RGBA32, nullptr),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_GetTranscodedSize(nullptr, KTX_TTF_RGBA32, &size),
+              KTX_INVALID_VALUE);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+} // namespace
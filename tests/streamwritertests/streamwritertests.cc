@@ -0,0 +1,291 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file streamwritertests.cc
+ * @~English
+ *
+ * @brief Tests of writing KTX2 files a level at a time with
+ *        ktxStreamWriter.
+ *
+ * Written files are reloaded and their levels compared with those of the
+ * source texture. Uncompressed files must be identical to those written
+ * by ktxTexture_WriteToMemory().
+ */
+
+#include <algorithm>
+#include <ostream>
+#include <stdio.h>
+#include <string.h>
+
+#include "ktxtest.h"
+extern "C" {
+#include "memstream.h"
+}
+
+namespace {
+
+enum LevelOrder { SmallestFirst, LargestFirst, Shuffled };
+
+struct StreamWriterParam {
+    TextureShape shape;
+    ktxSupercmpScheme scheme;
+    LevelOrder order;
+};
+
+std::ostream&
+operator<<(std::ostream& os, const StreamWriterParam& param)
+{
+    return os << param.shape.name << " scheme " << param.scheme
+              << " order " << param.order;
+}
+
+class StreamWriterTest : public ::testing::TestWithParam<StreamWriterParam> {
+  protected:
+    void SetUp() override {
+        texture = createPatternTexture(GetParam().shape, 1);
+        ASSERT_TRUE(texture != nullptr);
+        params.structSize = sizeof(params);
+        params.supercompressionScheme = GetParam().scheme;
+        params.compressionLevel = GetParam().scheme == KTX_SS_ZLIB ? 6 : 5;
+        params.threadCount = GetParam().order == Shuffled ? 3 : 0;
+    }
+
+    void TearDown() override {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+    }
+
+    std::vector<ktx_uint32_t> levelOrder() {
+        std::vector<ktx_uint32_t> order(texture->numLevels);
+        for (ktx_uint32_t i = 0; i < texture->numLevels; i++)
+            order[i] = GetParam().order == SmallestFirst
+                     ? texture->numLevels - 1 - i : i;
+        if (GetParam().order == Shuffled)
+            std::shuffle(order.begin(), order.end(), std::minstd_rand(1));
+        return order;
+    }
+
+    void writeLevels(ktxStreamWriter* writer) {
+        for (ktx_uint32_t level : levelOrder()) {
+            std::vector<ktx_uint8_t> data = levelData(texture, level);
+            ASSERT_EQ(ktxStreamWriter_WriteLevel(writer, level, data.data(),
+                                                 data.size()),
+                      KTX_SUCCESS) << "Level " << level;
+        }
+        EXPECT_EQ(ktxStreamWriter_Finish(writer), KTX_SUCCESS);
+    }
+
+    // Write the levels of the texture to a memory stream with a writer
+    // created from @p description. If not @p seekable the stream's
+    // position cannot be got or set, as with a pipe.
+    std::vector<ktx_uint8_t> writeToMemoryStream(ktxTexture2* description,
+                                                 bool seekable);
+
+    // Uncompressed output must be exactly what WriteToMemory writes.
+    void expectWritten(const std::vector<ktx_uint8_t>& bytes) {
+        if (GetParam().scheme == KTX_SS_NONE)
+            EXPECT_EQ(bytes, writeToMemory(texture));
+        expectReloadMatches(bytes, texture, GetParam().scheme);
+    }
+
+    ktxTexture2* texture = nullptr;
+    ktxStreamWriterParams params = {};
+};
+
+std::vector<StreamWriterParam>
+streamWriterParams()
+{
+    std::vector<StreamWriterParam> params;
+    for (const TextureShape& shape : textureShapes)
+        for (ktxSupercmpScheme scheme : { KTX_SS_NONE, KTX_SS_ZSTD,
+                                          KTX_SS_ZLIB })
+            for (LevelOrder order : { SmallestFirst, LargestFirst, Shuffled })
+                params.push_back({ shape, scheme, order });
+    return params;
+}
+
+INSTANTIATE_TEST_SUITE_P(ShapesSchemesAndOrders, StreamWriterTest,
+                         ::testing::ValuesIn(streamWriterParams()));
+
+KTX_error_code
+failPosition(ktxStream*, ktx_off_t)
+{
+    return KTX_FILE_ISPIPE;
+}
+
+KTX_error_code
+failGetPosition(ktxStream*, ktx_off_t* const)
+{
+    return KTX_FILE_ISPIPE;
+}
+
+std::vector<ktx_uint8_t>
+StreamWriterTest::writeToMemoryStream(ktxTexture2* description, bool seekable)
+{
+    std::vector<ktx_uint8_t> bytes;
+    ktxStream stream;
+    EXPECT_EQ(ktxMemStream_construct(&stream, KTX_FALSE), KTX_SUCCESS);
+    if (!seekable) {
+        stream.getpos = failGetPosition;
+        stream.setpos = failPosition;
+    }
+    ktxStreamWriter* writer = nullptr;
+    EXPECT_EQ(ktxStreamWriter_Create(description, &stream, &params, &writer),
+              KTX_SUCCESS);
+    if (writer) {
+        writeLevels(writer);
+        ktxStreamWriter_Destroy(writer);
+
+        ktx_uint8_t* data;
+        ktx_size_t size;
+        ktxMemStream_getdata(&stream, &data);
+        stream.getsize(&stream, &size);
+        bytes.assign(data, data + size);
+    }
+    stream.destruct(&stream);
+    return bytes;
+}
+
+TEST_P(StreamWriterTest, WritesToMemoryStream) {
+    expectWritten(writeToMemoryStream(texture, true));
+}
+
+TEST_P(StreamWriterTest, WritesToNonSeekableStream) {
+    expectWritten(writeToMemoryStream(texture, false));
+}
+
+TEST_P(StreamWriterTest, WritesFromTextureWithoutStorage) {
+    ktxTextureCreateInfo createInfo = {};
+    createInfo.vkFormat = texture->vkFormat;
+    createInfo.baseWidth = texture->baseWidth;
+    createInfo.baseHeight = texture->baseHeight;
+    createInfo.baseDepth = texture->baseDepth;
+    createInfo.numDimensions = texture->numDimensions;
+    createInfo.numLevels = texture->numLevels;
+    createInfo.numLayers = texture->numLayers;
+    createInfo.numFaces = texture->numFaces;
+    createInfo.isArray = texture->isArray;
+    createInfo.generateMipmaps = KTX_FALSE;
+    ktxTexture2* description = nullptr;
+    ASSERT_EQ(ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_NO_STORAGE,
+                                 &description), KTX_SUCCESS);
+    EXPECT_TRUE(description->pData == nullptr);
+
+    std::vector<ktx_uint8_t> bytes = writeToMemoryStream(description, true);
+    ktxTexture_Destroy(ktxTexture(description));
+    expectWritten(bytes);
+}
+
+TEST_P(StreamWriterTest, WritesToStdioStreamAfterOtherData) {
+    FILE* file = tmpfile();
+    ASSERT_TRUE(file != nullptr);
+    fwrite("HEAD", 1, 4, file);
+    ktxStreamWriter* writer = nullptr;
+    ASSERT_EQ(ktxStreamWriter_CreateForStdioStream(texture, file, &params,
+                                                   &writer),
+              KTX_SUCCESS);
+    writeLevels(writer);
+    ktxStreamWriter_Destroy(writer);
+    fwrite("TAIL", 1, 4, file);
+
+    long size = ftell(file);
+    ASSERT_GT(size, 8);
+    std::vector<ktx_uint8_t> all((size_t)size);
+    rewind(file);
+    ASSERT_EQ(fread(all.data(), 1, all.size(), file), all.size());
+    fclose(file);
+    EXPECT_EQ(memcmp(all.data(), "HEAD", 4), 0);
+    EXPECT_EQ(memcmp(all.data() + all.size() - 4, "TAIL", 4), 0);
+    expectWritten(std::vector<ktx_uint8_t>(all.begin() + 4, all.end() - 4));
+}
+
+TEST(StreamWriterMisuseTest, RejectsInvalidUse) {
+    TextureShape shape = { "rgba8", VK_FORMAT_R8G8B8A8_UNORM, 8, 8, 1, 1, 1, 4 };
+    ktxTexture2* texture = createPatternTexture(shape, 2);
+    ASSERT_TRUE(texture != nullptr);
+    ktxStream stream;
+    ASSERT_EQ(ktxMemStream_construct(&stream, KTX_FALSE), KTX_SUCCESS);
+    ktxStreamWriterParams params = { sizeof(params), KTX_SS_ZSTD, 0, 0 };
+    ktxStreamWriter* writer = nullptr;
+
+    params.supercompressionScheme = KTX_SS_BASIS_LZ;
+    EXPECT_EQ(ktxStreamWriter_Create(texture, &stream, &params, &writer),
+              KTX_INVALID_VALUE);
+    params.supercompressionScheme = KTX_SS_ZSTD;
+    params.structSize = 4;
+    EXPECT_EQ(ktxStreamWriter_Create(texture, &stream, &params, &writer),
+              KTX_INVALID_VALUE);
+    params.structSize = sizeof(params);
+
+    ASSERT_EQ(ktxStreamWriter_Create(texture, &stream, &params, &writer),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> data = levelData(texture, 1);
+    EXPECT_EQ(ktxStreamWriter_WriteLevel(writer, 1, data.data(),
+                                         data.size() + 1),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxStreamWriter_WriteLevel(writer, 4, data.data(), data.size()),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxStreamWriter_WriteLevel(writer, 1, data.data(), data.size()),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxStreamWriter_WriteLevel(writer, 1, data.data(), data.size()),
+              KTX_INVALID_OPERATION);
+    EXPECT_EQ(ktxStreamWriter_Finish(writer), KTX_INVALID_OPERATION);
+    ktxStreamWriter_Destroy(writer);
+    stream.destruct(&stream);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST(StreamWriterMisuseTest, RejectsSupercompressedTexture) {
+    ktxTexture2* texture = createTexture("uastc_cube_zstd.ktx2",
+                                         KTX_TEXTURE_CREATE_NO_FLAGS);
+    ASSERT_TRUE(texture != nullptr);
+    ktxStream stream;
+    ASSERT_EQ(ktxMemStream_construct(&stream, KTX_FALSE), KTX_SUCCESS);
+    ktxStreamWriterParams params = { sizeof(params), KTX_SS_ZSTD, 0, 0 };
+    ktxStreamWriter* writer = nullptr;
+    EXPECT_EQ(ktxStreamWriter_Create(texture, &stream, &params, &writer),
+              KTX_INVALID_OPERATION);
+    stream.destruct(&stream);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST(StreamWriterFileTest, WritesUastcFile) {
+    ktxTexture2* texture = createTexture("uastc_cube.ktx2",
+                                         KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+    ASSERT_TRUE(texture != nullptr);
+    for (ktxSupercmpScheme scheme : { KTX_SS_NONE, KTX_SS_ZSTD,
+                                      KTX_SS_ZLIB }) {
+        ktxStream stream;
+        ASSERT_EQ(ktxMemStream_construct(&stream, KTX_FALSE), KTX_SUCCESS);
+        ktxStreamWriterParams params = { sizeof(params), scheme, 0, 0 };
+        ktxStreamWriter* writer = nullptr;
+        ASSERT_EQ(ktxStreamWriter_Create(texture, &stream, &params, &writer),
+                  KTX_SUCCESS);
+        for (ktx_uint32_t level = texture->numLevels; level-- > 0;) {
+            std::vector<ktx_uint8_t> data = levelData(texture, level);
+            ASSERT_EQ(ktxStreamWriter_WriteLevel(writer, level, data.data(),
+                                                 data.size()),
+                      KTX_SUCCESS);
+        }
+        ASSERT_EQ(ktxStreamWriter_Finish(writer), KTX_SUCCESS);
+        ktxStreamWriter_Destroy(writer);
+
+        ktx_uint8_t* data;
+        ktx_size_t size;
+        ktxMemStream_getdata(&stream, &data);
+        stream.getsize(&stream, &size);
+        expectReloadMatches(std::vector<ktx_uint8_t>(data, data + size),
+                            texture, scheme);
+        stream.destruct(&stream);
+    }
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+} // namespace
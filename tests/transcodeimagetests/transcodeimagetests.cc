@@ -0,0 +1,241 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file transcodeimagetests.cc
+ * @~English
+ *
+ * @brief Tests of transcoding single images of BasisLZ/ETC1S and UASTC
+ *        textures into caller memory with ktxTexture2_TranscodeImage().
+ *
+ * Images are compared, row by row, with those of the levels transcoded
+ * by ktxTexture2_TranscodeLevel().
+ */
+
+#include <string>
+#include <tuple>
+#include <string.h>
+
+#include "ktxtest.h"
+
+namespace {
+
+//////////////////////////////
+// Helpers
+//////////////////////////////
+
+const char*
+formatName(ktx_transcode_fmt_e format)
+{
+    switch (format) {
+      case KTX_TTF_RGBA32: return "RGBA32";
+      case KTX_TTF_BC7_RGBA: return "BC7_RGBA";
+      case KTX_TTF_ETC1_RGB: return "ETC1_RGB";
+      case KTX_TTF_RGB565: return "RGB565";
+      default: return "other";
+    }
+}
+
+////////////////////////////////////////////////////////////
+// Test fixture, parameterized by file and target format
+////////////////////////////////////////////////////////////
+
+typedef std::tuple<const char*, ktx_transcode_fmt_e> TranscodeParam;
+
+class TranscodeImageTest : public ::testing::TestWithParam<TranscodeParam> {
+  protected:
+    void SetUp() override {
+        fileName = std::get<0>(GetParam());
+        format = std::get<1>(GetParam());
+        texture = createTexture(fileName,
+                                KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+        ASSERT_TRUE(texture != nullptr);
+    }
+
+    void TearDown() override {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+    }
+
+    // Images of @p level, tightly packed, transcoded by TranscodeLevel.
+    std::vector<ktx_uint8_t> transcodeLevel(ktxTexture2* tex,
+                                            ktx_uint32_t level) {
+        ktx_size_t levelSize = 0;
+        EXPECT_EQ(ktxTexture2_GetTranscodedLevelSize(tex, level, format,
+                                                     &levelSize),
+                  KTX_SUCCESS);
+        std::vector<ktx_uint8_t> data(levelSize);
+        EXPECT_EQ(ktxTexture2_TranscodeLevel(tex, level, format, 0,
+                                             data.data(), data.size()),
+                  KTX_SUCCESS);
+        return data;
+    }
+
+    // Transcode every image of every level with rows @p rowAlignment
+    // apart and compare them, row by row, with the levels transcoded
+    // by TranscodeLevel. The padding must not be written.
+    void expectImagesMatchLevels(ktxTexture2* tex,
+                                 ktx_uint32_t rowAlignment) {
+        const ktx_uint8_t fill = 0xcd;
+        ktx_uint32_t images = tex->numLayers * tex->numFaces;
+
+        for (ktx_uint32_t level = 0; level < tex->numLevels; level++) {
+            std::vector<ktx_uint8_t> levelData = transcodeLevel(tex, level);
+
+            ktx_uint32_t packedPitch, rowPitch;
+            ktx_size_t packedSize, imageSize;
+            ASSERT_EQ(ktxTexture2_GetTranscodedImageLayout(tex, level, format,
+                                                         1, &packedPitch,
+                                                         &packedSize),
+                      KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_GetTranscodedImageLayout(tex, level, format,
+                                                         rowAlignment,
+                                                         &rowPitch,
+                                                         &imageSize),
+                      KTX_SUCCESS);
+            ASSERT_EQ(packedSize * images, levelData.size());
+            ASSERT_EQ(packedSize % packedPitch, 0U);
+            ktx_uint32_t rows = (ktx_uint32_t)(packedSize / packedPitch);
+            EXPECT_EQ(rowPitch % rowAlignment, 0U);
+            EXPECT_GE(rowPitch, packedPitch);
+            EXPECT_LT(rowPitch, packedPitch + rowAlignment);
+            EXPECT_EQ(imageSize, (ktx_size_t)rowPitch * rows);
+
+            for (ktx_uint32_t layer = 0; layer < tex->numLayers; layer++) {
+                for (ktx_uint32_t face = 0; face < tex->numFaces; face++) {
+                    std::vector<ktx_uint8_t> image(imageSize, fill);
+                    ASSERT_EQ(ktxTexture2_TranscodeImage(tex, level, layer,
+                                                         face, format, 0,
+                                                         image.data(),
+                                                         image.size(),
+                                                         rowPitch),
+                              KTX_SUCCESS)
+                        << "Level " << level << " layer " << layer
+                        << " face " << face;
+
+                    const ktx_uint8_t* expected = levelData.data()
+                        + (layer * tex->numFaces + face) * packedSize;
+                    for (ktx_uint32_t row = 0; row < rows; row++) {
+                        const ktx_uint8_t* actual
+                            = image.data() + (size_t)row * rowPitch;
+                        EXPECT_EQ(memcmp(actual, expected
+                                                 + (size_t)row * packedPitch,
+                                         packedPitch), 0)
+                            << "Level " << level << " layer " << layer
+                            << " face " << face << " row " << row;
+                        for (ktx_uint32_t i = packedPitch; i < rowPitch; i++)
+                            ASSERT_EQ(actual[i], fill)
+                                << "Padding written in row " << row;
+                    }
+                }
+            }
+        }
+    }
+
+    std::string fileName;
+    ktx_transcode_fmt_e format = KTX_TTF_RGBA32;
+    ktxTexture2* texture = nullptr;
+};
+
+std::string
+transcodeParamName(const ::testing::TestParamInfo<TranscodeParam>& info)
+{
+    std::string name = std::get<0>(info.param);
+    name = name.substr(0, name.find('.'));
+    return name + "_" + formatName(std::get<1>(info.param));
+}
+
+INSTANTIATE_TEST_SUITE_P(FilesAndFormats, TranscodeImageTest,
+                         ::testing::Combine(
+                             ::testing::Values("etc1s_array.ktx2",
+                                               "etc1s_video.ktx2",
+                                               "uastc_cube_zstd.ktx2",
+                                               "uastc_video.ktx2"),
+                             ::testing::Values(KTX_TTF_RGBA32,
+                                               KTX_TTF_RGB565,
+                                               KTX_TTF_BC7_RGBA,
+                                               KTX_TTF_ETC1_RGB)),
+                         transcodeParamName);
+
+//////////////////////////////
+// TranscodeImage
+//////////////////////////////
+
+TEST_P(TranscodeImageTest, PackedImagesMatchTranscodeLevel) {
+    expectImagesMatchLevels(texture, 1);
+}
+
+TEST_P(TranscodeImageTest, PaddedRowsMatchTranscodeLevel) {
+    expectImagesMatchLevels(texture, 256);
+}
+
+TEST_P(TranscodeImageTest, ZeroPitchIsPacked) {
+    ktx_uint32_t level = texture->numLevels > 1 ? 1 : 0;
+    std::vector<ktx_uint8_t> levelData = transcodeLevel(texture, level);
+    ktx_uint32_t packedPitch;
+    ktx_size_t packedSize;
+    ASSERT_EQ(ktxTexture2_GetTranscodedImageLayout(texture, level, format, 0,
+                                                   &packedPitch, &packedSize),
+              KTX_SUCCESS);
+
+    std::vector<ktx_uint8_t> image(packedSize);
+    ASSERT_EQ(ktxTexture2_TranscodeImage(texture, level, 0, 0, format, 0,
+                                         image.data(), image.size(), 0),
+              KTX_SUCCESS);
+    EXPECT_EQ(memcmp(image.data(), levelData.data(), packedSize), 0);
+}
+
+TEST_P(TranscodeImageTest, ReadsImagesFromSource) {
+    ktxTexture2* unloaded = createTexture(fileName,
+                                          KTX_TEXTURE_CREATE_NO_FLAGS);
+    ASSERT_TRUE(unloaded != nullptr);
+    expectImagesMatchLevels(unloaded, 64);
+    EXPECT_TRUE(unloaded->pData == nullptr);
+    ktxTexture_Destroy(ktxTexture(unloaded));
+}
+
+TEST_P(TranscodeImageTest, RejectsInvalidArguments) {
+    ktx_uint32_t rowPitch;
+    ktx_size_t imageSize;
+    ASSERT_EQ(ktxTexture2_GetTranscodedImageLayout(texture, 0, format, 1,
+                                                   &rowPitch, &imageSize),
+              KTX_SUCCESS);
+    std::vector<ktx_uint8_t> image(imageSize * 2);
+
+    EXPECT_EQ(ktxTexture2_GetTranscodedImageLayout(texture, 0, format, 3,
+                                                   &rowPitch, &imageSize),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_GetTranscodedImageLayout(texture,
+                                                   texture->numLevels,
+                                                   format, 1,
+                                                   &rowPitch, &imageSize),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_TranscodeImage(texture, 0, 0, 0, format, 0,
+                                         image.data(), imageSize - 1,
+                                         rowPitch),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_TranscodeImage(texture, 0, 0, 0, format, 0,
+                                         image.data(), image.size(),
+                                         rowPitch - 1),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_TranscodeImage(texture, 0, 0, 0, format, 0,
+                                         image.data(), image.size(),
+                                         rowPitch + 1),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_TranscodeImage(texture, 0, texture->numLayers, 0,
+                                         format, 0,
+                                         image.data(), image.size(), 0),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_TranscodeImage(texture, 0, 0, texture->numFaces,
+                                         format, 0,
+                                         image.data(), image.size(), 0),
+              KTX_INVALID_VALUE);
+}
+
+} // namespace
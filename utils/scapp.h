@@ -448,6 +448,7 @@ class scApp : public ktxApp {
                 noSSE = false;
                 verbose = false; // Default to quiet operation.
                 for (int i = 0; i < 4; i++) inputSwizzle[i] = 0;
+                cache = nullptr;
             }
 #define TRAVIS_DEBUG 0
 #if TRAVIS_DEBUG
@@ -503,6 +504,7 @@ class scApp : public ktxApp {
                 qualityLevel.clear();
                 normalMap = false;
                 for (int i = 0; i < 4; i++) inputSwizzle[i] = 0;
+                cache = nullptr;
             }
         };
         int          ktx2;